@@ -0,0 +1,1096 @@
+/*
+MIT License
+
+Copyright (c) 2018 Velli20
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <stdio.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <time.h>
+
+#include "xml_parser.h"
+
+#define COUNTOF(ARRAY) (sizeof(ARRAY) / sizeof(ARRAY[0]))
+
+// Defines
+
+#define BENCH_MAX_NAMES                     512
+#define BENCH_NAME_LENGTH                   32
+
+// bench_buffer
+
+typedef struct bench_buffer
+{
+    PARSER_CHAR* data;
+    PARSER_SIZE  length;
+    PARSER_SIZE  size;
+}
+BENCH_BUFFER;
+
+// bench_names
+
+typedef struct bench_names
+{
+    PARSER_XML_NAME list[BENCH_MAX_NAMES];
+    PARSER_CHAR     strings[BENCH_MAX_NAMES][BENCH_NAME_LENGTH];
+    PARSER_INT      count;
+}
+BENCH_NAMES;
+
+static BENCH_NAMES bench_element_names;
+static BENCH_NAMES bench_attribute_names;
+
+// bench_time
+
+static double bench_time(void)
+{
+    struct timespec ts;
+
+    timespec_get(&ts, TIME_UTC);
+
+    return((double)ts.tv_sec + (double)ts.tv_nsec * 1e-9);
+}
+
+// bench_append
+
+static void bench_append(BENCH_BUFFER* buffer,
+                         const char*   format, ...)
+{
+    va_list arg;
+    int     length;
+
+    if ( buffer->size - buffer->length < 256 )
+    {
+        buffer->size = buffer->size ? buffer->size * 2 : 65536;
+        buffer->data = realloc(buffer->data, buffer->size);
+        if ( !buffer->data )
+            exit(1);
+    }
+
+    va_start(arg, format);
+    length = vsnprintf(buffer->data + buffer->length, buffer->size - buffer->length, format, arg);
+    va_end(arg);
+
+    buffer->length += (PARSER_SIZE)length;
+}
+
+// bench_make_names
+
+static void bench_make_names(BENCH_NAMES* names,
+                             const char*  prefix,
+                             PARSER_INT   count)
+{
+    PARSER_INT i;
+
+    for ( i = 0; i < count; i++ )
+    {
+        snprintf(names->strings[i], BENCH_NAME_LENGTH, "%s_%d", prefix, i);
+        names->list[i].name = names->strings[i];
+    }
+
+    names->count = count;
+}
+
+// bench_make_document
+// Document with given number of elements that use names from
+// the whole name list.
+
+static void bench_make_document(BENCH_BUFFER* buffer,
+                                PARSER_INT    element_count)
+{
+    PARSER_INT i;
+
+    buffer->length = 0;
+
+    bench_append(buffer, "<%s>\n", bench_element_names.list[0].name);
+
+    for ( i = 0; i < element_count; i++ )
+    {
+        bench_append(buffer, "  <%s %s=\"%d\" %s=\"value\">text</%s>\n",
+                     bench_element_names.list[(i * 7) % bench_element_names.count].name,
+                     bench_attribute_names.list[(i * 13) % bench_attribute_names.count].name, i,
+                     bench_attribute_names.list[(i * 5 + 1) % bench_attribute_names.count].name,
+                     bench_element_names.list[(i * 7) % bench_element_names.count].name);
+    }
+
+    bench_append(buffer, "</%s>\n", bench_element_names.list[0].name);
+}
+
+// bench_parse
+// Returns parse throughput in MB/s.
+
+static double bench_parse(const BENCH_BUFFER*       buffer,
+                          PARSER_INT                flags,
+                          const PARSER_SAX_HANDLER* handler,
+                          PARSER_INT                rounds)
+{
+    PARSER_CONFIG config;
+    PARSER_XML*   xml;
+    double        start;
+    double        elapsed;
+    PARSER_INT    i;
+
+    parser_init_config(&config, bench_element_names.list, bench_element_names.count, bench_attribute_names.list, bench_attribute_names.count);
+
+    config.flags       = flags;
+    config.sax_handler = handler;
+
+    start = bench_time();
+
+    for ( i = 0; i < rounds; i++ )
+    {
+        xml = parser_begin_config(&config);
+        if ( !xml )
+            exit(1);
+
+        if ( parser_append(xml, buffer->data, (PARSER_INT)buffer->length) )
+            exit(1);
+
+        parser_free_xml(xml);
+    }
+
+    elapsed = bench_time() - start;
+
+    return(((double)buffer->length * rounds) / (elapsed * 1e6));
+}
+
+// bench_name_lookup
+// Parse throughput as a function of name list size.
+
+static void bench_name_lookup(void)
+{
+    static const PARSER_INT name_counts[] = { 8, 64, 400 };
+    BENCH_BUFFER            buffer;
+    size_t                  i;
+
+    memset(&buffer, 0, sizeof(buffer));
+
+    printf("Name lookup (MB/s)\n");
+    printf("%8s %12s %12s\n", "names", "linear", "hashed");
+
+    for ( i = 0; i < COUNTOF(name_counts); i++ )
+    {
+        bench_make_names(&bench_element_names, "element", name_counts[i]);
+        bench_make_names(&bench_attribute_names, "attribute", name_counts[i]);
+        bench_make_document(&buffer, 10000);
+
+        printf("%8d %12.1f %12.1f\n", name_counts[i],
+               bench_parse(&buffer, PARSER_XML_FLAG_LINEAR_NAME_LOOKUP, 0, 5),
+               bench_parse(&buffer, 0, 0, 5));
+    }
+
+    free(buffer.data);
+}
+
+// bench_text_scan
+// Parse throughput of a document dominated by comments,
+// attribute values and element content.
+
+static void bench_text_scan(void)
+{
+    BENCH_BUFFER buffer;
+    PARSER_INT   i;
+    PARSER_INT   n;
+
+    memset(&buffer, 0, sizeof(buffer));
+
+    bench_make_names(&bench_element_names, "element", 8);
+    bench_make_names(&bench_attribute_names, "attribute", 8);
+
+    bench_append(&buffer, "<%s>\n", bench_element_names.list[0].name);
+
+    for ( i = 0; i < 2000; i++ )
+    {
+        bench_append(&buffer, "  <!--");
+
+        for ( n = 0; n < 32; n++ )
+            bench_append(&buffer, " Lorem ipsum dolor sit amet, consectetur adipiscing elit.");
+
+        bench_append(&buffer, " -->\n  <%s %s=\"Sed ut perspiciatis unde omnis iste natus error sit voluptatem\">"
+                     "Nemo enim ipsam voluptatem quia voluptas sit aspernatur aut odit aut fugit</%s>\n",
+                     bench_element_names.list[1].name, bench_attribute_names.list[0].name, bench_element_names.list[1].name);
+    }
+
+    bench_append(&buffer, "</%s>\n", bench_element_names.list[0].name);
+
+    printf("Text scan (MB/s)\n");
+    printf("%8s %12s\n", "copy", "in-situ");
+    printf("%8.1f %12.1f\n", bench_parse(&buffer, 0, 0, 5), bench_parse(&buffer, PARSER_XML_FLAG_IN_SITU, 0, 5));
+
+    free(buffer.data);
+}
+
+// bench_sax_event
+
+static PARSER_ERROR bench_sax_element(void* context, PARSER_INT name_index, const PARSER_CHAR* name, PARSER_SIZE name_length)
+{
+    (void)name;
+    (void)name_length;
+
+    *(PARSER_SIZE*)context += (PARSER_SIZE)name_index;
+
+    return(0);
+}
+
+// bench_pull
+// Returns pull parser throughput in MB/s. Elements below the
+// root are skipped when skip is set.
+
+static double bench_pull(const BENCH_BUFFER* buffer,
+                         PARSER_INT          skip,
+                         PARSER_INT          rounds)
+{
+    PARSER_CONFIG config;
+    PARSER_TOKEN  token;
+    PARSER_XML*   xml;
+    PARSER_SIZE   sum;
+    double        start;
+    double        elapsed;
+    PARSER_INT    i;
+
+    parser_init_config(&config, bench_element_names.list, bench_element_names.count, bench_attribute_names.list, bench_attribute_names.count);
+
+    sum   = 0;
+    start = bench_time();
+
+    for ( i = 0; i < rounds; i++ )
+    {
+        xml = parser_begin_pull(&config);
+        if ( !xml )
+            exit(1);
+
+        if ( parser_append(xml, buffer->data, (PARSER_INT)buffer->length) )
+            exit(1);
+
+        while ( !parser_next_token(xml, &token) )
+        {
+            sum += (PARSER_SIZE)token.name_index;
+
+            if ( skip && token.type == PARSER_TOKEN_START_ELEMENT && token.depth == 2 )
+                parser_skip_subtree(xml);
+        }
+
+        parser_free_xml(xml);
+    }
+
+    elapsed = bench_time() - start;
+
+    if ( !sum )
+        printf("No tokens\n");
+
+    return(((double)buffer->length * rounds) / (elapsed * 1e6));
+}
+
+// bench_sax
+// Parse throughput of tree building compared to event handler.
+
+static void bench_sax(void)
+{
+    PARSER_SAX_HANDLER handler;
+    BENCH_BUFFER       buffer;
+    PARSER_SIZE        sum;
+
+    memset(&buffer, 0, sizeof(buffer));
+    memset(&handler, 0, sizeof(handler));
+
+    handler.start_element = bench_sax_element;
+    handler.context       = &sum;
+
+    bench_make_names(&bench_element_names, "element", 64);
+    bench_make_names(&bench_attribute_names, "attribute", 64);
+    bench_make_document(&buffer, 1000000);
+
+    printf("Tree vs events (MB/s)\n");
+    printf("%8s %12s %12s %12s %12s\n", "tree", "arena", "events", "pull", "pull skip");
+    printf("%8.1f %12.1f %12.1f %12.1f %12.1f\n",
+           bench_parse(&buffer, 0, 0, 5),
+           bench_parse(&buffer, PARSER_XML_FLAG_ARENA, 0, 5),
+           bench_parse(&buffer, 0, &handler, 5),
+           bench_pull(&buffer, 0, 5),
+           bench_pull(&buffer, 1, 5));
+
+    free(buffer.data);
+}
+
+// bench_document
+// Search time of a linked tree compared to the compact document on a
+// document with 1M elements. Searched name is not in the document so
+// that every element is visited.
+
+static void bench_document(void)
+{
+    const PARSER_DOCUMENT* document;
+    const PARSER_ELEMENT*  element;
+    PARSER_CONFIG          config;
+    BENCH_BUFFER           buffer;
+    PARSER_XML*            tree;
+    PARSER_XML*            compact;
+    PARSER_INT             found;
+    PARSER_INT             i;
+    double                 start;
+    double                 tree_time;
+    double                 document_time;
+
+    memset(&buffer, 0, sizeof(buffer));
+
+    bench_make_names(&bench_element_names, "element", 65);
+    bench_make_names(&bench_attribute_names, "attribute", 64);
+
+    bench_element_names.count = 64;
+    bench_make_document(&buffer, 1000000);
+    bench_element_names.count = 65;
+
+    parser_init_config(&config, bench_element_names.list, bench_element_names.count, bench_attribute_names.list, bench_attribute_names.count);
+
+    config.flags = PARSER_XML_FLAG_ARENA | PARSER_XML_FLAG_ELEMENT_INDEX;
+
+    tree    = parser_begin_config(&config);
+    compact = parser_begin_document(&config);
+
+    if ( !tree || !compact ||
+          parser_append(tree, buffer.data, (PARSER_INT)buffer.length) ||
+          parser_append(compact, buffer.data, (PARSER_INT)buffer.length) )
+    {
+        exit(1);
+    }
+
+    document = parser_get_document(compact);
+    found    = 0;
+
+    start = bench_time();
+
+    for ( i = 0; i < 10; i++ )
+        found += parser_find_element_by_index(tree, 0, 0x7FFFFFFF, 64) != 0;
+
+    tree_time = bench_time() - start;
+    start     = bench_time();
+
+    for ( i = 0; i < 10; i++ )
+        found += parser_document_find_element(document, 0, PARSER_DOCUMENT_NONE, PARSER_DOCUMENT_NONE, 64) != PARSER_DOCUMENT_NONE;
+
+    document_time = bench_time() - start;
+
+    printf("Search of %u elements (ms)\n", document->element_count);
+    printf("%8s %12s %12s\n", "tree", "document", "speedup");
+    printf("%8.2f %12.2f %12.1f\n", tree_time * 100.0, document_time * 100.0, tree_time / document_time);
+
+    if ( found )
+        printf("Unexpected search result\n");
+
+    // Enumerate elements of each name with searches and the index.
+
+    start = bench_time();
+
+    for ( i = 0; i < 64; i++ )
+    {
+        // Search continues from the next element in document order.
+        // Null offset would restart from the first element.
+
+        for ( element = parser_find_element_by_index(tree, 0, 0x7FFFFFFF, i); element; )
+        {
+            found++;
+
+            if ( parser_get_first_child_element(element) )
+                element = parser_get_first_child_element(element);
+            else
+                element = parser_get_subtree_next_element(element);
+
+            if ( element )
+                element = parser_find_element_by_index(tree, element, 0x7FFFFFFF, i);
+        }
+    }
+
+    tree_time = bench_time() - start;
+    start     = bench_time();
+
+    for ( i = 0; i < 64; i++ )
+    {
+        for ( element = parser_find_all_elements_by_index(tree, i); element; element = parser_get_next_element_by_name(element) )
+            found--;
+    }
+
+    document_time = bench_time() - start;
+
+    printf("Enumerate elements of %d names (ms)\n", 64);
+    printf("%8s %12s %12s\n", "search", "index", "speedup");
+    printf("%8.2f %12.2f %12.1f\n", tree_time * 1000.0, document_time * 1000.0, tree_time / document_time);
+
+    if ( found )
+        printf("Unexpected search result\n");
+
+    parser_free_xml(tree);
+    parser_free_xml(compact);
+    free(buffer.data);
+}
+
+// bench_parse_parallel
+// Returns parallel parse throughput in MB/s of a tree or
+// compact document.
+
+static double bench_parse_parallel(const BENCH_BUFFER* buffer,
+                                   PARSER_INT          flags,
+                                   PARSER_INT          document,
+                                   PARSER_INT          thread_count,
+                                   PARSER_INT          rounds)
+{
+    PARSER_CONFIG config;
+    PARSER_XML*   xml;
+    double        start;
+    double        elapsed;
+    PARSER_INT    i;
+
+    parser_init_config(&config, bench_element_names.list, bench_element_names.count, bench_attribute_names.list, bench_attribute_names.count);
+
+    config.flags = flags;
+
+    start = bench_time();
+
+    for ( i = 0; i < rounds; i++ )
+    {
+        xml = document ? parser_begin_document(&config) : parser_begin_config(&config);
+        if ( !xml )
+            exit(1);
+
+        if ( parser_append_parallel(xml, buffer->data, buffer->length, thread_count) )
+            exit(1);
+
+        parser_free_xml(xml);
+    }
+
+    elapsed = bench_time() - start;
+
+    return(((double)buffer->length * rounds) / (elapsed * 1e6));
+}
+
+// bench_parallel
+// Parse throughput with threads. Tokenizing is parallel and
+// building the tree or document is serial.
+
+static void bench_parallel(void)
+{
+    static const PARSER_INT thread_counts[] = { 1, 2, 4, 8 };
+    BENCH_BUFFER            buffer;
+    size_t                  i;
+
+    memset(&buffer, 0, sizeof(buffer));
+
+    bench_make_names(&bench_element_names, "element", 64);
+    bench_make_names(&bench_attribute_names, "attribute", 64);
+    bench_make_document(&buffer, 1000000);
+
+    printf("Parallel parse (MB/s)\n");
+    printf("%8s %12s %12s\n", "threads", "arena", "document");
+
+    for ( i = 0; i < COUNTOF(thread_counts); i++ )
+    {
+        printf("%8d %12.1f %12.1f\n", thread_counts[i],
+               bench_parse_parallel(&buffer, PARSER_XML_FLAG_ARENA, 0, thread_counts[i], 5),
+               bench_parse_parallel(&buffer, 0, 1, thread_counts[i], 5));
+    }
+
+    free(buffer.data);
+}
+
+// bench_batch
+// Documents per second of small documents parsed one at a time
+// and with the batch parser.
+
+static void bench_batch(void)
+{
+    static const PARSER_INT thread_counts[] = { 1, 2, 4, 8 };
+    const PARSER_CHAR**     strings;
+    PARSER_SIZE*            lengths;
+    PARSER_CONFIG           config;
+    BENCH_BUFFER            buffer;
+    PARSER_BATCH*           batch;
+    PARSER_XML*             xml;
+    PARSER_INT              count;
+    PARSER_INT              i;
+    size_t                  t;
+    double                  start;
+    double                  single_rate;
+    double                  reset_rate;
+
+    memset(&buffer, 0, sizeof(buffer));
+
+    bench_make_names(&bench_element_names, "element", 64);
+    bench_make_names(&bench_attribute_names, "attribute", 64);
+    bench_make_document(&buffer, 40);
+
+    count   = 50000;
+    strings = malloc(sizeof(PARSER_CHAR*) * (size_t)count);
+    lengths = malloc(sizeof(PARSER_SIZE) * (size_t)count);
+    if ( !strings || !lengths )
+        exit(1);
+
+    for ( i = 0; i < count; i++ )
+    {
+        strings[i] = buffer.data;
+        lengths[i] = buffer.length;
+    }
+
+    parser_init_config(&config, bench_element_names.list, bench_element_names.count, bench_attribute_names.list, bench_attribute_names.count);
+
+    start = bench_time();
+
+    for ( i = 0; i < count; i++ )
+    {
+        xml = parser_begin_config(&config);
+        if ( !xml || parser_append(xml, strings[i], (PARSER_INT)lengths[i]) )
+            exit(1);
+
+        parser_free_xml(xml);
+    }
+
+    single_rate = count / (bench_time() - start);
+
+    // Same parser is reused for every document.
+
+    xml = parser_begin_config(&config);
+    if ( !xml )
+        exit(1);
+
+    start = bench_time();
+
+    for ( i = 0; i < count; i++ )
+    {
+        if ( parser_append(xml, strings[i], (PARSER_INT)lengths[i]) || parser_reset(xml) )
+            exit(1);
+    }
+
+    reset_rate = count / (bench_time() - start);
+
+    parser_free_xml(xml);
+
+    printf("Batch of %d documents of %d bytes (documents/s)\n", count, (int)buffer.length);
+    printf("%8s %12s %12s %12s\n", "threads", "batch", "single", "reset");
+
+    for ( t = 0; t < COUNTOF(thread_counts); t++ )
+    {
+        batch = parser_begin_batch(&config, thread_counts[t]);
+        if ( !batch )
+            exit(1);
+
+        start = bench_time();
+
+        if ( parser_batch_parse(batch, strings, lengths, (PARSER_SIZE)count) )
+            exit(1);
+
+        printf("%8d %12.0f %12.0f %12.0f\n", thread_counts[t], count / (bench_time() - start), single_rate, reset_rate);
+
+        parser_free_batch(batch);
+    }
+
+    free(strings);
+    free(lengths);
+    free(buffer.data);
+}
+
+// bench_writer_discard
+
+static PARSER_ERROR bench_writer_discard(void* context, const PARSER_CHAR* data, PARSER_SIZE length)
+{
+    PARSER_SIZE* total;
+
+    (void)data;
+
+    total   = context;
+    *total += length;
+
+    return(0);
+}
+
+// bench_writer_events
+// Writes the document of bench_make_document() with writer events.
+
+static PARSER_SIZE bench_writer_events(PARSER_WRITER* writer,
+                                       PARSER_INT     element_count)
+{
+    PARSER_SIZE total;
+    PARSER_INT  i;
+
+    total = 0;
+
+    writer->output.context = &total;
+
+    if ( parser_writer_start_element(writer, 0) )
+        exit(1);
+
+    for ( i = 0; i < element_count; i++ )
+    {
+        if ( parser_writer_start_element(writer, (i * 7) % bench_element_names.count) ||
+             parser_writer_attribute_int(writer, (i * 13) % bench_attribute_names.count, i) ||
+             parser_writer_attribute_string(writer, (i * 5 + 1) % bench_attribute_names.count, "value", 5) ||
+             parser_writer_text(writer, "text", 4) ||
+             parser_writer_end_element(writer) )
+            exit(1);
+    }
+
+    if ( parser_writer_end_element(writer) || parser_writer_flush(writer) )
+        exit(1);
+
+    return(total);
+}
+
+// bench_writer
+// Writes parsed tree back to XML in compact and pretty modes, and
+// the same document with writer events.
+
+static void bench_writer(void)
+{
+    static const PARSER_INT modes[]= { 0, PARSER_WRITE_FLAG_PRETTY };
+
+    PARSER_CHAR   chunk[16384];
+    PARSER_CONFIG config;
+    PARSER_WRITER writer;
+    BENCH_BUFFER  buffer;
+    PARSER_XML*   xml;
+    PARSER_CHAR*  string;
+    PARSER_SIZE   length;
+    PARSER_SIZE   total;
+    PARSER_INT    i;
+    size_t        m;
+    double        start;
+    double        callback_time;
+    double        string_time;
+    double        events_time;
+
+    memset(&buffer, 0, sizeof(buffer));
+
+    bench_make_names(&bench_element_names, "element", 64);
+    bench_make_names(&bench_attribute_names, "attribute", 64);
+    bench_make_document(&buffer, 1000000);
+
+    parser_init_config(&config, bench_element_names.list, bench_element_names.count, bench_attribute_names.list, bench_attribute_names.count);
+
+    config.flags = PARSER_XML_FLAG_ARENA;
+
+    xml = parser_begin_config(&config);
+    if ( !xml || parser_append(xml, buffer.data, (PARSER_INT)buffer.length) )
+        exit(1);
+
+    printf("Write of %d bytes parsed (MB/s)\n", (int)buffer.length);
+    printf("%8s %12s %12s %12s\n", "mode", "callback", "string", "events");
+
+    for ( m = 0; m < COUNTOF(modes); m++ )
+    {
+        total = 0;
+        start = bench_time();
+
+        for ( i = 0; i < 5; i++ )
+        {
+            if ( parser_write_xml(xml, bench_writer_discard, &total, modes[m]) )
+                exit(1);
+        }
+
+        callback_time = bench_time() - start;
+        start         = bench_time();
+        length        = 0;
+
+        for ( i = 0; i < 5; i++ )
+        {
+            if ( parser_write_xml_to_string(xml, &string, &length, modes[m]) )
+                exit(1);
+
+            parser_free(string);
+        }
+
+        string_time = bench_time() - start;
+        start       = bench_time();
+        total       = 0;
+
+        for ( i = 0; i < 5; i++ )
+        {
+            if ( parser_writer_init(&writer, &config, chunk, sizeof(chunk), bench_writer_discard, 0, modes[m]) )
+                exit(1);
+
+            total += bench_writer_events(&writer, 1000000);
+        }
+
+        events_time = bench_time() - start;
+
+        printf("%8s %12.0f %12.0f %12.0f\n", modes[m] ? "pretty" : "compact", (double)length * 5 / callback_time * 1e-6,
+               (double)length * 5 / string_time * 1e-6, (double)total / events_time * 1e-6);
+    }
+
+    parser_free_xml(xml);
+    free(buffer.data);
+}
+
+// bench_query_count
+
+static PARSER_ERROR bench_query_count(void* context, PARSER_INT query_index, const PARSER_ELEMENT* element)
+{
+    (void)element;
+
+    ((PARSER_INT*)context)[query_index]++;
+
+    return(0);
+}
+
+// bench_query
+// Same lookups written as nested find calls with names, compiled
+// queries evaluated one at a time and all queries in one pass.
+
+static void bench_query(void)
+{
+    PARSER_QUERY*         queries[8];
+    PARSER_CHAR           paths[COUNTOF(queries)][64];
+    PARSER_INT            counts[COUNTOF(queries)];
+    PARSER_CONFIG         config;
+    BENCH_BUFFER          buffer;
+    PARSER_XML*           xml;
+    const PARSER_ELEMENT* element;
+    PARSER_INT            total;
+    PARSER_INT            i;
+    size_t                q;
+    double                start;
+    double                find_time;
+    double                query_time;
+    double                one_pass_time;
+
+    memset(&buffer, 0, sizeof(buffer));
+
+    bench_make_names(&bench_element_names, "element", 64);
+    bench_make_names(&bench_attribute_names, "attribute", 64);
+    bench_make_document(&buffer, 200000);
+
+    parser_init_config(&config, bench_element_names.list, bench_element_names.count, bench_attribute_names.list, bench_attribute_names.count);
+
+    config.flags = PARSER_XML_FLAG_ARENA;
+
+    xml = parser_begin_config(&config);
+    if ( !xml || parser_append(xml, buffer.data, (PARSER_INT)buffer.length) )
+        exit(1);
+
+    for ( q = 0; q < COUNTOF(queries); q++ )
+    {
+        snprintf(paths[q], sizeof(paths[q]), "/%s/%s[@%s]", bench_element_names.list[0].name,
+                 bench_element_names.list[q + 1].name, bench_attribute_names.list[q * 3].name);
+
+        queries[q] = parser_compile_query(xml, paths[q]);
+        if ( !queries[q] )
+            exit(1);
+    }
+
+    start = bench_time();
+    total = 0;
+
+    for ( i = 0; i < 5; i++ )
+    {
+        for ( q = 0; q < COUNTOF(queries); q++ )
+        {
+            element = parser_get_first_child_element(parser_find_element(xml, 0, 1, bench_element_names.list[0].name));
+
+            for ( ; (element = parser_find_element(xml, element, 1, bench_element_names.list[q + 1].name)); element = parser_get_next_element(element) )
+                total += parser_find_attribute(xml, element, 0, bench_attribute_names.list[q * 3].name) != 0;
+        }
+    }
+
+    find_time = bench_time() - start;
+    start     = bench_time();
+
+    memset(counts, 0, sizeof(counts));
+
+    for ( i = 0; i < 5; i++ )
+    {
+        for ( q = 0; q < COUNTOF(queries); q++ )
+        {
+            if ( parser_evaluate_queries(xml, &queries[q], 1, bench_query_count, &counts[q]) )
+                exit(1);
+        }
+    }
+
+    query_time = bench_time() - start;
+    start      = bench_time();
+
+    for ( i = 0; i < 5; i++ )
+    {
+        if ( parser_evaluate_queries(xml, queries, COUNTOF(queries), bench_query_count, counts) )
+            exit(1);
+    }
+
+    one_pass_time = bench_time() - start;
+
+    for ( q = 0; q < COUNTOF(queries); q++ )
+    {
+        total -= counts[q] / 2;
+        parser_free_query(queries[q]);
+    }
+
+    printf("Query of %d lookups over %d elements (ms)\n", (int)COUNTOF(queries), 200000);
+    printf("%12s %12s %12s\n", "find", "query", "one pass");
+    printf("%12.2f %12.2f %12.2f%s\n", find_time * 1e3 / 5, query_time * 1e3 / 5, one_pass_time * 1e3 / 5, total ? " (mismatch)" : "");
+
+    parser_free_xml(xml);
+    free(buffer.data);
+}
+
+// bench_filter_alloc
+// Counts allocations of the xml.
+
+static void* bench_filter_alloc(void* context, PARSER_SIZE size)
+{
+    (*(PARSER_INT*)context)++;
+
+    return(malloc(size));
+}
+
+// bench_filter_free
+
+static void bench_filter_free(void* context, void* ptr)
+{
+    (void)context;
+
+    free(ptr);
+}
+
+// bench_filter_match
+
+static PARSER_ERROR bench_filter_match(void* context, PARSER_INT query_index, const PARSER_ELEMENT* element)
+{
+    (void)query_index;
+    (void)element;
+
+    (*(PARSER_INT*)context)++;
+
+    return(0);
+}
+
+// bench_filter
+// Full tree compared to a tree of the matching elements only and
+// to matches passed to a callback.
+
+static void bench_filter(void)
+{
+    static const char* modes[]= { "tree", "filter", "callback" };
+
+    PARSER_ALLOCATOR allocator;
+    PARSER_CONFIG    config;
+    BENCH_BUFFER     buffer;
+    PARSER_XML*      xml;
+    PARSER_QUERY*    query;
+    PARSER_CHAR      path[64];
+    PARSER_INT       allocations;
+    PARSER_INT       matches;
+    PARSER_INT       i;
+    size_t           m;
+    double           start;
+    double           time;
+
+    memset(&buffer, 0, sizeof(buffer));
+
+    bench_make_names(&bench_element_names, "element", 64);
+    bench_make_names(&bench_attribute_names, "attribute", 64);
+    bench_make_document(&buffer, 200000);
+
+    allocator.alloc   = bench_filter_alloc;
+    allocator.free    = bench_filter_free;
+    allocator.realloc = 0;
+    allocator.context = &allocations;
+
+    parser_init_config(&config, bench_element_names.list, bench_element_names.count, bench_attribute_names.list, bench_attribute_names.count);
+
+    config.allocator = &allocator;
+
+    snprintf(path, sizeof(path), "/%s/%s[@%s >= 100000]", bench_element_names.list[0].name, bench_element_names.list[5].name, bench_attribute_names.list[55].name);
+
+    printf("Filter %s of %d bytes\n", path, (int)buffer.length);
+    printf("%10s %12s %12s %12s\n", "mode", "MB/s", "allocations", "matches");
+
+    for ( m = 0; m < COUNTOF(modes); m++ )
+    {
+        time        = 0;
+        allocations = 0;
+        matches     = 0;
+
+        for ( i = 0; i < 5; i++ )
+        {
+            xml   = parser_begin_config(&config);
+            query = xml ? parser_compile_query(xml, path) : 0;
+
+            if ( !query || (m && parser_set_filters(xml, &query, 1, m == 2 ? bench_filter_match : 0, &matches)) )
+                exit(1);
+
+            start = bench_time();
+
+            if ( parser_append(xml, buffer.data, (PARSER_INT)buffer.length) )
+                exit(1);
+
+            time += bench_time() - start;
+
+            parser_free_xml(xml);
+            parser_free_query(query);
+        }
+
+        printf("%10s %12.1f %12d %12d\n", modes[m], (double)buffer.length * 5 / time * 1e-6, (int)allocations / 5, (int)matches / 5);
+    }
+
+    free(buffer.data);
+}
+
+// bench_number_strtod
+// Attribute handler that decodes values with strtod().
+
+static PARSER_ERROR bench_number_strtod(void* context, PARSER_INT name_index, const PARSER_CHAR* name, PARSER_SIZE name_length,
+                                        const PARSER_CHAR* value, PARSER_SIZE value_length)
+{
+    char buffer[64];
+
+    (void)name_index;
+    (void)name;
+    (void)name_length;
+
+    if ( value_length >= sizeof(buffer) )
+        return(0);
+
+    memcpy(buffer, value, value_length);
+    buffer[value_length] = '\0';
+
+    *(double*)context += strtod(buffer, 0);
+
+    return(0);
+}
+
+// bench_number_decoder
+// Attribute handler that decodes values with parser_parse_number().
+
+static PARSER_ERROR bench_number_decoder(void* context, PARSER_INT name_index, const PARSER_CHAR* name, PARSER_SIZE name_length,
+                                         const PARSER_CHAR* value, PARSER_SIZE value_length)
+{
+    PARSER_INT64  int_value;
+    PARSER_DOUBLE float_value;
+
+    (void)name_index;
+    (void)name;
+    (void)name_length;
+
+    if ( parser_parse_number(value, value_length, &int_value, &float_value) == PARSER_ATTRIBUTE_VALUE_TYPE_INTEGER )
+        float_value = (double)int_value;
+
+    *(double*)context += float_value;
+
+    return(0);
+}
+
+// bench_number
+// Decoding of numeric attribute values with strtod() compared to
+// the parser decoder, and tree parse throughput of the same
+// attribute-heavy document with values typed while parsing, on
+// first access and by declared types.
+
+static void bench_number(void)
+{
+    static const PARSER_ATTRIBUTE_DECLARATION declarations[]=
+    {
+        { 0, 0, PARSER_DECLARED_TYPE_INT32  },
+        { 0, 0, PARSER_DECLARED_TYPE_INT32  },
+        { 0, 0, PARSER_DECLARED_TYPE_DOUBLE },
+        { 0, 0, PARSER_DECLARED_TYPE_DOUBLE },
+        { 0, 0, PARSER_DECLARED_TYPE_DOUBLE },
+        { 0, 0, PARSER_DECLARED_TYPE_NONE   },
+        { 0, 0, PARSER_DECLARED_TYPE_NONE   },
+        { 0, 0, PARSER_DECLARED_TYPE_NONE   },
+    };
+
+    PARSER_SAX_HANDLER handler;
+    PARSER_CONFIG      config;
+    BENCH_BUFFER       buffer;
+    PARSER_XML*        xml;
+    double             sum;
+    double             start;
+    PARSER_INT         i;
+
+    memset(&buffer, 0, sizeof(buffer));
+    memset(&handler, 0, sizeof(handler));
+
+    bench_make_names(&bench_element_names, "element", 8);
+    bench_make_names(&bench_attribute_names, "attribute", 8);
+
+    bench_append(&buffer, "<%s>\n", bench_element_names.list[0].name);
+
+    for ( i = 0; i < 200000; i++ )
+    {
+        bench_append(&buffer, "  <%s %s=\"%d\" %s=\"%d\" %s=\"%d.%03d\" %s=\"%.15g\" %s=\"%de-7\"/>\n",
+                     bench_element_names.list[1 + i % 7].name,
+                     bench_attribute_names.list[0].name, i,
+                     bench_attribute_names.list[1].name, -i * 37,
+                     bench_attribute_names.list[2].name, i % 1000, (i * 7) % 1000,
+                     bench_attribute_names.list[3].name, (double)i / 7,
+                     bench_attribute_names.list[4].name, i * 13);
+    }
+
+    bench_append(&buffer, "</%s>\n", bench_element_names.list[0].name);
+
+    handler.context = &sum;
+
+    printf("Numeric attributes (MB/s)\n");
+    printf("%8s %12s %12s %12s %12s\n", "strtod", "decoder", "tree", "declared", "lazy tree");
+
+    handler.attribute = bench_number_strtod;
+    printf("%8.1f", bench_parse(&buffer, 0, &handler, 5));
+
+    handler.attribute = bench_number_decoder;
+    printf(" %12.1f", bench_parse(&buffer, 0, &handler, 5));
+
+    printf(" %12.1f", bench_parse(&buffer, 0, 0, 5));
+
+    // Same tree with declared attribute types.
+
+    parser_init_config(&config, bench_element_names.list, bench_element_names.count, bench_attribute_names.list, bench_attribute_names.count);
+
+    config.attribute_declarations = declarations;
+
+    start = bench_time();
+
+    for ( i = 0; i < 5; i++ )
+    {
+        xml = parser_begin_config(&config);
+        if ( !xml || parser_append(xml, buffer.data, (PARSER_INT)buffer.length) )
+            exit(1);
+
+        parser_free_xml(xml);
+    }
+
+    printf(" %12.1f", (double)buffer.length * 5 / (bench_time() - start) * 1e-6);
+    printf(" %12.1f\n", bench_parse(&buffer, PARSER_XML_FLAG_LAZY_VALUES, 0, 5));
+
+    free(buffer.data);
+}
+
+int main(void)
+{
+    bench_name_lookup();
+    bench_text_scan();
+    bench_sax();
+    bench_document();
+    bench_parallel();
+    bench_batch();
+    bench_writer();
+    bench_query();
+    bench_filter();
+    bench_number();
+
+    return(0);
+}
@@ -27,6 +27,8 @@ SOFTWARE.
 #include <stdlib.h>
 #include <string.h>
 #include <stdarg.h>
+#include <errno.h>
+#include <locale.h>
 
 #include "xml_parser.h"
 
@@ -157,6 +159,145 @@ static PARSER_ERROR test_parse(void)
     return(0);
 }
 
+// test_arena_parse
+
+static PARSER_ERROR test_arena_parse(void)
+{
+    static PARSER_CHAR region[2048];
+    PARSER_XML*        xml;
+    PARSER_ERROR       error;
+    int                i;
+
+    // Parse once using caller-supplied region and once
+    // using only arena blocks.
+
+    for ( i = 0; i < 2; i++ )
+    {
+        xml = parser_begin_arena(test_1_element_names, COUNTOF(test_1_element_names),
+                                 test_1_attribute_names, COUNTOF(test_1_attribute_names),
+                                 i == 0 ? region : 0, i == 0 ? sizeof(region) : 0);
+        if ( !xml )
+            return(1);
+
+        error = parser_append(xml, parse_test_string, strlen(parse_test_string));
+        if ( error )
+            return(error);
+
+        if ( !parser_find_element(xml, 0, 4, "element_type_8") )
+        {
+            printf("%s %d: Element not found.\n", __FUNCTION__, __LINE__);
+            return(PARSER_RESULT_ERROR);
+        }
+
+        error = parser_free_xml(xml);
+        if ( error )
+            return(error);
+    }
+
+    return(0);
+}
+
+// test_allocator_context
+
+typedef struct test_allocator_context
+{
+    int allocations;
+    int frees;
+}
+TEST_ALLOCATOR_CONTEXT;
+
+// test_allocator_alloc
+
+static void* test_allocator_alloc(void* context, PARSER_SIZE size)
+{
+    ((TEST_ALLOCATOR_CONTEXT*)context)->allocations++;
+
+    return(malloc(size));
+}
+
+// test_allocator_free
+
+static void test_allocator_free(void* context, void* ptr)
+{
+    ((TEST_ALLOCATOR_CONTEXT*)context)->frees++;
+
+    free(ptr);
+}
+
+// test_allocator_realloc
+
+static void* test_allocator_realloc(void* context, void* ptr, PARSER_SIZE size)
+{
+    (void)context;
+
+    return(realloc(ptr, size));
+}
+
+// test_allocator
+
+static PARSER_ERROR test_allocator(void)
+{
+    TEST_ALLOCATOR_CONTEXT context[2];
+    PARSER_ALLOCATOR       allocator[2];
+    PARSER_CONFIG          config;
+    PARSER_XML*            xml[2];
+    PARSER_ERROR           error;
+    int                    buffers;
+    int                    i;
+
+    // Run two parsers with separate allocators, second one in arena mode.
+
+    for ( i = 0; i < 2; i++ )
+    {
+        context[i].allocations = 0;
+        context[i].frees       = 0;
+
+        allocator[i].alloc   = test_allocator_alloc;
+        allocator[i].free    = test_allocator_free;
+        allocator[i].realloc = test_allocator_realloc;
+        allocator[i].context = &context[i];
+
+        parser_init_config(&config, test_1_element_names, COUNTOF(test_1_element_names), test_1_attribute_names, COUNTOF(test_1_attribute_names));
+
+        config.allocator = &allocator[i];
+        config.flags     = i == 1 ? PARSER_XML_FLAG_ARENA : 0;
+
+        xml[i] = parser_begin_config(&config);
+        if ( !xml[i] )
+            return(1);
+
+        error = parser_append(xml[i], parse_test_string, strlen(parse_test_string));
+        if ( error )
+            return(error);
+    }
+
+    buffers = (xml[1]->state->temp_name_buffer != 0) + (xml[1]->state->temp_value_buffer != 0);
+
+    for ( i = 0; i < 2; i++ )
+    {
+        error = parser_free_xml(xml[i]);
+        if ( error )
+            return(error);
+
+        if ( context[i].allocations < 1 || context[i].allocations != context[i].frees )
+        {
+            printf("%s %d: Allocator %d: %d allocations, %d frees.\n", __FUNCTION__, __LINE__, i, context[i].allocations, context[i].frees);
+            return(PARSER_RESULT_ERROR);
+        }
+    }
+
+    // Arena mode allocates the tree in one block. Name indexes and
+    // scratch buffers come from the allocator.
+
+    if ( context[1].allocations != 1 + 2 + buffers )
+    {
+        printf("%s %d: Arena made %d allocations.\n", __FUNCTION__, __LINE__, context[1].allocations);
+        return(PARSER_RESULT_ERROR);
+    }
+
+    return(0);
+}
+
 // List of element names in test string.
 
 static const PARSER_XML_NAME test_find_elements_element_names[]=
@@ -208,6 +349,49 @@ static const PARSER_CHAR test_find_elements_string[]=
 
 // test_find_element
 
+// test_collect_elements
+// Collects elements in document order by walking the linked lists.
+
+static void test_collect_elements(const PARSER_ELEMENT*  element,
+                                  const PARSER_ELEMENT** list,
+                                  size_t*                count,
+                                  size_t                 max_count)
+{
+    for ( ; element && *count < max_count; element = parser_get_next_element(element) )
+    {
+        list[(*count)++] = element;
+        test_collect_elements(parser_get_first_child_element(element), list, count, max_count);
+    }
+}
+
+// test_check_subtrees
+// Compares recorded subtree extents with a walk of the tree.
+
+static PARSER_ERROR test_check_subtrees(const PARSER_XML* xml)
+{
+    const PARSER_ELEMENT* list[32];
+    const PARSER_ELEMENT* next;
+    size_t                count;
+    size_t                i;
+
+    count = 0;
+    test_collect_elements(xml->first_element, list, &count, COUNTOF(list));
+
+    for ( i = 0; i < count; i++ )
+    {
+        next = i + (size_t)list[i]->descendant_count + 1 < count ? list[i + (size_t)list[i]->descendant_count + 1] : 0;
+
+        if ( parser_get_subtree_next_element(list[i]) != next ||
+             list[i]->depth != (list[i]->parent_element ? list[i]->parent_element->depth + 1 : 1) )
+        {
+            printf("%s %d: Invalid subtree of element %d\n", __FUNCTION__, __LINE__, (int)i);
+            return(PARSER_RESULT_ERROR);
+        }
+    }
+
+    return(count && (size_t)list[0]->descendant_count + 1 == count ? 0 : PARSER_RESULT_ERROR);
+}
+
 static PARSER_ERROR test_find_element(void)
 {
     const PARSER_ELEMENT* elem;
@@ -233,7 +417,10 @@ static PARSER_ERROR test_find_element(void)
 
     error = parser_append(xml, test_find_elements_string, xml_string_length);
     if ( error )
+    {
+        parser_free_xml(xml);
         return(error);
+    }
 
     // Make sure all elements are succesfully parsed.
 
@@ -248,42 +435,3299 @@ static PARSER_ERROR test_find_element(void)
         }
     }
 
+    // Subtrees below the depth limit are jumped over.
+
+    if ( !error )
+        error = test_check_subtrees(xml);
+
+    if ( !error && (!parser_find_element(xml, 0, 2, "element_type_7") ||
+                     parser_find_element(xml, 0, 2, "element_type_8") ||
+                     parser_find_element(xml, 0, 8, "no_such_element")) )
+    {
+        printf("%s %d: Invalid depth limited search.\n", __FUNCTION__, __LINE__);
+        error = PARSER_RESULT_ERROR;
+    }
+
     // End parsing.
 
-    error = parser_finalize(xml);
+    parser_free_xml(xml);
+
+    return(error);
+}
+
+// test_name_lookup
+// Name lookup that matches names only by their length.
+
+static PARSER_INT test_name_lookup(const void*        context,
+                                   const PARSER_CHAR* name,
+                                   PARSER_SIZE        length)
+{
+    (void)name;
+    (void)context;
+
+    return(length == strlen("depth") ? 0 : PARSER_UNKNOWN_INDEX);
+}
+
+// test_invalid_name_lookup
+// Name lookup that returns indexes below and above the name list.
+
+static PARSER_INT test_invalid_name_lookup(const void*        context,
+                                           const PARSER_CHAR* name,
+                                           PARSER_SIZE        length)
+{
+    (void)name;
+    (void)context;
+
+    return(length > 4 ? -2 : 1000);
+}
+
+// test_find_element_by_index
+
+static PARSER_ERROR test_find_element_by_index(void)
+{
+    const PARSER_ELEMENT*   elem;
+    const PARSER_ATTRIBUTE* attribute;
+    PARSER_CONFIG           config;
+    PARSER_XML*             xml;
+    PARSER_ERROR            error;
+    PARSER_INT              value;
+    PARSER_INT              i;
+
+    parser_init_config(&config, test_find_elements_element_names, COUNTOF(test_find_elements_element_names),
+                       test_find_elements_attribute_names, COUNTOF(test_find_elements_attribute_names));
+
+    config.attribute_name_lookup.function = test_name_lookup;
+
+    xml = parser_begin_config(&config);
+    if ( !xml )
+        return(1);
+
+    error = parser_append(xml, test_find_elements_string, strlen(test_find_elements_string));
+    if ( error )
+        return(error);
+
+    // Element names are numbered by their depth in the test string.
+
+    for ( i = 0, elem = 0; i < (PARSER_INT)COUNTOF(test_find_elements_element_names); i++ )
+    {
+        elem = parser_find_element_by_index(xml, elem, 4, i);
+        if ( !elem )
+        {
+            printf("%s %d: Element %d not found.\n", __FUNCTION__, __LINE__, i);
+            return(PARSER_RESULT_ERROR);
+        }
+
+        attribute = parser_find_attribute_by_index(xml, elem, 0, 0);
+        if ( !attribute || parser_get_attribute_int_value(attribute, &value) )
+        {
+            printf("%s %d: Depth attribute of element %d not found.\n", __FUNCTION__, __LINE__, i);
+            return(PARSER_RESULT_ERROR);
+        }
+    }
+
+    // Names are resolved to the same indexes once.
+
+    if ( parser_get_element_name_index(xml, "element_type_7") != 6 ||
+         parser_get_element_name_index(xml, "element_type") != PARSER_UNKNOWN_INDEX ||
+         parser_get_attribute_name_index(xml, "depth") != 0 ||
+         parser_find_element(xml, 0, 4, "element_type_7") != parser_find_element_by_index(xml, 0, 4, 6) ||
+         parser_find_attribute(xml, xml->first_element, 0, "depth") != parser_find_attribute_by_index(xml, xml->first_element, 0, 0) )
+    {
+        printf("%s %d: Invalid name index.\n", __FUNCTION__, __LINE__);
+        parser_free_xml(xml);
+        return(PARSER_RESULT_ERROR);
+    }
+
+    return(parser_free_xml(xml));
+}
+
+// test_name_index
+// Hash index resolves the same names as linear search. Names with
+// the same FNV-1a hash, duplicate names, long names that differ
+// after PARSER_MAX_NAME_STRING_LENGTH characters and names missing
+// from the list are looked up.
+
+static PARSER_ERROR test_name_index(void)
+{
+    static const PARSER_CHAR* missing[]=
+    {
+        "zinke", "macallums", "liquid_", "costarrin", "element_type_1"
+    };
+
+    static const PARSER_CHAR* long_suffixes[]=
+    {
+        "bvrz", "vbbld", "c"
+    };
+
+    static PARSER_CHAR long_names[3][160];
+
+    PARSER_XML_NAME    names[7];
+    const PARSER_CHAR* name;
+    PARSER_CONFIG      config;
+    PARSER_XML*        xml;
+    PARSER_INT         expected;
+    PARSER_INT         flags;
+    size_t             n;
+    PARSER_ERROR       error;
+
+    // "costarring" and "liquid" have the same hash, and so do
+    // "altarage" and "zinke". Long names with suffixes "bvrz" and
+    // "vbbld" after 136 characters also have the same hash.
+
+    names[0].name = "costarring";
+    names[1].name = "liquid";
+    names[2].name = "altarage";
+    names[3].name = "liquid";
+    names[4].name = long_names[0];
+    names[5].name = long_names[1];
+    names[6].name = "costarring";
+
+    for ( n = 0; n < COUNTOF(long_names); n++ )
+    {
+        memset(long_names[n], 'n', 136);
+        strcpy(long_names[n] + 136, long_suffixes[n]);
+    }
+
+    error = 0;
+
+    for ( flags = 0; flags <= PARSER_XML_FLAG_LINEAR_NAME_LOOKUP && !error; flags += PARSER_XML_FLAG_LINEAR_NAME_LOOKUP )
+    {
+        parser_init_config(&config, names, COUNTOF(names), names, COUNTOF(names));
+
+        config.flags = flags;
+
+        xml = parser_begin_config(&config);
+        if ( !xml )
+            return(1);
+
+        // Duplicate resolves to its first occurrence.
+
+        for ( n = 0; n < COUNTOF(names) && !error; n++ )
+        {
+            expected = n == 3 ? 1 : n == 6 ? 0 : (PARSER_INT)n;
+
+            if ( parser_get_element_name_index(xml, names[n].name) != expected ||
+                 parser_get_attribute_name_index(xml, names[n].name) != expected )
+            {
+                printf("%s %d: Name %d not found with flags %d.\n", __FUNCTION__, __LINE__, (int)n, flags);
+                error = PARSER_RESULT_ERROR;
+            }
+        }
+
+        for ( n = 0; n <= COUNTOF(missing) && !error; n++ )
+        {
+            name = n < COUNTOF(missing) ? missing[n] : long_names[2];
+
+            if ( parser_get_element_name_index(xml, name) != PARSER_UNKNOWN_INDEX ||
+                 parser_get_attribute_name_index(xml, name) != PARSER_UNKNOWN_INDEX )
+            {
+                printf("%s %d: Missing name %d found with flags %d.\n", __FUNCTION__, __LINE__, (int)n, flags);
+                error = PARSER_RESULT_ERROR;
+            }
+        }
+
+        parser_free_xml(xml);
+    }
+
     if ( error )
         return(error);
 
+    // Indexes outside the list from an external lookup are unknown.
+
+    parser_init_config(&config, names, COUNTOF(names), names, COUNTOF(names));
+
+    config.flags                          = PARSER_XML_FLAG_ELEMENT_INDEX;
+    config.element_name_lookup.function   = test_invalid_name_lookup;
+    config.attribute_name_lookup.function = test_invalid_name_lookup;
+
+    xml = parser_begin_config(&config);
+    if ( !xml )
+        return(1);
+
+    error = parser_append(xml, "<liquid liquid='1'><altarage/><ab ab='2'/></liquid>", 51);
+
+    if ( !error && (!xml->first_element || parser_find_element_by_index(xml, 0, 2, 0) ||
+                    parser_get_element_name_index(xml, "liquid") != PARSER_UNKNOWN_INDEX ||
+                    parser_get_element_name_index(xml, "ab") != PARSER_UNKNOWN_INDEX ||
+                    parser_get_attribute_name_index(xml, "liquid") != PARSER_UNKNOWN_INDEX) )
+    {
+        printf("%s %d: Invalid index of external lookup was used.\n", __FUNCTION__, __LINE__);
+        error = PARSER_RESULT_ERROR;
+    }
+
+    parser_free_xml(xml);
+
+    return(error);
+}
+
+// Tokenizer test string with markup that is skipped and
+// characters that are special only in some states.
+
+static const PARSER_CHAR test_tokenizer_string[]=
+{
+"<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+"<!DOCTYPE element_type_1>\n"
+"<element_type_1 stringAttribute='say \"a > b\"' intAttribute = \"42\">\n"
+"  <!-- comment - with -> and <element_type_2> -->\n"
+"  <element_type_2 stringAttribute=\"\">text with 'quotes' > and = signs</element_type_2 >\n"
+"  <element_type_3/>\n"
+"</element_type_1>\n"
+};
+
+// test_tokenizer_check
+
+static PARSER_ERROR test_tokenizer_check(const PARSER_XML* xml)
+{
+    const PARSER_ELEMENT*   elem;
+    const PARSER_ATTRIBUTE* attribute;
+    const PARSER_CHAR*      string;
+    PARSER_INT              value;
+
+    elem = parser_find_element(xml, 0, 1, "element_type_1");
+    if ( !elem )
+        return(PARSER_RESULT_ERROR);
+
+    attribute = parser_find_attribute(xml, elem, 0, "stringAttribute");
+    if ( !attribute || parser_get_attribute_string_value(attribute, &string) || strcmp(string, "say \"a > b\"") )
+    {
+        printf("%s %d: Invalid attribute value.\n", __FUNCTION__, __LINE__);
+        return(PARSER_RESULT_ERROR);
+    }
+
+    attribute = parser_find_attribute(xml, elem, 0, "intAttribute");
+    if ( !attribute || parser_get_attribute_int_value(attribute, &value) || value != 42 )
+    {
+        printf("%s %d: Invalid attribute value.\n", __FUNCTION__, __LINE__);
+        return(PARSER_RESULT_ERROR);
+    }
+
+    // Element inside the comment is not parsed.
+
+    elem = parser_find_element(xml, 0, 2, "element_type_2");
+    if ( !elem || parser_get_next_element(elem) != parser_find_element(xml, 0, 2, "element_type_3") )
+    {
+        printf("%s %d: Invalid child elements.\n", __FUNCTION__, __LINE__);
+        return(PARSER_RESULT_ERROR);
+    }
+
+    attribute = parser_find_attribute(xml, elem, 0, "stringAttribute");
+    if ( !attribute || parser_get_attribute_string_value(attribute, &string) || *string )
+    {
+        printf("%s %d: Invalid empty attribute value.\n", __FUNCTION__, __LINE__);
+        return(PARSER_RESULT_ERROR);
+    }
+
+    if ( !PARSER_GET_CHILD_STRING(elem) || strcmp(PARSER_GET_CHILD_STRING(elem)->buffer, "text with 'quotes' > and = signs") )
+    {
+        printf("%s %d: Invalid content string.\n", __FUNCTION__, __LINE__);
+        return(PARSER_RESULT_ERROR);
+    }
+
     return(0);
 }
 
-int main(void)
+// test_tokenizer
+
+static PARSER_ERROR test_tokenizer(void)
 {
+    static const PARSER_CHAR* invalid_strings[]=
+    {
+        "<element_type_1></element_type_1></element_type_1>",
+        "<element_type_1 intAttribute=42/>",
+        "<element_type_1 <element_type_2/>",
+        "<-element_type_1/>",
+    };
+
+    PARSER_XML*  xml;
     PARSER_ERROR error;
+    size_t       length;
+    size_t       split;
+    size_t       i;
 
-    // Test parsing.
+    length = strlen(test_tokenizer_string);
 
-    error = test_parse();
-    if ( error )
+    // Parse in one buffer and one byte at a time.
+
+    for ( split = length; split > 0; split = split == length ? 1 : 0 )
     {
-        printf("Parse test error: %d\n", error);
-        return(error);
+        xml = parser_begin(test_1_element_names, COUNTOF(test_1_element_names), test_1_attribute_names, COUNTOF(test_1_attribute_names));
+        if ( !xml )
+            return(1);
+
+        for ( i = 0, error = 0; i < length && !error; i += split )
+            error = parser_append(xml, test_tokenizer_string + i, (PARSER_INT)(length - i < split ? length - i : split));
+
+        if ( error || test_tokenizer_check(xml) )
+        {
+            printf("%s %d: Parsing failed with split %d, error %d.\n", __FUNCTION__, __LINE__, (int)split, error);
+            parser_free_xml(xml);
+            return(PARSER_RESULT_ERROR);
+        }
+
+        parser_free_xml(xml);
     }
 
-    // Test split parsing.
+    // Syntax errors.
 
-    error = test_split_parse();
-    if ( error )
+    for ( i = 0; i < COUNTOF(invalid_strings); i++ )
     {
-        printf("Split parse test error: %d\n", error);
-        return(error);
+        xml = parser_begin(test_1_element_names, COUNTOF(test_1_element_names), test_1_attribute_names, COUNTOF(test_1_attribute_names));
+        if ( !xml )
+            return(1);
+
+        error = parser_append(xml, invalid_strings[i], strlen(invalid_strings[i]));
+
+        parser_free_xml(xml);
+
+        if ( error != EINVAL )
+        {
+            printf("%s %d: Invalid string %d parsed with result %d.\n", __FUNCTION__, __LINE__, (int)i, error);
+            return(PARSER_RESULT_ERROR);
+        }
     }
 
-    // Test element finding.
+    return(0);
+}
 
-    error = test_find_element();
-    if ( error )
-        return(error);
+// test_in_situ_check
+// Checks that values of the tokenizer test string are
+// slices of the input between begin and end.
+
+static PARSER_ERROR test_in_situ_check(const PARSER_XML*  xml,
+                                       const PARSER_CHAR* begin,
+                                       const PARSER_CHAR* end)
+{
+    const PARSER_ELEMENT*   elem;
+    const PARSER_ATTRIBUTE* attribute;
+    const PARSER_CHAR*      string;
+    PARSER_SIZE             length;
+
+    // Attribute value is a slice of the input.
+
+    elem      = parser_find_element(xml, 0, 1, "element_type_1");
+    attribute = parser_find_attribute(xml, elem, 0, "stringAttribute");
+
+    if ( parser_get_attribute_string_slice(attribute, &string, &length) || string < begin || string >= end ||
+         length != strlen("say \"a > b\"") || strncmp(string, "say \"a > b\"", length) )
+    {
+        printf("%s %d: Invalid attribute slice.\n", __FUNCTION__, __LINE__);
+        return(PARSER_RESULT_ERROR);
+    }
+
+    // Slice is not null terminated.
+
+    if ( parser_get_attribute_string_value(attribute, &string) != EINVAL )
+    {
+        printf("%s %d: Borrowed value returned as string.\n", __FUNCTION__, __LINE__);
+        return(PARSER_RESULT_ERROR);
+    }
+
+    // Content string is a slice of the input.
+
+    elem = parser_find_element(xml, 0, 2, "element_type_2");
+
+    if ( parser_get_content_string_slice(PARSER_GET_CHILD_STRING(elem), &string, &length) || string < begin || string >= end ||
+         length != strlen("text with 'quotes' > and = signs") || strncmp(string, "text with 'quotes' > and = signs", length) )
+    {
+        printf("%s %d: Invalid content string slice.\n", __FUNCTION__, __LINE__);
+        return(PARSER_RESULT_ERROR);
+    }
+
+    return(0);
+}
+
+// test_in_situ_parse
+
+static PARSER_ERROR test_in_situ_parse(void)
+{
+    PARSER_CONFIG config;
+    PARSER_XML*   xml;
+    PARSER_ERROR  error;
+
+    parser_init_config(&config, test_1_element_names, COUNTOF(test_1_element_names), test_1_attribute_names, COUNTOF(test_1_attribute_names));
+
+    config.flags = PARSER_XML_FLAG_IN_SITU;
+
+    xml = parser_begin_config(&config);
+    if ( !xml )
+        return(1);
+
+    error = parser_append(xml, test_tokenizer_string, strlen(test_tokenizer_string));
+    if ( !error )
+        error = test_in_situ_check(xml, test_tokenizer_string, test_tokenizer_string + sizeof(test_tokenizer_string));
+
+    parser_free_xml(xml);
+
+    return(error);
+}
+
+// test_parse_file
+
+static PARSER_ERROR test_parse_file(void)
+{
+    static const PARSER_CHAR path[] = "libxml_test_file.xml";
+    PARSER_CONFIG            config;
+    PARSER_XML*              xml;
+    PARSER_ERROR             error;
+    FILE*                    file;
+
+    file = fopen(path, "wb");
+    if ( !file )
+        return(1);
+
+    if ( fwrite(test_tokenizer_string, 1, strlen(test_tokenizer_string), file) != strlen(test_tokenizer_string) )
+    {
+        fclose(file);
+        return(1);
+    }
+
+    fclose(file);
+
+    // Values of in-situ xml refer to the kept mapping.
+
+    parser_init_config(&config, test_1_element_names, COUNTOF(test_1_element_names), test_1_attribute_names, COUNTOF(test_1_attribute_names));
+
+    config.flags = PARSER_XML_FLAG_IN_SITU;
+
+    xml = parser_begin_config(&config);
+    if ( !xml )
+        return(1);
+
+    error = parser_parse_file(xml, path, 0);
+    remove(path);
+
+    if ( error || test_in_situ_check(xml, xml->file_data, (const PARSER_CHAR*)xml->file_data + xml->file_size) )
+    {
+        printf("%s %d: Parsing file failed with error %d.\n", __FUNCTION__, __LINE__, error);
+        parser_free_xml(xml);
+        return(PARSER_RESULT_ERROR);
+    }
+
+    error = parser_free_xml(xml);
+    if ( error )
+        return(error);
+
+    // Missing file.
+
+    xml = parser_begin(test_1_element_names, COUNTOF(test_1_element_names), test_1_attribute_names, COUNTOF(test_1_attribute_names));
+    if ( !xml )
+        return(1);
+
+    error = parser_parse_file(xml, path, 0);
+
+    parser_free_xml(xml);
+
+    return(error ? 0 : PARSER_RESULT_ERROR);
+}
+
+// test_long_values
+// Values much longer than the initial scratch buffers are parsed
+// in one piece also when they continue over parser_append() calls.
+
+static PARSER_ERROR test_long_values(void)
+{
+    static const size_t      value_length = 100000;
+    static const size_t      splits[]     = { 0, 7, 1 };
+    const PARSER_ELEMENT*    elem;
+    const PARSER_ATTRIBUTE*  attribute;
+    const PARSER_CHAR*       string;
+    PARSER_XML*              xml;
+    PARSER_CHAR*             document;
+    PARSER_ERROR             error;
+    size_t                   length;
+    size_t                   split;
+    size_t                   i;
+    size_t                   n;
+
+    document = malloc(value_length * 2 + 256);
+    if ( !document )
+        return(1);
+
+    length  = (size_t)sprintf(document, "<element_type_1 stringAttribute=\"");
+    for ( i = 0; i < value_length; i++ )
+        document[length++] = (PARSER_CHAR)('A' + i % 26);
+
+    length += (size_t)sprintf(document + length, "\">");
+    for ( i = 0; i < value_length; i++ )
+        document[length++] = (PARSER_CHAR)('a' + i % 26);
+
+    length += (size_t)sprintf(document + length, "</element_type_1>");
+
+    for ( n = 0, error = 0; n < COUNTOF(splits) && !error; n++ )
+    {
+        split = splits[n] ? splits[n] : length;
+
+        xml = parser_begin(test_1_element_names, COUNTOF(test_1_element_names), test_1_attribute_names, COUNTOF(test_1_attribute_names));
+        if ( !xml )
+        {
+            free(document);
+            return(1);
+        }
+
+        for ( i = 0; i < length && !error; i += split )
+            error = parser_append(xml, document + i, (PARSER_INT)(length - i < split ? length - i : split));
+
+        elem      = parser_find_element(xml, 0, 1, "element_type_1");
+        attribute = parser_find_attribute(xml, elem, 0, "stringAttribute");
+
+        if ( error || parser_get_attribute_string_value(attribute, &string) || strlen(string) != value_length ||
+             strncmp(string, document + strlen("<element_type_1 stringAttribute=\""), value_length) )
+        {
+            printf("%s %d: Invalid attribute value with split %d.\n", __FUNCTION__, __LINE__, (int)split);
+            error = PARSER_RESULT_ERROR;
+        }
+
+        // Content is a single string.
+
+        else if ( !PARSER_GET_CHILD_STRING(elem) || PARSER_GET_CHILD_STRING(elem)->next_string ||
+                  PARSER_GET_CHILD_STRING(elem)->length != value_length || PARSER_GET_CHILD_STRING(elem)->buffer[0] != 'a' )
+        {
+            printf("%s %d: Invalid content string with split %d.\n", __FUNCTION__, __LINE__, (int)split);
+            error = PARSER_RESULT_ERROR;
+        }
+
+        parser_free_xml(xml);
+    }
+
+    free(document);
+
+    return(error);
+}
+
+// Events of the tokenizer test string written by the SAX test handler.
+// Whitespace between elements is not reported.
+
+static const PARSER_CHAR test_sax_events[]=
+{
+"<0 3='say \"a > b\"' 1='42' "
+"<1 3='' [text with 'quotes' > and = signs]>1 "
+"<2 >2 "
+">0 "
+};
+
+// test_sax_context
+
+typedef struct test_sax_context
+{
+    PARSER_CHAR events[1024];
+    size_t      length;
+    PARSER_INT  stop_at_text;
+}
+TEST_SAX_CONTEXT;
+
+// test_sax_append
+
+static PARSER_ERROR test_sax_append(TEST_SAX_CONTEXT* context, const char* format, ...)
+{
+    va_list arguments;
+    int     length;
+
+    va_start(arguments, format);
+    length = vsnprintf(context->events + context->length, sizeof(context->events) - context->length, format, arguments);
+    va_end(arguments);
+
+    if ( length < 0 || (size_t)length >= sizeof(context->events) - context->length )
+        return(ENOMEM);
+
+    context->length += (size_t)length;
+
+    return(0);
+}
+
+// test_sax_start_element
+
+static PARSER_ERROR test_sax_start_element(void* context, PARSER_INT name_index, const PARSER_CHAR* name, PARSER_SIZE name_length)
+{
+    (void)name;
+    (void)name_length;
+
+    return(test_sax_append(context, "<%d ", name_index));
+}
+
+// test_sax_attribute
+
+static PARSER_ERROR test_sax_attribute(void* context, PARSER_INT name_index, const PARSER_CHAR* name, PARSER_SIZE name_length,
+                                       const PARSER_CHAR* value, PARSER_SIZE value_length)
+{
+    (void)name;
+    (void)name_length;
+
+    return(test_sax_append(context, "%d='%.*s' ", name_index, (int)value_length, value));
+}
+
+// test_sax_text
+
+static PARSER_ERROR test_sax_text(void* context, const PARSER_CHAR* text, PARSER_SIZE length)
+{
+    if ( ((TEST_SAX_CONTEXT*)context)->stop_at_text )
+        return(ECANCELED);
+
+    return(test_sax_append(context, "[%.*s]", (int)length, text));
+}
+
+// test_sax_end_element
+
+static PARSER_ERROR test_sax_end_element(void* context, PARSER_INT name_index)
+{
+    return(test_sax_append(context, ">%d ", name_index));
+}
+
+// test_sax
+
+static PARSER_ERROR test_sax(void)
+{
+    PARSER_SAX_HANDLER handler;
+    TEST_SAX_CONTEXT   context;
+    PARSER_CONFIG      config;
+    PARSER_XML*        xml;
+    PARSER_ERROR       error;
+    size_t             length;
+    size_t             split;
+    size_t             i;
+
+    parser_init_config(&config, test_1_element_names, COUNTOF(test_1_element_names), test_1_attribute_names, COUNTOF(test_1_attribute_names));
+
+    handler.start_element = test_sax_start_element;
+    handler.attribute     = test_sax_attribute;
+    handler.text          = test_sax_text;
+    handler.end_element   = test_sax_end_element;
+    handler.context       = &context;
+
+    length = strlen(test_tokenizer_string);
+
+    // Parse in one buffer and one byte at a time.
+
+    for ( split = length; split > 0; split = split == length ? 1 : 0 )
+    {
+        memset(&context, 0, sizeof(context));
+
+        xml = parser_begin_sax(&config, &handler);
+        if ( !xml )
+            return(1);
+
+        for ( i = 0, error = 0; i < length && !error; i += split )
+            error = parser_append(xml, test_tokenizer_string + i, (PARSER_INT)(length - i < split ? length - i : split));
+
+        // No tree is built.
+
+        if ( error || xml->first_element || strcmp(context.events, test_sax_events) )
+        {
+            printf("%s %d: Invalid events with split %d, error %d:\n%s\n", __FUNCTION__, __LINE__, (int)split, error, context.events);
+            parser_free_xml(xml);
+            return(PARSER_RESULT_ERROR);
+        }
+
+        parser_free_xml(xml);
+    }
+
+    // Handler error stops parsing.
+
+    memset(&context, 0, sizeof(context));
+    context.stop_at_text = 1;
+
+    xml = parser_begin_sax(&config, &handler);
+    if ( !xml )
+        return(1);
+
+    error = parser_append(xml, test_tokenizer_string, (PARSER_INT)length);
+
+    parser_free_xml(xml);
+
+    if ( error != ECANCELED )
+    {
+        printf("%s %d: Handler error not returned: %d\n", __FUNCTION__, __LINE__, error);
+        return(PARSER_RESULT_ERROR);
+    }
+
+    return(0);
+}
+
+// test_pull_read
+// Reads tokens in the format of the SAX test handler and skips
+// elements with the given name index.
+
+static PARSER_ERROR test_pull_read(PARSER_XML* xml, TEST_SAX_CONTEXT* context, size_t split, PARSER_INT skip_index)
+{
+    PARSER_TOKEN token;
+    PARSER_ERROR error;
+    size_t       length;
+    size_t       i;
+
+    length = strlen(test_tokenizer_string);
+
+    for ( i = 0; i < length; i += split )
+    {
+        error = parser_append(xml, test_tokenizer_string + i, (PARSER_INT)(length - i < split ? length - i : split));
+        if ( error )
+            return(error);
+
+        while ( !(error = parser_next_token(xml, &token)) )
+        {
+            switch ( token.type )
+            {
+                case PARSER_TOKEN_START_ELEMENT:
+                    error = test_sax_append(context, "<%d ", token.name_index);
+                    if ( !error && token.name_index == skip_index )
+                        error = parser_skip_subtree(xml);
+                    break;
+
+                case PARSER_TOKEN_ATTRIBUTE:
+                    error = test_sax_append(context, "%d='%.*s' ", token.name_index, (int)token.value_length, token.value);
+                    break;
+
+                case PARSER_TOKEN_TEXT:
+                    error = test_sax_append(context, "[%.*s]", (int)token.value_length, token.value);
+                    break;
+
+                case PARSER_TOKEN_END_ELEMENT:
+                    error = test_sax_append(context, ">%d ", token.name_index);
+                    break;
+
+                default:
+                    error = EINVAL;
+                    break;
+            }
+
+            if ( error )
+                return(error);
+        }
+
+        if ( error != EAGAIN )
+            return(error);
+    }
+
+    return(0);
+}
+
+// test_pull
+
+static PARSER_ERROR test_pull(void)
+{
+    static const struct
+    {
+        PARSER_INT         skip_index;
+        const PARSER_CHAR* events;
+    }
+    cases[]=
+    {
+        { PARSER_UNKNOWN_INDEX, test_sax_events },
+        { 1,                    "<0 3='say \"a > b\"' 1='42' <1 >1 <2 >2 >0 " },
+        { 0,                    "<0 >0 " }
+    };
+
+    TEST_SAX_CONTEXT context;
+    PARSER_CONFIG    config;
+    PARSER_XML*      xml;
+    PARSER_ERROR     error;
+    size_t           length;
+    size_t           split;
+    size_t           i;
+
+    parser_init_config(&config, test_1_element_names, COUNTOF(test_1_element_names), test_1_attribute_names, COUNTOF(test_1_attribute_names));
+
+    length = strlen(test_tokenizer_string);
+
+    for ( i = 0; i < COUNTOF(cases); i++ )
+    {
+        // Read from one buffer and one byte at a time.
+
+        for ( split = length; split > 0; split = split == length ? 1 : 0 )
+        {
+            memset(&context, 0, sizeof(context));
+
+            xml = parser_begin_pull(&config);
+            if ( !xml )
+                return(1);
+
+            error = test_pull_read(xml, &context, split, cases[i].skip_index);
+
+            if ( error || xml->first_element || xml->state->depth || strcmp(context.events, cases[i].events) )
+            {
+                printf("%s %d: Invalid tokens with skip %d, split %d, error %d:\n%s\n", __FUNCTION__, __LINE__, cases[i].skip_index, (int)split, error, context.events);
+                parser_free_xml(xml);
+                return(PARSER_RESULT_ERROR);
+            }
+
+            parser_free_xml(xml);
+        }
+    }
+
+    return(0);
+}
+
+// test_document_parse
+
+static PARSER_XML* test_document_parse(const PARSER_CHAR* string, size_t split)
+{
+    PARSER_CONFIG config;
+    PARSER_XML*   xml;
+    size_t        length;
+    size_t        i;
+
+    parser_init_config(&config, test_1_element_names, COUNTOF(test_1_element_names), test_1_attribute_names, COUNTOF(test_1_attribute_names));
+
+    xml = parser_begin_document(&config);
+    if ( !xml )
+        return(0);
+
+    length = strlen(string);
+
+    for ( i = 0; i < length; i += split )
+    {
+        if ( parser_append(xml, string + i, (PARSER_INT)(length - i < split ? length - i : split)) )
+        {
+            parser_free_xml(xml);
+            return(0);
+        }
+    }
+
+    return(xml);
+}
+
+// test_document_check_value
+
+static PARSER_ERROR test_document_check_value(const PARSER_DOCUMENT* document,
+                                              PARSER_UINT32          element,
+                                              PARSER_INT             attribute_index,
+                                              const PARSER_CHAR*     expected)
+{
+    const PARSER_CHAR* value;
+    PARSER_SIZE        length;
+    PARSER_ERROR       error;
+
+    if ( attribute_index == PARSER_UNKNOWN_INDEX )
+        error = parser_document_get_text(document, element, &value, &length);
+    else
+        error = parser_document_get_attribute_value(document, parser_document_find_attribute(document, element, attribute_index), &value, &length);
+
+    if ( error || length != strlen(expected) || memcmp(value, expected, length) )
+        return(PARSER_RESULT_ERROR);
+
+    return(0);
+}
+
+// test_document
+
+static PARSER_ERROR test_document(void)
+{
+    static const PARSER_UINT32 expected[][6]=
+    {
+        // name, depth, parent, first child, next sibling, subtree end
+        { 0, 1, PARSER_DOCUMENT_NONE, 1,                    PARSER_DOCUMENT_NONE, 3 },
+        { 1, 2, 0,                    PARSER_DOCUMENT_NONE, 2,                    2 },
+        { 2, 2, 0,                    PARSER_DOCUMENT_NONE, PARSER_DOCUMENT_NONE, 3 }
+    };
+
+    const PARSER_DOCUMENT* document;
+    PARSER_XML*            xml;
+    PARSER_CHAR*           string;
+    size_t                 split;
+    size_t                 length;
+    PARSER_UINT32          i;
+
+    length = strlen(test_tokenizer_string);
+
+    for ( split = length; split > 0; split = split == length ? 1 : 0 )
+    {
+        xml = test_document_parse(test_tokenizer_string, split);
+        if ( !xml )
+            return(1);
+
+        document = parser_get_document(xml);
+
+        if ( xml->first_element || !document || document->element_count != COUNTOF(expected) || document->attribute_count != 3 )
+        {
+            printf("%s %d: Invalid document with split %d\n", __FUNCTION__, __LINE__, (int)split);
+            parser_free_xml(xml);
+            return(PARSER_RESULT_ERROR);
+        }
+
+        for ( i = 0; i < COUNTOF(expected); i++ )
+        {
+            if ( document->element_name[i]         != (PARSER_INT)expected[i][0] ||
+                 document->element_depth[i]        != expected[i][1]             ||
+                 document->element_parent[i]       != expected[i][2]             ||
+                 document->element_first_child[i]  != expected[i][3]             ||
+                 document->element_next_sibling[i] != expected[i][4]             ||
+                 document->element_subtree_end[i]  != expected[i][5] )
+            {
+                printf("%s %d: Invalid element %u with split %d\n", __FUNCTION__, __LINE__, i, (int)split);
+                parser_free_xml(xml);
+                return(PARSER_RESULT_ERROR);
+            }
+        }
+
+        if ( test_document_check_value(document, 0, 3, "say \"a > b\"") ||
+             test_document_check_value(document, 0, 1, "42") ||
+             test_document_check_value(document, 1, 3, "") ||
+             test_document_check_value(document, 1, PARSER_UNKNOWN_INDEX, "text with 'quotes' > and = signs") ||
+             parser_document_find_attribute(document, 2, 3) != PARSER_DOCUMENT_NONE )
+        {
+            printf("%s %d: Invalid values with split %d\n", __FUNCTION__, __LINE__, (int)split);
+            parser_free_xml(xml);
+            return(PARSER_RESULT_ERROR);
+        }
+
+        // Depth limit jumps over subtrees.
+
+        if ( parser_document_find_element(document, 0, PARSER_DOCUMENT_NONE, PARSER_DOCUMENT_NONE, 2) != 2 ||
+             parser_document_find_element(document, 0, PARSER_DOCUMENT_NONE, 1, 2) != PARSER_DOCUMENT_NONE ||
+             parser_document_find_element(document, 1, 2, PARSER_DOCUMENT_NONE, 2) != PARSER_DOCUMENT_NONE )
+        {
+            printf("%s %d: Invalid search result with split %d\n", __FUNCTION__, __LINE__, (int)split);
+            parser_free_xml(xml);
+            return(PARSER_RESULT_ERROR);
+        }
+
+        parser_free_xml(xml);
+    }
+
+    // Content strings around child elements are joined.
+
+    xml = test_document_parse("<element_type_1>ab<element_type_2 intAttribute='1'>c</element_type_2>de</element_type_1>", 1);
+    if ( !xml )
+        return(1);
+
+    if ( test_document_check_value(parser_get_document(xml), 0, PARSER_UNKNOWN_INDEX, "abde") ||
+         test_document_check_value(parser_get_document(xml), 1, PARSER_UNKNOWN_INDEX, "c") )
+    {
+        printf("%s %d: Invalid joined text\n", __FUNCTION__, __LINE__);
+        parser_free_xml(xml);
+        return(PARSER_RESULT_ERROR);
+    }
+
+    parser_free_xml(xml);
+
+    for ( split = 1; split <= 1000; split *= 1000 )
+    {
+        xml = test_document_parse("<element_type_1>a<element_type_2>b<element_type_3>c</element_type_3>d<element_type_3/>e</element_type_2>f<element_type_2/>g</element_type_1>", split);
+        if ( !xml )
+            return(1);
+
+        document = parser_get_document(xml);
+
+        if ( test_document_check_value(document, 0, PARSER_UNKNOWN_INDEX, "afg") ||
+             test_document_check_value(document, 1, PARSER_UNKNOWN_INDEX, "bde") ||
+             test_document_check_value(document, 2, PARSER_UNKNOWN_INDEX, "c") ||
+             test_document_check_value(document, 3, PARSER_UNKNOWN_INDEX, "") ||
+             test_document_check_value(document, 4, PARSER_UNKNOWN_INDEX, "") )
+        {
+            printf("%s %d: Invalid nested joined text with split %d\n", __FUNCTION__, __LINE__, (int)split);
+            parser_free_xml(xml);
+            return(PARSER_RESULT_ERROR);
+        }
+
+        parser_free_xml(xml);
+    }
+
+    // Text between many children with values is copied once when
+    // joined.
+
+    string = malloc(1000 * 48 + 64);
+    if ( !string )
+        return(ENOMEM);
+
+    length = (size_t)sprintf(string, "<element_type_1>");
+
+    for ( i = 0; i < 1000; i++ )
+        length += (size_t)sprintf(string + length, "x<element_type_2 intAttribute='1'/>");
+
+    sprintf(string + length, "</element_type_1>");
+
+    xml = test_document_parse(string, strlen(string));
+
+    free(string);
+
+    if ( !xml )
+        return(1);
+
+    document = parser_get_document(xml);
+
+    if ( document->element_text_length[0] != 1000 || document->text_length > 3 * 1000 )
+    {
+        printf("%s %d: Joined text of %u characters used %u\n", __FUNCTION__, __LINE__, document->element_text_length[0], (unsigned)document->text_length);
+        parser_free_xml(xml);
+        return(PARSER_RESULT_ERROR);
+    }
+
+    parser_free_xml(xml);
+
+    return(0);
+}
+
+// test_element_index
+// Elements of a name are listed in document order at any depth.
+
+static PARSER_ERROR test_element_index(void)
+{
+    static const PARSER_CHAR string[]=
+    {
+        "<element_type_1>"
+        "<element_type_2 intAttribute='1'/>"
+        "<element_type_3><element_type_2 intAttribute='2'><element_type_2 intAttribute='3'/></element_type_2></element_type_3>"
+        "<element_type_2 intAttribute='4'/>"
+        "</element_type_1>"
+    };
+
+    const PARSER_ELEMENT* elem;
+    PARSER_CONFIG         config;
+    PARSER_XML*           xml;
+    PARSER_INT            value;
+    PARSER_INT            count;
+    size_t                length;
+    size_t                split;
+    size_t                i;
+
+    parser_init_config(&config, test_1_element_names, COUNTOF(test_1_element_names), test_1_attribute_names, COUNTOF(test_1_attribute_names));
+
+    config.flags = PARSER_XML_FLAG_ELEMENT_INDEX;
+    length       = strlen(string);
+
+    for ( split = length; split > 0; split = split == length ? 1 : 0 )
+    {
+        xml = parser_begin_config(&config);
+        if ( !xml )
+            return(1);
+
+        for ( i = 0; i < length; i += split )
+        {
+            if ( parser_append(xml, string + i, (PARSER_INT)(length - i < split ? length - i : split)) )
+            {
+                parser_free_xml(xml);
+                return(PARSER_RESULT_ERROR);
+            }
+        }
+
+        count = 0;
+
+        for ( elem = parser_find_all_elements(xml, "element_type_2"); elem; elem = parser_get_next_element_by_name(elem) )
+        {
+            if ( parser_get_attribute_int_value(parser_find_attribute_by_index(xml, elem, 0, 1), &value) || value != ++count )
+                break;
+        }
+
+        if ( elem || count != 4 ||
+             parser_find_all_elements_by_index(xml, 0) != xml->first_element ||
+             parser_find_all_elements(xml, "element_type_4") )
+        {
+            printf("%s %d: Invalid element index with split %d\n", __FUNCTION__, __LINE__, (int)split);
+            parser_free_xml(xml);
+            return(PARSER_RESULT_ERROR);
+        }
+
+        parser_free_xml(xml);
+    }
+
+    return(0);
+}
+
+// test_parallel_context
+// Hash of the events written by the SAX test handler format.
+
+typedef struct test_parallel_context
+{
+    PARSER_UINT32 hash;
+    PARSER_UINT32 count;
+}
+TEST_PARALLEL_CONTEXT;
+
+// test_parallel_hash
+
+static PARSER_ERROR test_parallel_hash(TEST_PARALLEL_CONTEXT* context, PARSER_INT type, PARSER_INT index, const PARSER_CHAR* string, PARSER_SIZE length)
+{
+    PARSER_SIZE i;
+
+    context->hash = (context->hash ^ (PARSER_UINT32)type) * 16777619u;
+    context->hash = (context->hash ^ (PARSER_UINT32)index) * 16777619u;
+
+    for ( i = 0; i < length; i++ )
+        context->hash = (context->hash ^ (unsigned char)string[i]) * 16777619u;
+
+    context->count += 1;
+
+    return(0);
+}
+
+// test_parallel_start_element
+
+static PARSER_ERROR test_parallel_start_element(void* context, PARSER_INT name_index, const PARSER_CHAR* name, PARSER_SIZE name_length)
+{
+    return(test_parallel_hash(context, 1, name_index, name, name_length));
+}
+
+// test_parallel_attribute
+
+static PARSER_ERROR test_parallel_attribute(void* context, PARSER_INT name_index, const PARSER_CHAR* name, PARSER_SIZE name_length,
+                                            const PARSER_CHAR* value, PARSER_SIZE value_length)
+{
+    return(test_parallel_hash(context, 2, name_index, name, name_length) ||
+           test_parallel_hash(context, 3, name_index, value, value_length));
+}
+
+// test_parallel_text
+
+static PARSER_ERROR test_parallel_text(void* context, const PARSER_CHAR* text, PARSER_SIZE length)
+{
+    return(test_parallel_hash(context, 4, 0, text, length));
+}
+
+// test_parallel_end_element
+
+static PARSER_ERROR test_parallel_end_element(void* context, PARSER_INT name_index)
+{
+    return(test_parallel_hash(context, 5, name_index, 0, 0));
+}
+
+// test_parallel_compare
+// Compares names, first attribute values and content of two trees.
+
+static PARSER_ERROR test_parallel_compare(const PARSER_ELEMENT* a, const PARSER_ELEMENT* b)
+{
+    const PARSER_CHAR* string_a;
+    const PARSER_CHAR* string_b;
+    PARSER_SIZE        length_a;
+    PARSER_SIZE        length_b;
+
+    for ( ; a && b; a = parser_get_next_element(a), b = parser_get_next_element(b) )
+    {
+        if ( a->elem_name.name_index != b->elem_name.name_index || a->descendant_count != b->descendant_count || a->depth != b->depth )
+            return(PARSER_RESULT_ERROR);
+
+        if ( (a->first_attribute != 0) != (b->first_attribute != 0) || (PARSER_GET_CHILD_STRING(a) != 0) != (PARSER_GET_CHILD_STRING(b) != 0) )
+            return(PARSER_RESULT_ERROR);
+
+        if ( a->first_attribute && a->first_attribute->attribute_type == ATTRIBUTE_TYPE_STRING )
+        {
+            if ( parser_get_attribute_string_slice(a->first_attribute, &string_a, &length_a) ||
+                 parser_get_attribute_string_slice(b->first_attribute, &string_b, &length_b) ||
+                 length_a != length_b || memcmp(string_a, string_b, length_a) )
+            {
+                return(PARSER_RESULT_ERROR);
+            }
+        }
+
+        if ( PARSER_GET_CHILD_STRING(a) )
+        {
+            if ( parser_get_content_string_slice(PARSER_GET_CHILD_STRING(a), &string_a, &length_a) ||
+                 parser_get_content_string_slice(PARSER_GET_CHILD_STRING(b), &string_b, &length_b) ||
+                 length_a != length_b || memcmp(string_a, string_b, length_a) )
+            {
+                return(PARSER_RESULT_ERROR);
+            }
+        }
+
+        if ( test_parallel_compare(parser_get_first_child_element(a), parser_get_first_child_element(b)) )
+            return(PARSER_RESULT_ERROR);
+    }
+
+    return(a || b ? PARSER_RESULT_ERROR : 0);
+}
+
+// test_parallel
+// Parallel parse gives the same events and tree as a serial parse.
+// Comments and attribute values contain tags that are taken for
+// chunk boundaries and have to be parsed again.
+
+static PARSER_ERROR test_parallel(void)
+{
+    static const PARSER_INT thread_counts[]= { 2, 3, 8 };
+
+    TEST_PARALLEL_CONTEXT serial_context;
+    TEST_PARALLEL_CONTEXT context;
+    PARSER_SAX_HANDLER    handler;
+    PARSER_CONFIG         config;
+    PARSER_XML*           serial_xml;
+    PARSER_XML*           xml;
+    PARSER_CHAR*          string;
+    PARSER_ERROR          error;
+    size_t                capacity;
+    size_t                length;
+    size_t                i;
+
+    capacity = 512 * 1024;
+    string   = malloc(capacity);
+    if ( !string )
+        return(ENOMEM);
+
+    length = (size_t)sprintf(string, "<?xml version=\"1.0\"?>\n<element_type_1>");
+
+    for ( i = 0; length + 256 < capacity; i++ )
+    {
+        length += (size_t)sprintf(string + length,
+                                  "\n  <element_type_2 stringAttribute='x> <element_type_3/>' intAttribute=\"%d\">text %d > more</element_type_2>"
+                                  "\n  <!-- comment> <element_type_3/> -->"
+                                  "\n  <element_type_3>%d</element_type_3>", (int)i, (int)i, (int)i);
+    }
+
+    length += (size_t)sprintf(string + length, "\n</element_type_1>\n");
+
+    parser_init_config(&config, test_1_element_names, COUNTOF(test_1_element_names), test_1_attribute_names, COUNTOF(test_1_attribute_names));
+
+    handler.start_element = test_parallel_start_element;
+    handler.attribute     = test_parallel_attribute;
+    handler.text          = test_parallel_text;
+    handler.end_element   = test_parallel_end_element;
+
+    memset(&serial_context, 0, sizeof(serial_context));
+    handler.context = &serial_context;
+
+    serial_xml = parser_begin_sax(&config, &handler);
+    if ( !serial_xml )
+    {
+        free(string);
+        return(1);
+    }
+
+    error = parser_append(serial_xml, string, (PARSER_INT)length);
+    parser_free_xml(serial_xml);
+
+    serial_xml = parser_begin(test_1_element_names, COUNTOF(test_1_element_names), test_1_attribute_names, COUNTOF(test_1_attribute_names));
+    if ( !serial_xml || error || parser_append(serial_xml, string, (PARSER_INT)length) )
+    {
+        parser_free_xml(serial_xml);
+        free(string);
+        return(PARSER_RESULT_ERROR);
+    }
+
+    for ( i = 0, error = 0; i < COUNTOF(thread_counts) && !error; i++ )
+    {
+        // Events.
+
+        memset(&context, 0, sizeof(context));
+        handler.context = &context;
+
+        xml = parser_begin_sax(&config, &handler);
+        if ( !xml )
+        {
+            error = 1;
+            break;
+        }
+
+        error = parser_append_parallel(xml, string, length, thread_counts[i]);
+        parser_free_xml(xml);
+
+        if ( error || context.count != serial_context.count || context.hash != serial_context.hash )
+        {
+            printf("%s %d: Invalid events with %d threads, error %d.\n", __FUNCTION__, __LINE__, thread_counts[i], error);
+            error = PARSER_RESULT_ERROR;
+            break;
+        }
+
+        // Tree.
+
+        xml = parser_begin(test_1_element_names, COUNTOF(test_1_element_names), test_1_attribute_names, COUNTOF(test_1_attribute_names));
+        if ( !xml )
+        {
+            error = 1;
+            break;
+        }
+
+        error = parser_append_parallel(xml, string, length, thread_counts[i]);
+
+        if ( error || test_parallel_compare(serial_xml->first_element, xml->first_element) )
+        {
+            printf("%s %d: Invalid tree with %d threads, error %d.\n", __FUNCTION__, __LINE__, thread_counts[i], error);
+            error = PARSER_RESULT_ERROR;
+        }
+
+        parser_free_xml(xml);
+    }
+
+    // Syntax error after the first chunks.
+
+    if ( !error )
+    {
+        string[length - 3] = '<';
+
+        xml = parser_begin(test_1_element_names, COUNTOF(test_1_element_names), test_1_attribute_names, COUNTOF(test_1_attribute_names));
+        if ( !xml )
+            error = 1;
+
+        else if ( parser_append_parallel(xml, string, length, 4) != EINVAL )
+            error = PARSER_RESULT_ERROR;
+
+        parser_free_xml(xml);
+    }
+
+    parser_free_xml(serial_xml);
+    free(string);
+
+    return(error);
+}
+
+// test_batch
+// Batch results are in the order of the documents and the
+// batch can be reused. Every seventh document is invalid.
+
+static PARSER_ERROR test_batch(void)
+{
+    static const PARSER_CHAR invalid_string[]= "<element_type_1 <element_type_2/>";
+    static const PARSER_INT  thread_counts[]= { 1, 4 };
+
+    const PARSER_CHAR* strings[100];
+    PARSER_SIZE        lengths[100];
+    PARSER_CONFIG      config;
+    PARSER_BATCH*      batch;
+    PARSER_ERROR       error;
+    size_t             round;
+    size_t             i;
+    size_t             t;
+
+    parser_init_config(&config, test_1_element_names, COUNTOF(test_1_element_names), test_1_attribute_names, COUNTOF(test_1_attribute_names));
+
+    for ( i = 0; i < COUNTOF(strings); i++ )
+    {
+        strings[i] = i % 7 ? test_tokenizer_string : invalid_string;
+        lengths[i] = strlen(strings[i]);
+    }
+
+    for ( t = 0; t < COUNTOF(thread_counts); t++ )
+    {
+        batch = parser_begin_batch(&config, thread_counts[t]);
+        if ( !batch )
+            return(1);
+
+        for ( round = 0; round < 3; round++ )
+        {
+            error = parser_batch_parse(batch, strings, lengths, COUNTOF(strings) - round);
+            if ( error )
+                break;
+
+            for ( i = 0; i < COUNTOF(strings) - round && !error; i++ )
+            {
+                if ( i % 7 )
+                    error = parser_batch_get_error(batch, i) || test_tokenizer_check(parser_batch_get_xml(batch, i));
+                else
+                    error = parser_batch_get_error(batch, i) != EINVAL;
+            }
+
+            if ( error || parser_batch_get_xml(batch, i) )
+            {
+                printf("%s %d: Invalid result %d with %d threads.\n", __FUNCTION__, __LINE__, (int)i - 1, thread_counts[t]);
+                error = PARSER_RESULT_ERROR;
+                break;
+            }
+        }
+
+        parser_free_batch(batch);
+
+        if ( error )
+            return(error);
+    }
+
+    return(0);
+}
+
+// test_reset_finalized
+// Every document is finalized before reset. After the first document
+// reset allocates nothing: arena position and allocation count stay
+// the same, and parser state keeps its scratch buffers.
+
+static PARSER_ERROR test_reset_finalized(PARSER_INT flags)
+{
+    TEST_ALLOCATOR_CONTEXT context;
+    PARSER_ALLOCATOR       allocator;
+    PARSER_CONFIG          config;
+    PARSER_XML*            xml;
+    PARSER_STATE*          state;
+    PARSER_CHAR*           name_buffer;
+    PARSER_CHAR*           position;
+    PARSER_ERROR           error;
+    int                    allocations;
+    int                    round;
+
+    context.allocations = 0;
+    context.frees       = 0;
+
+    allocator.alloc   = test_allocator_alloc;
+    allocator.free    = test_allocator_free;
+    allocator.realloc = test_allocator_realloc;
+    allocator.context = &context;
+
+    parser_init_config(&config, test_1_element_names, COUNTOF(test_1_element_names), test_1_attribute_names, COUNTOF(test_1_attribute_names));
+
+    config.allocator = &allocator;
+    config.flags     = flags;
+
+    xml = parser_begin_config(&config);
+    if ( !xml )
+        return(1);
+
+    state       = 0;
+    name_buffer = 0;
+    position    = 0;
+    allocations = 0;
+    error       = 0;
+
+    for ( round = 0; round < 1000 && !error; round++ )
+    {
+        error = parser_append(xml, test_tokenizer_string, (PARSER_INT)strlen(test_tokenizer_string));
+        if ( !error )
+            error = test_tokenizer_check(xml);
+
+        if ( !error )
+            error = parser_finalize(xml);
+
+        if ( !error )
+            error = parser_reset(xml);
+
+        if ( error )
+            break;
+
+        // Arena is rewound to the same position and heap mode frees
+        // the whole tree.
+
+        if ( round && (xml->state != state || xml->state->temp_name_buffer != name_buffer ||
+             xml->arena.position != position || context.allocations - context.frees != allocations) )
+        {
+            error = PARSER_RESULT_ERROR;
+            break;
+        }
+
+        state       = xml->state;
+        name_buffer = xml->state->temp_name_buffer;
+        position    = xml->arena.position;
+        allocations = context.allocations - context.frees;
+    }
+
+    parser_free_xml(xml);
+
+    if ( !error && context.allocations != context.frees )
+        error = PARSER_RESULT_ERROR;
+
+    if ( error )
+        printf("%s %d: Reset of finalized xml allocated in round %d with flags %d.\n", __FUNCTION__, __LINE__, round, flags);
+
+    return(error);
+}
+
+// test_reset
+// Same xml parses several documents. First document is invalid and
+// the third is finalized before reset. Arena memory of the tree is
+// reused after reset.
+
+static PARSER_ERROR test_reset(void)
+{
+    static const PARSER_CHAR invalid_string[]= "<element_type_1 <element_type_2/>";
+
+    PARSER_CONFIG          config;
+    PARSER_XML*            xml;
+    const PARSER_DOCUMENT* document;
+    PARSER_CHAR*           position;
+    PARSER_UINT32          element_count;
+    PARSER_ERROR           error;
+    size_t                 round;
+    size_t                 i;
+
+    error = test_reset_finalized(0);
+    if ( !error )
+        error = test_reset_finalized(PARSER_XML_FLAG_ARENA);
+
+    if ( error )
+        return(error);
+
+    parser_init_config(&config, test_1_element_names, COUNTOF(test_1_element_names), test_1_attribute_names, COUNTOF(test_1_attribute_names));
+
+    for ( i = 0; i < 2; i++ )
+    {
+        config.flags = i == 1 ? PARSER_XML_FLAG_ARENA : 0;
+        position     = 0;
+
+        xml = parser_begin_config(&config);
+        if ( !xml )
+            return(1);
+
+        error = parser_append(xml, invalid_string, (PARSER_INT)strlen(invalid_string)) != EINVAL;
+
+        for ( round = 0; round < 4 && !error; round++ )
+        {
+            error = parser_reset(xml);
+            if ( !error && xml->first_element )
+                error = PARSER_RESULT_ERROR;
+
+            if ( error )
+                break;
+
+            // Next document must fill the same arena blocks.
+
+            if ( (config.flags & PARSER_XML_FLAG_ARENA) && round == 2 && xml->arena.position != position )
+            {
+                error = PARSER_RESULT_ERROR;
+                break;
+            }
+
+            position = xml->arena.position;
+
+            error = parser_append(xml, test_tokenizer_string, (PARSER_INT)strlen(test_tokenizer_string));
+            if ( !error )
+                error = test_tokenizer_check(xml);
+
+            if ( !error && round == 2 )
+                error = parser_finalize(xml);
+        }
+
+        parser_free_xml(xml);
+
+        if ( error )
+        {
+            printf("%s %d: Failed to reuse xml in round %d with flags %d.\n", __FUNCTION__, __LINE__, (int)round, config.flags);
+            return(error);
+        }
+    }
+
+    // Compact document keeps its arrays.
+
+    config.flags = 0;
+
+    xml = parser_begin_document(&config);
+    if ( !xml )
+        return(1);
+
+    error         = parser_append(xml, test_tokenizer_string, (PARSER_INT)strlen(test_tokenizer_string));
+    document      = parser_get_document(xml);
+    element_count = document ? document->element_count : 0;
+
+    if ( !error )
+        error = parser_reset(xml);
+
+    if ( !error && (document != parser_get_document(xml) || document->element_count) )
+        error = PARSER_RESULT_ERROR;
+
+    if ( !error )
+        error = parser_append(xml, test_tokenizer_string, (PARSER_INT)strlen(test_tokenizer_string));
+
+    if ( !error && (!element_count || document->element_count != element_count) )
+        error = PARSER_RESULT_ERROR;
+
+    parser_free_xml(xml);
+
+    if ( error )
+        printf("%s %d: Failed to reuse compact document.\n", __FUNCTION__, __LINE__);
+
+    return(error);
+}
+
+// test_writer_string
+// Written back the same in pretty mode.
+
+static const PARSER_CHAR test_writer_string[]=
+{
+"<element_type_1 testElementId=\"0\" intAttribute=\"2000000000\" floatAttribute=\"3.5\" stringAttribute=\"say &quot;a &lt; b&quot;\">\n"
+"  <element_type_2 testElementId=\"1\">\n"
+"    <element_type_3 testElementId=\"11\"/>\n"
+"    <element_type_3>text &amp; more</element_type_3>\n"
+"  </element_type_2>\n"
+"  <element_type_4>\n"
+"    text before children\n"
+"    <element_type_5 floatAttribute=\"0.5\" stringAttribute=\"\"/>\n"
+"  </element_type_4>\n"
+"</element_type_1>\n"
+};
+
+// test_writer_compact_string
+
+static const PARSER_CHAR test_writer_compact_string[]=
+{
+"<element_type_1 testElementId=\"0\" intAttribute=\"2000000000\" floatAttribute=\"3.5\" stringAttribute=\"say &quot;a &lt; b&quot;\">"
+"<element_type_2 testElementId=\"1\"><element_type_3 testElementId=\"11\"/><element_type_3>text &amp; more</element_type_3></element_type_2>"
+"<element_type_4>text before children\n    <element_type_5 floatAttribute=\"0.5\" stringAttribute=\"\"/></element_type_4>"
+"</element_type_1>"
+};
+
+// test_writer_append
+// Write callback that appends to TEST_SAX_CONTEXT.
+
+static PARSER_ERROR test_writer_append(void* context, const PARSER_CHAR* data, PARSER_SIZE length)
+{
+    return(test_sax_append(context, "%.*s", (int)length, data));
+}
+
+// test_writer
+// Tree is written back in pretty and compact modes, to a string,
+// a fixed buffer and a callback. Quote in a value that is read
+// inside single quotes is escaped. String is allocated with the
+// allocator of the xml.
+
+static PARSER_ERROR test_writer(void)
+{
+    static const PARSER_CHAR quote_string[]         = "<element_type_1 stringAttribute='a \"b\"'/>";
+    static const PARSER_CHAR quote_written_string[] = "<element_type_1 stringAttribute=\"a &quot;b&quot;\"/>";
+
+    TEST_ALLOCATOR_CONTEXT allocator_context;
+    PARSER_ALLOCATOR       allocator;
+    PARSER_CONFIG          config;
+    PARSER_XML*            xml;
+    PARSER_CHAR*           string;
+    PARSER_CHAR            buffer[64];
+    TEST_SAX_CONTEXT       context;
+    PARSER_SIZE            length;
+    PARSER_ERROR           error;
+    int                    allocations;
+    int                    i;
+
+    parser_init_config(&config, test_1_element_names, COUNTOF(test_1_element_names), test_1_attribute_names, COUNTOF(test_1_attribute_names));
+
+    xml = parser_begin_config(&config);
+    if ( !xml )
+        return(1);
+
+    string = 0;
+    error  = parser_append(xml, test_writer_string, (PARSER_INT)strlen(test_writer_string));
+
+    if ( !error )
+        error = parser_write_xml_to_string(xml, &string, &length, PARSER_WRITE_FLAG_PRETTY);
+
+    if ( !error && (length != strlen(test_writer_string) || strcmp(string, test_writer_string)) )
+    {
+        printf("%s %d: Pretty output does not match:\n%s\n", __FUNCTION__, __LINE__, string);
+        error = PARSER_RESULT_ERROR;
+    }
+
+    parser_free(string);
+    string = 0;
+
+    if ( !error )
+        error = parser_write_xml_to_string(xml, &string, &length, 0);
+
+    if ( !error && strcmp(string, test_writer_compact_string) )
+    {
+        printf("%s %d: Compact output does not match:\n%s\n", __FUNCTION__, __LINE__, string);
+        error = PARSER_RESULT_ERROR;
+    }
+
+    parser_free(string);
+
+    // Callback gets the same output.
+
+    memset(&context, 0, sizeof(context));
+
+    if ( !error )
+        error = parser_write_xml(xml, test_writer_append, &context, PARSER_WRITE_FLAG_PRETTY);
+
+    if ( !error && strcmp(context.events, test_writer_string) )
+        error = PARSER_RESULT_ERROR;
+
+    // Output that does not fit is cut.
+
+    if ( !error && (parser_write_xml_to_buffer(xml, buffer, sizeof(buffer), &length, 0) != ENOBUFS ||
+                    length >= sizeof(buffer) || strncmp(buffer, test_writer_compact_string, length)) )
+        error = PARSER_RESULT_ERROR;
+
+    parser_free_xml(xml);
+
+    if ( error )
+        return(error);
+
+    xml = parser_begin_config(&config);
+    if ( !xml )
+        return(1);
+
+    error = parser_append(xml, quote_string, (PARSER_INT)strlen(quote_string));
+    if ( !error )
+        error = parser_write_xml_to_buffer(xml, buffer, sizeof(buffer), &length, 0);
+
+    if ( !error && strcmp(buffer, quote_written_string) )
+    {
+        printf("%s %d: Quote is not escaped: %s\n", __FUNCTION__, __LINE__, buffer);
+        error = PARSER_RESULT_ERROR;
+    }
+
+    parser_free_xml(xml);
+
+    if ( error )
+        return(error);
+
+    // String that grows several times is allocated with the allocator
+    // of the xml, also without realloc.
+
+    allocator_context.allocations = 0;
+    allocator_context.frees       = 0;
+
+    allocator.alloc   = test_allocator_alloc;
+    allocator.free    = test_allocator_free;
+    allocator.realloc = 0;
+    allocator.context = &allocator_context;
+
+    config.allocator = &allocator;
+
+    xml = parser_begin_config(&config);
+    if ( !xml )
+        return(1);
+
+    string = 0;
+    error  = parser_append(xml, "<element_type_1>", 16);
+
+    for ( i = 0; i < 1000 && !error; i++ )
+        error = parser_append(xml, test_writer_string, (PARSER_INT)strlen(test_writer_string));
+
+    if ( !error )
+        error = parser_append(xml, "</element_type_1>", 17);
+
+    allocations = allocator_context.allocations;
+
+    if ( !error )
+        error = parser_write_xml_to_string(xml, &string, &length, PARSER_WRITE_FLAG_PRETTY);
+
+    if ( !error && (allocator_context.allocations - allocations < 2 || length != strlen(string) || strncmp(string, "<element_type_1>\n", 17)) )
+    {
+        printf("%s %d: Output of %u characters made %d allocations.\n", __FUNCTION__, __LINE__, (unsigned)length, allocator_context.allocations - allocations);
+        error = PARSER_RESULT_ERROR;
+    }
+
+    if ( string )
+        allocator.free(allocator.context, string);
+
+    parser_free_xml(xml);
+
+    if ( !error && allocator_context.allocations != allocator_context.frees )
+        error = PARSER_RESULT_ERROR;
+
+    return(error);
+}
+
+// test_stream_writer_string
+
+static const PARSER_CHAR test_stream_writer_string[]=
+{
+"<element_type_1 testElementId=\"0\" intAttribute=\"-5\" floatAttribute=\"3.5\" stringAttribute=\"say &quot;a &lt; b&quot; &amp; c\">\n"
+"  <element_type_2 testElementId=\"1\" floatAttribute=\"3.141592653589793\">\n"
+"    <element_type_3 testElementId=\"11\"/>\n"
+"    <element_type_3>text &amp; more</element_type_3>\n"
+"  </element_type_2>\n"
+"  <element_type_4>text &lt;before&gt;\n"
+"    <element_type_5 floatAttribute=\"0.5\" stringAttribute=\"\"/>\n"
+"  </element_type_4>\n"
+"</element_type_1>\n"
+};
+
+// test_stream_writer_event
+// Start, End, Int, Float and string Attribute, Text.
+
+typedef struct test_stream_writer_event
+{
+    PARSER_CHAR        type;
+    PARSER_INT         name_index;
+    const PARSER_CHAR* value;
+}
+TEST_STREAM_WRITER_EVENT;
+
+static const TEST_STREAM_WRITER_EVENT test_stream_writer_events[]=
+{
+    { 'S', 0, 0 }, { 'I', 0, "0" }, { 'I', 1, "-5" }, { 'F', 2, "3.5" }, { 'A', 3, "say \"a < b\" & c" },
+        { 'S', 1, 0 }, { 'I', 0, "1" }, { 'F', 2, "3.141592653589793" },
+            { 'S', 2, 0 }, { 'I', 0, "11" }, { 'E', 0, 0 },
+            { 'S', 2, 0 }, { 'T', 0, "text & more" }, { 'E', 0, 0 },
+        { 'E', 0, 0 },
+        { 'S', 3, 0 }, { 'T', 0, "text <before>" },
+            { 'S', 4, 0 }, { 'F', 2, "0.5" }, { 'A', 3, "" }, { 'E', 0, 0 },
+        { 'E', 0, 0 },
+    { 'E', 0, 0 }
+};
+
+// test_stream_writer_write
+
+static PARSER_ERROR test_stream_writer_write(PARSER_WRITER* writer)
+{
+    const TEST_STREAM_WRITER_EVENT* event;
+    PARSER_ERROR                    error;
+    size_t                          i;
+
+    for ( i = 0, error = 0; i < COUNTOF(test_stream_writer_events) && !error; i++ )
+    {
+        event = &test_stream_writer_events[i];
+
+        switch ( event->type )
+        {
+            case 'S': error = parser_writer_start_element(writer, event->name_index);                                        break;
+            case 'I': error = parser_writer_attribute_int(writer, event->name_index, strtoll(event->value, 0, 10));          break;
+            case 'F': error = parser_writer_attribute_float(writer, event->name_index, strtod(event->value, 0));             break;
+            case 'A': error = parser_writer_attribute_string(writer, event->name_index, event->value, strlen(event->value)); break;
+            case 'T': error = parser_writer_text(writer, event->value, strlen(event->value));                                break;
+            default:  error = parser_writer_end_element(writer);                                                             break;
+        }
+    }
+
+    if ( error )
+        return(error);
+
+    return(parser_writer_flush(writer));
+}
+
+// test_stream_writer
+// Same output to a fixed buffer and through a small buffer to a
+// callback. Output is parsed back. Events in wrong places fail.
+
+static PARSER_ERROR test_stream_writer(void)
+{
+    PARSER_CONFIG    config;
+    PARSER_WRITER    writer;
+    PARSER_XML*      xml;
+    PARSER_CHAR      buffer[1024];
+    PARSER_CHAR      chunk[16];
+    TEST_SAX_CONTEXT context;
+    PARSER_ERROR     error;
+
+    parser_init_config(&config, test_1_element_names, COUNTOF(test_1_element_names), test_1_attribute_names, COUNTOF(test_1_attribute_names));
+
+    error = parser_writer_init(&writer, &config, buffer, sizeof(buffer), 0, 0, PARSER_WRITE_FLAG_PRETTY);
+    if ( !error )
+        error = test_stream_writer_write(&writer);
+
+    if ( !error && (writer.output.position != strlen(test_stream_writer_string) || strcmp(buffer, test_stream_writer_string)) )
+    {
+        printf("%s %d: Output does not match:\n%s\n", __FUNCTION__, __LINE__, buffer);
+        return(PARSER_RESULT_ERROR);
+    }
+
+    memset(&context, 0, sizeof(context));
+
+    if ( !error )
+        error = parser_writer_init(&writer, &config, chunk, sizeof(chunk), test_writer_append, &context, PARSER_WRITE_FLAG_PRETTY);
+    if ( !error )
+        error = test_stream_writer_write(&writer);
+
+    if ( !error && strcmp(context.events, test_stream_writer_string) )
+    {
+        printf("%s %d: Output does not match:\n%s\n", __FUNCTION__, __LINE__, context.events);
+        return(PARSER_RESULT_ERROR);
+    }
+
+    if ( error )
+        return(error);
+
+    xml = parser_begin_config(&config);
+    if ( !xml )
+        return(1);
+
+    error = parser_append(xml, buffer, (PARSER_INT)strlen(buffer));
+
+    parser_free_xml(xml);
+
+    if ( error )
+        return(error);
+
+    // Attribute after content, unknown name and end without element.
+
+    parser_writer_init(&writer, &config, buffer, sizeof(buffer), 0, 0, 0);
+
+    if ( parser_writer_start_element(&writer, 0) ||
+         parser_writer_text(&writer, "a", 1) ||
+         parser_writer_attribute_int(&writer, 0, 1) != EINVAL ||
+         parser_writer_start_element(&writer, (PARSER_INT)COUNTOF(test_1_element_names)) != EINVAL ||
+         parser_writer_end_element(&writer) ||
+         parser_writer_end_element(&writer) != EINVAL )
+        return(PARSER_RESULT_ERROR);
+
+    return(0);
+}
+
+// test_writer_float
+// Large and small floats are written with '.' as the decimal point
+// in any installed locale and read back as the same value.
+
+static PARSER_ERROR test_writer_float(void)
+{
+    static const PARSER_DOUBLE values[]=
+    {
+        1.5e20, 1e-5, -2.5e-300, 0.1 + 0.2, 1e300 / 3, 1234567890123456.0, 1e9
+    };
+
+    static const PARSER_CHAR* expected[]=
+    {
+        "1.5e+20", "1e-05", "-2.5e-300", "0.30000000000000004", "3.3333333333333335e+299", "1234567890123456.0", "1000000000.0"
+    };
+
+    static const PARSER_CHAR* locales[]=
+    {
+        "C", "de_DE.UTF-8", "fr_FR.UTF-8", "ps_AF.UTF-8"
+    };
+
+    PARSER_CONFIG config;
+    PARSER_WRITER writer;
+    PARSER_CHAR   buffer[128];
+    PARSER_CHAR   string[128];
+    PARSER_INT64  int_value;
+    PARSER_DOUBLE float_value;
+    PARSER_ERROR  error;
+    size_t        i;
+    size_t        j;
+
+    parser_init_config(&config, test_1_element_names, COUNTOF(test_1_element_names), test_1_attribute_names, COUNTOF(test_1_attribute_names));
+
+    for ( i = 0, error = 0; i < COUNTOF(locales) && !error; i++ )
+    {
+        if ( !setlocale(LC_NUMERIC, locales[i]) )
+            continue;
+
+        for ( j = 0; j < COUNTOF(values) && !error; j++ )
+        {
+            error = parser_writer_init(&writer, &config, buffer, sizeof(buffer), 0, 0, 0);
+            if ( !error )
+                error = parser_writer_start_element(&writer, 0);
+            if ( !error )
+                error = parser_writer_attribute_float(&writer, 2, values[j]);
+            if ( !error )
+                error = parser_writer_end_element(&writer);
+            if ( !error )
+                error = parser_writer_flush(&writer);
+            if ( error )
+                break;
+
+            snprintf(string, sizeof(string), "<element_type_1 floatAttribute=\"%s\"/>", expected[j]);
+
+            if ( strncmp(buffer, string, strlen(string)) ||
+                 parser_parse_number(expected[j], strlen(expected[j]), &int_value, &float_value) != PARSER_ATTRIBUTE_VALUE_TYPE_FLOAT ||
+                 float_value != values[j] )
+            {
+                printf("%s %d: Output in locale %s does not match: %s\n", __FUNCTION__, __LINE__, locales[i], buffer);
+                error = PARSER_RESULT_ERROR;
+            }
+        }
+    }
+
+    setlocale(LC_NUMERIC, "C");
+
+    return(error);
+}
+
+// test_query_string
+
+static const PARSER_CHAR test_query_string[]=
+{
+"<element_type_1 testElementId=\"1\">\n"
+"  <element_type_2 testElementId=\"2\" intAttribute=\"3\">\n"
+"    <element_type_3 testElementId=\"3\" floatAttribute=\"0.5\"/>\n"
+"    <element_type_3 testElementId=\"4\" stringAttribute=\"abc\"/>\n"
+"    <element_type_2 testElementId=\"5\">\n"
+"      <element_type_3 testElementId=\"6\" intAttribute=\"7\"/>\n"
+"    </element_type_2>\n"
+"  </element_type_2>\n"
+"  <element_type_4 testElementId=\"7\" stringAttribute='b \"c\"' intAttribute=\"9007199254740993\">\n"
+"    <element_type_3 testElementId=\"8\" floatAttribute=\"25.5\"/>\n"
+"  </element_type_4>\n"
+"  <unknown_element testElementId=\"9\"><element_type_3 testElementId=\"10\"/></unknown_element>\n"
+"</element_type_1>\n"
+};
+
+// test_query_path
+// Path and testElementId of the matching elements.
+
+typedef struct test_query_path
+{
+    const PARSER_CHAR* path;
+    const PARSER_CHAR* expected;
+}
+TEST_QUERY_PATH;
+
+static const TEST_QUERY_PATH test_query_paths[]=
+{
+    { "/element_type_1",                                              "1 "         },
+    { "/element_type_1/element_type_2",                               "2 "         },
+    { "//element_type_2",                                             "2 5 "       },
+    { "//element_type_3",                                             "3 4 6 8 10 "},
+    { "/element_type_1/element_type_2//element_type_3",               "3 4 6 "     },
+    { "/element_type_1/*/element_type_3",                             "3 4 8 10 "  },
+    { "/element_type_1//element_type_2/*",                            "3 4 5 6 "   },
+    { "//element_type_2//element_type_2/element_type_3",              "6 "         },
+    { "//element_type_2[@intAttribute=3]/element_type_3",             "3 4 "       },
+    { "//*[@intAttribute > 5]",                                       "6 7 "       },
+    { "//*[@floatAttribute>=0.5]",                                    "3 8 "       },
+    { "//*[ @floatAttribute = 25.5 ]",                                "8 "         },
+    { "//*[@floatAttribute = 2.55e1]",                                "8 "         },
+    { "//*[@intAttribute > +5]",                                      "6 7 "       },
+    { "//*[@intAttribute=9007199254740993]",                          "7 "         },
+    { "//*[@intAttribute=9007199254740992]",                          ""           },
+    { "//*[@intAttribute<9007199254740993]",                          "2 6 "       },
+    { "//*[@intAttribute>9007199254740992]",                          "7 "         },
+    { "//*[@intAttribute=9007199254740992.0]",                        "7 "         },
+    { "//*[@stringAttribute='abc']",                                  "4 "         },
+    { "//element_type_4[@stringAttribute='b \"c\"']",                 "7 "         },
+    { "//*[@stringAttribute != \"abc\"]",                             "7 "         },
+    { "//*[@stringAttribute]",                                        "4 7 "       },
+    { "//element_type_3[@testElementId>3][@testElementId<=8]",        "4 6 8 "     },
+    { "//*[@intAttribute='3']",                                       ""           },
+    { "//no_such_element",                                            ""           },
+    { "//*[@no_such_attribute]",                                      ""           },
+};
+
+// test_query_match
+// Appends testElementId of the element to the context of the query.
+
+static PARSER_ERROR test_query_match(void* context, PARSER_INT query_index, const PARSER_ELEMENT* element)
+{
+    const PARSER_ATTRIBUTE* attribute;
+
+    for ( attribute = element->first_attribute; attribute; attribute = attribute->next_attribute )
+    {
+        if ( (attribute->attribute_type & PARSER_ATTRIBUTE_NAME_TYPE_INDEX) && attribute->attr_name.attribute_index == 0 )
+            return(test_sax_append((TEST_SAX_CONTEXT*)context + query_index, "%d ", (int)attribute->attr_val.int_value));
+    }
+
+    return(PARSER_RESULT_ERROR);
+}
+
+// test_query_count
+
+static PARSER_ERROR test_query_count(void* context, PARSER_INT query_index, const PARSER_ELEMENT* element)
+{
+    (void)query_index;
+    (void)element;
+
+    (*(PARSER_INT*)context)++;
+
+    return(0);
+}
+
+// test_query
+// Queries are evaluated one at a time and all together. Invalid
+// paths are not compiled. Deep tree grows the mask stack.
+
+static PARSER_ERROR test_query(void)
+{
+    static const PARSER_CHAR* invalid_paths[]=
+    {
+        "", "element_type_1", "/", "/element_type_1/", "/element_type_1[", "/element_type_1[@testElementId=]",
+        "/element_type_1[testElementId]", "/element_type_1[@testElementId='1]", "/element_type_1[@testElementId=inf]",
+        "/element_type_1[@testElementId=<1]", "/element_type_1 /element_type_2", "/element_type_1[@testElementId]x",
+    };
+
+    TEST_ALLOCATOR_CONTEXT allocator_context;
+    PARSER_ALLOCATOR       allocator;
+    PARSER_CONFIG          config;
+    PARSER_QUERY*          queries[COUNTOF(test_query_paths)];
+    TEST_SAX_CONTEXT*      contexts;
+    PARSER_XML*            xml;
+    PARSER_QUERY*          query;
+    PARSER_CHAR*           string;
+    PARSER_CHAR            path[64 * 2 + 1];
+    PARSER_ERROR           error;
+    PARSER_INT             count;
+    int                    allocations;
+    size_t                 i;
+
+    parser_init_config(&config, test_1_element_names, COUNTOF(test_1_element_names), test_1_attribute_names, COUNTOF(test_1_attribute_names));
+
+    xml = parser_begin_config(&config);
+    if ( !xml )
+        return(1);
+
+    contexts = (TEST_SAX_CONTEXT*)calloc(COUNTOF(test_query_paths), sizeof(TEST_SAX_CONTEXT));
+    memset(queries, 0, sizeof(queries));
+
+    error = contexts ? parser_append(xml, test_query_string, (PARSER_INT)strlen(test_query_string)) : ENOMEM;
+
+    for ( i = 0; i < COUNTOF(test_query_paths) && !error; i++ )
+    {
+        queries[i] = parser_compile_query(xml, test_query_paths[i].path);
+        if ( !queries[i] )
+        {
+            printf("%s %d: Failed to compile %s\n", __FUNCTION__, __LINE__, test_query_paths[i].path);
+            error = PARSER_RESULT_ERROR;
+            break;
+        }
+
+        error = parser_evaluate_queries(xml, &queries[i], 1, test_query_match, &contexts[i]);
+
+        if ( !error && strcmp(contexts[i].events, test_query_paths[i].expected) )
+        {
+            printf("%s %d: %s matched %s\n", __FUNCTION__, __LINE__, test_query_paths[i].path, contexts[i].events);
+            error = PARSER_RESULT_ERROR;
+        }
+    }
+
+    // All queries in one pass.
+
+    if ( !error )
+    {
+        memset(contexts, 0, COUNTOF(test_query_paths) * sizeof(TEST_SAX_CONTEXT));
+        error = parser_evaluate_queries(xml, queries, COUNTOF(test_query_paths), test_query_match, contexts);
+    }
+
+    for ( i = 0; i < COUNTOF(test_query_paths) && !error; i++ )
+    {
+        if ( strcmp(contexts[i].events, test_query_paths[i].expected) )
+        {
+            printf("%s %d: %s matched %s in one pass\n", __FUNCTION__, __LINE__, test_query_paths[i].path, contexts[i].events);
+            error = PARSER_RESULT_ERROR;
+        }
+    }
+
+    if ( !error && (parser_find_query_element(xml, queries[3]) != xml->first_element->child_element.first_element->child_element.first_element ||
+                    parser_find_query_element(xml, queries[COUNTOF(test_query_paths) - 1])) )
+        error = PARSER_RESULT_ERROR;
+
+    for ( i = 0; i < COUNTOF(invalid_paths) && !error; i++ )
+    {
+        query = parser_compile_query(xml, invalid_paths[i]);
+        if ( query )
+        {
+            printf("%s %d: Invalid path %s was compiled\n", __FUNCTION__, __LINE__, invalid_paths[i]);
+            parser_free_query(query);
+            error = PARSER_RESULT_ERROR;
+        }
+    }
+
+    // Longest path has 63 steps.
+
+    for ( i = 0; i < 64; i++ )
+        memcpy(path + i * 2, "/*", 3);
+
+    query = error ? 0 : parser_compile_query(xml, path);
+    if ( query )
+    {
+        parser_free_query(query);
+        error = PARSER_RESULT_ERROR;
+    }
+
+    path[63 * 2] = 0;
+    query        = error ? 0 : parser_compile_query(xml, path);
+    if ( !error && !query )
+        error = PARSER_RESULT_ERROR;
+
+    parser_free_query(query);
+
+    for ( i = 0; i < COUNTOF(test_query_paths); i++ )
+        parser_free_query(queries[i]);
+
+    free(contexts);
+    parser_free_xml(xml);
+
+    if ( error )
+        return(error);
+
+    // Nested deeper than the masks on the stack. Query and the masks
+    // are allocated with the allocator of the xml.
+
+    allocator_context.allocations = 0;
+    allocator_context.frees       = 0;
+
+    allocator.alloc   = test_allocator_alloc;
+    allocator.free    = test_allocator_free;
+    allocator.realloc = test_allocator_realloc;
+    allocator.context = &allocator_context;
+
+    config.allocator = &allocator;
+
+    xml    = parser_begin_config(&config);
+    string = (PARSER_CHAR*)malloc(300 * 36 + 1);
+
+    if ( !xml || !string )
+    {
+        parser_free_xml(xml);
+        free(string);
+        return(1);
+    }
+
+    for ( i = 0, string[0] = 0; i < 300; i++ )
+        strcat(string, "<element_type_1>");
+
+    for ( i = 0; i < 300; i++ )
+        strcat(string, "</element_type_1>");
+
+    count       = 0;
+    query       = 0;
+    error       = parser_append(xml, string, (PARSER_INT)strlen(string));
+    allocations = allocator_context.allocations;
+
+    if ( !error )
+    {
+        query = parser_compile_query(xml, "//element_type_1//element_type_1");
+        error = query ? parser_evaluate_queries(xml, &query, 1, test_query_count, &count) : PARSER_RESULT_ERROR;
+    }
+
+    if ( !error && count != 299 )
+    {
+        printf("%s %d: Matched %d of 299 nested elements\n", __FUNCTION__, __LINE__, (int)count);
+        error = PARSER_RESULT_ERROR;
+    }
+
+    // Query and two mask arrays.
+
+    if ( !error && allocator_context.allocations - allocations != 3 )
+    {
+        printf("%s %d: Query made %d allocations\n", __FUNCTION__, __LINE__, allocator_context.allocations - allocations);
+        error = PARSER_RESULT_ERROR;
+    }
+
+    parser_free_query(query);
+    parser_free_xml(xml);
+    free(string);
+
+    if ( !error && allocator_context.allocations != allocator_context.frees )
+        error = PARSER_RESULT_ERROR;
+
+    return(error);
+}
+
+// test_filter_case
+// Filters and testElementId of all elements in the filtered tree.
+
+typedef struct test_filter_case
+{
+    const PARSER_CHAR* paths[2];
+    const PARSER_CHAR* expected;
+}
+TEST_FILTER_CASE;
+
+static const TEST_FILTER_CASE test_filter_cases[]=
+{
+    { { "//element_type_3",                      0                              }, "3 4 6 8 10 " },
+    { { "//element_type_2[@intAttribute=3]",     0                              }, "2 3 4 5 6 "  },
+    { { "//element_type_4",                      "//*[@stringAttribute='abc']"  }, "4 7 8 "      },
+    { { "/element_type_1/*[@testElementId>=7]",  0                              }, "7 8 9 10 "   },
+    { { "//no_such_element",                     0                              }, ""            },
+};
+
+// test_filter_match
+// Appends query index and testElementId of the matched element.
+
+static PARSER_ERROR test_filter_match(void* context, PARSER_INT query_index, const PARSER_ELEMENT* element)
+{
+    const PARSER_ATTRIBUTE* attribute;
+    PARSER_INT              id;
+
+    attribute = parser_get_first_element_attribute(element);
+    id        = attribute && (attribute->attribute_type & PARSER_ATTRIBUTE_VALUE_TYPE_INTEGER) ? attribute->attr_val.int_value : -1;
+
+    return(test_sax_append(context, "%d:%d ", (int)query_index, (int)id));
+}
+
+// test_filter_parse
+// Parses test_query_string with filters in pieces of the given size.
+
+static PARSER_ERROR test_filter_parse(PARSER_XML*        xml,
+                                      const PARSER_CHAR* const* paths,
+                                      PARSER_INT         path_count,
+                                      size_t             piece_size,
+                                      PARSER_QUERY_FUNCTION match,
+                                      void*              context)
+{
+    PARSER_QUERY* queries[2];
+    PARSER_ERROR  error;
+    size_t        length;
+    size_t        i;
+
+    length = strlen(test_query_string);
+    error  = 0;
+
+    memset(queries, 0, sizeof(queries));
+
+    for ( i = 0; i < (size_t)path_count && !error; i++ )
+    {
+        queries[i] = parser_compile_query(xml, paths[i]);
+        if ( !queries[i] )
+            error = PARSER_RESULT_ERROR;
+    }
+
+    if ( !error )
+        error = parser_set_filters(xml, queries, path_count, match, context);
+
+    for ( i = 0; i < length && !error; i += piece_size )
+        error = parser_append(xml, test_query_string + i, (PARSER_INT)(length - i < piece_size ? length - i : piece_size));
+
+    // Filters keep the queries until the xml is freed.
+
+    if ( !error )
+        error = parser_set_filters(xml, 0, 0, 0, 0);
+
+    for ( i = 0; i < (size_t)path_count; i++ )
+        parser_free_query(queries[i]);
+
+    return(error);
+}
+
+// test_filter
+// Only matched subtrees are built, in whole and in pieces, with
+// and without arena. Depths are relative to the matched elements.
+// Matches passed to a callback are released.
+
+static PARSER_ERROR test_filter(void)
+{
+    static const PARSER_CHAR* callback_paths[]=
+    {
+        "//element_type_3", "//element_type_2[@intAttribute=3]"
+    };
+
+    const PARSER_ELEMENT*  list[32];
+    TEST_ALLOCATOR_CONTEXT allocator_context;
+    PARSER_ALLOCATOR       allocator;
+    TEST_SAX_CONTEXT       context;
+    PARSER_CONFIG          config;
+    PARSER_XML*            xml;
+    PARSER_QUERY*          query;
+    PARSER_ERROR           error;
+    size_t                 count;
+    size_t                 c;
+    size_t                 i;
+    int                    unfiltered_allocations;
+
+    parser_init_config(&config, test_1_element_names, COUNTOF(test_1_element_names), test_1_attribute_names, COUNTOF(test_1_attribute_names));
+
+    for ( c = 0; c < COUNTOF(test_filter_cases) * 2; c++ )
+    {
+        config.flags = c % 2 ? PARSER_XML_FLAG_ARENA : 0;
+
+        xml = parser_begin_config(&config);
+        if ( !xml )
+            return(1);
+
+        error = test_filter_parse(xml, test_filter_cases[c / 2].paths, test_filter_cases[c / 2].paths[1] ? 2 : 1, c % 2 ? 7 : 4096, 0, 0);
+
+        count = 0;
+        test_collect_elements(xml->first_element, list, &count, COUNTOF(list));
+
+        for ( i = 0; i < count && !error; i++ )
+        {
+            if ( list[i]->depth != (list[i]->parent_element ? list[i]->parent_element->depth + 1 : 1) )
+                error = PARSER_RESULT_ERROR;
+        }
+
+        memset(&context, 0, sizeof(context));
+
+        query = error ? 0 : parser_compile_query(xml, "//*");
+        if ( query )
+            error = parser_evaluate_queries(xml, &query, 1, test_query_match, &context);
+
+        if ( !error && strcmp(context.events, test_filter_cases[c / 2].expected) )
+        {
+            printf("%s %d: %s kept %s\n", __FUNCTION__, __LINE__, test_filter_cases[c / 2].paths[0], context.events);
+            error = PARSER_RESULT_ERROR;
+        }
+
+        parser_free_query(query);
+        parser_free_xml(xml);
+
+        if ( error )
+            return(error);
+    }
+
+    // Matches inside a matched subtree are part of it. Nothing is
+    // left after parsing and all allocations are freed.
+
+    allocator_context.allocations = 0;
+    allocator_context.frees       = 0;
+
+    allocator.alloc   = test_allocator_alloc;
+    allocator.free    = test_allocator_free;
+    allocator.realloc = test_allocator_realloc;
+    allocator.context = &allocator_context;
+
+    config.allocator = &allocator;
+    config.flags     = 0;
+
+    xml = parser_begin_config(&config);
+    if ( !xml )
+        return(1);
+
+    error = parser_append(xml, test_query_string, (PARSER_INT)strlen(test_query_string));
+
+    parser_free_xml(xml);
+
+    unfiltered_allocations        = allocator_context.allocations;
+    allocator_context.allocations = 0;
+    allocator_context.frees       = 0;
+
+    memset(&context, 0, sizeof(context));
+
+    xml = error ? 0 : parser_begin_config(&config);
+    if ( !xml )
+        return(1);
+
+    error = test_filter_parse(xml, callback_paths, COUNTOF(callback_paths), 4096, test_filter_match, &context);
+
+    if ( !error && (xml->first_element || strcmp(context.events, "1:2 0:8 0:10 ")) )
+    {
+        printf("%s %d: Callback got %s\n", __FUNCTION__, __LINE__, context.events);
+        error = PARSER_RESULT_ERROR;
+    }
+
+    parser_free_xml(xml);
+
+    if ( !error && (allocator_context.allocations != allocator_context.frees || allocator_context.allocations >= unfiltered_allocations) )
+    {
+        printf("%s %d: %d allocations, %d frees\n", __FUNCTION__, __LINE__, allocator_context.allocations, allocator_context.frees);
+        error = PARSER_RESULT_ERROR;
+    }
+
+    if ( error )
+        return(error);
+
+    // Filters are set before parsing and only for the tree.
+
+    config.allocator = 0;
+
+    xml   = parser_begin_config(&config);
+    query = xml ? parser_compile_query(xml, "//element_type_3") : 0;
+
+    if ( query )
+    {
+        error = parser_append(xml, test_query_string, 10);
+        if ( !error && parser_set_filters(xml, &query, 1, 0, 0) != EBUSY )
+            error = PARSER_RESULT_ERROR;
+    }
+
+    parser_free_query(query);
+    parser_free_xml(xml);
+
+    xml   = parser_begin_pull(&config);
+    query = xml ? parser_compile_query(xml, "//element_type_3") : 0;
+
+    if ( !error && (!query || parser_set_filters(xml, &query, 1, 0, 0) != EINVAL) )
+        error = PARSER_RESULT_ERROR;
+
+    parser_free_query(query);
+    parser_free_xml(xml);
+
+    return(error);
+}
+
+// test_number_case
+// Expected type and integer value. Float values are compared to
+// strtod().
+
+typedef struct test_number_case
+{
+    const PARSER_CHAR* string;
+    PARSER_INT         type;
+    PARSER_INT64       int_value;
+}
+TEST_NUMBER_CASE;
+
+static const TEST_NUMBER_CASE test_number_cases[]=
+{
+    { "0",                        PARSER_ATTRIBUTE_VALUE_TYPE_INTEGER, 0                   },
+    { "-7",                       PARSER_ATTRIBUTE_VALUE_TYPE_INTEGER, -7                  },
+    { "007",                      PARSER_ATTRIBUTE_VALUE_TYPE_INTEGER, 7                   },
+    { "123456789012345678",       PARSER_ATTRIBUTE_VALUE_TYPE_INTEGER, 123456789012345678  },
+    { "9223372036854775807",      PARSER_ATTRIBUTE_VALUE_TYPE_INTEGER, INT64_MAX           },
+    { "-9223372036854775808",     PARSER_ATTRIBUTE_VALUE_TYPE_INTEGER, INT64_MIN           },
+    { "9223372036854775808",      PARSER_ATTRIBUTE_VALUE_TYPE_FLOAT,   0                   },
+    { "123456789012345678901234", PARSER_ATTRIBUTE_VALUE_TYPE_FLOAT,   0                   },
+    { "1.5",                      PARSER_ATTRIBUTE_VALUE_TYPE_FLOAT,   0                   },
+    { "-0.25",                    PARSER_ATTRIBUTE_VALUE_TYPE_FLOAT,   0                   },
+    { "-0.0",                     PARSER_ATTRIBUTE_VALUE_TYPE_FLOAT,   0                   },
+    { ".5",                       PARSER_ATTRIBUTE_VALUE_TYPE_FLOAT,   0                   },
+    { "5.",                       PARSER_ATTRIBUTE_VALUE_TYPE_FLOAT,   0                   },
+    { "0.1",                      PARSER_ATTRIBUTE_VALUE_TYPE_FLOAT,   0                   },
+    { "1e3",                      PARSER_ATTRIBUTE_VALUE_TYPE_FLOAT,   0                   },
+    { "2.5E-3",                   PARSER_ATTRIBUTE_VALUE_TYPE_FLOAT,   0                   },
+    { "-1.25e+30",                PARSER_ATTRIBUTE_VALUE_TYPE_FLOAT,   0                   },
+    { "12345678.87654321",        PARSER_ATTRIBUTE_VALUE_TYPE_FLOAT,   0                   },
+    { "3.14159265358979323846",   PARSER_ATTRIBUTE_VALUE_TYPE_FLOAT,   0                   },
+    { "0.000000000000000000001",  PARSER_ATTRIBUTE_VALUE_TYPE_FLOAT,   0                   },
+    { "4.9e-324",                 PARSER_ATTRIBUTE_VALUE_TYPE_FLOAT,   0                   },
+    { "1.7976931348623157e308",   PARSER_ATTRIBUTE_VALUE_TYPE_FLOAT,   0                   },
+    { "1e-400",                   PARSER_ATTRIBUTE_VALUE_TYPE_FLOAT,   0                   },
+    { "",                         PARSER_ATTRIBUTE_VALUE_TYPE_STRING,  0                   },
+    { "-",                        PARSER_ATTRIBUTE_VALUE_TYPE_STRING,  0                   },
+    { ".",                        PARSER_ATTRIBUTE_VALUE_TYPE_STRING,  0                   },
+    { "1,5",                      PARSER_ATTRIBUTE_VALUE_TYPE_STRING,  0                   },
+    { "1.2.3",                    PARSER_ATTRIBUTE_VALUE_TYPE_STRING,  0                   },
+    { "1e",                       PARSER_ATTRIBUTE_VALUE_TYPE_STRING,  0                   },
+    { "e1",                       PARSER_ATTRIBUTE_VALUE_TYPE_STRING,  0                   },
+    { "+1",                       PARSER_ATTRIBUTE_VALUE_TYPE_STRING,  0                   },
+    { " 1",                       PARSER_ATTRIBUTE_VALUE_TYPE_STRING,  0                   },
+    { "0x10",                     PARSER_ATTRIBUTE_VALUE_TYPE_STRING,  0                   },
+    { "12345678a",                PARSER_ATTRIBUTE_VALUE_TYPE_STRING,  0                   },
+    { "inf",                      PARSER_ATTRIBUTE_VALUE_TYPE_STRING,  0                   },
+};
+
+// test_number_check
+// Float must be the same double that strtod() returns.
+
+static PARSER_ERROR test_number_check(const PARSER_CHAR* string,
+                                      PARSER_INT         expected_type,
+                                      PARSER_INT64       expected_int)
+{
+    PARSER_INT64  int_value;
+    PARSER_DOUBLE float_value;
+    PARSER_DOUBLE expected_float;
+    PARSER_INT    type;
+
+    int_value   = 0;
+    float_value = 0;
+    type        = parser_parse_number(string, strlen(string), &int_value, &float_value);
+
+    if ( type != expected_type )
+    {
+        printf("%s %d: %s: type %d\n", __FUNCTION__, __LINE__, string, (int)type);
+        return(PARSER_RESULT_ERROR);
+    }
+
+    if ( type == PARSER_ATTRIBUTE_VALUE_TYPE_INTEGER && int_value != expected_int )
+    {
+        printf("%s %d: %s: %" PRId64 "\n", __FUNCTION__, __LINE__, string, int_value);
+        return(PARSER_RESULT_ERROR);
+    }
+
+    expected_float = strtod(string, 0);
+
+    if ( type == PARSER_ATTRIBUTE_VALUE_TYPE_FLOAT && memcmp(&float_value, &expected_float, sizeof(float_value)) )
+    {
+        printf("%s %d: %s: %.17g\n", __FUNCTION__, __LINE__, string, float_value);
+        return(PARSER_RESULT_ERROR);
+    }
+
+    return(0);
+}
+
+// test_number_attributes
+
+static const PARSER_CHAR test_number_string[]=
+{
+"<element_type_1 testElementId=\"-7\" intAttribute=\"5000000000\" floatAttribute=\"-1.5e3\" stringAttribute=\"1,5\"/>"
+};
+
+// test_number_written_string
+
+static const PARSER_CHAR test_number_written_string[]=
+{
+"<element_type_1 testElementId=\"-7\" intAttribute=\"5000000000\" floatAttribute=\"-1500.0\" stringAttribute=\"1,5\"/>"
+"<element_type_2 floatAttribute=\"0.1\" intAttribute=\"1e+300\" stringAttribute=\"3.141592653589793\"/>"
+};
+
+// test_number
+// Decoder results are compared to strtod() and strtoll() for a
+// table, for generated numbers and for long numbers. Typed getters
+// and writing the values back are tested on a parsed tree.
+
+static PARSER_ERROR test_number(void)
+{
+    static const PARSER_CHAR more_string[] = "<element_type_2 floatAttribute=\"0.1\" intAttribute=\"1e300\" stringAttribute=\"3.141592653589793\"/>";
+    static PARSER_CHAR       long_string[1024];
+
+    PARSER_CONFIG           config;
+    PARSER_XML*             xml;
+    const PARSER_ELEMENT*   element;
+    const PARSER_ATTRIBUTE* attribute;
+    PARSER_CHAR             string[64];
+    PARSER_CHAR             buffer[256];
+    PARSER_INT64            int_value;
+    PARSER_DOUBLE           float_value;
+    PARSER_INT              value;
+    PARSER_SIZE             length;
+    PARSER_SIZE             n;
+    PARSER_SIZE             digits;
+    uint32_t                random;
+    PARSER_INT              i;
+    PARSER_ERROR            error;
+
+    for ( n = 0; n < COUNTOF(test_number_cases); n++ )
+    {
+        error = test_number_check(test_number_cases[n].string, test_number_cases[n].type, test_number_cases[n].int_value);
+        if ( error )
+            return(error);
+    }
+
+    // Generated floats with up to 20 digits in both parts and
+    // integers with up to 18 digits.
+
+    for ( i = 0, random = 1; i < 100000; i++ )
+    {
+        length = 0;
+
+        random = random * 1103515245u + 12345u;
+        if ( random & 0x10000 )
+            string[length++] = '-';
+
+        random = random * 1103515245u + 12345u;
+        digits = 1 + (random >> 16) % 20;
+
+        for ( n = 0; n < digits; n++ )
+        {
+            random           = random * 1103515245u + 12345u;
+            string[length++] = (PARSER_CHAR)('0' + (random >> 16) % 10);
+        }
+
+        random = random * 1103515245u + 12345u;
+
+        if ( i % 4 == 0 && digits <= 18 )
+        {
+            string[length] = '\0';
+
+            error = test_number_check(string, PARSER_ATTRIBUTE_VALUE_TYPE_INTEGER, strtoll(string, 0, 10));
+            if ( error )
+                return(error);
+
+            continue;
+        }
+
+        if ( i % 4 != 1 )
+        {
+            string[length++] = '.';
+            digits           = (random >> 16) % 20;
+
+            for ( n = 0; n < digits; n++ )
+            {
+                random           = random * 1103515245u + 12345u;
+                string[length++] = (PARSER_CHAR)('0' + (random >> 16) % 10);
+            }
+        }
+
+        if ( i % 4 != 2 )
+        {
+            random  = random * 1103515245u + 12345u;
+            length += (PARSER_SIZE)sprintf(string + length, "e%d", (int)((random >> 16) % 81) - 40);
+        }
+
+        string[length] = '\0';
+
+        error = test_number_check(string, PARSER_ATTRIBUTE_VALUE_TYPE_FLOAT, 0);
+        if ( error )
+            return(error);
+    }
+
+    // Values longer than the digits passed to strtod(). Halfway
+    // between 1 and the next double rounds up only if a digit after
+    // the zeros is not zero.
+
+    for ( i = 0; i < 6; i++ )
+    {
+        length = 0;
+
+        if ( i < 4 )
+        {
+            length = (PARSER_SIZE)sprintf(long_string, "%s1.00000000000000011102230246251565404236316680908203125", i & 1 ? "-" : "");
+
+            memset(long_string + length, '0', 900);
+            length += 900;
+
+            if ( i & 2 )
+                long_string[length++] = '1';
+        }
+
+        else
+        {
+            if ( i == 5 )
+                long_string[length++] = '.';
+
+            memset(long_string + length, i == 5 ? '0' : '9', 900);
+            length += 900;
+
+            length += (PARSER_SIZE)sprintf(long_string + length, "%s", i == 5 ? "17976931348623157e1209" : "e-600");
+        }
+
+        long_string[length] = '\0';
+
+        error = test_number_check(long_string, PARSER_ATTRIBUTE_VALUE_TYPE_FLOAT, 0);
+        if ( error )
+            return(error);
+    }
+
+    // Typed getters.
+
+    parser_init_config(&config, test_1_element_names, COUNTOF(test_1_element_names), test_1_attribute_names, COUNTOF(test_1_attribute_names));
+
+    xml = parser_begin_config(&config);
+    if ( !xml )
+        return(1);
+
+    error = parser_append(xml, test_number_string, (PARSER_INT)strlen(test_number_string));
+    if ( !error )
+        error = parser_append(xml, more_string, (PARSER_INT)strlen(more_string));
+
+    element = xml->first_element;
+
+    if ( !error )
+    {
+        attribute = parser_find_attribute_by_index(xml, element, 0, 0);
+
+        if ( parser_get_attribute_int_value(attribute, &value) || value != -7 ||
+             parser_get_attribute_double_value(attribute, &float_value) || float_value != -7.0 )
+            error = PARSER_RESULT_ERROR;
+
+        attribute = parser_find_attribute_by_index(xml, element, 0, 1);
+
+        if ( parser_get_attribute_int_value(attribute, &value) != ERANGE ||
+             parser_get_attribute_int64_value(attribute, &int_value) || int_value != 5000000000ll )
+            error = PARSER_RESULT_ERROR;
+
+        attribute = parser_find_attribute_by_index(xml, element, 0, 2);
+
+        if ( parser_get_attribute_type(attribute) != ATTRIBUTE_TYPE_FLOAT ||
+             parser_get_attribute_int64_value(attribute, &int_value) != EINVAL ||
+             parser_get_attribute_double_value(attribute, &float_value) || float_value != -1500.0 )
+            error = PARSER_RESULT_ERROR;
+
+        attribute = parser_find_attribute_by_index(xml, element, 0, 3);
+
+        if ( parser_get_attribute_type(attribute) != ATTRIBUTE_TYPE_STRING ||
+             parser_get_attribute_double_value(attribute, &float_value) != EINVAL )
+            error = PARSER_RESULT_ERROR;
+    }
+
+    // Floats are written back so that they read back the same.
+
+    if ( !error )
+        error = parser_write_xml_to_buffer(xml, buffer, sizeof(buffer), &length, 0);
+
+    if ( !error && strcmp(buffer, test_number_written_string) )
+    {
+        printf("%s %d: Output does not match:\n%s\n", __FUNCTION__, __LINE__, buffer);
+        error = PARSER_RESULT_ERROR;
+    }
+
+    parser_free_xml(xml);
+
+    return(error);
+}
+
+// test_lazy_parse
+
+static PARSER_XML* test_lazy_parse(const PARSER_CHAR*      string,
+                                   PARSER_INT              flags,
+                                   const PARSER_ALLOCATOR* allocator)
+{
+    PARSER_CONFIG config;
+    PARSER_XML*   xml;
+
+    parser_init_config(&config, test_1_element_names, COUNTOF(test_1_element_names), test_1_attribute_names, COUNTOF(test_1_attribute_names));
+
+    config.flags     = flags;
+    config.allocator = allocator;
+
+    xml = parser_begin_config(&config);
+
+    if ( xml && parser_append(xml, string, (PARSER_INT)strlen(string)) )
+    {
+        parser_free_xml(xml);
+        xml = 0;
+    }
+
+    return(xml);
+}
+
+// test_lazy_compare
+// Getters of a lazy tree return the same as the eagerly typed tree.
+// Lazy values are typed by the first getter.
+
+static PARSER_ERROR test_lazy_compare(const PARSER_XML* eager,
+                                      const PARSER_XML* lazy)
+{
+    const PARSER_ELEMENT*   list[2][32];
+    const PARSER_ATTRIBUTE* a;
+    const PARSER_ATTRIBUTE* b;
+    const PARSER_CHAR*      string[2];
+    PARSER_SIZE             length[2];
+    PARSER_INT64            int_value[2];
+    PARSER_DOUBLE           float_value[2];
+    size_t                  count[2];
+    size_t                  i;
+
+    count[0] = 0;
+    count[1] = 0;
+
+    test_collect_elements(eager->first_element, list[0], &count[0], COUNTOF(list[0]));
+    test_collect_elements(lazy->first_element, list[1], &count[1], COUNTOF(list[1]));
+
+    if ( !count[0] || count[0] != count[1] )
+        return(PARSER_RESULT_ERROR);
+
+    for ( i = 0; i < count[0]; i++ )
+    {
+        for ( a = parser_get_first_element_attribute(list[0][i]), b = parser_get_first_element_attribute(list[1][i]); a && b;
+              a = parser_get_next_element_attribute(a), b = parser_get_next_element_attribute(b) )
+        {
+            if ( (a->attribute_type & PARSER_ATTRIBUTE_VALUE_LAZY) || !(b->attribute_type & PARSER_ATTRIBUTE_VALUE_LAZY) ||
+                 parser_get_attribute_type(a) != parser_get_attribute_type(b) || (b->attribute_type & PARSER_ATTRIBUTE_VALUE_LAZY) )
+            {
+                printf("%s %d: Attribute of element %d is not typed on access\n", __FUNCTION__, __LINE__, (int)i);
+                return(PARSER_RESULT_ERROR);
+            }
+
+            int_value[0]   = int_value[1]   = 0;
+            float_value[0] = float_value[1] = 0;
+
+            if ( parser_get_attribute_int64_value(a, &int_value[0]) != parser_get_attribute_int64_value(b, &int_value[1]) ||
+                 parser_get_attribute_double_value(a, &float_value[0]) != parser_get_attribute_double_value(b, &float_value[1]) ||
+                 parser_get_attribute_string_slice(a, &string[0], &length[0]) != parser_get_attribute_string_slice(b, &string[1], &length[1]) ||
+                 int_value[0] != int_value[1] || float_value[0] != float_value[1] || length[0] != length[1] ||
+                 (length[0] && memcmp(string[0], string[1], length[0])) )
+            {
+                printf("%s %d: Attribute of element %d does not match\n", __FUNCTION__, __LINE__, (int)i);
+                return(PARSER_RESULT_ERROR);
+            }
+        }
+
+        if ( a || b )
+            return(PARSER_RESULT_ERROR);
+    }
+
+    return(0);
+}
+
+// test_lazy_values
+// Trees parsed with and without PARSER_XML_FLAG_LAZY_VALUES in
+// malloc, in-situ and arena modes. Untyped values are written back
+// as they were read, and queries type the values they test.
+
+static PARSER_ERROR test_lazy_values(void)
+{
+    static const PARSER_CHAR* strings[] = { test_writer_string, test_number_string };
+    static const PARSER_INT   flags[]   = { 0, PARSER_XML_FLAG_IN_SITU, PARSER_XML_FLAG_ARENA };
+
+    TEST_ALLOCATOR_CONTEXT context[2];
+    PARSER_ALLOCATOR       allocator[2];
+    PARSER_XML*            xml[2];
+    PARSER_QUERY*          query;
+    PARSER_CHAR*           string;
+    PARSER_SIZE            length;
+    size_t                 i;
+    size_t                 j;
+    PARSER_INT             k;
+    int                    written;
+    PARSER_ERROR           error;
+
+    for ( i = 0; i < COUNTOF(strings); i++ )
+    {
+        for ( j = 0; j < COUNTOF(flags); j++ )
+        {
+            for ( k = 0; k < 2; k++ )
+            {
+                context[k].allocations = 0;
+                context[k].frees       = 0;
+
+                allocator[k].alloc   = test_allocator_alloc;
+                allocator[k].free    = test_allocator_free;
+                allocator[k].realloc = test_allocator_realloc;
+                allocator[k].context = &context[k];
+
+                xml[k] = test_lazy_parse(strings[i], flags[j] | (k ? PARSER_XML_FLAG_LAZY_VALUES : 0), &allocator[k]);
+            }
+
+            error   = xml[0] && xml[1] ? 0 : 1;
+            string  = 0;
+            written = context[1].allocations;
+
+            if ( !error && strings[i] == test_writer_string )
+                error = parser_write_xml_to_string(xml[1], &string, &length, PARSER_WRITE_FLAG_PRETTY);
+
+            written = context[1].allocations - written;
+
+            if ( string && strcmp(string, strings[i]) )
+            {
+                printf("%s %d: Output does not match:\n%s\n", __FUNCTION__, __LINE__, string);
+                error = PARSER_RESULT_ERROR;
+            }
+
+            if ( string )
+                allocator[1].free(allocator[1].context, string);
+
+            if ( !error )
+                error = test_lazy_compare(xml[0], xml[1]);
+
+            parser_free_xml(xml[0]);
+            parser_free_xml(xml[1]);
+
+            if ( error )
+                return(error);
+
+            // Copied string values are stored with the attribute. Written
+            // string is not counted.
+
+            if ( context[0].allocations != context[0].frees || context[1].allocations != context[1].frees ||
+                 (!flags[j] && strings[i] == test_writer_string && context[1].allocations - written >= context[0].allocations) )
+            {
+                printf("%s %d: %d and %d allocations\n", __FUNCTION__, __LINE__, context[0].allocations, context[1].allocations);
+                return(PARSER_RESULT_ERROR);
+            }
+        }
+    }
+
+    xml[0] = test_lazy_parse(test_writer_string, PARSER_XML_FLAG_LAZY_VALUES, 0);
+    if ( !xml[0] )
+        return(1);
+
+    query = parser_compile_query(xml[0], "//*[@testElementId=11]");
+    error = query ? 0 : 1;
+
+    if ( !error && parser_find_query_element(xml[0], query) != xml[0]->first_element->child_element.first_element->child_element.first_element )
+        error = PARSER_RESULT_ERROR;
+
+    parser_free_query(query);
+    parser_free_xml(xml[0]);
+
+    return(error);
+}
+
+// Attribute names and declarations of the declared types test.
+
+static const PARSER_XML_NAME test_declared_attribute_names[]=
+{
+    { "id"      },
+    { "size"    },
+    { "ratio"   },
+    { "enabled" },
+    { "kind"    },
+    { "code"    },
+    { "other"   },
+};
+
+static const PARSER_CHAR* const test_declared_kinds[]= { "small", "large" };
+
+static const PARSER_ATTRIBUTE_DECLARATION test_declarations[]=
+{
+    { 0,                   0, PARSER_DECLARED_TYPE_INT32  },
+    { 0,                   0, PARSER_DECLARED_TYPE_INT64  },
+    { 0,                   0, PARSER_DECLARED_TYPE_DOUBLE },
+    { 0,                   0, PARSER_DECLARED_TYPE_BOOL   },
+    { test_declared_kinds, 2, PARSER_DECLARED_TYPE_ENUM   },
+    { 0,                   0, PARSER_DECLARED_TYPE_STRING },
+    { 0,                   0, PARSER_DECLARED_TYPE_NONE   },
+};
+
+// test_declared_string
+
+static const PARSER_CHAR test_declared_string[]=
+{
+"<element_type_1 id=\"007\" size=\"5000000000\" ratio=\"1.0e3\" enabled=\"1\" kind=\"large\" code=\"007\" other=\"42\">"
+"<element_type_2 ratio=\"7\" enabled=\"false\" kind=\"small\"/>"
+"</element_type_1>"
+};
+
+// test_declared_written_string
+
+static const PARSER_CHAR test_declared_written_string[]=
+{
+"<element_type_1 id=\"7\" size=\"5000000000\" ratio=\"1000.0\" enabled=\"true\" kind=\"large\" code=\"007\" other=\"42\">"
+"<element_type_2 ratio=\"7.0\" enabled=\"false\" kind=\"small\"/>"
+"</element_type_1>"
+};
+
+// test_declared_begin
+
+static PARSER_XML* test_declared_begin(const PARSER_ATTRIBUTE_DECLARATION* declarations,
+                                       PARSER_INT                          flags)
+{
+    PARSER_CONFIG config;
+
+    parser_init_config(&config, test_1_element_names, COUNTOF(test_1_element_names), test_declared_attribute_names, COUNTOF(test_declared_attribute_names));
+
+    config.attribute_declarations = declarations;
+    config.flags                  = flags;
+
+    return(parser_begin_config(&config));
+}
+
+// test_declared_types
+// Values are decoded to their declared types, values that do not
+// match are parse errors, and bool and enum values are written and
+// queried by name.
+
+static PARSER_ERROR test_declared_types(void)
+{
+    static const PARSER_CHAR* mismatches[]=
+    {
+        "<element_type_1 id=\"5000000000\"/>",
+        "<element_type_1 id=\"1.5\"/>",
+        "<element_type_1 id=\"\"/>",
+        "<element_type_1 size=\"abc\"/>",
+        "<element_type_1 ratio=\"x\"/>",
+        "<element_type_1 enabled=\"yes\"/>",
+        "<element_type_1 kind=\"medium\"/>",
+    };
+
+    static const PARSER_CHAR* const           no_values[]   = { "a" };
+    static const PARSER_CHAR* const           null_value[]  = { "a", 0 };
+    static const PARSER_CHAR* const           empty_value[] = { "", "b" };
+    static const PARSER_ATTRIBUTE_DECLARATION invalid[][7]  =
+    {
+        { { 0,           0, 99                        } },
+        { { no_values,   0, PARSER_DECLARED_TYPE_ENUM } },
+        { { null_value,  2, PARSER_DECLARED_TYPE_ENUM } },
+        { { empty_value, 2, PARSER_DECLARED_TYPE_ENUM } },
+    };
+
+    const PARSER_ELEMENT*   element;
+    const PARSER_ATTRIBUTE* attribute;
+    const PARSER_CHAR*      string;
+    PARSER_QUERY*           query;
+    PARSER_XML*             xml;
+    PARSER_CHAR             buffer[512];
+    PARSER_INT64            int_value;
+    PARSER_DOUBLE           float_value;
+    PARSER_SIZE             length;
+    PARSER_INT              value;
+    PARSER_INT              flags;
+    size_t                  n;
+    PARSER_ERROR            error;
+
+    for ( flags = 0; flags <= PARSER_XML_FLAG_LAZY_VALUES; flags += PARSER_XML_FLAG_LAZY_VALUES )
+    {
+        xml = test_declared_begin(test_declarations, flags);
+        if ( !xml )
+            return(1);
+
+        error   = parser_append(xml, test_declared_string, (PARSER_INT)strlen(test_declared_string));
+        element = xml->first_element;
+
+        // Only the undeclared value is lazy.
+
+        for ( attribute = element ? element->first_attribute : 0; !error && attribute; attribute = attribute->next_attribute )
+        {
+            if ( !(attribute->attribute_type & PARSER_ATTRIBUTE_VALUE_LAZY) != (!flags || attribute->attr_name.attribute_index != 6) )
+                error = PARSER_RESULT_ERROR;
+        }
+
+        if ( !error &&
+             (parser_get_attribute_int_value(parser_find_attribute_by_index(xml, element, 0, 0), &value) || value != 7 ||
+              parser_get_attribute_int64_value(parser_find_attribute_by_index(xml, element, 0, 1), &int_value) || int_value != 5000000000ll ||
+              parser_get_attribute_type(parser_find_attribute_by_index(xml, element, 0, 2)) != ATTRIBUTE_TYPE_FLOAT ||
+              parser_get_attribute_double_value(parser_find_attribute_by_index(xml, element, 0, 2), &float_value) || float_value != 1000.0 ||
+              parser_get_attribute_int_value(parser_find_attribute_by_index(xml, element, 0, 3), &value) || value != 1 ||
+              parser_get_attribute_int_value(parser_find_attribute_by_index(xml, element, 0, 4), &value) || value != 1 ||
+              parser_get_attribute_string_slice(parser_find_attribute_by_index(xml, element, 0, 5), &string, &length) || length != 3 || memcmp(string, "007", 3) ||
+              parser_get_attribute_int_value(parser_find_attribute_by_index(xml, element, 0, 6), &value) || value != 42) )
+        {
+            printf("%s %d: Declared values do not match\n", __FUNCTION__, __LINE__);
+            error = PARSER_RESULT_ERROR;
+        }
+
+        if ( !error )
+            error = parser_write_xml_to_buffer(xml, buffer, sizeof(buffer), &length, 0);
+
+        if ( !error && strcmp(buffer, test_declared_written_string) )
+        {
+            printf("%s %d: Output does not match:\n%s\n", __FUNCTION__, __LINE__, buffer);
+            error = PARSER_RESULT_ERROR;
+        }
+
+        // Enum and bool names in queries.
+
+        query = error ? 0 : parser_compile_query(xml, "//*[@kind='small'][@enabled='false']");
+
+        if ( !error && (!query || !element || parser_find_query_element(xml, query) != element->child_element.first_element) )
+            error = PARSER_RESULT_ERROR;
+
+        parser_free_query(query);
+        parser_free_xml(xml);
+
+        if ( error )
+            return(error);
+    }
+
+    for ( n = 0; n < COUNTOF(mismatches); n++ )
+    {
+        xml = test_declared_begin(test_declarations, 0);
+        if ( !xml )
+            return(1);
+
+        error = parser_append(xml, mismatches[n], (PARSER_INT)strlen(mismatches[n]));
+
+        parser_free_xml(xml);
+
+        if ( error != EINVAL )
+        {
+            printf("%s %d: %s: %d\n", __FUNCTION__, __LINE__, mismatches[n], (int)error);
+            return(PARSER_RESULT_ERROR);
+        }
+    }
+
+    for ( n = 0; n < COUNTOF(invalid); n++ )
+    {
+        xml = test_declared_begin(invalid[n], 0);
+        if ( xml )
+        {
+            parser_free_xml(xml);
+            return(PARSER_RESULT_ERROR);
+        }
+    }
+
+    return(0);
+}
+
+int main(void)
+{
+    PARSER_ERROR error;
+
+    // Test parsing.
+
+    error = test_parse();
+    if ( error )
+    {
+        printf("Parse test error: %d\n", error);
+        return(error);
+    }
+
+    // Test split parsing.
+
+    error = test_split_parse();
+    if ( error )
+    {
+        printf("Split parse test error: %d\n", error);
+        return(error);
+    }
+
+    // Test arena parsing.
+
+    error = test_arena_parse();
+    if ( error )
+    {
+        printf("Arena parse test error: %d\n", error);
+        return(error);
+    }
+
+    // Test custom allocators.
+
+    error = test_allocator();
+    if ( error )
+    {
+        printf("Allocator test error: %d\n", error);
+        return(error);
+    }
+
+    // Test element finding.
+
+    error = test_find_element();
+    if ( error )
+        return(error);
+
+    error = test_find_element_by_index();
+    if ( error )
+    {
+        printf("Find element by index test error: %d\n", error);
+        return(error);
+    }
+
+    error = test_name_index();
+    if ( error )
+    {
+        printf("Name index test error: %d\n", error);
+        return(error);
+    }
+
+    error = test_tokenizer();
+    if ( error )
+    {
+        printf("Tokenizer test error: %d\n", error);
+        return(error);
+    }
+
+    error = test_in_situ_parse();
+    if ( error )
+    {
+        printf("In-situ parse test error: %d\n", error);
+        return(error);
+    }
+
+    error = test_parse_file();
+    if ( error )
+    {
+        printf("Parse file test error: %d\n", error);
+        return(error);
+    }
+
+    error = test_long_values();
+    if ( error )
+    {
+        printf("Long values test error: %d\n", error);
+        return(error);
+    }
+
+    error = test_sax();
+    if ( error )
+    {
+        printf("SAX test error: %d\n", error);
+        return(error);
+    }
+
+    error = test_pull();
+    if ( error )
+    {
+        printf("Pull test error: %d\n", error);
+        return(error);
+    }
+
+    error = test_document();
+    if ( error )
+    {
+        printf("Document test error: %d\n", error);
+        return(error);
+    }
+
+    error = test_element_index();
+    if ( error )
+    {
+        printf("Element index test error: %d\n", error);
+        return(error);
+    }
+
+    error = test_parallel();
+    if ( error )
+    {
+        printf("Parallel test error: %d\n", error);
+        return(error);
+    }
+
+    error = test_batch();
+    if ( error )
+    {
+        printf("Batch test error: %d\n", error);
+        return(error);
+    }
+
+    error = test_reset();
+    if ( error )
+    {
+        printf("Reset test error: %d\n", error);
+        return(error);
+    }
+
+    error = test_writer();
+    if ( error )
+    {
+        printf("Writer test error: %d\n", error);
+        return(error);
+    }
+
+    error = test_stream_writer();
+    if ( error )
+    {
+        printf("Stream writer test error: %d\n", error);
+        return(error);
+    }
+
+    error = test_writer_float();
+    if ( error )
+    {
+        printf("Writer float test error: %d\n", error);
+        return(error);
+    }
+
+    error = test_query();
+    if ( error )
+    {
+        printf("Query test error: %d\n", error);
+        return(error);
+    }
+
+    error = test_filter();
+    if ( error )
+    {
+        printf("Filter test error: %d\n", error);
+        return(error);
+    }
+
+    error = test_number();
+    if ( error )
+    {
+        printf("Number test error: %d\n", error);
+        return(error);
+    }
+
+    error = test_lazy_values();
+    if ( error )
+    {
+        printf("Lazy values test error: %d\n", error);
+        return(error);
+    }
+
+    error = test_declared_types();
+    if ( error )
+    {
+        printf("Declared types test error: %d\n", error);
+        return(error);
+    }
 
     printf("LIBXML test ok\n");
 
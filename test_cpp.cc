@@ -0,0 +1,202 @@
+/*
+MIT License
+
+Copyright (c) 2018 Velli20
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <cstdio>
+#include <cstring>
+
+#include "xml_parser_cpp_wrapper.h"
+
+using xml_parser::MakeNameTable;
+
+enum class ElementId
+{
+    kElementType1,
+    kElementType2,
+    kElementType3,
+    kElementType4,
+    kElementType5,
+    kElementType6,
+    kElementType7,
+    kElementType8
+};
+
+enum class AttributeId
+{
+    kTestElementId,
+    kIntAttribute,
+    kFloatAttribute,
+    kStringAttribute
+};
+
+enum class RootId
+{
+    kRoot
+};
+
+// Names of test string in test.c.
+
+static constexpr auto kElementNames = MakeNameTable<ElementId>("element_type_1",
+                                                               "element_type_2",
+                                                               "element_type_3",
+                                                               "element_type_4",
+                                                               "element_type_5",
+                                                               "element_type_6",
+                                                               "element_type_7",
+                                                               "element_type_8");
+
+static constexpr auto kAttributeNames = MakeNameTable<AttributeId>("testElementId",
+                                                                   "intAttribute",
+                                                                   "floatAttribute",
+                                                                   "stringAttribute");
+
+static constexpr auto kRootNames = MakeNameTable<RootId>("root");
+
+// Lookups are resolved at compile time.
+
+static_assert(kElementNames.Find("element_type_1") == 0, "first name");
+static_assert(kElementNames.Find("element_type_8") == 7, "last name");
+static_assert(kElementNames.Find("element_type_3") == kElementNames.Index(ElementId::kElementType3), "enum index");
+static_assert(kElementNames.Find("element_type_9") == PARSER_UNKNOWN_INDEX, "same length miss");
+static_assert(kElementNames.Find("element_type_") == PARSER_UNKNOWN_INDEX, "prefix miss");
+static_assert(kElementNames.Find("element_type_1", 9) == PARSER_UNKNOWN_INDEX, "length miss");
+static_assert(kElementNames.Find("") == PARSER_UNKNOWN_INDEX, "empty name");
+static_assert(kElementNames.Count() == 8, "element count");
+
+static_assert(kAttributeNames.Find("stringAttribute") == 3, "attribute name");
+static_assert(kAttributeNames.Find("testElementID") == PARSER_UNKNOWN_INDEX, "attribute miss");
+static_assert(kAttributeNames.Find("") == PARSER_UNKNOWN_INDEX, "empty attribute name");
+
+static_assert(kRootNames.Find("root") == 0, "one name");
+static_assert(kRootNames.Find("rooT") == PARSER_UNKNOWN_INDEX, "one name miss");
+static_assert(kRootNames.Find("") == PARSER_UNKNOWN_INDEX, "one name empty");
+static_assert(kRootNames.Count() == 1, "one name count");
+
+static const PARSER_CHAR parse_test_string[]=
+{
+"<element_type_1 testElementId=\"0\" intAttribute=\"20\" floatAttribute=\"1.230000\" stringAttribute=\"TEST\">\n"
+"  <element_type_2 testElementId=\"1\">\n"
+"    <element_type_3 testElementId=\"11\"/>\n"
+"    <element_type_3 testElementId=\"12\"/>\n"
+"    <element_type_3 testElementId=\"13\"/>\n"
+"    <element_type_3 testElementId=\"14\"/>\n"
+"  </element_type_2>\n"
+"  <element_type_4>\n"
+"    <element_type_5>\n"
+"      <element_type_6 testElementId=\"15\"/>\n"
+"      <element_type_6 testElementId=\"17\"/>\n"
+"    </element_type_5>\n"
+"  </element_type_4>\n"
+"  <element_type_7>\n"
+"    <element_type_8 testElementId=\"18\"/>\n"
+"  </element_type_7>\n"
+"</element_type_1>\n"
+};
+
+// test_name_table_parse
+
+static PARSER_ERROR test_name_table_parse(void)
+{
+    xml_parser::Parser     parser(kElementNames, kAttributeNames);
+    xml_parser::Element*   element;
+    xml_parser::Attribute* attribute;
+    PARSER_INT             count;
+
+    parser.Append(parse_test_string, static_cast<PARSER_INT>(std::strlen(parse_test_string)));
+
+    // Names are resolved by the tables.
+
+    element = parser.FindElement(nullptr, 1, ElementId::kElementType1);
+    if ( !element )
+    {
+        std::printf("%s %d: Element not found.\n", __FUNCTION__, __LINE__);
+        return(PARSER_RESULT_ERROR);
+    }
+
+    attribute = parser.FindElementAttribute(element, nullptr, AttributeId::kIntAttribute);
+    if ( parser.GetAttributeValue(attribute) != 20u )
+    {
+        std::printf("%s %d: Invalid attribute value.\n", __FUNCTION__, __LINE__);
+        return(PARSER_RESULT_ERROR);
+    }
+
+    attribute = parser.FindElementAttribute(element, nullptr, AttributeId::kFloatAttribute);
+    if ( parser.GetAttributeType(attribute) != xml_parser::AttributeType::kFloat )
+    {
+        std::printf("%s %d: Invalid attribute type.\n", __FUNCTION__, __LINE__);
+        return(PARSER_RESULT_ERROR);
+    }
+
+    element = parser.FindElement(nullptr, 2, ElementId::kElementType2);
+    if ( !element )
+    {
+        std::printf("%s %d: Element not found.\n", __FUNCTION__, __LINE__);
+        return(PARSER_RESULT_ERROR);
+    }
+
+    count = 0;
+    for ( element = parser.GetChildElement(element); element; element = parser.GetNextElement(element) )
+    {
+        attribute = parser.FindElementAttribute(element, nullptr, AttributeId::kTestElementId);
+        if ( parser.GetAttributeValue(attribute) != static_cast<std::uint32_t>(11 + count) )
+        {
+            std::printf("%s %d: Invalid attribute value.\n", __FUNCTION__, __LINE__);
+            return(PARSER_RESULT_ERROR);
+        }
+
+        count++;
+    }
+
+    if ( count != 4 )
+    {
+        std::printf("%s %d: Invalid element count %d.\n", __FUNCTION__, __LINE__, count);
+        return(PARSER_RESULT_ERROR);
+    }
+
+    element = parser.FindElement(nullptr, 4, ElementId::kElementType8);
+    if ( !element || std::strcmp(kElementNames.Name(ElementId::kElementType8), "element_type_8") )
+    {
+        std::printf("%s %d: Element not found.\n", __FUNCTION__, __LINE__);
+        return(PARSER_RESULT_ERROR);
+    }
+
+    return(0);
+}
+
+int main(void)
+{
+    PARSER_ERROR error;
+
+    // Test parsing with compile-time name tables.
+
+    error = test_name_table_parse();
+    if ( error )
+    {
+        std::printf("Name table parse test error: %d\n", error);
+        return(error);
+    }
+
+    std::printf("LIBXML C++ test ok\n");
+
+    return(0);
+}
@@ -25,6 +25,8 @@ SOFTWARE.
 // Includes
 
 #include "xml_parser.h"
+#include "xml_parser_internal.h"
+#include "xml_parser_scan.h"
 #include <string.h>
 #if defined(PARSER_INCLUDE_LOG)
 #include <stdio.h>
@@ -35,36 +37,274 @@ SOFTWARE.
 
 // Defines
 
-#define PARSER_STATE_COMMENT_OPEN             0x001
-#define PARSER_STATE_ELEMENT_START_TAG_OPEN   0x002
-#define PARSER_STATE_ATTRIBUTE_VALUE_OPEN     0x004
-#define PARSER_STATE_ELEMENT_NAME_OPEN        0x008
-#define PARSER_STATE_ELEMENT_OPEN             0x010
-#define PARSER_STATE_ATTRIBUTE_NAME_OPEN      0x020
-#define PARSER_STATE_ELEMENT_END_TAG_OPEN     0x040
-#define PARSER_STATE_CONTENT_TYPE_STRING      0x080
-#define PARSER_STATE_XML_PROLOG_OPEN          0x100
-#define PARSER_STATE_PARSE_INT_VALUE          0x200
-#define PARSER_STATE_PARSE_FLOAT_VALUE        0x400
-#define PARSER_STATE_PARSE_STRING_VALUE       0x800
+// Character classes of the tokenizer.
+
+#define PARSER_CLASS_OTHER                    0
+#define PARSER_CLASS_WHITE                    1
+#define PARSER_CLASS_NAME_START               2
+#define PARSER_CLASS_NAME                     3
+#define PARSER_CLASS_DASH                     4
+#define PARSER_CLASS_LT                       5
+#define PARSER_CLASS_GT                       6
+#define PARSER_CLASS_SLASH                    7
+#define PARSER_CLASS_EQUALS                   8
+#define PARSER_CLASS_QUOTE                    9
+#define PARSER_CLASS_EXCLAMATION              10
+#define PARSER_CLASS_QUESTION                 11
+#define PARSER_CLASS_COUNT                    12
+
+// Tokenizer states. Zero state is the error state so that
+// unspecified transitions lead to an error.
+
+#define PARSER_TOKENIZER_ERROR                0
+#define PARSER_TOKENIZER_TEXT                 1
+#define PARSER_TOKENIZER_TEXT_DATA            2
+#define PARSER_TOKENIZER_TAG_OPEN             3
+#define PARSER_TOKENIZER_START_TAG_NAME       4
+#define PARSER_TOKENIZER_START_TAG            5
+#define PARSER_TOKENIZER_ATTRIBUTE_NAME       6
+#define PARSER_TOKENIZER_ATTRIBUTE_NAME_END   7
+#define PARSER_TOKENIZER_ATTRIBUTE_EQUALS     8
+#define PARSER_TOKENIZER_ATTRIBUTE_VALUE      9
+#define PARSER_TOKENIZER_EMPTY_TAG            10
+#define PARSER_TOKENIZER_END_TAG_NAME         11
+#define PARSER_TOKENIZER_END_TAG              12
+#define PARSER_TOKENIZER_MARKUP               13
+#define PARSER_TOKENIZER_MARKUP_DASH          14
+#define PARSER_TOKENIZER_COMMENT              15
+#define PARSER_TOKENIZER_COMMENT_DASH         16
+#define PARSER_TOKENIZER_COMMENT_END          17
+#define PARSER_TOKENIZER_DECLARATION          18
+#define PARSER_TOKENIZER_PROLOG               19
+#define PARSER_TOKENIZER_PROLOG_QUESTION      20
+#define PARSER_TOKENIZER_STATE_COUNT          21
+
+// Tokenizer actions run on transitions.
+
+#define PARSER_ACTION_NONE                    0
+#define PARSER_ACTION_CAPTURE_BEGIN           1
+#define PARSER_ACTION_TEXT_END                2
+#define PARSER_ACTION_ELEMENT_START           3
+#define PARSER_ACTION_ELEMENT_END             4
+#define PARSER_ACTION_ATTRIBUTE_NAME_END      5
+#define PARSER_ACTION_ATTRIBUTE_VALUE_BEGIN   6
+#define PARSER_ACTION_ATTRIBUTE_VALUE_END     7
+#define PARSER_ACTION_CAPTURE_NEXT            8
+#define PARSER_ACTION_END_TAG_NAME            9
+#define PARSER_ACTION_END_TAG_NAME_CLOSE      10
+
+// Run stop character of the state that is replaced with
+// the opening quotation mark of the attribute value.
+
+#define PARSER_RUN_QUOTE                      1
 
 // Macros
 
-#define IS_VALID_NAME_CHARACHTER(C)((C >= '0'  && C <= 'z' && C != '>' && C !='<'))
-#define IS_PARENTHESIS(C)          ((C == '\'' || C == '"'))
-#define IS_ALPHA_CHAR(C)           ((C >= 'a'  && C <= 'z') || (C >= 'A' && C <= 'Z'))
-#define IS_WHITE_CHAR(C)           ((C == ' '  || C == '\0' ||  C =='\r' || C == '\n'))
-#define IS_COMMA_CHAR(C)           ((C == ','  || C == '.'))
-#define IS_NUMERIC_CHAR(C)         ((C >= '0'  && C <= '9'))
-
-#define IS_START_OF_ELEMENT_TAG(CURRENT_CHAR, NEXT_CHAR)    (CURRENT_CHAR == '<' && IS_ALPHA_CHAR(NEXT_CHAR))
-#define IS_START_OF_ELEMENT_END_TAG(CURRENT_CHAR, NEXT_CHAR)(CURRENT_CHAR == '<' && NEXT_CHAR == '/')
-#define IS_END_OF_ELEMENT(CURRENT_CHAR, NEXT_CHAR)          (CURRENT_CHAR == '>' && IS_ALPHA_CHAR(NEXT_CHAR))
-#define IS_END_OF_ELEMENT_NAME(CURRENT_CHAR)                (CURRENT_CHAR == '>' || IS_WHITE_CHAR(CURRENT_CHAR))
-#define IS_START_OF_ATTRIBUTE_NAME(CURRENT_CHAR, NEXT_CHAR) (CURRENT_CHAR == ' ' && IS_ALPHA_CHAR(NEXT_CHAR))
-#define IS_END_OF_ATTRIBUTE_NAME(CURRENT_CHAR)              (CURRENT_CHAR == '=')
-#define IS_START_OF_XML_PROLOG(CURRENT_CHAR, NEXT_CHAR)     (CURRENT_CHAR == '<' && NEXT_CHAR == '?')
-#define IS_END_OF_XML_PROLOG(CURRENT_CHAR, NEXT_CHAR)       (CURRENT_CHAR == '?' && NEXT_CHAR == '>')
+
+#define PARSER_TRANSITION(STATE, ACTION) { PARSER_TOKENIZER_##STATE, PARSER_ACTION_##ACTION }
+
+// Types
+
+typedef struct parser_transition
+{
+    uint8_t next_state;
+    uint8_t action;
+}
+PARSER_TRANSITION;
+
+// parser_character_class
+// Maps each byte to its character class. Bytes above 0x7F are
+// parts of UTF-8 sequences and accepted as name characters.
+
+static const uint8_t parser_character_class[256]=
+{
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 0, 0, 1, 0, 0,   // 0x00
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,   // 0x10
+    1,10, 9, 0, 0, 0, 0, 9, 0, 0, 0, 0, 0, 4, 3, 7,   // 0x20  !"#$%&'()*+,-./
+    3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 2, 0, 5, 8, 6,11,   // 0x30 0123456789:;<=>?
+    0, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2,   // 0x40 @ABCDEFGHIJKLMNO
+    2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 0, 0, 0, 0, 2,   // 0x50 PQRSTUVWXYZ[\]^_
+    0, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2,   // 0x60 `abcdefghijklmno
+    2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 0, 0, 0, 0, 0,   // 0x70 pqrstuvwxyz{|}~
+    2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2,   // 0x80
+    2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2,   // 0x90
+    2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2,   // 0xA0
+    2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2,   // 0xB0
+    2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2,   // 0xC0
+    2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2,   // 0xD0
+    2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2,   // 0xE0
+    2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2,   // 0xF0
+};
+
+// parser_transition_table
+// Next state and action for each state and character class. Columns:
+// other, white, name start, name, dash, <, >, /, =, quote, !, ?
+
+static const PARSER_TRANSITION parser_transition_table[PARSER_TOKENIZER_STATE_COUNT][PARSER_CLASS_COUNT]=
+{
+    // PARSER_TOKENIZER_ERROR
+
+    { PARSER_TRANSITION(ERROR, NONE) },
+
+    // PARSER_TOKENIZER_TEXT: whitespace between elements is skipped.
+
+    { PARSER_TRANSITION(TEXT_DATA, CAPTURE_BEGIN), PARSER_TRANSITION(TEXT,      NONE),       PARSER_TRANSITION(TEXT_DATA, CAPTURE_BEGIN), PARSER_TRANSITION(TEXT_DATA, CAPTURE_BEGIN),
+      PARSER_TRANSITION(TEXT_DATA, CAPTURE_BEGIN), PARSER_TRANSITION(TAG_OPEN,  NONE),       PARSER_TRANSITION(TEXT_DATA, CAPTURE_BEGIN), PARSER_TRANSITION(TEXT_DATA, CAPTURE_BEGIN),
+      PARSER_TRANSITION(TEXT_DATA, CAPTURE_BEGIN), PARSER_TRANSITION(TEXT_DATA, CAPTURE_BEGIN), PARSER_TRANSITION(TEXT_DATA, CAPTURE_BEGIN), PARSER_TRANSITION(TEXT_DATA, CAPTURE_BEGIN) },
+
+    // PARSER_TOKENIZER_TEXT_DATA
+
+    { PARSER_TRANSITION(TEXT_DATA, NONE),       PARSER_TRANSITION(TEXT_DATA, NONE),       PARSER_TRANSITION(TEXT_DATA, NONE),       PARSER_TRANSITION(TEXT_DATA, NONE),
+      PARSER_TRANSITION(TEXT_DATA, NONE),       PARSER_TRANSITION(TAG_OPEN,  TEXT_END),   PARSER_TRANSITION(TEXT_DATA, NONE),       PARSER_TRANSITION(TEXT_DATA, NONE),
+      PARSER_TRANSITION(TEXT_DATA, NONE),       PARSER_TRANSITION(TEXT_DATA, NONE),       PARSER_TRANSITION(TEXT_DATA, NONE),       PARSER_TRANSITION(TEXT_DATA, NONE) },
+
+    // PARSER_TOKENIZER_TAG_OPEN
+
+    { PARSER_TRANSITION(ERROR,     NONE),       PARSER_TRANSITION(ERROR,     NONE),       PARSER_TRANSITION(START_TAG_NAME, CAPTURE_BEGIN), PARSER_TRANSITION(ERROR, NONE),
+      PARSER_TRANSITION(ERROR,     NONE),       PARSER_TRANSITION(ERROR,     NONE),       PARSER_TRANSITION(ERROR,     NONE),       PARSER_TRANSITION(END_TAG_NAME, CAPTURE_NEXT),
+      PARSER_TRANSITION(ERROR,     NONE),       PARSER_TRANSITION(ERROR,     NONE),       PARSER_TRANSITION(MARKUP,    NONE),       PARSER_TRANSITION(PROLOG,    NONE) },
+
+    // PARSER_TOKENIZER_START_TAG_NAME
+
+    { PARSER_TRANSITION(ERROR,     NONE),       PARSER_TRANSITION(START_TAG, ELEMENT_START),   PARSER_TRANSITION(START_TAG_NAME, NONE), PARSER_TRANSITION(START_TAG_NAME, NONE),
+      PARSER_TRANSITION(START_TAG_NAME, NONE),  PARSER_TRANSITION(ERROR,     NONE),       PARSER_TRANSITION(TEXT,      ELEMENT_START), PARSER_TRANSITION(EMPTY_TAG, ELEMENT_START),
+      PARSER_TRANSITION(ERROR,     NONE),       PARSER_TRANSITION(ERROR,     NONE),       PARSER_TRANSITION(ERROR,     NONE),       PARSER_TRANSITION(ERROR,     NONE) },
+
+    // PARSER_TOKENIZER_START_TAG: between attributes.
+
+    { PARSER_TRANSITION(ERROR,     NONE),       PARSER_TRANSITION(START_TAG, NONE),       PARSER_TRANSITION(ATTRIBUTE_NAME, CAPTURE_BEGIN), PARSER_TRANSITION(ERROR, NONE),
+      PARSER_TRANSITION(ERROR,     NONE),       PARSER_TRANSITION(ERROR,     NONE),       PARSER_TRANSITION(TEXT,      NONE), PARSER_TRANSITION(EMPTY_TAG, NONE),
+      PARSER_TRANSITION(ERROR,     NONE),       PARSER_TRANSITION(ERROR,     NONE),       PARSER_TRANSITION(ERROR,     NONE),       PARSER_TRANSITION(ERROR,     NONE) },
+
+    // PARSER_TOKENIZER_ATTRIBUTE_NAME
+
+    { PARSER_TRANSITION(ERROR,     NONE),       PARSER_TRANSITION(ATTRIBUTE_NAME_END, ATTRIBUTE_NAME_END), PARSER_TRANSITION(ATTRIBUTE_NAME, NONE), PARSER_TRANSITION(ATTRIBUTE_NAME, NONE),
+      PARSER_TRANSITION(ATTRIBUTE_NAME, NONE),  PARSER_TRANSITION(ERROR,     NONE),       PARSER_TRANSITION(ERROR,     NONE),       PARSER_TRANSITION(ERROR,     NONE),
+      PARSER_TRANSITION(ATTRIBUTE_EQUALS, ATTRIBUTE_NAME_END), PARSER_TRANSITION(ERROR, NONE), PARSER_TRANSITION(ERROR,     NONE),       PARSER_TRANSITION(ERROR,     NONE) },
+
+    // PARSER_TOKENIZER_ATTRIBUTE_NAME_END
+
+    { PARSER_TRANSITION(ERROR,     NONE),       PARSER_TRANSITION(ATTRIBUTE_NAME_END, NONE), PARSER_TRANSITION(ERROR,  NONE),       PARSER_TRANSITION(ERROR,     NONE),
+      PARSER_TRANSITION(ERROR,     NONE),       PARSER_TRANSITION(ERROR,     NONE),       PARSER_TRANSITION(ERROR,     NONE),       PARSER_TRANSITION(ERROR,     NONE),
+      PARSER_TRANSITION(ATTRIBUTE_EQUALS, NONE), PARSER_TRANSITION(ERROR,    NONE),       PARSER_TRANSITION(ERROR,     NONE),       PARSER_TRANSITION(ERROR,     NONE) },
+
+    // PARSER_TOKENIZER_ATTRIBUTE_EQUALS
+
+    { PARSER_TRANSITION(ERROR,     NONE),       PARSER_TRANSITION(ATTRIBUTE_EQUALS, NONE), PARSER_TRANSITION(ERROR,   NONE),       PARSER_TRANSITION(ERROR,     NONE),
+      PARSER_TRANSITION(ERROR,     NONE),       PARSER_TRANSITION(ERROR,     NONE),       PARSER_TRANSITION(ERROR,     NONE),       PARSER_TRANSITION(ERROR,     NONE),
+      PARSER_TRANSITION(ERROR,     NONE),       PARSER_TRANSITION(ATTRIBUTE_VALUE, ATTRIBUTE_VALUE_BEGIN), PARSER_TRANSITION(ERROR, NONE), PARSER_TRANSITION(ERROR, NONE) },
+
+    // PARSER_TOKENIZER_ATTRIBUTE_VALUE: quotation mark that differs from
+    // the opening one is kept in the value by the action.
+
+    { PARSER_TRANSITION(ATTRIBUTE_VALUE, NONE), PARSER_TRANSITION(ATTRIBUTE_VALUE, NONE), PARSER_TRANSITION(ATTRIBUTE_VALUE, NONE), PARSER_TRANSITION(ATTRIBUTE_VALUE, NONE),
+      PARSER_TRANSITION(ATTRIBUTE_VALUE, NONE), PARSER_TRANSITION(ATTRIBUTE_VALUE, NONE), PARSER_TRANSITION(ATTRIBUTE_VALUE, NONE), PARSER_TRANSITION(ATTRIBUTE_VALUE, NONE),
+      PARSER_TRANSITION(ATTRIBUTE_VALUE, NONE), PARSER_TRANSITION(START_TAG, ATTRIBUTE_VALUE_END), PARSER_TRANSITION(ATTRIBUTE_VALUE, NONE), PARSER_TRANSITION(ATTRIBUTE_VALUE, NONE) },
+
+    // PARSER_TOKENIZER_EMPTY_TAG
+
+    { PARSER_TRANSITION(ERROR,     NONE),       PARSER_TRANSITION(ERROR,     NONE),       PARSER_TRANSITION(ERROR,     NONE),       PARSER_TRANSITION(ERROR,     NONE),
+      PARSER_TRANSITION(ERROR,     NONE),       PARSER_TRANSITION(ERROR,     NONE),       PARSER_TRANSITION(TEXT,      ELEMENT_END), PARSER_TRANSITION(ERROR, NONE),
+      PARSER_TRANSITION(ERROR,     NONE),       PARSER_TRANSITION(ERROR,     NONE),       PARSER_TRANSITION(ERROR,     NONE),       PARSER_TRANSITION(ERROR,     NONE) },
+
+    // PARSER_TOKENIZER_END_TAG_NAME
+
+    { PARSER_TRANSITION(ERROR,     NONE),       PARSER_TRANSITION(END_TAG,   END_TAG_NAME), PARSER_TRANSITION(END_TAG_NAME, NONE), PARSER_TRANSITION(END_TAG_NAME, NONE),
+      PARSER_TRANSITION(END_TAG_NAME, NONE),    PARSER_TRANSITION(ERROR,     NONE),       PARSER_TRANSITION(TEXT,      END_TAG_NAME_CLOSE), PARSER_TRANSITION(ERROR, NONE),
+      PARSER_TRANSITION(ERROR,     NONE),       PARSER_TRANSITION(ERROR,     NONE),       PARSER_TRANSITION(ERROR,     NONE),       PARSER_TRANSITION(ERROR,     NONE) },
+
+    // PARSER_TOKENIZER_END_TAG
+
+    { PARSER_TRANSITION(ERROR,     NONE),       PARSER_TRANSITION(END_TAG,   NONE),       PARSER_TRANSITION(ERROR,     NONE),       PARSER_TRANSITION(ERROR,     NONE),
+      PARSER_TRANSITION(ERROR,     NONE),       PARSER_TRANSITION(ERROR,     NONE),       PARSER_TRANSITION(TEXT,      ELEMENT_END), PARSER_TRANSITION(ERROR,   NONE),
+      PARSER_TRANSITION(ERROR,     NONE),       PARSER_TRANSITION(ERROR,     NONE),       PARSER_TRANSITION(ERROR,     NONE),       PARSER_TRANSITION(ERROR,     NONE) },
+
+    // PARSER_TOKENIZER_MARKUP: after "<!".
+
+    { PARSER_TRANSITION(DECLARATION, NONE),     PARSER_TRANSITION(DECLARATION, NONE),     PARSER_TRANSITION(DECLARATION, NONE),     PARSER_TRANSITION(DECLARATION, NONE),
+      PARSER_TRANSITION(MARKUP_DASH, NONE),     PARSER_TRANSITION(DECLARATION, NONE),     PARSER_TRANSITION(TEXT,      NONE),       PARSER_TRANSITION(DECLARATION, NONE),
+      PARSER_TRANSITION(DECLARATION, NONE),     PARSER_TRANSITION(DECLARATION, NONE),     PARSER_TRANSITION(DECLARATION, NONE),     PARSER_TRANSITION(DECLARATION, NONE) },
+
+    // PARSER_TOKENIZER_MARKUP_DASH: after "<!-".
+
+    { PARSER_TRANSITION(ERROR,     NONE),       PARSER_TRANSITION(ERROR,     NONE),       PARSER_TRANSITION(ERROR,     NONE),       PARSER_TRANSITION(ERROR,     NONE),
+      PARSER_TRANSITION(COMMENT,   NONE),       PARSER_TRANSITION(ERROR,     NONE),       PARSER_TRANSITION(ERROR,     NONE),       PARSER_TRANSITION(ERROR,     NONE),
+      PARSER_TRANSITION(ERROR,     NONE),       PARSER_TRANSITION(ERROR,     NONE),       PARSER_TRANSITION(ERROR,     NONE),       PARSER_TRANSITION(ERROR,     NONE) },
+
+    // PARSER_TOKENIZER_COMMENT
+
+    { PARSER_TRANSITION(COMMENT,   NONE),       PARSER_TRANSITION(COMMENT,   NONE),       PARSER_TRANSITION(COMMENT,   NONE),       PARSER_TRANSITION(COMMENT,   NONE),
+      PARSER_TRANSITION(COMMENT_DASH, NONE),    PARSER_TRANSITION(COMMENT,   NONE),       PARSER_TRANSITION(COMMENT,   NONE),       PARSER_TRANSITION(COMMENT,   NONE),
+      PARSER_TRANSITION(COMMENT,   NONE),       PARSER_TRANSITION(COMMENT,   NONE),       PARSER_TRANSITION(COMMENT,   NONE),       PARSER_TRANSITION(COMMENT,   NONE) },
+
+    // PARSER_TOKENIZER_COMMENT_DASH
+
+    { PARSER_TRANSITION(COMMENT,   NONE),       PARSER_TRANSITION(COMMENT,   NONE),       PARSER_TRANSITION(COMMENT,   NONE),       PARSER_TRANSITION(COMMENT,   NONE),
+      PARSER_TRANSITION(COMMENT_END, NONE),     PARSER_TRANSITION(COMMENT,   NONE),       PARSER_TRANSITION(COMMENT,   NONE),       PARSER_TRANSITION(COMMENT,   NONE),
+      PARSER_TRANSITION(COMMENT,   NONE),       PARSER_TRANSITION(COMMENT,   NONE),       PARSER_TRANSITION(COMMENT,   NONE),       PARSER_TRANSITION(COMMENT,   NONE) },
+
+    // PARSER_TOKENIZER_COMMENT_END: after "--".
+
+    { PARSER_TRANSITION(COMMENT,   NONE),       PARSER_TRANSITION(COMMENT,   NONE),       PARSER_TRANSITION(COMMENT,   NONE),       PARSER_TRANSITION(COMMENT,   NONE),
+      PARSER_TRANSITION(COMMENT_END, NONE),     PARSER_TRANSITION(COMMENT,   NONE),       PARSER_TRANSITION(TEXT,      NONE),       PARSER_TRANSITION(COMMENT,   NONE),
+      PARSER_TRANSITION(COMMENT,   NONE),       PARSER_TRANSITION(COMMENT,   NONE),       PARSER_TRANSITION(COMMENT,   NONE),       PARSER_TRANSITION(COMMENT,   NONE) },
+
+    // PARSER_TOKENIZER_DECLARATION: skipped until '>'.
+
+    { PARSER_TRANSITION(DECLARATION, NONE),     PARSER_TRANSITION(DECLARATION, NONE),     PARSER_TRANSITION(DECLARATION, NONE),     PARSER_TRANSITION(DECLARATION, NONE),
+      PARSER_TRANSITION(DECLARATION, NONE),     PARSER_TRANSITION(DECLARATION, NONE),     PARSER_TRANSITION(TEXT,      NONE),       PARSER_TRANSITION(DECLARATION, NONE),
+      PARSER_TRANSITION(DECLARATION, NONE),     PARSER_TRANSITION(DECLARATION, NONE),     PARSER_TRANSITION(DECLARATION, NONE),     PARSER_TRANSITION(DECLARATION, NONE) },
+
+    // PARSER_TOKENIZER_PROLOG: XML prolog and processing instructions are skipped.
+
+    { PARSER_TRANSITION(PROLOG,    NONE),       PARSER_TRANSITION(PROLOG,    NONE),       PARSER_TRANSITION(PROLOG,    NONE),       PARSER_TRANSITION(PROLOG,    NONE),
+      PARSER_TRANSITION(PROLOG,    NONE),       PARSER_TRANSITION(PROLOG,    NONE),       PARSER_TRANSITION(PROLOG,    NONE),       PARSER_TRANSITION(PROLOG,    NONE),
+      PARSER_TRANSITION(PROLOG,    NONE),       PARSER_TRANSITION(PROLOG,    NONE),       PARSER_TRANSITION(PROLOG,    NONE),       PARSER_TRANSITION(PROLOG_QUESTION, NONE) },
+
+    // PARSER_TOKENIZER_PROLOG_QUESTION
+
+    { PARSER_TRANSITION(PROLOG,    NONE),       PARSER_TRANSITION(PROLOG,    NONE),       PARSER_TRANSITION(PROLOG,    NONE),       PARSER_TRANSITION(PROLOG,    NONE),
+      PARSER_TRANSITION(PROLOG,    NONE),       PARSER_TRANSITION(PROLOG,    NONE),       PARSER_TRANSITION(TEXT,      NONE),       PARSER_TRANSITION(PROLOG,    NONE),
+      PARSER_TRANSITION(PROLOG,    NONE),       PARSER_TRANSITION(PROLOG,    NONE),       PARSER_TRANSITION(PROLOG,    NONE),       PARSER_TRANSITION(PROLOG_QUESTION, NONE) },
+};
+
+// parser_state_run
+// Character that ends a run of characters in the state. Runs
+// are skipped with vector scan without table lookups.
+
+static const PARSER_CHAR parser_state_run[PARSER_TOKENIZER_STATE_COUNT]=
+{
+    0,                  // ERROR
+    0,                  // TEXT
+    '<',                // TEXT_DATA
+    0,                  // TAG_OPEN
+    0,                  // START_TAG_NAME
+    0,                  // START_TAG
+    0,                  // ATTRIBUTE_NAME
+    0,                  // ATTRIBUTE_NAME_END
+    0,                  // ATTRIBUTE_EQUALS
+    PARSER_RUN_QUOTE,   // ATTRIBUTE_VALUE
+    0,                  // EMPTY_TAG
+    0,                  // END_TAG_NAME
+    0,                  // END_TAG
+    0,                  // MARKUP
+    0,                  // MARKUP_DASH
+    '-',                // COMMENT
+    0,                  // COMMENT_DASH
+    0,                  // COMMENT_END
+    '>',                // DECLARATION
+    '?',                // PROLOG
+    0,                  // PROLOG_QUESTION
+};
+
+// parser_state_captures
+// States where characters belong to a token that is
+// collected to the value buffer over buffer boundaries.
+
+static const uint8_t parser_state_captures[PARSER_TOKENIZER_STATE_COUNT]=
+{
+    0, 0, 1, 0, 1, 0, 1, 0, 0, 1, 0, 1, 0, 0, 0, 0, 0, 0, 0, 0, 0
+};
 
 // parser_log
 
@@ -113,50 +353,175 @@ static inline PARSER_INT parser_strncmp(const PARSER_CHAR* str_1,
     return(*str_1 - *str_2);
 }
 
-// parser_strnlen
+// parser_xml_malloc
+// Allocates memory for the xml tree either from the arena
+// or with the allocator of the xml.
+
+static inline void* parser_xml_malloc(PARSER_XML* xml,
+                                      PARSER_SIZE size)
+{
+    if ( xml->flags & PARSER_XML_FLAG_ARENA )
+        return(parser_arena_alloc(&xml->arena, size));
+
+    return(xml->allocator.alloc(xml->allocator.context, size));
+}
+
+// parser_xml_free
+// Arena memory is released all at once in parser_free_xml().
+
+static inline void parser_xml_free(PARSER_XML* xml,
+                                   void*       ptr)
+{
+    if ( xml->flags & PARSER_XML_FLAG_ARENA )
+        return;
+
+    xml->allocator.free(xml->allocator.context, ptr);
+}
+
+// parser_name_hash
+// FNV-1a hash of a name string.
 
-static inline PARSER_SIZE parser_strnlen(const PARSER_CHAR* str,
-                                         PARSER_SIZE        max_length)
+static inline PARSER_UINT32 parser_name_hash(const PARSER_CHAR* name,
+                                             PARSER_SIZE        length)
 {
-    PARSER_SIZE n;
+    PARSER_UINT32 hash;
+    PARSER_SIZE   n;
 
-    for ( n= 0; n < max_length && *str != '\0'; n++, str++ );
+    for ( hash = 2166136261u, n = 0; n < length; n++ )
+    {
+        hash ^= (PARSER_UINT32)(unsigned char)name[n];
+        hash *= 16777619u;
+    }
+
+    return(hash);
+}
 
-    return(n);
+// parser_name_equals
+// Compares null terminated name list string with a name of given length.
+
+static inline PARSER_INT parser_name_equals(const PARSER_CHAR* list_name,
+                                            const PARSER_CHAR* name,
+                                            PARSER_SIZE        length)
+{
+    return(!strncmp(list_name, name, length) && list_name[length] == '\0');
 }
 
-// parser_strncpy
+// parser_build_name_index
+// Builds hash index for name list. Table size is power of two and
+// at least twice the name count so that probe sequences stay short.
 
-static inline PARSER_SIZE parser_strncpy(const PARSER_CHAR* src,
-                                         PARSER_CHAR*       dest,
-                                         PARSER_SIZE        max_length)
+static PARSER_ERROR parser_build_name_index(PARSER_XML*            xml,
+                                            PARSER_NAME_INDEX*     name_index,
+                                            const PARSER_XML_NAME* name_list,
+                                            PARSER_INT             name_list_count)
 {
-    PARSER_SIZE n;
+    PARSER_UINT32 slot_count;
+    PARSER_UINT32 hash;
+    PARSER_UINT32 n;
+    PARSER_INT    i;
+
+    name_index->slots     = 0;
+    name_index->slot_mask = 0;
+
+    if ( !name_list || name_list_count < 1 )
+        return(0);
+
+    for ( slot_count = 8; slot_count < (PARSER_UINT32)name_list_count * 2; slot_count *= 2 );
+
+    name_index->slots = xml->allocator.alloc(xml->allocator.context, sizeof(PARSER_NAME_INDEX_SLOT) * slot_count);
+    if ( !name_index->slots )
+        return(ENOMEM);
+
+    name_index->slot_mask = slot_count - 1;
+
+    for ( n = 0; n < slot_count; n++ )
+        name_index->slots[n].index = PARSER_UNKNOWN_INDEX;
+
+    for ( i = 0; i < name_list_count; i++ )
+    {
+        if ( !name_list[i].name || !*name_list[i].name )
+        {
+            parser_log(__LINE__, __FUNCTION__, "Invalid string at index: %d", i);
+            return(EINVAL);
+        }
+
+        hash = parser_name_hash(name_list[i].name, strlen(name_list[i].name));
+
+        // Keep first occurrence of duplicate names as linear search would.
+
+        for ( n = hash & name_index->slot_mask; name_index->slots[n].index != PARSER_UNKNOWN_INDEX; n = (n + 1) & name_index->slot_mask )
+        {
+            if ( name_index->slots[n].hash == hash && !strcmp(name_list[name_index->slots[n].index].name, name_list[i].name) )
+                break;
+        }
+
+        if ( name_index->slots[n].index != PARSER_UNKNOWN_INDEX )
+            continue;
+
+        name_index->slots[n].hash  = hash;
+        name_index->slots[n].index = i;
+    }
+
+    return(0);
+}
 
-    for ( n= 0; n < max_length && *src != '\0'; *dest++ = *src++ );
+// parser_free_name_index
 
-    *dest= '\0';
+static void parser_free_name_index(PARSER_XML*        xml,
+                                   PARSER_NAME_INDEX* name_index)
+{
+    if ( name_index->slots )
+        xml->allocator.free(xml->allocator.context, name_index->slots);
 
-    return(n);
+    name_index->slots     = 0;
+    name_index->slot_mask = 0;
 }
 
 // find_matching_string_index
 
-static inline PARSER_ERROR find_matching_string_index(const PARSER_CHAR*     name_string,
-                                                      const PARSER_XML_NAME* name_list,
-                                                      PARSER_INT             name_list_count,
-                                                      PARSER_INT*            index)
+static inline PARSER_ERROR find_matching_string_index(const PARSER_CHAR*       name_string,
+                                                      PARSER_SIZE              name_length,
+                                                      const PARSER_XML_NAME*   name_list,
+                                                      PARSER_INT               name_list_count,
+                                                      const PARSER_NAME_INDEX* name_index,
+                                                      PARSER_INT*              index)
 {
-    PARSER_INT i;
+    PARSER_UINT32 hash;
+    PARSER_UINT32 n;
+    PARSER_INT    i;
 
-    if ( !name_string || !*name_string || !index )
+    if ( !name_string || !name_length || !name_list || name_list_count == 0 )
     {
         *index = PARSER_UNKNOWN_INDEX;
         return(0);
     }
 
-    if ( !name_list || name_list_count == 0 )
+    // Use external lookup if provided.
+
+    if ( name_index && name_index->lookup.function )
+    {
+        *index = name_index->lookup.function(name_index->lookup.context, name_string, name_length);
+        if ( *index < 0 || *index >= name_list_count )
+            *index = PARSER_UNKNOWN_INDEX;
+
+        return(0);
+    }
+
+    // Look up from the hash index.
+
+    if ( name_index && name_index->slots )
     {
+        hash = parser_name_hash(name_string, name_length);
+
+        for ( n = hash & name_index->slot_mask; name_index->slots[n].index != PARSER_UNKNOWN_INDEX; n = (n + 1) & name_index->slot_mask )
+        {
+            if ( name_index->slots[n].hash == hash && parser_name_equals(name_list[name_index->slots[n].index].name, name_string, name_length) )
+            {
+                *index = name_index->slots[n].index;
+                return(0);
+            }
+        }
+
         *index = PARSER_UNKNOWN_INDEX;
         return(0);
     }
@@ -171,7 +536,7 @@ static inline PARSER_ERROR find_matching_string_index(const PARSER_CHAR*     nam
 
         // Return index if match is found.
 
-        if ( !parser_strncmp(name_list[i].name, name_string, PARSER_MAX_NAME_STRING_LENGTH) )
+        if ( parser_name_equals(name_list[i].name, name_string, name_length) )
         {
             *index = i;
             return(0);
@@ -183,95 +548,203 @@ static inline PARSER_ERROR find_matching_string_index(const PARSER_CHAR*     nam
     return(0);
 }
 
-// parser_add_new_element
+// parser_shared_element_lookup
+// Name lookup that uses the name index of another xml.
 
-static PARSER_ERROR parser_add_new_element(PARSER_XML*        xml,
-                                           PARSER_ELEMENT*    parent_element,
-                                           const PARSER_CHAR* element_name,
-                                           PARSER_ELEMENT**   inserted_child_element)
+static PARSER_INT parser_shared_element_lookup(const void*        context,
+                                               const PARSER_CHAR* name,
+                                               PARSER_SIZE        length)
 {
-    PARSER_ELEMENT* child_element;
-    PARSER_INT      index;
-#if defined(PARSER_WITH_DYNAMIC_NAMES)
-    PARSER_SIZE     length;
-#endif
-    PARSER_ERROR    error;
+    const PARSER_XML* xml;
+    PARSER_INT        index;
 
-    if ( !xml || !inserted_child_element )
-        return(EINVAL);
+    xml = context;
 
-    *inserted_child_element = 0;
+    if ( find_matching_string_index(name, length, xml->element_name_list, xml->element_name_list_length, &xml->element_name_index, &index) )
+        return(PARSER_UNKNOWN_INDEX);
 
-    // Allocate memory for the element struct.
+    return(index);
+}
 
-    child_element = parser_malloc(sizeof(PARSER_ELEMENT));
-    if ( !child_element )
-    {
-        parser_log(__LINE__, __FUNCTION__, "Parser: Out of memory");
-        return(0);
-    }
+// parser_shared_attribute_lookup
+
+static PARSER_INT parser_shared_attribute_lookup(const void*        context,
+                                                 const PARSER_CHAR* name,
+                                                 PARSER_SIZE        length)
+{
+    const PARSER_XML* xml;
+    PARSER_INT        index;
 
-    memset(child_element, 0, sizeof(PARSER_ELEMENT));
+    xml = context;
 
-    // Link inner element.
+    if ( find_matching_string_index(name, length, xml->attribute_name_list, xml->attribute_name_list_length, &xml->attribute_name_index, &index) )
+        return(PARSER_UNKNOWN_INDEX);
 
-    if ( parent_element )
+    return(index);
+}
+
+// parser_share_name_lookups
+// Sets lookups of the config to use the name indexes of the xml.
+// Index is only read, so parsers on other threads can share it.
+
+void parser_share_name_lookups(const PARSER_XML* xml,
+                               PARSER_CONFIG*    config)
+{
+    config->element_name_lookup.function   = parser_shared_element_lookup;
+    config->element_name_lookup.context    = xml;
+    config->attribute_name_lookup.function = parser_shared_attribute_lookup;
+    config->attribute_name_lookup.context  = xml;
+
+    // External lookups are called directly.
+
+    if ( xml->element_name_index.lookup.function )
+        config->element_name_lookup = xml->element_name_index.lookup;
+
+    if ( xml->attribute_name_index.lookup.function )
+        config->attribute_name_lookup = xml->attribute_name_index.lookup;
+}
+
+// parser_can_borrow
+// Returns non-zero if the token can be stored as a slice of the input.
+// Tokens collected to the value buffer are always copied.
+
+static inline PARSER_INT parser_can_borrow(const PARSER_XML*  xml,
+                                           const PARSER_CHAR* token)
+{
+    return((xml->flags & PARSER_XML_FLAG_IN_SITU) && token != xml->state->temp_value_buffer);
+}
+
+// parser_free_attributes
+
+static void parser_free_attributes(PARSER_XML*       xml,
+                                   PARSER_ATTRIBUTE* attribute)
+{
+    PARSER_ATTRIBUTE* prev_attribute;
+
+    while ( attribute )
     {
-        if ( !parent_element->child_element.first_element )
-        {
-            parent_element->child_element.first_element = child_element;
-        }
+        // Free attribute name string.
 
-        else if ( !parent_element->child_element.last_element )
+        if ( (attribute->attribute_type & PARSER_ATTRIBUTE_NAME_TYPE_STRING) && attribute->attr_name.name_string  )
         {
-            parser_free(child_element);
-            parser_log(__LINE__, __FUNCTION__, "Parser error: last_element == NULL");
-            return(0);
+            parser_xml_free(xml, attribute->attr_name.name_string);
         }
 
-        else
+        // Free attribute value string. Lazy value is stored in the
+        // attribute allocation.
+
+        if ( (attribute->attribute_type & PARSER_ATTRIBUTE_VALUE_TYPE_STRING)    &&
+            !(attribute->attribute_type & PARSER_ATTRIBUTE_VALUE_BORROWED) && attribute->attr_val.string_ptr &&
+             attribute->attr_val.string_ptr != (PARSER_CHAR*)(attribute + 1) )
         {
-            parent_element->child_element.last_element->next_element = child_element;
+            parser_xml_free(xml, attribute->attr_val.string_ptr);
         }
 
-        // Inherit parent element pointer from previous element.
+        prev_attribute = attribute;
+        attribute      = attribute->next_attribute;
 
-        parent_element->child_element.last_element = child_element;
-        child_element->parent_element              = parent_element;
+        parser_xml_free(xml, prev_attribute);
     }
+}
 
-    // Link root element.
+// parser_free_element
 
-    else
+static PARSER_ERROR parser_free_element(PARSER_XML*     xml,
+                                       PARSER_ELEMENT* element)
+{
+    PARSER_ELEMENT* prev_element;
+    PARSER_STRING*  string;
+    PARSER_STRING*  prev_string;
+
+    while ( element )
     {
-        if ( !xml->first_element )
-            xml->first_element = child_element;
+        // Free allocated element name string.
 
-        if ( xml->last_element )
-            xml->last_element->next_element = child_element;
+#if defined(PARSER_WITH_DYNAMIC_NAMES)
 
-        xml->last_element = child_element;
+        if ( element->content_type & PARSER_ELEMENT_NAME_TYPE_STRING && element->elem_name.name_string )
+            parser_xml_free(xml, element->elem_name.name_string);
+
+#endif
+
+        // Free inner element structs.
+
+        if ( element->child_element.first_element )
+            parser_free_element(xml, element->child_element.first_element);
+
+        // Free inner string structs.
+
+        if ( element->child_string.first_string )
+        {
+            string = element->child_string.first_string;
+            while ( string )
+            {
+                prev_string = string;
+                string      = string->next_string;
+
+                if ( prev_string->buffer_size )
+                    parser_xml_free(xml, prev_string->buffer);
+
+                parser_xml_free(xml, prev_string);
+            }
+        }
+
+        // Free attributes.
+
+        parser_free_attributes(xml, element->first_attribute);
+
+        prev_element = element;
+        element      = element->next_element;
+
+        // Free previous element struct.
+
+        parser_xml_free(xml, prev_element);
     }
 
-    *inserted_child_element = child_element;
+    return(0);
+}
 
-    // Find element name index in xml name list.
+// parser_new_element
+// Allocates element that is not yet linked to the tree.
 
-    error = find_matching_string_index(element_name, xml->element_name_list, xml->element_name_list_length, &index);
-    if ( error )
+static PARSER_ERROR parser_new_element(PARSER_XML*        xml,
+                                       const PARSER_CHAR* element_name,
+                                       PARSER_SIZE        length,
+                                       PARSER_INT         index,
+                                       PARSER_ELEMENT**   new_element)
+{
+    PARSER_ELEMENT* element;
+
+#if !defined(PARSER_WITH_DYNAMIC_NAMES)
+
+    // Name string is needed only for unknown names.
+
+    (void)element_name;
+    (void)length;
+
+#endif
+
+    *new_element = 0;
+
+    // Allocate memory for the element struct.
+
+    element = parser_xml_malloc(xml, sizeof(PARSER_ELEMENT));
+    if ( !element )
     {
-        parser_log(__LINE__, __FUNCTION__, "Error %d at finding xml name index", error);
-        return(error);
+        parser_log(__LINE__, __FUNCTION__, "Parser: Out of memory");
+        return(ENOMEM);
     }
 
+    memset(element, 0, sizeof(PARSER_ELEMENT));
+
     // Set element name type to xml name list index.
 
 #if defined(PARSER_WITH_DYNAMIC_NAMES)
     if ( index != PARSER_UNKNOWN_INDEX )
     {
 #endif
-        child_element->elem_name.name_index = index;
-        child_element->content_type         = PARSER_ELEMENT_NAME_TYPE_INDEX;
+        element->elem_name.name_index = index;
+        element->content_type         = PARSER_ELEMENT_NAME_TYPE_INDEX;
 
 #if defined(PARSER_WITH_DYNAMIC_NAMES)
     }
@@ -281,151 +754,321 @@ static PARSER_ERROR parser_add_new_element(PARSER_XML*        xml,
 
 #if defined(PARSER_WITH_DYNAMIC_NAMES)
 
-    else
+    else if ( length < 1 )
     {
-        // Get element name length.
-
-        length = parser_strnlen(element_name, PARSER_MAX_NAME_STRING_LENGTH);
-        if ( length < 1 )
-        {
-            child_element->content_type = PARSER_ELEMENT_NAME_TYPE_NONE;
-            parser_log(__LINE__, __FUNCTION__, "Warning: Element name length < 1");
-            return(0);
-        }
+        element->content_type = PARSER_ELEMENT_NAME_TYPE_NONE;
+        parser_log(__LINE__, __FUNCTION__, "Warning: Element name length < 1");
+    }
 
+    else
+    {
         // Allocate memory for the element name string buffer.
 
-        child_element->elem_name.name_string = parser_malloc(sizeof(PARSER_CHAR) * (length + 1));
-        if ( !child_element->elem_name.name_string )
+        element->elem_name.name_string = parser_xml_malloc(xml, sizeof(PARSER_CHAR) * (length + 1));
+        if ( !element->elem_name.name_string )
         {
-            *inserted_child_element = 0;
+            parser_xml_free(xml, element);
 
             parser_log(__LINE__, __FUNCTION__, "Parser: Out of memory");
-            parser_free(child_element);
             return(ENOMEM);
         }
 
         // Copy element name to buffer.
 
-        parser_strncpy(element_name, child_element->elem_name.name_string, (length + 1));
+        memcpy(element->elem_name.name_string, element_name, length);
+        element->elem_name.name_string[length] = '\0';
 
-        child_element->content_type = PARSER_ELEMENT_NAME_TYPE_STRING;
+        element->content_type = PARSER_ELEMENT_NAME_TYPE_STRING;
     }
 #endif
 
+    *new_element = element;
+
     return(0);
 }
 
-// parser_add_attribute_to_element
+// parser_link_element
+// Links element as the last child of the parent or as the last
+// root element.
 
-static PARSER_ERROR parser_add_attribute_to_element(const PARSER_XML*  xml,
-                                                    PARSER_ELEMENT*    parent_element,
-                                                    const PARSER_CHAR* attribute_name_string,
-                                                    const PARSER_CHAR* attribute_value_string)
+static PARSER_ERROR parser_link_element(PARSER_XML*     xml,
+                                        PARSER_ELEMENT* parent_element,
+                                        PARSER_ELEMENT* child_element)
 {
-    PARSER_ATTRIBUTE* attribute;
-    PARSER_ERROR      error;
-    PARSER_SIZE       length;
-    PARSER_INT        index;
-    PARSER_INT        int_value;
-    PARSER_FLOAT      float_value;
-    PARSER_SIZE       n;
+    // Link inner element.
 
-    if ( !parent_element || !attribute_name_string || !*attribute_name_string || !attribute_value_string || !*attribute_value_string )
+    if ( parent_element )
     {
-        parser_log(__LINE__, __FUNCTION__, "Parser error: Invalid parameter");
-        return(EINVAL);
-    }
-
-    // Check start/stop indexes.
+        if ( !parent_element->child_element.first_element )
+        {
+            parent_element->child_element.first_element = child_element;
+        }
 
-    length = parser_strnlen(attribute_value_string, PARSER_MAX_VALUE_STRING_LENGTH);
-    PARSER_ASSERT(length > 0);
+        else if ( !parent_element->child_element.last_element )
+        {
+            parser_log(__LINE__, __FUNCTION__, "Parser error: last_element == NULL");
+            return(PARSER_RESULT_ERROR);
+        }
 
-    // Find matching XML name index.
+        else
+        {
+            parent_element->child_element.last_element->next_element = child_element;
+        }
 
-    error = find_matching_string_index(attribute_name_string, xml->attribute_name_list, xml->attribute_name_list_length, &index);
-    PARSER_ASSERT(!error);
+        // Inherit parent element pointer from previous element.
 
-    // Allocate memory for element attribute struct.
+        parent_element->child_element.last_element = child_element;
+        child_element->parent_element              = parent_element;
+    }
 
-    attribute = parser_malloc(sizeof(PARSER_ATTRIBUTE));
-    if ( !attribute )
+    // Link root element.
+
+    else
     {
-        parser_log(__LINE__, __FUNCTION__, "Parser: Out of memory");
-        return(ENOMEM);
+        if ( !xml->first_element )
+            xml->first_element = child_element;
+
+        if ( xml->last_element )
+            xml->last_element->next_element = child_element;
+
+        xml->last_element = child_element;
     }
 
-    memset(attribute, 0, sizeof(PARSER_ATTRIBUTE));
+    return(0);
+}
+
+// parser_add_new_element
+
+static PARSER_ERROR parser_add_new_element(PARSER_XML*        xml,
+                                           PARSER_ELEMENT*    parent_element,
+                                           const PARSER_CHAR* element_name,
+                                           PARSER_SIZE        length,
+                                           PARSER_INT         index,
+                                           PARSER_ELEMENT**   inserted_child_element)
+{
+    PARSER_ELEMENT* child_element;
+    PARSER_ERROR    error;
+
+    if ( !xml || !inserted_child_element )
+        return(EINVAL);
 
-    attribute->attribute_type = PARSER_ATTRIBUTE_VALUE_TYPE_INTEGER;
+    *inserted_child_element = 0;
 
-    // Get value data type.
+    error = parser_new_element(xml, element_name, length, index, &child_element);
+    if ( error )
+        return(error);
 
-    for ( n= 0, int_value= 0, float_value= 0; n < length; n++ )
+    error = parser_link_element(xml, parent_element, child_element);
+    if ( error )
     {
-        // Switch data type to float.
+        parser_free_element(xml, child_element);
+        return(error);
+    }
 
-        if ( IS_COMMA_CHAR(attribute_value_string[n]) && attribute->attribute_type != PARSER_ATTRIBUTE_VALUE_TYPE_FLOAT )
-        {
-            attribute->attribute_type = PARSER_ATTRIBUTE_VALUE_TYPE_FLOAT;
+    *inserted_child_element = child_element;
 
-            float_value = int_value;
-            int_value   = 1;
-            continue;
-        }
+    return(0);
+}
+
+// parser_get_declared_type
+
+PARSER_INT parser_get_declared_type(const PARSER_XML* xml,
+                                    PARSER_INT        index)
+{
+    if ( !xml->attribute_declarations || index < 0 || index >= xml->attribute_name_list_length )
+        return(PARSER_DECLARED_TYPE_NONE);
+
+    return(xml->attribute_declarations[index].type);
+}
+
+// parser_decode_declared_value
+
+PARSER_INT parser_decode_declared_value(const PARSER_ATTRIBUTE_DECLARATION* declaration,
+                                        const PARSER_CHAR*                  value,
+                                        PARSER_SIZE                         length,
+                                        PARSER_INT64*                       int_value_ptr,
+                                        PARSER_DOUBLE*                      float_value_ptr)
+{
+    PARSER_INT type;
+    PARSER_INT n;
+
+    switch ( declaration->type )
+    {
+        case PARSER_DECLARED_TYPE_INT32:
+        case PARSER_DECLARED_TYPE_INT64:
+            type = parser_parse_number(value, length, int_value_ptr, float_value_ptr);
+            if ( type != PARSER_ATTRIBUTE_VALUE_TYPE_INTEGER )
+                return(0);
+
+            if ( declaration->type == PARSER_DECLARED_TYPE_INT32 && (*int_value_ptr < INT32_MIN || *int_value_ptr > INT32_MAX) )
+                return(0);
+
+            return(type);
+
+        case PARSER_DECLARED_TYPE_DOUBLE:
+            type = parser_parse_number(value, length, int_value_ptr, float_value_ptr);
+            if ( type == PARSER_ATTRIBUTE_VALUE_TYPE_INTEGER )
+                *float_value_ptr = (PARSER_DOUBLE)*int_value_ptr;
+
+            else if ( type != PARSER_ATTRIBUTE_VALUE_TYPE_FLOAT )
+                return(0);
+
+            return(PARSER_ATTRIBUTE_VALUE_TYPE_FLOAT);
+
+        case PARSER_DECLARED_TYPE_BOOL:
+            if ( (length == 4 && !memcmp(value, "true", 4)) || (length == 1 && *value == '1') )
+                *int_value_ptr = 1;
+
+            else if ( (length == 5 && !memcmp(value, "false", 5)) || (length == 1 && *value == '0') )
+                *int_value_ptr = 0;
+
+            else
+                return(0);
+
+            return(PARSER_ATTRIBUTE_VALUE_TYPE_INTEGER);
+
+        case PARSER_DECLARED_TYPE_ENUM:
+            for ( n = 0; n < declaration->enum_value_count; n++ )
+            {
+                if ( strlen(declaration->enum_values[n]) == length && !memcmp(declaration->enum_values[n], value, length) )
+                {
+                    *int_value_ptr = n;
+                    return(PARSER_ATTRIBUTE_VALUE_TYPE_INTEGER);
+                }
+            }
+
+            return(0);
+
+        default:
+            return(0);
+    }
+}
+
+// parser_add_attribute_to_element
+
+static PARSER_ERROR parser_add_attribute_to_element(PARSER_XML*        xml,
+                                                    PARSER_ELEMENT*    parent_element,
+                                                    const PARSER_CHAR* attribute_name_string,
+                                                    PARSER_SIZE        name_length,
+                                                    PARSER_INT         index,
+                                                    const PARSER_CHAR* attribute_value_string,
+                                                    PARSER_SIZE        length)
+{
+    PARSER_ATTRIBUTE* attribute;
+    PARSER_INT64      int_value;
+    PARSER_DOUBLE     float_value;
+    PARSER_SIZE       inline_length;
+    PARSER_INT        declared_type;
+    PARSER_INT        value_type;
+    PARSER_INT        borrow;
+    PARSER_INT        lazy;
+
+    if ( !parent_element || !attribute_name_string || !name_length || !attribute_value_string )
+    {
+        parser_log(__LINE__, __FUNCTION__, "Parser error: Invalid parameter");
+        return(EINVAL);
+    }
+
+    // Declared value is decoded before anything is allocated.
 
-        // Switch data type to string.
+    declared_type = parser_get_declared_type(xml, index);
+    value_type    = PARSER_ATTRIBUTE_VALUE_TYPE_STRING;
+    int_value     = 0;
+    float_value   = 0;
 
-        else if ( !IS_NUMERIC_CHAR(attribute_value_string[n]) )
+    if ( declared_type != PARSER_DECLARED_TYPE_NONE && declared_type != PARSER_DECLARED_TYPE_STRING )
+    {
+        value_type = parser_decode_declared_value(&xml->attribute_declarations[index], attribute_value_string, length, &int_value, &float_value);
+        if ( !value_type )
         {
-            attribute->attribute_type = PARSER_ATTRIBUTE_VALUE_TYPE_STRING;
-            break;
+            parser_log(__LINE__, __FUNCTION__, "Error: Value of attribute %d does not match its declared type", (int)index);
+            return(EINVAL);
         }
+    }
+
+    // Lazy value that is not borrowed is stored after the
+    // attribute struct in the same allocation.
+
+    lazy          = (xml->flags & PARSER_XML_FLAG_LAZY_VALUES) && declared_type == PARSER_DECLARED_TYPE_NONE;
+    borrow        = parser_can_borrow(xml, attribute_value_string);
+    inline_length = lazy && !borrow ? length + 1 : 0;
+
+    // Allocate memory for element attribute struct.
+
+    attribute = parser_xml_malloc(xml, sizeof(PARSER_ATTRIBUTE) + inline_length);
+    if ( !attribute )
+    {
+        parser_log(__LINE__, __FUNCTION__, "Parser: Out of memory");
+        return(ENOMEM);
+    }
+
+    memset(attribute, 0, sizeof(PARSER_ATTRIBUTE));
 
-        // Parse float.
+    // Value is an integer, a float or a string. Empty value
+    // is a string. Lazy value is typed on first access.
 
-        if ( attribute->attribute_type == PARSER_ATTRIBUTE_VALUE_TYPE_FLOAT )
+    if ( lazy )
+    {
+        attribute->attribute_type = PARSER_ATTRIBUTE_VALUE_TYPE_STRING | PARSER_ATTRIBUTE_VALUE_LAZY;
+        attribute->value_length   = (PARSER_INT)length;
+
+        if ( borrow )
         {
-            float_value += (PARSER_FLOAT)((PARSER_FLOAT)(attribute_value_string[n] - '0') / (PARSER_FLOAT)(int_value * 10));
-            int_value   *= 10;
+            attribute->attribute_type        |= PARSER_ATTRIBUTE_VALUE_BORROWED;
+            attribute->attr_val.string_slice  = attribute_value_string;
         }
 
-        // Parse integer.
-
         else
         {
-            int_value *= 10;
-            int_value += attribute_value_string[n] - '0';
+            attribute->attr_val.string_ptr = (PARSER_CHAR*)(attribute + 1);
+
+            memcpy(attribute->attr_val.string_ptr, attribute_value_string, length);
+            attribute->attr_val.string_ptr[length] = '\0';
         }
     }
 
-    // Copy parsed float/integer value to attribute struct.
-
-    if ( attribute->attribute_type == PARSER_ATTRIBUTE_VALUE_TYPE_FLOAT )
+    else if ( declared_type == PARSER_DECLARED_TYPE_NONE )
     {
-        attribute->attr_val.float_value = float_value;
+        attribute->attribute_type = parser_parse_number(attribute_value_string, length, &attribute->attr_val.int_value, &attribute->attr_val.float_value);
     }
 
-    else if ( attribute->attribute_type == PARSER_ATTRIBUTE_VALUE_TYPE_INTEGER )
+    else
     {
-        attribute->attr_val.int_value = int_value;
-    }
+        attribute->attribute_type = value_type;
 
-    // Copy full string value.
+        if ( value_type == PARSER_ATTRIBUTE_VALUE_TYPE_INTEGER )
+            attribute->attr_val.int_value = int_value;
 
-    else
+        else if ( value_type == PARSER_ATTRIBUTE_VALUE_TYPE_FLOAT )
+            attribute->attr_val.float_value = float_value;
+    }
+
+    if ( attribute->attribute_type == PARSER_ATTRIBUTE_VALUE_TYPE_STRING )
     {
-        // Allocate memory for the value string.
+        attribute->value_length = (PARSER_INT)length;
+
+        // Store slice of the input in in-situ mode.
 
-        attribute->attr_val.string_ptr = parser_malloc(((PARSER_SIZE)(length + 1)) * sizeof(PARSER_CHAR));
-        if ( !attribute->attr_val.string_ptr )
+        if ( borrow )
         {
-            parser_log(__LINE__, __FUNCTION__, "Parser error: Out of memory.");
-            return(ENOMEM);
+            attribute->attribute_type        |= PARSER_ATTRIBUTE_VALUE_BORROWED;
+            attribute->attr_val.string_slice  = attribute_value_string;
         }
 
-        parser_strncpy(attribute_value_string, attribute->attr_val.string_ptr, length + 1);
+        // Allocate memory for the value string.
+
+        else
+        {
+            attribute->attr_val.string_ptr = parser_xml_malloc(xml, ((PARSER_SIZE)(length + 1)) * sizeof(PARSER_CHAR));
+            if ( !attribute->attr_val.string_ptr )
+            {
+                parser_log(__LINE__, __FUNCTION__, "Parser error: Out of memory.");
+                return(ENOMEM);
+            }
+
+            memcpy(attribute->attr_val.string_ptr, attribute_value_string, length);
+            attribute->attr_val.string_ptr[length] = '\0';
+        }
     }
 
     // Link attribute to parent element.
@@ -443,19 +1086,8 @@ static PARSER_ERROR parser_add_attribute_to_element(const PARSER_XML*  xml,
 
     if ( index == PARSER_UNKNOWN_INDEX )
     {
-        // Get attribute name length.
-
-        length = parser_strnlen(attribute_name_string, PARSER_MAX_NAME_STRING_LENGTH);
-        if ( length < 1 )
-        {
-            parser_log(__LINE__, __FUNCTION__, "Parser warning: Attribute length < 1.");
-            attribute->attribute_type|= PARSER_ATTRIBUTE_NAME_TYPE_NONE;
-
-            return(0);
-        }
-
         attribute->attribute_type        |= PARSER_ATTRIBUTE_NAME_TYPE_STRING;
-        attribute->attr_name.name_string  = parser_malloc(sizeof(PARSER_CHAR) * (length + 1));
+        attribute->attr_name.name_string  = parser_xml_malloc(xml, sizeof(PARSER_CHAR) * (name_length + 1));
 
         if ( !attribute->attr_name.name_string )
         {
@@ -463,7 +1095,8 @@ static PARSER_ERROR parser_add_attribute_to_element(const PARSER_XML*  xml,
             return(ENOMEM);
         }
 
-        parser_strncpy(attribute_name_string, attribute->attr_name.name_string, length + 1);
+        memcpy(attribute->attr_name.name_string, attribute_name_string, name_length);
+        attribute->attr_name.name_string[name_length] = '\0';
     }
 
     // No need to copy attrbute name string.
@@ -479,42 +1112,53 @@ static PARSER_ERROR parser_add_attribute_to_element(const PARSER_XML*  xml,
 
 // parser_copy_element_content_string
 
-static PARSER_ERROR parser_copy_element_content_string(PARSER_ELEMENT*    owner_element,
-                                                       const PARSER_CHAR* buffer)
+static PARSER_ERROR parser_copy_element_content_string(PARSER_XML*        xml,
+                                                       PARSER_ELEMENT*    owner_element,
+                                                       const PARSER_CHAR* buffer,
+                                                       PARSER_SIZE        length)
 {
     PARSER_STRING* string;
-    PARSER_SIZE    length;
 
     PARSER_ASSERT(owner_element);
     PARSER_ASSERT(buffer);
-
-    // Get content string length.
-
-    length = parser_strnlen(buffer, PARSER_MAX_VALUE_STRING_LENGTH);
     PARSER_ASSERT(length > 0);
 
     // Allocate memory for the string struct.
 
-    string = parser_malloc(sizeof(PARSER_STRING));
+    string = parser_xml_malloc(xml, sizeof(PARSER_STRING));
     if ( !string )
         return(ENOMEM);
 
-    // Allocate memory for content string.
+    string->length      = length;
+    string->next_string = 0;
+
+    // Store slice of the input in in-situ mode.
 
-    string->buffer = parser_malloc(sizeof(PARSER_CHAR) * ((PARSER_SIZE)(length + 1)));
-    if ( !string->buffer )
+    if ( parser_can_borrow(xml, buffer) )
     {
-        parser_free(string);
-        parser_log(__LINE__, __FUNCTION__, "Parser error: Out of memory.");
-        return(EXIT_FAILURE);
+        string->buffer      = (PARSER_CHAR*)buffer;
+        string->buffer_size = 0;
     }
 
-    // Copy element inner content.
+    else
+    {
+        // Allocate memory for content string.
+
+        string->buffer = parser_xml_malloc(xml, sizeof(PARSER_CHAR) * ((PARSER_SIZE)(length + 1)));
+        if ( !string->buffer )
+        {
+            parser_xml_free(xml, string);
+            parser_log(__LINE__, __FUNCTION__, "Parser error: Out of memory.");
+            return(ENOMEM);
+        }
+
+        // Copy element inner content.
 
-    parser_strncpy(buffer, string->buffer, length + 1);
+        memcpy(string->buffer, buffer, length);
+        string->buffer[length] = '\0';
 
-    string->buffer_size = length + 1;
-    string->next_string = 0;
+        string->buffer_size = length + 1;
+    }
 
     // Link first string struct to owner element.
 
@@ -529,90 +1173,74 @@ static PARSER_ERROR parser_copy_element_content_string(PARSER_ELEMENT*    owner_
     return(0);
 }
 
-// parser_free_element
+// parser_arm_state
+// Sets parser state to the beginning of a document. Scratch
+// buffers are kept.
 
-static PARSER_ERROR parser_free_element(PARSER_ELEMENT* element)
+static void parser_arm_state(PARSER_STATE* state)
 {
-    PARSER_ATTRIBUTE* attribute;
-    PARSER_ATTRIBUTE* prev_attribute;
-    PARSER_ELEMENT*   prev_element;
-    PARSER_STRING*    string;
-    PARSER_STRING*    prev_string;
-
-    while ( element )
-    {
-        // Free allocated element name string.
-
-#if defined(PARSER_WITH_DYNAMIC_NAMES)
-
-        if ( element->content_type & PARSER_ELEMENT_NAME_TYPE_STRING && element->elem_name.name_string )
-            parser_free(element->elem_name.name_string);
-
-#endif
-
-        // Free inner element structs.
-
-        if ( element->child_element.first_element )
-            parser_free_element(element->child_element.first_element);
-
-        // Free inner string structs.
-
-        if ( element->child_string.first_string )
-        {
-            string = element->child_string.first_string;
-            while ( string )
-            {
-                prev_string = string;
-                string      = string->next_string;
-
-                parser_free(prev_string->buffer);
-                parser_free(prev_string);
-            }
-        }
-
-        // Free attributes.
+    state->element         = 0;
+    state->capture_start   = 0;
+    state->closed_element  = 0;
+    state->closed_count    = 0;
+    state->tokenizer_state = PARSER_TOKENIZER_TEXT;
+    state->depth           = 0;
+    state->name_index      = PARSER_UNKNOWN_INDEX;
+    state->name_buf_pos    = 0;
+    state->value_buf_pos   = 0;
+    state->quote_char      = 0;
+    state->input           = 0;
+    state->input_length    = 0;
+    state->input_position  = 0;
+    state->token_ready     = 0;
+    state->skip_depth      = 0;
+    state->filter_depth    = 0;
+    state->filter_pending  = 0;
+
+    memset(&state->token, 0, sizeof(PARSER_TOKEN));
+}
 
-        if ( element->first_attribute )
-        {
-            attribute = element->first_attribute;
-            while ( attribute )
-            {
-                // Free attribute name string.
+// parser_new_state
+// Allocates parser state without scratch buffers.
 
-                if ( (attribute->attribute_type & PARSER_ATTRIBUTE_NAME_TYPE_STRING) && attribute->attr_name.name_string  )
-                {
-                    parser_free(attribute->attr_name.name_string);
-                }
+static PARSER_ERROR parser_new_state(PARSER_XML* xml)
+{
+    xml->state = parser_xml_malloc(xml, sizeof(PARSER_STATE));
+    if ( !xml->state )
+        return(ENOMEM);
 
-                // Free attribute value string.
+    xml->state->temp_name_buffer       = 0;
+    xml->state->temp_value_buffer      = 0;
+    xml->state->temp_name_buffer_size  = 0;
+    xml->state->temp_value_buffer_size = 0;
 
-                if ( (attribute->attribute_type & PARSER_ATTRIBUTE_VALUE_TYPE_STRING) && attribute->attr_val.string_ptr )
-                {
-                    parser_free(attribute->attr_val.string_ptr);
-                }
+    parser_arm_state(xml->state);
 
-                prev_attribute = attribute;
-                attribute      = attribute->next_attribute;
+    return(0);
+}
 
-                parser_free(prev_attribute);
-            }
-        }
+// parser_free_state
+// Frees parser state and its scratch buffers.
 
-        prev_element = element;
-        element      = element->next_element;
+static void parser_free_state(PARSER_XML*   xml,
+                              PARSER_STATE* state)
+{
+    if ( !state )
+        return;
 
-        // Free previous element struct.
+    if ( state->temp_name_buffer )
+        xml->allocator.free(xml->allocator.context, state->temp_name_buffer);
 
-        parser_free(prev_element);
-    }
+    if ( state->temp_value_buffer )
+        xml->allocator.free(xml->allocator.context, state->temp_value_buffer);
 
-    return(0);
+    parser_xml_free(xml, state);
 }
 
 // parser_finalize
-// Called after xml parsing is completed. Memory alloctated
-// for parser state is freed and xml struct becomes no longer
-// valid for parsing.
+// Called after xml parsing is completed. Xml struct becomes no
+// longer valid for parsing. Parser state and its scratch buffers
+// are kept for parser_reset() and freed by parser_free_xml().
 
 PARSER_ERROR parser_finalize(PARSER_XML* xml)
 {
@@ -622,11 +1250,15 @@ PARSER_ERROR parser_finalize(PARSER_XML* xml)
     if ( !xml->state )
         return(0);
 
-    // Free xml state.
+    // Element that waits for a filter decision is not in the tree.
 
-    parser_free(xml->state);
+    if ( xml->state->filter_pending )
+        parser_free_element(xml, xml->state->element);
 
-    xml->state= 0;
+    xml->state->filter_pending = 0;
+
+    xml->finalized_state = xml->state;
+    xml->state           = 0;
 
     return(0);
 }
@@ -646,448 +1278,1494 @@ PARSER_ERROR parser_free_xml(PARSER_XML* xml)
     if ( error )
         return(error);
 
+    parser_free_state(xml, xml->finalized_state);
+    parser_free_name_index(xml, &xml->element_name_index);
+    parser_free_name_index(xml, &xml->attribute_name_index);
+
+    parser_release_file(xml);
+    parser_free_document(xml);
+    parser_free_filter(xml);
+
+    if ( xml->elements_by_name )
+        parser_xml_free(xml, xml->elements_by_name);
+
+    // Release whole arena at once. XML struct itself is allocated
+    // from the arena.
+
+    if ( xml->flags & PARSER_XML_FLAG_ARENA )
+    {
+        parser_arena_release(&xml->arena);
+        return(0);
+    }
+
     // Free all buffers.
 
-    error = parser_free_element(xml->first_element);
+    error = parser_free_element(xml, xml->first_element);
     if ( error )
         return(error);
 
     // Free xml struct.
 
-    parser_free(xml);
+    xml->allocator.free(xml->allocator.context, xml);
 
     return(0);
 }
 
-// parser_begin
-// Returns new xml struct fith initialized parser state.
-// XML struct must be freed after it is no longer needed
-// anymore with parser_free_xml() function.
+// parser_reset
+// Releases the parsed tree or document and prepares the xml for the
+// next document. Name indexes, scratch buffers and the arena blocks
+// are kept, so parsing the next document needs no setup. State of
+// a finalized xml is armed again.
 
-PARSER_XML* parser_begin(const PARSER_XML_NAME* element_name_list,
-                         PARSER_INT             element_name_list_length,
-                         const PARSER_XML_NAME* attribute_name_list,
-                         PARSER_INT             attribute_name_list_length)
+PARSER_ERROR parser_reset(PARSER_XML* xml)
 {
-    PARSER_XML* xml;
+    PARSER_ERROR error;
 
-#if !defined(PARSER_WITH_DYNAMIC_NAMES)
+    if ( !xml )
+        return(EINVAL);
 
-    // Check element name list.
+    parser_release_file(xml);
+    parser_reset_document(xml);
 
-    if ( !element_name_list || element_name_list_length < 1 )
-    {
-        parser_log(__LINE__, __FUNCTION__, "Error: No xml element name list.");
-        return(0);
-    }
+    if ( xml->state && xml->state->filter_pending )
+        parser_free_element(xml, xml->state->element);
 
-#endif
+    if ( xml->elements_by_name )
+        memset(xml->elements_by_name, 0, sizeof(PARSER_CHILD_ELEMENT) * (PARSER_SIZE)xml->element_name_list_length);
 
-    // Allocate memory for xml struct.
+    // Arena memory of the tree is released at once.
 
-    xml = parser_malloc(sizeof(PARSER_XML));
-    if ( !xml )
+    if ( xml->flags & PARSER_XML_FLAG_ARENA )
     {
-        parser_log(__LINE__, __FUNCTION__, "Error: Out of memory while allocating xml struct");
-        return(0);
+        parser_arena_rewind(&xml->arena, xml->arena_mark_block, xml->arena_mark);
+    }
+
+    else
+    {
+        error = parser_free_element(xml, xml->first_element);
+        if ( error )
+            return(error);
     }
 
     xml->first_element = 0;
     xml->last_element  = 0;
 
-    // Allocate memory for xml parser state.
-
-    xml->state = parser_malloc(sizeof(PARSER_STATE));
     if ( !xml->state )
     {
-        parser_log(__LINE__, __FUNCTION__, "Error: Out of memory while allocating xml parser state");
-        parser_free(xml);
+        xml->state           = xml->finalized_state;
+        xml->finalized_state = 0;
     }
 
-    xml->state->flags          = 0;
-    xml->state->name_buf_pos   = 0;
-    xml->state->value_buf_pos  = 0;
-    xml->state->previous_char  = 0;
-    xml->state->current_char   = 0;
-    xml->state->next_char      = 0;
-    xml->state->element        = 0;
-    xml->state->parent_element = 0;
+    parser_arm_state(xml->state);
 
-    xml->element_name_list          = element_name_list;
-    xml->element_name_list_length   = element_name_list_length;
-    xml->attribute_name_list        = attribute_name_list;
-    xml->attribute_name_list_length = attribute_name_list_length;
-
-    return(xml);
+    return(0);
 }
 
-// parser_append
+// parser_init_config
+// Initializes config with given name lists and default options.
 
-PARSER_ERROR parser_append(PARSER_XML*        xml,
-                           const PARSER_CHAR* xml_string,
-                           PARSER_INT         xml_string_length)
+void parser_init_config(PARSER_CONFIG*         config,
+                        const PARSER_XML_NAME* element_name_list,
+                        PARSER_INT             element_name_list_length,
+                        const PARSER_XML_NAME* attribute_name_list,
+                        PARSER_INT             attribute_name_list_length)
 {
-    PARSER_INT   i;
-    PARSER_ERROR error;
+    if ( !config )
+        return;
 
-    // Check input string...
+    memset(config, 0, sizeof(PARSER_CONFIG));
+
+    config->element_name_list          = element_name_list;
+    config->element_name_list_length   = element_name_list_length;
+    config->attribute_name_list        = attribute_name_list;
+    config->attribute_name_list_length = attribute_name_list_length;
+}
+
+// parser_check_declarations
+// Enum needs at least one value and every value must be a
+// non-empty string.
+
+static PARSER_ERROR parser_check_declarations(const PARSER_CONFIG* config)
+{
+    const PARSER_ATTRIBUTE_DECLARATION* declaration;
+    PARSER_INT                          n;
+    PARSER_INT                          i;
+
+    if ( !config->attribute_declarations )
+        return(0);
+
+    for ( n = 0; n < config->attribute_name_list_length; n++ )
+    {
+        declaration = &config->attribute_declarations[n];
+
+        if ( declaration->type < PARSER_DECLARED_TYPE_NONE || declaration->type > PARSER_DECLARED_TYPE_STRING )
+            return(EINVAL);
+
+        if ( declaration->type != PARSER_DECLARED_TYPE_ENUM )
+            continue;
+
+        if ( !declaration->enum_values || declaration->enum_value_count < 1 )
+            return(EINVAL);
+
+        for ( i = 0; i < declaration->enum_value_count; i++ )
+        {
+            if ( !declaration->enum_values[i] || !declaration->enum_values[i][0] )
+                return(EINVAL);
+        }
+    }
+
+    return(0);
+}
+
+// parser_begin_config
+// Returns new xml struct with initialized parser state. Memory
+// of the xml is allocated with the allocator given in config, and
+// bump-allocated from an arena if PARSER_XML_FLAG_ARENA is set.
+// Arena uses optional arena_region first and then chains new blocks
+// of PARSER_ARENA_BLOCK_SIZE bytes. Region must stay valid until
+// parser_free_xml() that releases all arena memory at once.
+
+PARSER_XML* parser_begin_config(const PARSER_CONFIG* config)
+{
+    const PARSER_ALLOCATOR* allocator;
+    PARSER_XML*             xml;
+
+    if ( !config )
+        return(0);
+
+#if !defined(PARSER_WITH_DYNAMIC_NAMES)
+
+    // Check element name list.
+
+    if ( !config->element_name_list || config->element_name_list_length < 1 )
+    {
+        parser_log(__LINE__, __FUNCTION__, "Error: No xml element name list.");
+        return(0);
+    }
+
+#endif
+
+    allocator = config->allocator ? config->allocator : &parser_default_allocator;
+
+    if ( !allocator->alloc || !allocator->free )
+    {
+        parser_log(__LINE__, __FUNCTION__, "Error: Invalid allocator.");
+        return(0);
+    }
+
+    if ( parser_check_declarations(config) )
+    {
+        parser_log(__LINE__, __FUNCTION__, "Error: Invalid attribute declaration.");
+        return(0);
+    }
+
+    // Allocate memory for xml struct.
+
+    if ( config->flags & PARSER_XML_FLAG_ARENA )
+    {
+        PARSER_ARENA arena;
+
+        parser_arena_init(&arena, allocator, config->arena_region, config->arena_region_size);
+
+        xml = parser_arena_alloc(&arena, sizeof(PARSER_XML));
+        if ( !xml )
+        {
+            parser_log(__LINE__, __FUNCTION__, "Error: Out of memory while allocating xml struct");
+            parser_arena_release(&arena);
+            return(0);
+        }
+
+        xml->arena = arena;
+    }
+
+    else
+    {
+        xml = allocator->alloc(allocator->context, sizeof(PARSER_XML));
+        if ( !xml )
+        {
+            parser_log(__LINE__, __FUNCTION__, "Error: Out of memory while allocating xml struct");
+            return(0);
+        }
+
+        parser_arena_init(&xml->arena, allocator, 0, 0);
+    }
+
+    xml->allocator     = *allocator;
+    xml->flags         = config->flags & ~(PARSER_XML_FLAG_SAX | PARSER_XML_FLAG_PULL);
+    xml->first_element = 0;
+    xml->last_element  = 0;
+    xml->document      = 0;
+    xml->filter        = 0;
+    xml->state         = 0;
+
+    xml->finalized_state = 0;
+    xml->file_data     = 0;
+
+    xml->elements_by_name = 0;
+    xml->file_size     = 0;
+
+    // Events are delivered to the handler instead of building the tree.
+
+    if ( config->sax_handler )
+    {
+        xml->sax_handler  = *config->sax_handler;
+        xml->flags       |= PARSER_XML_FLAG_SAX;
+    }
+
+    else
+    {
+        memset(&xml->sax_handler, 0, sizeof(xml->sax_handler));
+    }
+
+    xml->element_name_index.slots    = 0;
+    xml->attribute_name_index.slots  = 0;
+    xml->element_name_index.lookup   = config->element_name_lookup;
+    xml->attribute_name_index.lookup = config->attribute_name_lookup;
+
+    // Allocate memory for xml parser state.
+
+    if ( parser_new_state(xml) )
+    {
+        parser_log(__LINE__, __FUNCTION__, "Error: Out of memory while allocating xml parser state");
+        parser_free_xml(xml);
+        return(0);
+    }
+
+    xml->element_name_list          = config->element_name_list;
+    xml->element_name_list_length   = config->element_name_list_length;
+    xml->attribute_name_list        = config->attribute_name_list;
+    xml->attribute_name_list_length = config->attribute_name_list_length;
+    xml->attribute_declarations     = config->attribute_declarations;
+
+    // Allocate name list heads for the element index.
+
+    if ( (config->flags & PARSER_XML_FLAG_ELEMENT_INDEX) && xml->element_name_list_length > 0 )
+    {
+        xml->elements_by_name = parser_xml_malloc(xml, sizeof(PARSER_CHILD_ELEMENT) * (PARSER_SIZE)xml->element_name_list_length);
+        if ( !xml->elements_by_name )
+        {
+            parser_log(__LINE__, __FUNCTION__, "Error: Out of memory while allocating element index");
+            parser_free_xml(xml);
+            return(0);
+        }
+
+        memset(xml->elements_by_name, 0, sizeof(PARSER_CHILD_ELEMENT) * (PARSER_SIZE)xml->element_name_list_length);
+    }
+
+    // Build hash indexes for the name lists.
+
+    if ( !(config->flags & PARSER_XML_FLAG_LINEAR_NAME_LOOKUP) )
+    {
+        if ( (!xml->element_name_index.lookup.function &&
+               parser_build_name_index(xml, &xml->element_name_index, xml->element_name_list, xml->element_name_list_length)) ||
+             (!xml->attribute_name_index.lookup.function &&
+               parser_build_name_index(xml, &xml->attribute_name_index, xml->attribute_name_list, xml->attribute_name_list_length)) )
+        {
+            parser_log(__LINE__, __FUNCTION__, "Error: Failed to build name index");
+            parser_free_xml(xml);
+            return(0);
+        }
+    }
+
+    // Arena memory after this is released by parser_reset().
+
+    xml->arena_mark_block = xml->arena.first_block;
+    xml->arena_mark       = xml->arena.position;
+
+    return(xml);
+}
+
+// parser_begin
+// Returns new xml struct fith initialized parser state.
+// XML struct must be freed after it is no longer needed
+// anymore with parser_free_xml() function.
+
+PARSER_XML* parser_begin(const PARSER_XML_NAME* element_name_list,
+                         PARSER_INT             element_name_list_length,
+                         const PARSER_XML_NAME* attribute_name_list,
+                         PARSER_INT             attribute_name_list_length)
+{
+    PARSER_CONFIG config;
+
+    parser_init_config(&config, element_name_list, element_name_list_length,
+                       attribute_name_list, attribute_name_list_length);
+
+    return(parser_begin_config(&config));
+}
+
+// parser_begin_arena
+// Same as parser_begin() but all memory of the xml is bump-allocated
+// from an arena that uses optional caller-supplied region first.
+
+PARSER_XML* parser_begin_arena(const PARSER_XML_NAME* element_name_list,
+                               PARSER_INT             element_name_list_length,
+                               const PARSER_XML_NAME* attribute_name_list,
+                               PARSER_INT             attribute_name_list_length,
+                               void*                  region,
+                               PARSER_SIZE            region_size)
+{
+    PARSER_CONFIG config;
+
+    parser_init_config(&config, element_name_list, element_name_list_length,
+                       attribute_name_list, attribute_name_list_length);
+
+    config.flags             = PARSER_XML_FLAG_ARENA;
+    config.arena_region      = region;
+    config.arena_region_size = region_size;
+
+    return(parser_begin_config(&config));
+}
+
+// parser_begin_sax
+// Same as parser_begin_config() but tokens are delivered to the event
+// handler as they are parsed and no tree nodes are allocated.
+
+PARSER_XML* parser_begin_sax(const PARSER_CONFIG*      config,
+                             const PARSER_SAX_HANDLER* handler)
+{
+    PARSER_CONFIG sax_config;
+
+    if ( !config || !handler )
+        return(0);
+
+    sax_config             = *config;
+    sax_config.sax_handler = handler;
+
+    return(parser_begin_config(&sax_config));
+}
+
+// parser_pull_set_token
+// Stores token for parser_next_token() and stops the tokenizer.
+
+static inline PARSER_ERROR parser_pull_set_token(PARSER_XML*        xml,
+                                                 PARSER_INT         type,
+                                                 PARSER_INT         name_index,
+                                                 PARSER_INT         depth,
+                                                 const PARSER_CHAR* name,
+                                                 PARSER_SIZE        name_length,
+                                                 const PARSER_CHAR* value,
+                                                 PARSER_SIZE        value_length)
+{
+    PARSER_TOKEN* token;
+
+    token = &xml->state->token;
+
+    token->type         = type;
+    token->name_index   = name_index;
+    token->depth        = depth;
+    token->name         = name;
+    token->name_length  = name_length;
+    token->value        = value;
+    token->value_length = value_length;
+
+    xml->state->token_ready = 1;
+
+    return(0);
+}
+
+// parser_pull_start_element
+
+static PARSER_ERROR parser_pull_start_element(void*              context,
+                                              PARSER_INT         name_index,
+                                              const PARSER_CHAR* name,
+                                              PARSER_SIZE        name_length)
+{
+    PARSER_XML* xml;
+
+    xml = context;
+
+    return(parser_pull_set_token(xml, PARSER_TOKEN_START_ELEMENT, name_index, xml->state->depth, name, name_length, 0, 0));
+}
+
+// parser_pull_attribute
+
+static PARSER_ERROR parser_pull_attribute(void*              context,
+                                          PARSER_INT         name_index,
+                                          const PARSER_CHAR* name,
+                                          PARSER_SIZE        name_length,
+                                          const PARSER_CHAR* value,
+                                          PARSER_SIZE        value_length)
+{
+    PARSER_XML* xml;
+
+    xml = context;
+
+    return(parser_pull_set_token(xml, PARSER_TOKEN_ATTRIBUTE, name_index, xml->state->depth, name, name_length, value, value_length));
+}
+
+// parser_pull_text
+
+static PARSER_ERROR parser_pull_text(void*              context,
+                                     const PARSER_CHAR* text,
+                                     PARSER_SIZE        length)
+{
+    PARSER_XML* xml;
+
+    xml = context;
+
+    return(parser_pull_set_token(xml, PARSER_TOKEN_TEXT, PARSER_UNKNOWN_INDEX, xml->state->depth, 0, 0, text, length));
+}
+
+// parser_pull_end_element
+// Depth is already decremented for the parent.
+
+static PARSER_ERROR parser_pull_end_element(void*      context,
+                                            PARSER_INT name_index)
+{
+    PARSER_XML* xml;
+
+    xml = context;
+
+    return(parser_pull_set_token(xml, PARSER_TOKEN_END_ELEMENT, name_index, xml->state->depth + 1, 0, 0, 0, 0));
+}
+
+// parser_begin_pull
+// Same as parser_begin_config() but tokens are read one at a time
+// with parser_next_token() from buffers given to parser_append().
+// No tree nodes are allocated.
+
+PARSER_XML* parser_begin_pull(const PARSER_CONFIG* config)
+{
+    PARSER_SAX_HANDLER handler;
+    PARSER_XML*        xml;
+
+    handler.start_element = parser_pull_start_element;
+    handler.attribute     = parser_pull_attribute;
+    handler.text          = parser_pull_text;
+    handler.end_element   = parser_pull_end_element;
+    handler.context       = 0;
+
+    xml = parser_begin_sax(config, &handler);
+    if ( !xml )
+        return(0);
+
+    xml->sax_handler.context = xml;
+    xml->flags              |= PARSER_XML_FLAG_PULL;
+
+    return(xml);
+}
+
+// parser_reserve_buffer
+// Grows scratch buffer to hold at least size characters. Scratch
+// buffers are not allocated from the arena since they are resized.
+
+static PARSER_ERROR parser_reserve_buffer(PARSER_XML*   xml,
+                                          PARSER_CHAR** buffer,
+                                          PARSER_SIZE*  buffer_size,
+                                          PARSER_SIZE   initial_size,
+                                          PARSER_SIZE   size)
+{
+    PARSER_CHAR* new_buffer;
+    PARSER_SIZE  new_size;
+
+    if ( size <= *buffer_size )
+        return(0);
+
+    for ( new_size = *buffer_size ? *buffer_size : initial_size; new_size < size; new_size *= 2 );
+
+    if ( xml->allocator.realloc && *buffer )
+    {
+        new_buffer = xml->allocator.realloc(xml->allocator.context, *buffer, new_size);
+    }
+
+    else
+    {
+        new_buffer = xml->allocator.alloc(xml->allocator.context, new_size);
+
+        if ( new_buffer && *buffer )
+        {
+            memcpy(new_buffer, *buffer, *buffer_size);
+            xml->allocator.free(xml->allocator.context, *buffer);
+        }
+    }
+
+    if ( !new_buffer )
+    {
+        parser_log(__LINE__, __FUNCTION__, "Error: Out of memory while growing scratch buffer");
+        return(ENOMEM);
+    }
+
+    *buffer      = new_buffer;
+    *buffer_size = new_size;
+
+    return(0);
+}
+
+// parser_save_capture
+// Appends the captured characters before the end to the value buffer.
+
+static inline PARSER_ERROR parser_save_capture(PARSER_XML*        xml,
+                                               const PARSER_CHAR* end)
+{
+    PARSER_STATE* state;
+    PARSER_SIZE   length;
+    PARSER_ERROR  error;
+
+    state  = xml->state;
+    length = (PARSER_SIZE)(end - state->capture_start);
+
+    error = parser_reserve_buffer(xml, &state->temp_value_buffer, &state->temp_value_buffer_size,
+                                  PARSER_MAX_VALUE_STRING_LENGTH, state->value_buf_pos + length);
+    if ( error )
+        return(error);
+
+    memcpy(state->temp_value_buffer + state->value_buf_pos, state->capture_start, length);
+    state->value_buf_pos += length;
+
+    return(0);
+}
+
+// parser_capture_token
+// Returns token that started at capture_start and ends before
+// the position. Token is read directly from the input unless
+// its beginning was saved from a previous buffer.
+
+static inline PARSER_ERROR parser_capture_token(PARSER_XML*         xml,
+                                                const PARSER_CHAR*  position,
+                                                const PARSER_CHAR** token,
+                                                PARSER_SIZE*        token_length)
+{
+    PARSER_STATE* state;
+    PARSER_ERROR  error;
+
+    state = xml->state;
+
+    if ( !state->value_buf_pos )
+    {
+        *token        = state->capture_start;
+        *token_length = (PARSER_SIZE)(position - state->capture_start);
+
+        return(0);
+    }
+
+    error = parser_save_capture(xml, position);
+    if ( error )
+        return(error);
+
+    *token        = state->temp_value_buffer;
+    *token_length = state->value_buf_pos;
+
+    return(0);
+}
+
+// parser_register_element
+// Records the new innermost element. Depth of an element that is
+// kept by filters is relative to the matched element.
+
+static void parser_register_element(PARSER_XML* xml)
+{
+    PARSER_STATE* state;
+
+    state = xml->state;
+
+    state->element->depth = state->filter_depth ? state->depth - state->filter_depth + 1 : state->depth;
+
+    // Link element to the end of its name list.
+
+    if ( xml->elements_by_name && state->name_index >= 0 && state->name_index < xml->element_name_list_length )
+    {
+        PARSER_CHILD_ELEMENT* list;
+
+        list = &xml->elements_by_name[state->name_index];
+
+        if ( list->last_element )
+            list->last_element->next_by_name = state->element;
+        else
+            list->first_element = state->element;
+
+        list->last_element = state->element;
+    }
+
+    // Element follows the subtrees closed since the previous start tag.
+
+    for ( ; state->closed_count > 0; state->closed_count-- )
+    {
+        state->closed_element->subtree_next = state->element;
+        state->closed_element               = state->closed_element->parent_element;
+    }
+}
+
+// parser_emit_element_start
+// Delivers start of an element with resolved name to the event
+// handler or adds it to the tree.
+
+static PARSER_ERROR parser_emit_element_start(PARSER_XML*        xml,
+                                              PARSER_INT         name_index,
+                                              const PARSER_CHAR* name,
+                                              PARSER_SIZE        length)
+{
+    PARSER_STATE* state;
+    PARSER_ERROR  error;
+
+    state = xml->state;
+
+    state->name_index  = name_index;
+    state->depth      += 1;
+
+    if ( xml->flags & PARSER_XML_FLAG_SAX )
+    {
+        if ( !xml->sax_handler.start_element )
+            return(0);
+
+        return(xml->sax_handler.start_element(xml->sax_handler.context, state->name_index, name, length));
+    }
+
+    // Add new element to xml struct.
+
+    error = parser_add_new_element(xml, state->element, name, length, state->name_index, &state->element);
+    if ( error )
+    {
+        parser_log(__LINE__, __FUNCTION__, "Error while inserting new element.");
+        return(error);
+    }
+
+    parser_register_element(xml);
+
+    return(0);
+}
+
+// parser_filter_release
+// Releases element that is not kept with its subtree. Arena
+// is rewound to the position before the element.
+
+static void parser_filter_release(PARSER_XML*     xml,
+                                  PARSER_ELEMENT* element)
+{
+    if ( xml->flags & PARSER_XML_FLAG_ARENA )
+        parser_arena_rewind(&xml->arena, xml->filter->mark_block, xml->filter->mark);
+    else
+        parser_free_element(xml, element);
+}
+
+// parser_filter_element_start
+// Start of an element outside of the kept subtrees. Element that
+// matches is added to the tree as a root element. Element whose
+// attributes are needed is built without linking it to the tree
+// until parser_filter_decide(). Other elements are not built.
+
+static PARSER_ERROR parser_filter_element_start(PARSER_XML*        xml,
+                                                PARSER_INT         name_index,
+                                                const PARSER_CHAR* name,
+                                                PARSER_SIZE        length)
+{
+    PARSER_STATE* state;
+    PARSER_ERROR  error;
+    PARSER_INT    decision;
+
+    state = xml->state;
+
+    error = parser_filter_start(xml->filter, state->depth + 1, name_index, &decision);
+    if ( error )
+        return(error);
+
+    xml->filter->mark_block = xml->arena.first_block;
+    xml->filter->mark       = xml->arena.position;
+
+    if ( decision == PARSER_FILTER_KEEP )
+    {
+        state->filter_depth = state->depth + 1;
+        return(parser_emit_element_start(xml, name_index, name, length));
+    }
+
+    state->name_index  = name_index;
+    state->depth      += 1;
+
+    if ( decision == PARSER_FILTER_SKIP )
+        state->skip_depth = state->depth;
+
+    if ( decision != PARSER_FILTER_TEST )
+        return(0);
+
+    error = parser_new_element(xml, name, length, name_index, &state->element);
+    if ( error )
+        return(error);
+
+    state->filter_pending = 1;
+
+    return(0);
+}
+
+// parser_filter_decide
+// Attributes of the tested element are complete. Element is
+// either linked to the tree as a root element or released.
+
+static PARSER_ERROR parser_filter_decide(PARSER_XML* xml)
+{
+    PARSER_STATE* state;
+    PARSER_INT    decision;
+
+    state = xml->state;
+
+    state->filter_pending = 0;
+
+    decision = parser_filter_test(xml->filter, state->depth, state->element);
+
+    if ( decision == PARSER_FILTER_KEEP )
+    {
+        state->filter_depth = state->depth;
+
+        parser_link_element(xml, 0, state->element);
+        parser_register_element(xml);
+
+        return(0);
+    }
+
+    parser_filter_release(xml, state->element);
+    state->element = 0;
+
+    if ( decision == PARSER_FILTER_SKIP )
+        state->skip_depth = state->depth;
+
+    return(0);
+}
+
+// parser_filter_element_end
+// Kept subtree is complete. With a match callback the subtree is
+// passed to the callback and released.
+
+static PARSER_ERROR parser_filter_element_end(PARSER_XML*     xml,
+                                              PARSER_ELEMENT* element)
+{
+    PARSER_STATE* state;
+    PARSER_ERROR  error;
+
+    state = xml->state;
+
+    state->filter_depth = 0;
+
+    if ( !xml->filter->match )
+        return(0);
+
+    error = xml->filter->match(xml->filter->context, xml->filter->matched_query, element);
+
+    // Other kept subtrees were released before, so the tree has only
+    // this element.
+
+    xml->first_element    = 0;
+    xml->last_element     = 0;
+    state->closed_element = 0;
+    state->closed_count   = 0;
+
+    if ( xml->elements_by_name )
+        memset(xml->elements_by_name, 0, sizeof(PARSER_CHILD_ELEMENT) * (PARSER_SIZE)xml->element_name_list_length);
+
+    parser_filter_release(xml, element);
+
+    return(error);
+}
+
+// parser_on_element_start
+// Start tag name is complete. Name is resolved to the name
+// list index once for both tree and event handler.
 
-    if ( !xml_string || !*xml_string || xml_string_length < 1 )
+static PARSER_ERROR parser_on_element_start(PARSER_XML*        xml,
+                                            const PARSER_CHAR* name,
+                                            PARSER_SIZE        length)
+{
+    PARSER_STATE* state;
+    PARSER_ERROR  error;
+    PARSER_INT    index;
+
+    state = xml->state;
+
+    if ( state->filter_pending )
     {
-        parser_log(__LINE__, __FUNCTION__, "Error: xml string empty/null");
-        return(EINVAL);
+        error = parser_filter_decide(xml);
+        if ( error )
+            return(error);
     }
 
-    if ( !xml )
+    // Skipped elements are only counted.
+
+    if ( state->skip_depth )
     {
-        parser_log(__LINE__, __FUNCTION__, "Error: Invalid XML struct.");
-        return(EINVAL);
+        state->depth += 1;
+        return(0);
     }
 
-    else if ( !xml->state )
+    error = find_matching_string_index(name, length, xml->element_name_list, xml->element_name_list_length, &xml->element_name_index, &index);
+    if ( error )
     {
-        parser_log(__LINE__, __FUNCTION__, "Error: XML struct is finalized.");
-        return(EINVAL);
+        parser_log(__LINE__, __FUNCTION__, "Error %d at finding xml name index", error);
+        return(error);
     }
 
-    // Start parsing.
+    if ( xml->filter && !state->filter_depth )
+        return(parser_filter_element_start(xml, index, name, length));
+
+    return(parser_emit_element_start(xml, index, name, length));
+}
+
+// parser_on_element_end
+// Element is closed with an end tag or an empty element tag.
+// End of the skipped element itself is delivered normally.
+
+static PARSER_ERROR parser_on_element_end(PARSER_XML* xml)
+{
+    PARSER_ELEMENT* element;
+    PARSER_STATE*   state;
+    PARSER_ERROR    error;
+
+    state = xml->state;
 
-    for ( i = 0; i < xml_string_length; i++ )
+    if ( state->depth < 1 )
     {
-        xml->state->previous_char = xml->state->current_char;
-        xml->state->current_char  = xml->state->next_char;
-        xml->state->next_char     = i < xml_string_length ? xml_string[i] : '\0';
+        parser_log(__LINE__, __FUNCTION__, "Error: Closing tag without open element");
+        return(EINVAL);
+    }
 
-        // Comment line start.
+    if ( state->filter_pending )
+    {
+        error = parser_filter_decide(xml);
+        if ( error )
+            return(error);
+    }
 
-        if ( !(xml->state->flags & PARSER_STATE_ATTRIBUTE_VALUE_OPEN) && xml->state->current_char == '<' && xml->state->next_char == '!' )
+    if ( state->skip_depth )
+    {
+        if ( state->depth > state->skip_depth )
         {
-            xml->state->flags |= PARSER_STATE_COMMENT_OPEN;
-
-#if defined(PARSER_DEBUG)
-            xml->state->value_buf_pos = 0;
-#endif
-            continue;
+            state->depth -= 1;
+            return(0);
         }
 
-        // Comment line end.
+        state->skip_depth = 0;
+    }
 
-        if ( (xml->state->flags & PARSER_STATE_COMMENT_OPEN) && xml->state->current_char == '-' && xml->state->next_char == '>' )
-        {
-            // Skip next character.
+    // Elements outside of the kept subtrees are not in the tree.
 
-            xml->state->flags &= ~PARSER_STATE_COMMENT_OPEN;
+    if ( xml->filter && !state->filter_depth )
+    {
+        state->depth -= 1;
+        return(0);
+    }
 
-#if defined(PARSER_DEBUG)
-            xml->state->temp_value_buffer[xml->state->value_buf_pos] = '\0';
-            parser_log(__LINE__, __FUNCTION__, "Comment: |%s|\n", xml->state->temp_value_buffer);
-#endif /* PARSER_DEBUG */
-            continue;
-        }
+    state->depth -= 1;
 
-        // Skip comment line chars.
+    if ( xml->flags & PARSER_XML_FLAG_SAX )
+    {
+        if ( !xml->sax_handler.end_element )
+            return(0);
 
-        if ( (xml->state->flags & PARSER_STATE_COMMENT_OPEN) )
-        {
-#if defined(PARSER_DEBUG)
-            xml->state->temp_value_buffer[xml->state->value_buf_pos] = xml->state->current_char;
-            xml->state->value_buf_pos += 1;
+        return(xml->sax_handler.end_element(xml->sax_handler.context, state->name_index));
+    }
 
-#endif /* PARSER_DEBUG */
-            continue;
-        }
+    element = state->element;
+
+    if ( element->parent_element )
+        element->parent_element->descendant_count += element->descendant_count + 1;
+
+    if ( !state->closed_count )
+        state->closed_element = element;
+
+    state->closed_count += 1;
+    state->element       = element->parent_element;
+
+    if ( state->depth < state->filter_depth )
+        return(parser_filter_element_end(xml, element));
+
+    return(0);
+}
+
+// parser_on_end_tag_name
+// Resolves end tag name for the event handler. Tree needs
+// only the depth of the element.
+
+static inline PARSER_ERROR parser_on_end_tag_name(PARSER_XML*        xml,
+                                                  const PARSER_CHAR* name,
+                                                  PARSER_SIZE        length)
+{
+    if ( !(xml->flags & PARSER_XML_FLAG_SAX) )
+        return(0);
+
+    if ( xml->state->skip_depth && xml->state->depth > xml->state->skip_depth )
+        return(0);
+
+    return(find_matching_string_index(name, length, xml->element_name_list, xml->element_name_list_length, &xml->element_name_index, &xml->state->name_index));
+}
+
+// parser_emit_attribute
+// Delivers attribute with resolved name to the event handler
+// or adds it to the open element.
+
+static PARSER_ERROR parser_emit_attribute(PARSER_XML*        xml,
+                                          PARSER_INT         index,
+                                          const PARSER_CHAR* name,
+                                          PARSER_SIZE        name_length,
+                                          const PARSER_CHAR* value,
+                                          PARSER_SIZE        length)
+{
+    PARSER_ERROR error;
+
+    if ( xml->flags & PARSER_XML_FLAG_SAX )
+    {
+        if ( !xml->sax_handler.attribute )
+            return(0);
+
+        return(xml->sax_handler.attribute(xml->sax_handler.context, index, name, name_length, value, length));
+    }
+
+#if !defined(PARSER_WITH_DYNAMIC_NAMES)
+
+    // Give warning and skip attribute if attribute is not found in
+    // attribute names list.
+
+    if ( !xml->attribute_name_list || xml->attribute_name_list_length < 1 )
+    {
+        parser_log(__LINE__, __FUNCTION__, "Warning: Attribute found in xml while attribute name list is empty and compiled without dynamically allocated string buffers.");
+        return(0);
+    }
+
+#endif /* !PARSER_WITH_DYNAMIC_NAMES */
+
+    // Link attribute to parent element.
+
+    error = parser_add_attribute_to_element(xml, xml->state->element, name, name_length, index, value, length);
+    if ( error )
+    {
+        parser_log(__LINE__, __FUNCTION__, "Error while inserting new attribute.");
+    }
+
+    return(error);
+}
+
+// parser_on_attribute
+
+static PARSER_ERROR parser_on_attribute(PARSER_XML*        xml,
+                                        const PARSER_CHAR* value,
+                                        PARSER_SIZE        length)
+{
+    PARSER_STATE* state;
+    PARSER_ERROR  error;
+    PARSER_INT    index;
+
+    state = xml->state;
+
+    if ( state->skip_depth )
+        return(0);
+
+    // Only the tested element has attributes outside of the kept subtrees.
+
+    if ( xml->filter && !state->filter_depth && !state->filter_pending )
+        return(0);
+
+    // Find matching XML name index.
+
+    error = find_matching_string_index(state->temp_name_buffer, state->name_buf_pos, xml->attribute_name_list, xml->attribute_name_list_length, &xml->attribute_name_index, &index);
+    if ( error )
+        return(error);
+
+    return(parser_emit_attribute(xml, index, state->temp_name_buffer, state->name_buf_pos, value, length));
+}
+
+// parser_on_text
+// Element content string. Text outside of elements is ignored.
+
+static inline PARSER_ERROR parser_on_text(PARSER_XML*        xml,
+                                          const PARSER_CHAR* text,
+                                          PARSER_SIZE        length)
+{
+    PARSER_ERROR error;
+
+    if ( xml->state->filter_pending )
+    {
+        error = parser_filter_decide(xml);
+        if ( error )
+            return(error);
+    }
+
+    if ( xml->state->depth < 1 || !length || xml->state->skip_depth )
+        return(0);
+
+    if ( xml->filter && !xml->state->filter_depth )
+        return(0);
+
+    if ( xml->flags & PARSER_XML_FLAG_SAX )
+    {
+        if ( !xml->sax_handler.text )
+            return(0);
+
+        return(xml->sax_handler.text(xml->sax_handler.context, text, length));
+    }
+
+    return(parser_copy_element_content_string(xml, xml->state->element, text, length));
+}
+
+// parser_push_result
+// Failed pushed event stops the xml like a failed parser_append().
+
+static inline PARSER_ERROR parser_push_result(PARSER_XML*  xml,
+                                              PARSER_ERROR error)
+{
+    if ( error )
+        xml->state->tokenizer_state = PARSER_TOKENIZER_ERROR;
+
+    return(error);
+}
+
+// parser_push_element_start
+// Events with names resolved elsewhere, for example by a parallel
+// parse of the same input. See xml_parser_internal.h.
 
-        // Store attribute value in to a temporary value buffer.
+PARSER_ERROR parser_push_element_start(PARSER_XML*        xml,
+                                       PARSER_INT         name_index,
+                                       const PARSER_CHAR* name,
+                                       PARSER_SIZE        length)
+{
+    return(parser_push_result(xml, parser_emit_element_start(xml, name_index, name, length)));
+}
+
+// parser_push_attribute
+
+PARSER_ERROR parser_push_attribute(PARSER_XML*        xml,
+                                   PARSER_INT         name_index,
+                                   const PARSER_CHAR* name,
+                                   PARSER_SIZE        name_length,
+                                   const PARSER_CHAR* value,
+                                   PARSER_SIZE        length)
+{
+    return(parser_push_result(xml, parser_emit_attribute(xml, name_index, name, name_length, value, length)));
+}
+
+// parser_push_text
+
+PARSER_ERROR parser_push_text(PARSER_XML*        xml,
+                              const PARSER_CHAR* text,
+                              PARSER_SIZE        length)
+{
+    return(parser_push_result(xml, parser_on_text(xml, text, length)));
+}
+
+// parser_push_element_end
+
+PARSER_ERROR parser_push_element_end(PARSER_XML* xml,
+                                     PARSER_INT  name_index)
+{
+    xml->state->name_index = name_index;
+
+    return(parser_push_result(xml, parser_on_element_end(xml)));
+}
+
+// parser_tokenizer_at_tag_open
+// Returns non-zero if the latest character was '<' in content.
 
-        if ( (xml->state->flags & PARSER_STATE_ATTRIBUTE_VALUE_OPEN) && !IS_PARENTHESIS(xml->state->current_char) )
+PARSER_INT parser_tokenizer_at_tag_open(const PARSER_XML* xml)
+{
+    return(xml->state->tokenizer_state == PARSER_TOKENIZER_TAG_OPEN);
+}
+
+// parser_tokenizer_at_text
+// Returns non-zero if the tokenizer is between tokens in content.
+
+PARSER_INT parser_tokenizer_at_text(const PARSER_XML* xml)
+{
+    return(xml->state->tokenizer_state == PARSER_TOKENIZER_TEXT);
+}
+
+// parser_run_action
+// Runs the action of a tokenizer transition on the character at position.
+
+static PARSER_ERROR parser_run_action(PARSER_XML*        xml,
+                                      PARSER_INT         action,
+                                      const PARSER_CHAR* position)
+{
+    PARSER_STATE*      state;
+    const PARSER_CHAR* token;
+    PARSER_SIZE        length;
+    PARSER_ERROR       error;
+
+    state = xml->state;
+
+    switch ( action )
+    {
+        case PARSER_ACTION_CAPTURE_BEGIN:
         {
-            xml->state->temp_value_buffer[xml->state->value_buf_pos] = xml->state->current_char;
-            xml->state->value_buf_pos += 1;
+            state->capture_start = position;
+            state->value_buf_pos = 0;
 
-            continue;
+            return(0);
         }
 
-        // XML prolog start.
-
-        if ( IS_START_OF_XML_PROLOG(xml->state->current_char, xml->state->next_char) )
+        case PARSER_ACTION_CAPTURE_NEXT:
         {
-            xml->state->flags |= PARSER_STATE_XML_PROLOG_OPEN;
-            continue;
+            state->capture_start = position + 1;
+            state->value_buf_pos = 0;
+
+            return(0);
         }
 
-        // XML prolog end.
+        case PARSER_ACTION_TEXT_END:
+        {
+            error = parser_capture_token(xml, position, &token, &length);
+            if ( error )
+                return(error);
+
+            error = parser_on_text(xml, token, length);
+            if ( error )
+            {
+                parser_log(__LINE__, __FUNCTION__, "Error %d while copying string", error);
+            }
+
+            return(error);
+        }
 
-        if ( (xml->state->flags & PARSER_STATE_XML_PROLOG_OPEN) && xml->state->previous_char == '?' && xml->state->current_char == '>' )
+        case PARSER_ACTION_ELEMENT_START:
         {
-            xml->state->flags &= ~PARSER_STATE_XML_PROLOG_OPEN;
-            continue;
+            error = parser_capture_token(xml, position, &token, &length);
+            if ( error )
+                return(error);
+
+            return(parser_on_element_start(xml, token, length));
         }
 
-        // Beginning of an element start tag.
+        case PARSER_ACTION_ELEMENT_END:
+        {
+            return(parser_on_element_end(xml));
+        }
 
-        if ( !(xml->state->flags & PARSER_STATE_ELEMENT_START_TAG_OPEN) && IS_START_OF_ELEMENT_TAG(xml->state->current_char, xml->state->next_char) )
+        case PARSER_ACTION_END_TAG_NAME:
+        case PARSER_ACTION_END_TAG_NAME_CLOSE:
         {
-            xml->state->flags |= PARSER_STATE_ELEMENT_START_TAG_OPEN;
-            xml->state->flags |= PARSER_STATE_ELEMENT_NAME_OPEN;
+            error = parser_capture_token(xml, position, &token, &length);
+            if ( error )
+                return(error);
 
-            if ( (xml->state->flags & PARSER_STATE_CONTENT_TYPE_STRING) && xml->state->value_buf_pos > 0 )
-            {
-                xml->state->temp_value_buffer[xml->state->value_buf_pos] = '\0';
+            error = parser_on_end_tag_name(xml, token, length);
+            if ( error || action == PARSER_ACTION_END_TAG_NAME )
+                return(error);
 
-                // Copy element content string.
+            return(parser_on_element_end(xml));
+        }
 
-                error = parser_copy_element_content_string(xml->state->element, xml->state->temp_value_buffer);
-                if ( error )
-                {
-                    parser_log(__LINE__, __FUNCTION__, "Error %d while copying string", error);
-                    return(error);
-                }
-            }
+        case PARSER_ACTION_ATTRIBUTE_NAME_END:
+        {
+            error = parser_capture_token(xml, position, &token, &length);
+            if ( error )
+                return(error);
 
-            xml->state->name_buf_pos = 0;
+            // Name is kept until the end of the value that may
+            // continue in the next buffer.
 
-            continue;
+            error = parser_reserve_buffer(xml, &state->temp_name_buffer, &state->temp_name_buffer_size,
+                                          PARSER_MAX_NAME_STRING_LENGTH, length);
+            if ( error )
+                return(error);
+
+            memcpy(state->temp_name_buffer, token, length);
+            state->name_buf_pos = length;
+
+            return(0);
         }
 
-        // End of element name.
+        case PARSER_ACTION_ATTRIBUTE_VALUE_BEGIN:
+        {
+            state->quote_char    = *position;
+            state->capture_start = position + 1;
+            state->value_buf_pos = 0;
+
+            return(0);
+        }
 
-        if ( (xml->state->flags & PARSER_STATE_ELEMENT_NAME_OPEN) && IS_END_OF_ELEMENT_NAME(xml->state->current_char) )
+        case PARSER_ACTION_ATTRIBUTE_VALUE_END:
         {
-            xml->state->flags &= ~PARSER_STATE_ELEMENT_NAME_OPEN;
-            xml->state->temp_name_buffer[xml->state->name_buf_pos] = '\0';
+            // Other quotation mark is part of the value.
 
-            // Add new element to xml struct.
+            if ( *position != state->quote_char )
+            {
+                state->tokenizer_state = PARSER_TOKENIZER_ATTRIBUTE_VALUE;
+                return(0);
+            }
 
-            error = parser_add_new_element(xml, xml->state->parent_element, xml->state->temp_name_buffer, &(xml->state->element));
+            error = parser_capture_token(xml, position, &token, &length);
             if ( error )
-            {
-                parser_log(__LINE__, __FUNCTION__, "Error while inserting new element.");
                 return(error);
-            }
+
+            return(parser_on_attribute(xml, token, length));
         }
 
-        // Write element name charachter in to a temporary name buffer.
+        default:
+            return(0);
+    }
+}
+
+// parser_tokenize
+// Tokenizes the xml string with a state machine. Character class
+// table and transition table give the next state and action for
+// each character, and runs of characters that cannot change the
+// state are skipped at once. Tokens are delivered as slices of the
+// input and only copied when they continue over buffer boundaries.
+// Tokenizing continues from position and stops after a token when
+// the parser is in pull mode.
+
+static PARSER_ERROR parser_tokenize(PARSER_XML*        xml,
+                                    const PARSER_CHAR* xml_string,
+                                    PARSER_SIZE        xml_string_length,
+                                    PARSER_SIZE*       position)
+{
+    const PARSER_TRANSITION* transition;
+    PARSER_STATE*            state;
+    PARSER_CHAR              stop;
+    PARSER_SIZE              i;
+    PARSER_ERROR             error;
+
+    state = xml->state;
+
+    for ( i = *position; i < xml_string_length; i++ )
+    {
+        // Skip runs of characters in bulk.
 
-        if ( (xml->state->flags & PARSER_STATE_ELEMENT_NAME_OPEN) && IS_VALID_NAME_CHARACHTER(xml->state->current_char) )
+        stop = parser_state_run[state->tokenizer_state];
+        if ( stop )
         {
-            xml->state->temp_name_buffer[xml->state->name_buf_pos] = xml->state->current_char;
-            xml->state->name_buf_pos += 1;
-            continue;
+            if ( stop == PARSER_RUN_QUOTE )
+                stop = state->quote_char;
+
+            i += parser_scan_any(xml_string + i, xml_string_length - i, stop, stop);
+            if ( i >= xml_string_length )
+                break;
         }
 
-        // End of element start tag.
+        transition = &parser_transition_table[state->tokenizer_state][parser_character_class[(unsigned char)xml_string[i]]];
 
-        if ( (xml->state->flags & PARSER_STATE_ELEMENT_START_TAG_OPEN) && xml->state->current_char == '>' )
-        {
-            xml->state->flags &= ~PARSER_STATE_ELEMENT_START_TAG_OPEN;
-            xml->state->flags &= ~PARSER_STATE_ATTRIBUTE_NAME_OPEN;
-            xml->state->flags &= ~PARSER_STATE_CONTENT_TYPE_STRING;
+        state->tokenizer_state = transition->next_state;
 
-            if ( !xml->state->element )
+        if ( transition->action != PARSER_ACTION_NONE )
+        {
+            error = parser_run_action(xml, transition->action, xml_string + i);
+            if ( error )
             {
-                parser_log(__LINE__, __FUNCTION__, "Error: !element");
-                return(EINVAL);
+                state->tokenizer_state = PARSER_TOKENIZER_ERROR;
+                return(error);
             }
 
-            // Element content start.
-
-            if ( xml->state->element && xml->state->previous_char != '/' )
+            if ( state->token_ready )
             {
-                xml->state->parent_element = xml->state->element;
-                xml->state->value_buf_pos  = 0;
-
-                xml->state->flags |= PARSER_STATE_ELEMENT_OPEN;
+                *position = i + 1;
+                return(0);
             }
+        }
 
-            continue;
+        if ( state->tokenizer_state == PARSER_TOKENIZER_ERROR )
+        {
+            parser_log(__LINE__, __FUNCTION__, "Error: Syntax error at character '%c'", xml_string[i]);
+            return(EINVAL);
         }
+    }
+
+    *position = xml_string_length;
 
-        // Element closing tag beginning.
+    // Save the beginning of the unfinished token.
 
-        if ( (xml->state->flags & PARSER_STATE_ELEMENT_OPEN) && IS_START_OF_ELEMENT_END_TAG(xml->state->current_char, xml->state->next_char) )
+    if ( parser_state_captures[state->tokenizer_state] )
+    {
+        error = parser_save_capture(xml, xml_string + xml_string_length);
+        if ( error )
         {
-            if ( !xml->state->element )
-            {
-                parser_log(__LINE__, __FUNCTION__, "Error: !element");
-                return(EINVAL);
-            }
+            state->tokenizer_state = PARSER_TOKENIZER_ERROR;
+            return(error);
+        }
+    }
+
+    return(0);
+}
+
+// parser_append
+// Parses next part of the xml string. In pull mode the buffer is
+// only stored and tokenized by parser_next_token(). Buffer must
+// stay valid until parser_next_token() has returned EAGAIN.
+
+PARSER_ERROR parser_append(PARSER_XML*        xml,
+                           const PARSER_CHAR* xml_string,
+                           PARSER_INT         xml_string_length)
+{
+    PARSER_STATE* state;
+    PARSER_SIZE   position;
+
+    // Check input string...
+
+    if ( !xml_string || !*xml_string || xml_string_length < 1 )
+    {
+        parser_log(__LINE__, __FUNCTION__, "Error: xml string empty/null");
+        return(EINVAL);
+    }
+
+    if ( !xml )
+    {
+        parser_log(__LINE__, __FUNCTION__, "Error: Invalid XML struct.");
+        return(EINVAL);
+    }
 
-            if ( (xml->state->flags & PARSER_STATE_CONTENT_TYPE_STRING) && xml->state->value_buf_pos > 0 )
-            {
-                xml->state->temp_value_buffer[xml->state->value_buf_pos] = '\0';
+    else if ( !xml->state )
+    {
+        parser_log(__LINE__, __FUNCTION__, "Error: XML struct is finalized.");
+        return(EINVAL);
+    }
 
-                // Copy element content string.
+    state = xml->state;
 
-                error = parser_copy_element_content_string(xml->state->element, xml->state->temp_value_buffer);
-                if ( error )
-                {
-                    parser_log(__LINE__, __FUNCTION__, "Error while inserting new element.");
-                    return(error);
-                }
-            }
+    if ( state->tokenizer_state == PARSER_TOKENIZER_ERROR )
+    {
+        parser_log(__LINE__, __FUNCTION__, "Error: XML struct is in error state.");
+        return(EINVAL);
+    }
 
-            xml->state->flags |=  PARSER_STATE_ELEMENT_END_TAG_OPEN;
-            xml->state->flags &= ~PARSER_STATE_CONTENT_TYPE_STRING;
+    if ( state->input )
+    {
+        parser_log(__LINE__, __FUNCTION__, "Error: Previous buffer is not read.");
+        return(EBUSY);
+    }
 
-            xml->state->name_buf_pos = 0;
-            xml->state->element      = xml->state->parent_element;
-        }
+    // Token that continues from the previous buffer.
 
-        // Copy content string in to a temporary value buffer.
+    state->capture_start = xml_string;
 
-        else if ( (xml->state->flags & PARSER_STATE_ELEMENT_OPEN)        &&
-                  (xml->state->flags & PARSER_STATE_CONTENT_TYPE_STRING) &&
-                 !(xml->state->flags & PARSER_STATE_ELEMENT_START_TAG_OPEN) )
-        {
-            xml->state->temp_value_buffer[xml->state->value_buf_pos]= xml->state->current_char;
-            xml->state->value_buf_pos += 1;
-        }
+    if ( xml->flags & PARSER_XML_FLAG_PULL )
+    {
+        state->input          = xml_string;
+        state->input_length   = (PARSER_SIZE)xml_string_length;
+        state->input_position = 0;
 
-        // Set element content type to string unless child element starting tag occurs later.
+        return(0);
+    }
 
-        else if ( (xml->state->flags & PARSER_STATE_ELEMENT_OPEN)           &&
-                 !(xml->state->flags & PARSER_STATE_CONTENT_TYPE_STRING)    &&
-                 !(xml->state->flags & PARSER_STATE_ELEMENT_START_TAG_OPEN) &&
-                 !(xml->state->flags & PARSER_STATE_ELEMENT_END_TAG_OPEN)   && (IS_ALPHA_CHAR(xml->state->current_char) || IS_NUMERIC_CHAR(xml->state->current_char)) )
-        {
-            xml->state->flags        |= PARSER_STATE_CONTENT_TYPE_STRING;
-            xml->state->value_buf_pos = 0;
+    position = 0;
 
-            xml->state->temp_value_buffer[xml->state->value_buf_pos] = xml->state->current_char;
-            xml->state->value_buf_pos += 1;
-        }
+    return(parser_tokenize(xml, xml_string, (PARSER_SIZE)xml_string_length, &position));
+}
 
-        // Element closing tag end.
+// parser_next_token
+// Returns next token of the pull parser. Returns EAGAIN when the
+// appended buffer is read and more input is needed. Document is
+// complete when EAGAIN is returned and the last token was the end
+// of the root element.
 
-        if ( (xml->state->flags & PARSER_STATE_ELEMENT_END_TAG_OPEN) && xml->state->current_char == '>' )
-        {
-            xml->state->flags&= ~PARSER_STATE_ELEMENT_END_TAG_OPEN;
+PARSER_ERROR parser_next_token(PARSER_XML*   xml,
+                               PARSER_TOKEN* token)
+{
+    PARSER_STATE* state;
+    PARSER_ERROR  error;
 
-            if ( xml->state->element->parent_element )
-            {
-                xml->state->element        = xml->state->element->parent_element;
-                xml->state->parent_element = xml->state->element;
-            }
+    if ( !xml || !xml->state || !token || !(xml->flags & PARSER_XML_FLAG_PULL) )
+        return(EINVAL);
 
-            else
-            {
-                xml->state->parent_element = 0;
-                xml->state->flags         &= ~PARSER_STATE_ELEMENT_OPEN;
-            }
-        }
+    state = xml->state;
 
-        // Start of attribute name.
+    if ( state->tokenizer_state == PARSER_TOKENIZER_ERROR )
+        return(EINVAL);
 
-        if ( !(xml->state->flags & PARSER_STATE_ATTRIBUTE_NAME_OPEN)    &&
-             !(xml->state->flags & PARSER_STATE_ATTRIBUTE_VALUE_OPEN)   &&
-             ((xml->state->flags & PARSER_STATE_ELEMENT_START_TAG_OPEN) ||
-              (xml->state->flags & PARSER_STATE_XML_PROLOG_OPEN))       &&
-             IS_START_OF_ATTRIBUTE_NAME(xml->state->current_char, xml->state->next_char) )
-        {
-            xml->state->flags       |= PARSER_STATE_ATTRIBUTE_NAME_OPEN;
-            xml->state->name_buf_pos = 0;
+    token->type        = PARSER_TOKEN_NONE;
+    state->token_ready = 0;
 
-            continue;
-        }
+    if ( !state->input )
+        return(EAGAIN);
 
-        // End of attribute name.
+    error = parser_tokenize(xml, state->input, state->input_length, &state->input_position);
+    if ( error )
+        return(error);
 
-        if ( (xml->state->flags & PARSER_STATE_ATTRIBUTE_NAME_OPEN) && IS_END_OF_ATTRIBUTE_NAME(xml->state->current_char) )
-        {
-            xml->state->flags &= ~PARSER_STATE_ATTRIBUTE_NAME_OPEN;
-            xml->state->temp_name_buffer[xml->state->name_buf_pos] = '\0';
+    if ( state->token_ready )
+    {
+        state->token_ready = 0;
+        *token             = state->token;
 
-            continue;
-        }
+        return(0);
+    }
 
-        // Store attribute name in to a temporary name buffer.
+    state->input = 0;
 
-        if ( (xml->state->flags & PARSER_STATE_ATTRIBUTE_NAME_OPEN) )
-        {
-            xml->state->temp_name_buffer[xml->state->name_buf_pos] = xml->state->current_char;
-            xml->state->name_buf_pos += 1;
+    return(EAGAIN);
+}
 
-            continue;
-        }
+// parser_skip_subtree
+// Skips the rest of the innermost open element. Tokens of its
+// attributes, content and child elements are not returned and
+// their names are not resolved. Next token of the element is its
+// end element token.
 
-        // Attribute value start/end.
+PARSER_ERROR parser_skip_subtree(PARSER_XML* xml)
+{
+    if ( !xml || !xml->state || !(xml->flags & PARSER_XML_FLAG_PULL) )
+        return(EINVAL);
 
-        if ( (xml->state->flags & (PARSER_STATE_ELEMENT_START_TAG_OPEN | PARSER_STATE_XML_PROLOG_OPEN)) && IS_PARENTHESIS(xml->state->current_char) )
-        {
-            // Attribute value start.
+    if ( xml->state->depth < 1 )
+        return(EINVAL);
 
-            if ( !(xml->state->flags & PARSER_STATE_ATTRIBUTE_VALUE_OPEN) )
-            {
-                // By default expect attribute value to be integer.
+    xml->state->skip_depth = xml->state->depth;
 
-                xml->state->flags |= PARSER_STATE_PARSE_INT_VALUE;
-                xml->state->flags |= PARSER_STATE_ATTRIBUTE_VALUE_OPEN;
+    return(0);
+}
 
-                xml->state->value_buf_pos = 0;
-            }
+// parser_search_next_element
+// Returns next element in depth-first order for element searches.
+// Subtrees below max_depth are jumped over at once. Depth is
+// relative to the element where the search started.
 
-            // Attribute value end.
+static inline const PARSER_ELEMENT* parser_search_next_element(const PARSER_ELEMENT* element,
+                                                               PARSER_INT*           depth,
+                                                               PARSER_INT            max_depth)
+{
+    const PARSER_ELEMENT* next;
 
-            else if ( (xml->state->flags & PARSER_STATE_ELEMENT_START_TAG_OPEN) )
-            {
-                xml->state->flags &= ~PARSER_STATE_ATTRIBUTE_VALUE_OPEN;
-                xml->state->flags &= ~PARSER_STATE_PARSE_INT_VALUE;
-                xml->state->flags &= ~PARSER_STATE_PARSE_FLOAT_VALUE;
-                xml->state->flags &= ~PARSER_STATE_PARSE_STRING_VALUE;
+    // Move to inner element or over the whole subtree.
 
-                xml->state->temp_value_buffer[xml->state->value_buf_pos] = '\0';
+    if ( element->child_element.first_element && *depth + 1 < max_depth )
+        next = element->child_element.first_element;
+    else
+        next = element->subtree_next;
 
-#if !defined(PARSER_WITH_DYNAMIC_NAMES)
+    if ( next )
+        *depth += next->depth - element->depth;
 
-                // Give warning and skip attribute if attribute is not found in
-                // attribute names list.
+    return(next);
+}
 
-                if ( !xml->attribute_name_list || xml->attribute_name_list_length < 1 )
-                {
-                    parser_log(__LINE__, __FUNCTION__, "Warning: Attribute found in xml while attribute name list is empty and compiled without dynamically allocated string buffers.");
-                    continue;
-                }
+// parser_get_element_name_index
+// Resolves element name to its index in the element name list
+// or PARSER_UNKNOWN_INDEX. Queries by index compare only integers.
 
-#endif /* !PARSER_WITH_DYNAMIC_NAMES */
+PARSER_INT parser_get_element_name_index(const PARSER_XML*  xml,
+                                         const PARSER_CHAR* element_name)
+{
+    PARSER_INT index;
 
-                // Link attribute to parent element.
+    if ( !xml || !element_name )
+        return(PARSER_UNKNOWN_INDEX);
 
-                error = parser_add_attribute_to_element(xml, xml->state->element, xml->state->temp_name_buffer, xml->state->temp_value_buffer);
-                if ( error )
-                {
-                    parser_log(__LINE__, __FUNCTION__, "Error while inserting new attribute.");
-                    return(error);
-                }
-            }
+    if ( find_matching_string_index(element_name, strlen(element_name), xml->element_name_list, xml->element_name_list_length, &xml->element_name_index, &index) )
+        return(PARSER_UNKNOWN_INDEX);
 
-            // XML prolog attribute end.
+    return(index);
+}
 
-            else if ( (xml->state->flags & PARSER_STATE_XML_PROLOG_OPEN) )
-            {
-                xml->state->flags &= ~PARSER_STATE_ATTRIBUTE_VALUE_OPEN;
-                xml->state->temp_value_buffer[xml->state->value_buf_pos] = '\0';
+// parser_get_attribute_name_index
+// Resolves attribute name to its index in the attribute name list
+// or PARSER_UNKNOWN_INDEX.
 
-                parser_log(__LINE__, __FUNCTION__, "XML prolog: %s=\"%s\"\n", xml->state->temp_name_buffer, xml->state->temp_value_buffer);
-            }
-        }
+PARSER_INT parser_get_attribute_name_index(const PARSER_XML*  xml,
+                                           const PARSER_CHAR* attribute_name)
+{
+    PARSER_INT index;
 
-    }
+    if ( !xml || !attribute_name )
+        return(PARSER_UNKNOWN_INDEX);
 
-    return(0);
+    if ( find_matching_string_index(attribute_name, strlen(attribute_name), xml->attribute_name_list, xml->attribute_name_list_length, &xml->attribute_name_index, &index) )
+        return(PARSER_UNKNOWN_INDEX);
+
+    return(index);
 }
 
 // parser_find_element
 // Returns first element after offset with matching element name.
+// Name is resolved once and elements are compared by index. Only
+// names outside of the name list are compared as strings.
 
 const PARSER_ELEMENT* parser_find_element(const PARSER_XML*     xml,
                                           const PARSER_ELEMENT* offset,
                                           PARSER_INT            max_depth,
                                           const PARSER_CHAR*    element_name)
 {
-    const PARSER_XML_NAME* xml_name_list;
-    const PARSER_ELEMENT*  element;
-    PARSER_INT             xml_name_list_length;
-    PARSER_INT             depth;
+    PARSER_INT index;
 
     if ( !xml || !xml->state )
     {
@@ -1095,12 +2773,9 @@ const PARSER_ELEMENT* parser_find_element(const PARSER_XML*     xml,
         return(0);
     }
 
-    xml_name_list        = xml->element_name_list;
-    xml_name_list_length = xml->element_name_list_length;
-
 #if !defined(PARSER_WITH_DYNAMIC_NAMES)
 
-    if ( !xml_name_list || xml_name_list_length < 1 )
+    if ( !xml->element_name_list || xml->element_name_list_length < 1 )
     {
         parser_log(__LINE__, __FUNCTION__, " Error: XML-name list is empty.");
         return(0);
@@ -1114,85 +2789,48 @@ const PARSER_ELEMENT* parser_find_element(const PARSER_XML*     xml,
         return(0);
     }
 
-    // Iterate trough all elements if no element offset is provided.
-
-    element = offset ? offset : xml->first_element;
-    depth   = 0;
-
-    while ( element && depth < max_depth )
-    {
-        // Return current element if name matches.
-
-        if ( (element->content_type & PARSER_ELEMENT_NAME_TYPE_INDEX) &&
-              element->elem_name.name_index != PARSER_UNKNOWN_INDEX &&
-              element->elem_name.name_index < xml_name_list_length )
-        {
-            if ( !parser_strncmp(xml_name_list[element->elem_name.name_index].name, element_name, PARSER_MAX_NAME_STRING_LENGTH) )
-                return(element);
-        }
+    index = parser_get_element_name_index(xml, element_name);
+    if ( index != PARSER_UNKNOWN_INDEX )
+        return(parser_find_element_by_index(xml, offset, max_depth, index));
 
 #if defined(PARSER_WITH_DYNAMIC_NAMES)
 
-        else if ( (element->content_type & PARSER_ELEMENT_NAME_TYPE_STRING) && element->elem_name.name_string )
-        {
-            if ( !parser_strncmp(element->elem_name.name_string, element_name, PARSER_MAX_NAME_STRING_LENGTH) )
-                return(element);
-        }
-
-#endif
-
-        // Move to inner element.
+    {
+        const PARSER_ELEMENT* element;
+        PARSER_INT            depth;
 
-        if ( element->child_element.first_element && depth < max_depth)
-        {
-            element = element->child_element.first_element;
-            depth++;
-        }
+        // Iterate trough all elements if no element offset is provided.
 
-        // If no more elements are available and element has parent element then move to parent element.
+        element = offset ? offset : xml->first_element;
+        depth   = 0;
 
-        else if ( !element->next_element && element->parent_element && !element->child_element.first_element )
+        while ( element && depth < max_depth )
         {
-            // Iterate until parent element with next element is found.
-
-            while ( element && element->parent_element )
+            if ( (element->content_type & PARSER_ELEMENT_NAME_TYPE_STRING) && element->elem_name.name_string )
             {
-                depth--;
-
-                if ( element->parent_element->next_element )
-                {
-                    element = element->parent_element->next_element;
-                    break;
-                }
-
-                else
-                {
-                    element = element->parent_element;
-                }
+                if ( !parser_strncmp(element->elem_name.name_string, element_name, PARSER_MAX_NAME_STRING_LENGTH) )
+                    return(element);
             }
-        }
-
-        // Move to next element in linked list.
 
-        else
-        {
-            element = element->next_element;
+            element = parser_search_next_element(element, &depth, max_depth);
         }
     }
 
+#endif
+
     return(0);
 }
 
 // parser_find_attribute
+// Returns first attribute after offset with matching name. Name is
+// resolved once and attributes are compared by index.
 
 const PARSER_ATTRIBUTE* parser_find_attribute(const PARSER_XML*       xml,
                                               const PARSER_ELEMENT*   element,
                                               const PARSER_ATTRIBUTE* offset,
                                               const PARSER_CHAR*      attribute_name)
 {
-    const PARSER_ATTRIBUTE* attribute;
-    const PARSER_XML_NAME*  xml_name_list;
-    PARSER_INT              xml_name_list_length;
+    PARSER_INT index;
 
     if ( !xml )
     {
@@ -1208,12 +2846,9 @@ const PARSER_ATTRIBUTE* parser_find_attribute(const PARSER_XML*       xml,
         return(0);
     }
 
-    xml_name_list        = xml->attribute_name_list;
-    xml_name_list_length = xml->attribute_name_list_length;
-
 #if !defined(PARSER_WITH_DYNAMIC_NAMES)
 
-    if ( !xml_name_list || xml_name_list_length < 1 )
+    if ( !xml->attribute_name_list || xml->attribute_name_list_length < 1 )
     {
         parser_log(__LINE__, __FUNCTION__, " Error: XML-name list is empty.");
         return(0);
@@ -1227,36 +2862,98 @@ const PARSER_ATTRIBUTE* parser_find_attribute(const PARSER_XML*       xml,
         return(0);
     }
 
-    attribute = offset ? offset : element->first_attribute;
+    index = parser_get_attribute_name_index(xml, attribute_name);
+    if ( index != PARSER_UNKNOWN_INDEX )
+        return(parser_find_attribute_by_index(xml, element, offset, index));
 
-    // Iterate trough attribute list.
+#if defined(PARSER_WITH_DYNAMIC_NAMES)
 
-    while ( attribute )
     {
-        // Return attribute pointer if name matches the name in the xml-name list with given index.
+        const PARSER_ATTRIBUTE* attribute;
+
+        // Names outside of the name list are stored as strings.
 
-        if ( (attribute->attribute_type & PARSER_ATTRIBUTE_NAME_TYPE_INDEX) &&
-             (attribute->attr_name.attribute_index != PARSER_UNKNOWN_INDEX) &&
-             xml_name_list && (attribute->attr_name.attribute_index < xml_name_list_length &&
-             !parser_strncmp(xml_name_list[attribute->attr_name.attribute_index].name, attribute_name, PARSER_MAX_NAME_STRING_LENGTH)) )
+        for ( attribute = offset ? offset : element->first_attribute; attribute; attribute = attribute->next_attribute )
         {
-            return(attribute);
+            if ( (attribute->attribute_type & PARSER_ATTRIBUTE_NAME_TYPE_STRING) &&
+                  attribute->attr_name.name_string &&
+                 !parser_strncmp(attribute->attr_name.name_string, attribute_name, PARSER_MAX_NAME_STRING_LENGTH) )
+            {
+                return(attribute);
+            }
         }
+    }
 
-#if defined(PARSER_WITH_DYNAMIC_NAMES)
+#endif
 
-        // If compiled with dynamically allocated string buffers.
+    return(0);
+}
 
-        else if ( (attribute->attribute_type & PARSER_ATTRIBUTE_NAME_TYPE_STRING)         &&
-                  (attribute->attr_name.name_string && *attribute->attr_name.name_string) &&
-                  !parser_strncmp(attribute->attr_name.name_string, attribute_name, PARSER_MAX_NAME_STRING_LENGTH) )
-        {
-            return(attribute);
-        }
+// parser_find_element_by_index
+// Returns first element after offset with matching index in
+// the element name list. Only integers are compared.
 
-#endif
+const PARSER_ELEMENT* parser_find_element_by_index(const PARSER_XML*     xml,
+                                                   const PARSER_ELEMENT* offset,
+                                                   PARSER_INT            max_depth,
+                                                   PARSER_INT            name_index)
+{
+    const PARSER_ELEMENT* element;
+    PARSER_INT            depth;
+
+    if ( !xml )
+    {
+        parser_log(__LINE__, __FUNCTION__, " Error: Invalid XML-pointer.");
+        return(0);
+    }
+
+    if ( name_index < 0 || name_index >= xml->element_name_list_length )
+    {
+        parser_log(__LINE__, __FUNCTION__, " Error: Invalid element name index.");
+        return(0);
+    }
+
+    element = offset ? offset : xml->first_element;
+    depth   = 0;
+
+    while ( element && depth < max_depth )
+    {
+        if ( (element->content_type & PARSER_ELEMENT_NAME_TYPE_INDEX) && element->elem_name.name_index == name_index )
+            return(element);
+
+        element = parser_search_next_element(element, &depth, max_depth);
+    }
+
+    return(0);
+}
+
+// parser_find_attribute_by_index
+// Returns first attribute after offset with matching index in
+// the attribute name list.
+
+const PARSER_ATTRIBUTE* parser_find_attribute_by_index(const PARSER_XML*       xml,
+                                                       const PARSER_ELEMENT*   element,
+                                                       const PARSER_ATTRIBUTE* offset,
+                                                       PARSER_INT              attribute_index)
+{
+    const PARSER_ATTRIBUTE* attribute;
+
+    if ( !xml || (!element && !offset) )
+    {
+        parser_log(__LINE__, __FUNCTION__, " Error: Invalid parameter.");
+        return(0);
+    }
+
+    if ( attribute_index < 0 || attribute_index >= xml->attribute_name_list_length )
+    {
+        parser_log(__LINE__, __FUNCTION__, " Error: Invalid attribute name index.");
+        return(0);
+    }
 
-        attribute = attribute->next_attribute;
+    for ( attribute = offset ? offset : element->first_attribute; attribute; attribute = attribute->next_attribute )
+    {
+        if ( (attribute->attribute_type & PARSER_ATTRIBUTE_NAME_TYPE_INDEX) && attribute->attr_name.attribute_index == attribute_index )
+            return(attribute);
     }
 
     return(0);
@@ -1272,6 +2969,58 @@ const PARSER_ELEMENT* parser_get_next_element(const PARSER_ELEMENT* element)
     return(element->next_element);
 }
 
+// parser_get_subtree_next_element
+// Returns element that follows the subtree of the element in
+// document order: the next sibling of the element or its nearest
+// ancestor that has one.
+
+const PARSER_ELEMENT* parser_get_subtree_next_element(const PARSER_ELEMENT* element)
+{
+    if ( !element )
+        return(0);
+
+    return(element->subtree_next);
+}
+
+// parser_find_all_elements_by_index
+// Returns first element with the name list index. Rest of the elements
+// are iterated with parser_get_next_element_by_name(). Requires
+// PARSER_XML_FLAG_ELEMENT_INDEX.
+
+const PARSER_ELEMENT* parser_find_all_elements_by_index(const PARSER_XML* xml,
+                                                        PARSER_INT        name_index)
+{
+    if ( !xml || !xml->elements_by_name )
+    {
+        parser_log(__LINE__, __FUNCTION__, " Error: No element index.");
+        return(0);
+    }
+
+    if ( name_index < 0 || name_index >= xml->element_name_list_length )
+        return(0);
+
+    return(xml->elements_by_name[name_index].first_element);
+}
+
+// parser_find_all_elements
+// Same as parser_find_all_elements_by_index() but with a name string.
+
+const PARSER_ELEMENT* parser_find_all_elements(const PARSER_XML*  xml,
+                                               const PARSER_CHAR* element_name)
+{
+    return(parser_find_all_elements_by_index(xml, parser_get_element_name_index(xml, element_name)));
+}
+
+// parser_get_next_element_by_name
+
+const PARSER_ELEMENT* parser_get_next_element_by_name(const PARSER_ELEMENT* element)
+{
+    if ( !element )
+        return(0);
+
+    return(element->next_by_name);
+}
+
 // parser_get_first_child_element
 
 const PARSER_ELEMENT* parser_get_first_child_element(const PARSER_ELEMENT* element)
@@ -1282,6 +3031,39 @@ const PARSER_ELEMENT* parser_get_first_child_element(const PARSER_ELEMENT* eleme
     return(element->child_element.first_element);
 }
 
+// parser_type_attribute_value
+// Typed value replaces the string in the attribute union. Copied
+// string is part of the attribute allocation and is released with it.
+
+void parser_type_attribute_value(const PARSER_ATTRIBUTE* attribute)
+{
+    PARSER_ATTRIBUTE* typed;
+    PARSER_INT64      int_value;
+    PARSER_DOUBLE     float_value;
+    PARSER_INT        type;
+
+    if ( !attribute || !(attribute->attribute_type & PARSER_ATTRIBUTE_VALUE_LAZY) )
+        return;
+
+    typed = (PARSER_ATTRIBUTE*)attribute;
+    type  = parser_parse_number(typed->attr_val.string_slice, (PARSER_SIZE)typed->value_length, &int_value, &float_value);
+
+    typed->attribute_type &= ~PARSER_ATTRIBUTE_VALUE_LAZY;
+
+    if ( type == PARSER_ATTRIBUTE_VALUE_TYPE_STRING )
+        return;
+
+    typed->attribute_type &= PARSER_ATTRIBUTE_NAME_TYPE_INDEX | PARSER_ATTRIBUTE_NAME_TYPE_STRING | PARSER_ATTRIBUTE_NAME_TYPE_NONE;
+    typed->attribute_type |= type;
+    typed->value_length    = 0;
+
+    if ( type == PARSER_ATTRIBUTE_VALUE_TYPE_INTEGER )
+        typed->attr_val.int_value = int_value;
+
+    else
+        typed->attr_val.float_value = float_value;
+}
+
 // parser_get_attribute_type
 
 PARSER_ATTRIBUTE_TYPE parser_get_attribute_type(const PARSER_ATTRIBUTE* attribute)
@@ -1289,6 +3071,8 @@ PARSER_ATTRIBUTE_TYPE parser_get_attribute_type(const PARSER_ATTRIBUTE* attribut
     if ( !attribute )
         return(ATTRIBUTE_TYPE_UNKNOWN);
 
+    parser_type_attribute_value(attribute);
+
     if ( attribute->attribute_type & PARSER_ATTRIBUTE_VALUE_TYPE_INTEGER )
         return(ATTRIBUTE_TYPE_INTEGER);
 
@@ -1329,6 +3113,29 @@ PARSER_ERROR parser_get_attribute_int_value(const PARSER_ATTRIBUTE* attribute,
     if ( !attribute || !int_value_ptr )
         return(EINVAL);
 
+    parser_type_attribute_value(attribute);
+
+    if ( !(attribute->attribute_type & PARSER_ATTRIBUTE_VALUE_TYPE_INTEGER) )
+        return(EINVAL);
+
+    if ( attribute->attr_val.int_value < INT32_MIN || attribute->attr_val.int_value > INT32_MAX )
+        return(ERANGE);
+
+    *int_value_ptr = (PARSER_INT)attribute->attr_val.int_value;
+
+    return(0);
+}
+
+// parser_get_attribute_int64_value
+
+PARSER_ERROR parser_get_attribute_int64_value(const PARSER_ATTRIBUTE* attribute,
+                                              PARSER_INT64*           int_value_ptr)
+{
+    if ( !attribute || !int_value_ptr )
+        return(EINVAL);
+
+    parser_type_attribute_value(attribute);
+
     if ( !(attribute->attribute_type & PARSER_ATTRIBUTE_VALUE_TYPE_INTEGER) )
         return(EINVAL);
 
@@ -1337,6 +3144,28 @@ PARSER_ERROR parser_get_attribute_int_value(const PARSER_ATTRIBUTE* attribute,
     return(0);
 }
 
+// parser_get_attribute_double_value
+
+PARSER_ERROR parser_get_attribute_double_value(const PARSER_ATTRIBUTE* attribute,
+                                               PARSER_DOUBLE*          float_value_ptr)
+{
+    if ( !attribute || !float_value_ptr )
+        return(EINVAL);
+
+    parser_type_attribute_value(attribute);
+
+    if ( attribute->attribute_type & PARSER_ATTRIBUTE_VALUE_TYPE_INTEGER )
+        *float_value_ptr = (PARSER_DOUBLE)attribute->attr_val.int_value;
+
+    else if ( attribute->attribute_type & PARSER_ATTRIBUTE_VALUE_TYPE_FLOAT )
+        *float_value_ptr = attribute->attr_val.float_value;
+
+    else
+        return(EINVAL);
+
+    return(0);
+}
+
 // parser_get_attribute_string_value
 
 PARSER_ERROR parser_get_attribute_string_value(const PARSER_ATTRIBUTE* attribute,
@@ -1347,10 +3176,57 @@ PARSER_ERROR parser_get_attribute_string_value(const PARSER_ATTRIBUTE* attribute
 
     *string_value_ptr = 0;
 
-    if ( !(attribute->attribute_type & PARSER_ATTRIBUTE_VALUE_TYPE_STRING) )
+    parser_type_attribute_value(attribute);
+
+    // Borrowed slices are not null terminated.
+
+    if ( !(attribute->attribute_type & PARSER_ATTRIBUTE_VALUE_TYPE_STRING) ||
+          (attribute->attribute_type & PARSER_ATTRIBUTE_VALUE_BORROWED) )
         return(EINVAL);
 
     *string_value_ptr = attribute->attr_val.string_ptr;
 
+    return(0);
+}
+
+// parser_get_attribute_string_slice
+// Returns string value and its length. Works for both copied
+// and in-situ values.
+
+PARSER_ERROR parser_get_attribute_string_slice(const PARSER_ATTRIBUTE* attribute,
+                                               const PARSER_CHAR**     string_ptr,
+                                               PARSER_SIZE*            length_ptr)
+{
+    if ( !attribute || !string_ptr || !length_ptr )
+        return(EINVAL);
+
+    *string_ptr = 0;
+    *length_ptr = 0;
+
+    parser_type_attribute_value(attribute);
+
+    if ( !(attribute->attribute_type & PARSER_ATTRIBUTE_VALUE_TYPE_STRING) )
+        return(EINVAL);
+
+    *string_ptr = attribute->attr_val.string_slice;
+    *length_ptr = (PARSER_SIZE)attribute->value_length;
+
+    return(0);
+}
+
+// parser_get_content_string_slice
+// Returns content string and its length. Works for both copied
+// and in-situ strings.
+
+PARSER_ERROR parser_get_content_string_slice(const PARSER_STRING* string,
+                                             const PARSER_CHAR**  string_ptr,
+                                             PARSER_SIZE*         length_ptr)
+{
+    if ( !string || !string_ptr || !length_ptr )
+        return(EINVAL);
+
+    *string_ptr = string->buffer;
+    *length_ptr = string->length;
+
     return(0);
 }
\ No newline at end of file
@@ -36,16 +36,41 @@ SOFTWARE.
 #define ENOMEM 12
 #endif
 
+#if !defined(EAGAIN)
+#define EAGAIN 11
+#endif
+
+#if !defined(EBUSY)
+#define EBUSY 16
+#endif
+
 #if !defined(EINVAL)
 #define EINVAL 22
 #endif
 
+#if !defined(ERANGE)
+#define ERANGE 34
+#endif
+
 //#define PARSER_INCLUDE_LOG
 //#define PARSER_WITH_DYNAMIC_NAMES
 
+// Initial sizes of the parser scratch buffers. Buffers grow
+// for longer names and values.
+
 #define PARSER_MAX_NAME_STRING_LENGTH       128
 #define PARSER_MAX_VALUE_STRING_LENGTH      128
 
+// Size of the memory blocks that are chained to the arena when
+// the initial region is exhausted.
+
+#define PARSER_ARENA_BLOCK_SIZE             65536
+#define PARSER_ARENA_ALIGNMENT              8
+
+// Deepest element nesting of PARSER_WRITER.
+
+#define PARSER_WRITER_MAX_DEPTH             256
+
 // Defines.
 
 #define PARSER_RESULT_ERROR                 0x01
@@ -64,19 +89,55 @@ SOFTWARE.
 #define PARSER_ATTRIBUTE_VALUE_TYPE_STRING  0x01
 #define PARSER_ATTRIBUTE_VALUE_TYPE_INTEGER 0x02
 #define PARSER_ATTRIBUTE_VALUE_TYPE_FLOAT   0x04
+#define PARSER_ATTRIBUTE_VALUE_BORROWED     0x08
+#define PARSER_ATTRIBUTE_VALUE_LAZY         0x80
 
 #define PARSER_ATTRIBUTE_NAME_TYPE_INDEX    0x10
 #define PARSER_ATTRIBUTE_NAME_TYPE_STRING   0x20
 #define PARSER_ATTRIBUTE_NAME_TYPE_NONE     0x40
 
+#define PARSER_XML_FLAG_ARENA               0x01
+#define PARSER_XML_FLAG_LINEAR_NAME_LOOKUP  0x02
+#define PARSER_XML_FLAG_IN_SITU             0x04
+#define PARSER_XML_FLAG_SAX                 0x08
+#define PARSER_XML_FLAG_PULL                0x10
+#define PARSER_XML_FLAG_ELEMENT_INDEX       0x20
+#define PARSER_XML_FLAG_LAZY_VALUES         0x40
+
+#define PARSER_DECLARED_TYPE_NONE           0x00
+#define PARSER_DECLARED_TYPE_INT32          0x01
+#define PARSER_DECLARED_TYPE_INT64          0x02
+#define PARSER_DECLARED_TYPE_DOUBLE         0x03
+#define PARSER_DECLARED_TYPE_BOOL           0x04
+#define PARSER_DECLARED_TYPE_ENUM           0x05
+#define PARSER_DECLARED_TYPE_STRING         0x06
+
+#define PARSER_FILE_FLAG_KEEP_MAPPING       0x01
+
+#define PARSER_WRITE_FLAG_PRETTY            0x01
+
+#define PARSER_DOCUMENT_NONE                0xFFFFFFFFu
+
+#define PARSER_TOKEN_NONE                   0x00
+#define PARSER_TOKEN_START_ELEMENT          0x01
+#define PARSER_TOKEN_ATTRIBUTE              0x02
+#define PARSER_TOKEN_TEXT                   0x03
+#define PARSER_TOKEN_END_ELEMENT            0x04
+
 // Types.
 
 typedef int32_t PARSER_ERROR;
 
 typedef int32_t PARSER_INT;
 
+typedef int64_t PARSER_INT64;
+
 typedef float PARSER_FLOAT;
 
+typedef double PARSER_DOUBLE;
+
+typedef uint32_t PARSER_UINT32;
+
 typedef size_t PARSER_SIZE;
 
 typedef char PARSER_CHAR;
@@ -87,6 +148,22 @@ typedef struct parser_xml_name
 }
 PARSER_XML_NAME;
 
+// parser_attribute_declaration
+// Declared type of the attribute at the same index of the attribute
+// name list. Integer and double values are stored as integers and
+// floats. Bool is "true", "false", "1" or "0" stored as integer 1
+// or 0, and enum value is stored as its index in enum_values.
+// Enum values must be non-empty strings.
+// String values are never typed as numbers.
+
+typedef struct parser_attribute_declaration
+{
+    const PARSER_CHAR* const* enum_values;
+    PARSER_INT                enum_value_count;
+    PARSER_INT                type;
+}
+PARSER_ATTRIBUTE_DECLARATION;
+
 typedef enum
 {
     ATTRIBUTE_TYPE_INTEGER = 0,
@@ -99,13 +176,20 @@ PARSER_ATTRIBUTE_TYPE;
 typedef struct parser_attribute
 {
     PARSER_INT attribute_type;
-    PARSER_INT pad;
+
+    // Length of the string value.
+
+    PARSER_INT value_length;
+
+    // String value is a slice of the parsed input without
+    // null terminator if PARSER_ATTRIBUTE_VALUE_BORROWED is set.
 
     union ATTRIBUTE_VALUE
     {
-        char*        string_ptr;
-        PARSER_INT   int_value;
-        PARSER_FLOAT float_value;
+        char*              string_ptr;
+        const PARSER_CHAR* string_slice;
+        PARSER_INT64       int_value;
+        PARSER_DOUBLE      float_value;
     }
     attr_val;
 
@@ -125,9 +209,14 @@ typedef struct parser_attribute
 }
 PARSER_ATTRIBUTE;
 
+// parser_string
+// Content string. Buffer size is zero when the buffer is a slice
+// of the parsed input without null terminator.
+
 typedef struct parser_string
 {
     PARSER_SIZE           buffer_size;
+    PARSER_SIZE           length;
     PARSER_CHAR*          buffer;
 
     struct parser_string* next_string;
@@ -162,6 +251,20 @@ typedef struct parser_element
 
     struct parser_string_content child_string;
     struct parser_child_element  child_element;
+
+    // Subtree extent recorded while parsing. Subtree next is the
+    // element that follows the last descendant in document order.
+    // Depth of a root element is 1.
+
+    struct parser_element* subtree_next;
+    PARSER_INT             descendant_count;
+    PARSER_INT             depth;
+
+    // Next element with the same name index in document order
+    // when parsed with PARSER_XML_FLAG_ELEMENT_INDEX.
+
+    struct parser_element* next_by_name;
+
     // Element name.
 
     union PARSER_ELEMENT_NAME
@@ -179,46 +282,449 @@ typedef struct parser_element
 }
 PARSER_ELEMENT;
 
+// parser_token
+// Token returned by parser_next_token(). Name is set for start element
+// and attribute tokens and value for attribute and text tokens. Slices
+// are not null terminated and stay valid until the next call. Depth is
+// the depth of the element the token belongs to, root being 1.
+
+typedef struct parser_token
+{
+    PARSER_INT type;
+    PARSER_INT name_index;
+    PARSER_INT depth;
+    PARSER_INT pad;
+
+    const PARSER_CHAR* name;
+    PARSER_SIZE        name_length;
+    const PARSER_CHAR* value;
+    PARSER_SIZE        value_length;
+}
+PARSER_TOKEN;
+
 // parser_state
+// Tokenizer state that is carried over between parser_append()
+// calls. Token that continues past the end of an appended buffer
+// is collected to temp_value_buffer. Scratch buffers are allocated
+// with the xml allocator only when needed and grow on demand.
 
 typedef struct parser_state
 {
-    PARSER_ELEMENT* element;
-    PARSER_ELEMENT* parent_element;
+    PARSER_ELEMENT*    element;
+    const PARSER_CHAR* capture_start;
 
-    PARSER_INT  flags;
-    PARSER_INT  name_buf_pos;
-    PARSER_INT  value_buf_pos;
-    PARSER_INT  pad_1;
+    // Innermost of the elements closed since the latest start tag.
+    // They are linked to the next element when it starts.
 
-    PARSER_CHAR previous_char;
-    PARSER_CHAR current_char;
-    PARSER_CHAR next_char;
-    PARSER_CHAR pad_2;
+    PARSER_ELEMENT*    closed_element;
+    PARSER_INT         closed_count;
+    PARSER_INT         pad_4;
+
+    PARSER_CHAR* temp_name_buffer;
+    PARSER_CHAR* temp_value_buffer;
+    PARSER_SIZE  temp_name_buffer_size;
+    PARSER_SIZE  temp_value_buffer_size;
+    PARSER_SIZE  name_buf_pos;
+    PARSER_SIZE  value_buf_pos;
+
+    // Input of parser_next_token() that is not yet tokenized.
+
+    const PARSER_CHAR* input;
+    PARSER_SIZE        input_length;
+    PARSER_SIZE        input_position;
+
+    PARSER_TOKEN token;
+    PARSER_INT   token_ready;
+
+    // Events of elements deeper than skip_depth are ignored.
 
-    PARSER_INT  pad_3;
-    PARSER_CHAR temp_name_buffer[PARSER_MAX_NAME_STRING_LENGTH];
-    PARSER_CHAR temp_value_buffer[PARSER_MAX_VALUE_STRING_LENGTH];
+    PARSER_INT  skip_depth;
+
+    // Depth of the element whose subtree is kept by filters, and
+    // whether the innermost element waits for its attributes to be
+    // tested. See parser_set_filters().
+
+    PARSER_INT  filter_depth;
+    PARSER_INT  filter_pending;
+
+    PARSER_INT  tokenizer_state;
+    PARSER_INT  depth;
+
+    // Name list index of the latest start or end tag.
+
+    PARSER_INT  name_index;
+
+    PARSER_CHAR quote_char;
+    PARSER_CHAR pad_1;
+    PARSER_CHAR pad_2;
+    PARSER_CHAR pad_3;
 }
 PARSER_STATE;
 
+// parser_name_lookup
+// Externally generated name lookup, for example a compile-time
+// perfect hash. Function returns index of the name in the
+// PARSER_XML_NAME -list or PARSER_UNKNOWN_INDEX. Any index outside
+// the list is treated as PARSER_UNKNOWN_INDEX.
+
+typedef PARSER_INT (*PARSER_NAME_LOOKUP_FUNCTION)(const void*        context,
+                                                  const PARSER_CHAR* name,
+                                                  PARSER_SIZE        length);
+
+typedef struct parser_name_lookup
+{
+    PARSER_NAME_LOOKUP_FUNCTION function;
+    const void*                 context;
+}
+PARSER_NAME_LOOKUP;
+
+// parser_name_index_slot
+
+typedef struct parser_name_index_slot
+{
+    PARSER_UINT32 hash;
+    PARSER_INT    index;
+}
+PARSER_NAME_INDEX_SLOT;
+
+// parser_name_index
+// Open addressing hash table that maps name strings to
+// indexes in the PARSER_XML_NAME -list. External lookup
+// is used instead of the table when set.
+
+typedef struct parser_name_index
+{
+    PARSER_NAME_LOOKUP      lookup;
+    PARSER_NAME_INDEX_SLOT* slots;
+    PARSER_UINT32           slot_mask;
+    PARSER_INT              pad;
+}
+PARSER_NAME_INDEX;
+
+// parser_allocator
+// Memory allocation functions used by the xml. Context pointer
+// is passed to every function call as the first argument.
+
+typedef struct parser_allocator
+{
+    void* (*alloc)(void* context, PARSER_SIZE size);
+    void  (*free)(void* context, void* ptr);
+    void* (*realloc)(void* context, void* ptr, PARSER_SIZE size);
+
+    void* context;
+}
+PARSER_ALLOCATOR;
+
+// parser_sax_handler
+// Event callbacks of parser_begin_sax(). Names are given with their
+// index in the PARSER_XML_NAME -list or PARSER_UNKNOWN_INDEX. Strings
+// are not null terminated and are valid only during the call. End
+// element gets the index of the closed element. Returning non-zero
+// stops parsing and parser_append() returns the error. Unused
+// callbacks may be null.
+
+typedef struct parser_sax_handler
+{
+    PARSER_ERROR (*start_element)(void*              context,
+                                  PARSER_INT         name_index,
+                                  const PARSER_CHAR* name,
+                                  PARSER_SIZE        name_length);
+
+    PARSER_ERROR (*attribute)(void*              context,
+                              PARSER_INT         name_index,
+                              const PARSER_CHAR* name,
+                              PARSER_SIZE        name_length,
+                              const PARSER_CHAR* value,
+                              PARSER_SIZE        value_length);
+
+    PARSER_ERROR (*text)(void*              context,
+                         const PARSER_CHAR* text,
+                         PARSER_SIZE        length);
+
+    PARSER_ERROR (*end_element)(void*      context,
+                                PARSER_INT name_index);
+
+    void* context;
+}
+PARSER_SAX_HANDLER;
+
+// parser_document
+// Compact document built by parser_begin_document(). Elements are
+// stored in document order and each element field is its own array
+// indexed by the element number, so searches scan contiguous memory.
+// Elements of a subtree are between the element and its subtree_end.
+// Attributes of element i are from element_first_attribute[i] up to
+// the first attribute of element i + 1. Names are name list indexes
+// or PARSER_UNKNOWN_INDEX. Values and text are stored in text.
+// Missing links are PARSER_DOCUMENT_NONE.
+
+typedef struct parser_document
+{
+    PARSER_INT*    element_name;
+    PARSER_UINT32* element_depth;
+    PARSER_UINT32* element_parent;
+    PARSER_UINT32* element_first_child;
+    PARSER_UINT32* element_next_sibling;
+    PARSER_UINT32* element_subtree_end;
+    PARSER_UINT32* element_first_attribute;
+    PARSER_UINT32* element_text_offset;
+    PARSER_UINT32* element_text_length;
+    PARSER_UINT32  element_count;
+    PARSER_UINT32  element_capacity;
+
+    PARSER_INT*    attribute_name;
+    PARSER_UINT32* attribute_value_offset;
+    PARSER_UINT32* attribute_value_length;
+    PARSER_UINT32  attribute_count;
+    PARSER_UINT32  attribute_capacity;
+
+    PARSER_CHAR*   text;
+    PARSER_SIZE    text_length;
+    PARSER_SIZE    text_capacity;
+
+    // Text of open elements that follows a child element. Segments
+    // are joined to the text of their element when it ends.
+
+    PARSER_UINT32* segment_element;
+    PARSER_UINT32* segment_offset;
+    PARSER_UINT32* segment_length;
+    PARSER_UINT32  segment_count;
+    PARSER_UINT32  segment_capacity;
+
+    // Open element and the latest closed element while parsing.
+
+    PARSER_UINT32  current;
+    PARSER_UINT32  last_closed;
+}
+PARSER_DOCUMENT;
+
+// parser_arena_block
+// Header of a memory block allocated for the arena. Usable
+// memory follows directly after the header.
+
+typedef struct parser_arena_block
+{
+    struct parser_arena_block* next_block;
+    PARSER_SIZE                size;
+}
+PARSER_ARENA_BLOCK;
+
+// parser_arena
+// Bump allocator used for all element, attribute and string
+// allocations of the xml when parsing is started with
+// parser_begin_arena(). Memory is released only all at once.
+
+typedef struct parser_arena
+{
+    PARSER_ALLOCATOR    allocator;
+    PARSER_ARENA_BLOCK* first_block;
+
+    // Blocks released by parser_arena_rewind() are kept for reuse.
+
+    PARSER_ARENA_BLOCK* free_block;
+
+    PARSER_CHAR* position;
+    PARSER_CHAR* end;
+
+    // Caller-supplied region that is reused after parser_arena_reset().
+
+    PARSER_CHAR* region;
+    PARSER_CHAR* region_end;
+}
+PARSER_ARENA;
+
 // parser_xml
 
 typedef struct parser_xml
 {
-    PARSER_STATE* state;
+    PARSER_STATE*    state;
+    PARSER_ALLOCATOR allocator;
+    PARSER_ARENA     arena;
+
+    // State of a finalized xml that parser_reset() arms again.
+
+    PARSER_STATE* finalized_state;
 
     const PARSER_XML_NAME* element_name_list;
     const PARSER_XML_NAME* attribute_name_list;
 
+    const PARSER_ATTRIBUTE_DECLARATION* attribute_declarations;
+
+    PARSER_NAME_INDEX element_name_index;
+    PARSER_NAME_INDEX attribute_name_index;
+
     struct parser_element* first_element;
     struct parser_element* last_element;
 
+    // Elements of each name list index with PARSER_XML_FLAG_ELEMENT_INDEX.
+
+    PARSER_CHILD_ELEMENT* elements_by_name;
+
+    // Event handler that replaces the tree with PARSER_XML_FLAG_SAX.
+
+    PARSER_SAX_HANDLER sax_handler;
+
+    // Compact document of parser_begin_document().
+
+    PARSER_DOCUMENT* document;
+
+    // Queries of parser_set_filters().
+
+    struct parser_filter* filter;
+
+    // File mapping kept by parser_parse_file().
+
+    void*       file_data;
+    PARSER_SIZE file_size;
+
+    // Arena position after parser_begin_config() that
+    // parser_reset() rewinds to.
+
+    PARSER_ARENA_BLOCK* arena_mark_block;
+    PARSER_CHAR*        arena_mark;
+
     PARSER_INT element_name_list_length;
     PARSER_INT attribute_name_list_length;
+
+    PARSER_INT flags;
+    PARSER_INT pad;
 }
 PARSER_XML;
 
+// parser_config
+// Options for parser_begin_config(). Initialize with parser_init_config().
+
+typedef struct parser_config
+{
+    const PARSER_XML_NAME*  element_name_list;
+    const PARSER_XML_NAME*  attribute_name_list;
+
+    PARSER_INT              element_name_list_length;
+    PARSER_INT              attribute_name_list_length;
+
+    // Optional declared types of the attributes with one entry for
+    // each name of the attribute name list. Values of declared
+    // attributes are decoded while parsing the tree, and a value that
+    // does not match its declaration is a parse error. Not used with
+    // events, pull parsing or documents.
+
+    const PARSER_ATTRIBUTE_DECLARATION* attribute_declarations;
+
+    // Allocator for all memory of the xml. Default allocator
+    // uses parser_malloc() and parser_free() when null.
+
+    const PARSER_ALLOCATOR* allocator;
+
+    // Optional precomputed name lookups that replace the hash
+    // indexes built by parser_begin_config().
+
+    PARSER_NAME_LOOKUP      element_name_lookup;
+    PARSER_NAME_LOOKUP      attribute_name_lookup;
+
+    // Optional event handler. Tree is not built when set.
+
+    const PARSER_SAX_HANDLER* sax_handler;
+
+    // Optional initial arena region when PARSER_XML_FLAG_ARENA is set.
+
+    void*                   arena_region;
+    PARSER_SIZE             arena_region_size;
+
+    // With PARSER_XML_FLAG_IN_SITU string attribute values and content
+    // strings are stored as slices of the appended input, which must
+    // stay valid until parser_free_xml(). Tokens that continue over
+    // parser_append() calls are still copied. With
+    // PARSER_XML_FLAG_ELEMENT_INDEX elements are also linked by name
+    // for parser_find_all_elements().
+    // With PARSER_XML_FLAG_LAZY_VALUES attribute values are stored as
+    // strings and typed on first access with the attribute getters,
+    // which store the typed value in the attribute. Values must then
+    // be read with the getters, and not from many threads at once.
+
+    PARSER_INT              flags;
+    PARSER_INT              pad;
+}
+PARSER_CONFIG;
+
+// parser_batch
+// Parses many documents with the same config on a pool of threads.
+// See parser_begin_batch().
+
+typedef struct parser_batch PARSER_BATCH;
+
+// parser_write_function
+// Output callback of the writers. Returning non-zero stops writing
+// and the writer returns the error.
+
+typedef PARSER_ERROR (*PARSER_WRITE_FUNCTION)(void*              context,
+                                              const PARSER_CHAR* data,
+                                              PARSER_SIZE        length);
+
+// parser_write_output
+// Output buffer of the writers. Flush passes the buffer to the
+// write callback or makes room for at least the needed number of
+// bytes in some other way.
+
+typedef struct parser_write_output
+{
+    PARSER_CHAR* data;
+    PARSER_SIZE  size;
+    PARSER_SIZE  position;
+
+    PARSER_ERROR (*flush)(struct parser_write_output* output,
+                          PARSER_SIZE                 needed);
+
+    PARSER_WRITE_FUNCTION write;
+    void*                 context;
+}
+PARSER_WRITE_OUTPUT;
+
+// parser_writer
+// Streaming writer of parser_writer_init(). Names are written by
+// their index in the PARSER_XML_NAME -lists. Memory use is constant:
+// output goes through the caller buffer and only name indexes of
+// the open elements are kept.
+
+typedef struct parser_writer
+{
+    PARSER_WRITE_OUTPUT output;
+
+    const PARSER_XML_NAME* element_name_list;
+    const PARSER_XML_NAME* attribute_name_list;
+
+    PARSER_INT element_name_list_length;
+    PARSER_INT attribute_name_list_length;
+
+    PARSER_INT flags;
+    PARSER_INT depth;
+
+    // Start tag of the innermost element is not closed yet, so
+    // attributes can be added.
+
+    PARSER_INT tag_open;
+
+    // Innermost element has child elements.
+
+    PARSER_INT has_children;
+
+    PARSER_INT open_elements[PARSER_WRITER_MAX_DEPTH];
+}
+PARSER_WRITER;
+
+// parser_query
+// Compiled path of parser_compile_query().
+
+typedef struct parser_query PARSER_QUERY;
+
+// parser_query_function
+// Called by parser_evaluate_queries() for each matching element
+// with the index of the query. Returning non-zero stops the
+// evaluation and parser_evaluate_queries() returns the error.
+
+typedef PARSER_ERROR (*PARSER_QUERY_FUNCTION)(void*                 context,
+                                              PARSER_INT            query_index,
+                                              const PARSER_ELEMENT* element);
+
 #define PARSER_GET_CHILD_STRING(PARENT_ELEMENT)    ((((PARSER_ELEMENT*)PARENT_ELEMENT)->child_string.first_string))
 
 // parser_malloc
@@ -229,6 +735,40 @@ void* parser_malloc(size_t size);
 
 void parser_free(void* ptr);
 
+// parser_realloc
+
+void* parser_realloc(void* ptr, size_t size);
+
+// parser_default_allocator
+
+extern const PARSER_ALLOCATOR parser_default_allocator;
+
+// parser_arena_init
+
+void parser_arena_init(PARSER_ARENA*           arena,
+                       const PARSER_ALLOCATOR* allocator,
+                       void*                   region,
+                       PARSER_SIZE             region_size);
+
+// parser_arena_alloc
+
+void* parser_arena_alloc(PARSER_ARENA* arena,
+                         PARSER_SIZE   size);
+
+// parser_arena_release
+
+void parser_arena_release(PARSER_ARENA* arena);
+
+// parser_arena_reset
+
+void parser_arena_reset(PARSER_ARENA* arena);
+
+// parser_arena_rewind
+
+void parser_arena_rewind(PARSER_ARENA*       arena,
+                         PARSER_ARENA_BLOCK* block,
+                         PARSER_CHAR*        position);
+
 // parser_begin
 
 PARSER_XML* parser_begin(const PARSER_XML_NAME* element_name_list,
@@ -236,16 +776,327 @@ PARSER_XML* parser_begin(const PARSER_XML_NAME* element_name_list,
                          const PARSER_XML_NAME* attribute_name_list,
                          PARSER_INT             attribute_name_list_length);
 
+// parser_begin_arena
+
+PARSER_XML* parser_begin_arena(const PARSER_XML_NAME* element_name_list,
+                               PARSER_INT             element_name_list_length,
+                               const PARSER_XML_NAME* attribute_name_list,
+                               PARSER_INT             attribute_name_list_length,
+                               void*                  region,
+                               PARSER_SIZE            region_size);
+
+// parser_begin_sax
+
+PARSER_XML* parser_begin_sax(const PARSER_CONFIG*      config,
+                             const PARSER_SAX_HANDLER* handler);
+
+// parser_begin_pull
+
+PARSER_XML* parser_begin_pull(const PARSER_CONFIG* config);
+
+// parser_begin_document
+
+PARSER_XML* parser_begin_document(const PARSER_CONFIG* config);
+
+// parser_init_config
+
+void parser_init_config(PARSER_CONFIG*         config,
+                        const PARSER_XML_NAME* element_name_list,
+                        PARSER_INT             element_name_list_length,
+                        const PARSER_XML_NAME* attribute_name_list,
+                        PARSER_INT             attribute_name_list_length);
+
+// parser_begin_config
+
+PARSER_XML* parser_begin_config(const PARSER_CONFIG* config);
+
 PARSER_ERROR parser_finalize(PARSER_XML* xml);
 
 PARSER_ERROR parser_append(PARSER_XML*        xml,
                            const PARSER_CHAR* xml_string,
                            PARSER_INT         xml_string_length);
 
+// parser_append_parallel
+// Parses a large buffer with up to thread_count threads. Result is
+// the same as with parser_append() of the whole buffer. Allocator
+// of the xml must be thread safe. Input is parsed serially with one
+// thread, when it is small or when the parser is not between
+// elements.
+
+PARSER_ERROR parser_append_parallel(PARSER_XML*        xml,
+                                    const PARSER_CHAR* xml_string,
+                                    PARSER_SIZE        xml_string_length,
+                                    PARSER_INT         thread_count);
+
+// parser_begin_batch
+// Returns batch parser that uses thread_count threads including the
+// calling thread. Documents share the name indexes and are allocated
+// from arenas of the threads. Allocator of the config must be thread
+// safe. Event handler and pull parsing are not supported.
+
+PARSER_BATCH* parser_begin_batch(const PARSER_CONFIG* config,
+                                 PARSER_INT           thread_count);
+
+// parser_batch_parse
+// Parses count documents. Results of the previous parse are released.
+
+PARSER_ERROR parser_batch_parse(PARSER_BATCH*             batch,
+                                const PARSER_CHAR* const* strings,
+                                const PARSER_SIZE*        lengths,
+                                PARSER_SIZE               count);
+
+// parser_batch_get_xml
+// Returns document of the index in the order of the parsed strings.
+// Document is owned by the batch and is valid until the next parse.
+
+PARSER_XML* parser_batch_get_xml(const PARSER_BATCH* batch,
+                                 PARSER_SIZE         index);
+
+// parser_batch_get_error
+// Returns result of parser_append() of the document.
+
+PARSER_ERROR parser_batch_get_error(const PARSER_BATCH* batch,
+                                    PARSER_SIZE         index);
+
+// parser_free_batch
+
+void parser_free_batch(PARSER_BATCH* batch);
+
+// parser_next_token
+
+PARSER_ERROR parser_next_token(PARSER_XML*   xml,
+                               PARSER_TOKEN* token);
+
+// parser_skip_subtree
+
+PARSER_ERROR parser_skip_subtree(PARSER_XML* xml);
+
 // parser_free_xml
 
 PARSER_ERROR parser_free_xml(PARSER_XML* xml);
 
+// parser_reset
+
+PARSER_ERROR parser_reset(PARSER_XML* xml);
+
+// parser_parse_file
+
+PARSER_ERROR parser_parse_file(PARSER_XML*        xml,
+                               const PARSER_CHAR* path,
+                               PARSER_INT         flags);
+
+// parser_release_file
+
+void parser_release_file(PARSER_XML* xml);
+
+// parser_free_document
+
+void parser_free_document(PARSER_XML* xml);
+
+// parser_reset_document
+
+void parser_reset_document(PARSER_XML* xml);
+
+// parser_get_document
+
+const PARSER_DOCUMENT* parser_get_document(const PARSER_XML* xml);
+
+// parser_document_find_element
+
+PARSER_UINT32 parser_document_find_element(const PARSER_DOCUMENT* document,
+                                           PARSER_UINT32          first,
+                                           PARSER_UINT32          last,
+                                           PARSER_UINT32          max_depth,
+                                           PARSER_INT             name_index);
+
+// parser_document_find_attribute
+
+PARSER_UINT32 parser_document_find_attribute(const PARSER_DOCUMENT* document,
+                                             PARSER_UINT32          element,
+                                             PARSER_INT             name_index);
+
+// parser_document_get_text
+
+PARSER_ERROR parser_document_get_text(const PARSER_DOCUMENT* document,
+                                      PARSER_UINT32          element,
+                                      const PARSER_CHAR**    text,
+                                      PARSER_SIZE*           length);
+
+// parser_document_get_attribute_value
+
+PARSER_ERROR parser_document_get_attribute_value(const PARSER_DOCUMENT* document,
+                                                 PARSER_UINT32          attribute,
+                                                 const PARSER_CHAR**    value,
+                                                 PARSER_SIZE*           length);
+
+// parser_write_xml
+// Writes the tree as XML to the callback in pieces of up to a few
+// kilobytes. Compact output has no whitespace between elements and
+// PARSER_WRITE_FLAG_PRETTY puts each element on its own indented
+// line and leaves out whitespace around text. Values are written as
+// they were stored while parsing, so entity references are written
+// as they were read. Only characters that would end the value are
+// escaped. Text of an element is written before its child elements,
+// because the tree does not record their order. Names that were not
+// in the name lists are available only with PARSER_WITH_DYNAMIC_NAMES,
+// and otherwise writing fails with EINVAL.
+
+PARSER_ERROR parser_write_xml(const PARSER_XML*     xml,
+                              PARSER_WRITE_FUNCTION write,
+                              void*                 context,
+                              PARSER_INT            flags);
+
+// parser_write_xml_to_buffer
+// Writes the tree to a caller buffer with a null terminator. Returns
+// ENOBUFS if the buffer is too small and the buffer has the output
+// written so far.
+
+PARSER_ERROR parser_write_xml_to_buffer(const PARSER_XML* xml,
+                                        PARSER_CHAR*      buffer,
+                                        PARSER_SIZE       buffer_size,
+                                        PARSER_SIZE*      bytes_written,
+                                        PARSER_INT        flags);
+
+// parser_write_xml_to_string
+// Writes the tree to a null terminated string that grows as needed.
+// String is allocated with the allocator of the xml, also in arena
+// mode, and is freed with the free function of that allocator. With
+// the default allocator free the string with parser_free().
+
+PARSER_ERROR parser_write_xml_to_string(const PARSER_XML* xml,
+                                        PARSER_CHAR**     string,
+                                        PARSER_SIZE*      length,
+                                        PARSER_INT        flags);
+
+// parser_writer_init
+// Starts streaming writer that collects output to the buffer and
+// passes it to the callback when the buffer is full. Without a
+// callback, output that does not fit the buffer fails with ENOBUFS.
+// Name lists are taken from the config. Text and string values are
+// escaped. PARSER_WRITE_FLAG_PRETTY puts each element on its own
+// indented line.
+
+PARSER_ERROR parser_writer_init(PARSER_WRITER*        writer,
+                                const PARSER_CONFIG*  config,
+                                PARSER_CHAR*          buffer,
+                                PARSER_SIZE           buffer_size,
+                                PARSER_WRITE_FUNCTION write,
+                                void*                 context,
+                                PARSER_INT            flags);
+
+// parser_writer_start_element
+
+PARSER_ERROR parser_writer_start_element(PARSER_WRITER* writer,
+                                         PARSER_INT     name_index);
+
+// parser_writer_attribute_int
+// Attributes are written to the start tag of the latest element
+// before its content.
+
+PARSER_ERROR parser_writer_attribute_int(PARSER_WRITER* writer,
+                                         PARSER_INT     name_index,
+                                         int64_t        value);
+
+// parser_writer_attribute_float
+// Value is written with the fewest digits that read back as the
+// same double.
+
+PARSER_ERROR parser_writer_attribute_float(PARSER_WRITER* writer,
+                                           PARSER_INT     name_index,
+                                           PARSER_DOUBLE  value);
+
+// parser_writer_attribute_string
+
+PARSER_ERROR parser_writer_attribute_string(PARSER_WRITER*     writer,
+                                            PARSER_INT         name_index,
+                                            const PARSER_CHAR* value,
+                                            PARSER_SIZE        length);
+
+// parser_writer_text
+
+PARSER_ERROR parser_writer_text(PARSER_WRITER*     writer,
+                                const PARSER_CHAR* text,
+                                PARSER_SIZE        length);
+
+// parser_writer_end_element
+
+PARSER_ERROR parser_writer_end_element(PARSER_WRITER* writer);
+
+// parser_writer_flush
+// Passes buffered output to the callback. Call after the last
+// element. Without a callback the buffer is null terminated and
+// the length of the output is in writer->output.position.
+
+PARSER_ERROR parser_writer_flush(PARSER_WRITER* writer);
+
+// parser_compile_query
+// Compiles a path such as /a/b[@id=3]//c to steps over name list
+// indexes. Steps are / for child and // for descendant elements of
+// the previous step, followed by an element name or *. Predicates
+// [@name] and [@name OP value] with OP one of = != < <= > >= test
+// attributes. Numbers are compared with integer and float values,
+// and strings in single or double quotes with string values. Names
+// are resolved with the name lists of the xml, and the query can
+// be used with any xml that has the same lists. Returns null if the
+// path is not valid or has more than 63 steps. Query is allocated
+// with the allocator of the xml, and the allocator must stay valid
+// until the query is freed with parser_free_query(). Evaluation
+// allocates with the allocator of the xml it is given.
+
+PARSER_QUERY* parser_compile_query(const PARSER_XML*  xml,
+                                   const PARSER_CHAR* path);
+
+// parser_free_query
+
+void parser_free_query(PARSER_QUERY* query);
+
+// parser_evaluate_queries
+// Evaluates all queries in one pass over the tree and calls match
+// for each matching element in document order.
+
+PARSER_ERROR parser_evaluate_queries(const PARSER_XML*     xml,
+                                     PARSER_QUERY* const*  queries,
+                                     PARSER_INT            query_count,
+                                     PARSER_QUERY_FUNCTION match,
+                                     void*                 context);
+
+// parser_find_query_element
+// Returns the first matching element in document order.
+
+const PARSER_ELEMENT* parser_find_query_element(const PARSER_XML* xml,
+                                                PARSER_QUERY*     query);
+
+// parser_set_filters
+// Builds only subtrees of elements that match one of the queries
+// while parsing. Each matched element becomes a root element of the
+// tree with depth 1, and matches inside its subtree are part of it.
+// Other elements are not built and subtrees that cannot contain a
+// match are skipped without resolving their names. With a match
+// callback, each matched subtree is passed to the callback with the
+// index of the first matching query when its end tag is read and
+// released after the callback returns. Set filters before the
+// first parser_append(). Queries must stay valid until the xml is
+// freed or the filters are removed with zero queries after a
+// complete document. SAX, pull and document parsers have no tree
+// and return EINVAL. Filtered input is parsed on the calling thread
+// by parser_append_parallel().
+
+PARSER_ERROR parser_set_filters(PARSER_XML*           xml,
+                                PARSER_QUERY* const*  queries,
+                                PARSER_INT            query_count,
+                                PARSER_QUERY_FUNCTION match,
+                                void*                 context);
+
+// parser_get_element_name_index
+
+PARSER_INT parser_get_element_name_index(const PARSER_XML*  xml,
+                                         const PARSER_CHAR* element_name);
+
+// parser_get_attribute_name_index
+
+PARSER_INT parser_get_attribute_name_index(const PARSER_XML*  xml,
+                                           const PARSER_CHAR* attribute_name);
+
 // parser_find_element
 
 const PARSER_ELEMENT* parser_find_element(const PARSER_XML*      xml,
@@ -262,14 +1113,64 @@ const PARSER_ELEMENT* parser_get_next_element(const PARSER_ELEMENT* element);
 
 const PARSER_ELEMENT* parser_get_first_child_element(const PARSER_ELEMENT* element);
 
+const PARSER_ELEMENT* parser_get_subtree_next_element(const PARSER_ELEMENT* element);
+
+const PARSER_ELEMENT* parser_find_all_elements(const PARSER_XML*  xml,
+                                               const PARSER_CHAR* element_name);
+
+const PARSER_ELEMENT* parser_find_all_elements_by_index(const PARSER_XML* xml,
+                                                        PARSER_INT        name_index);
+
+const PARSER_ELEMENT* parser_get_next_element_by_name(const PARSER_ELEMENT* element);
+
+const PARSER_ELEMENT* parser_find_element_by_index(const PARSER_XML*     xml,
+                                                   const PARSER_ELEMENT* offset,
+                                                   PARSER_INT            max_depth,
+                                                   PARSER_INT            name_index);
+
+const PARSER_ATTRIBUTE* parser_find_attribute_by_index(const PARSER_XML*       xml,
+                                                       const PARSER_ELEMENT*   element,
+                                                       const PARSER_ATTRIBUTE* offset,
+                                                       PARSER_INT              attribute_index);
+
+// parser_parse_number
+// Decodes attribute value the same way as the parser does. Integer
+// is an optional minus sign and digits that fit 64 bits. Float also
+// has a fraction after '.' or an exponent after 'e' or 'E', and
+// integers that do not fit 64 bits are floats. Returns
+// PARSER_ATTRIBUTE_VALUE_TYPE_INTEGER or _FLOAT and writes only the
+// value of that type, or _STRING if the whole string is not a number.
+
+PARSER_INT parser_parse_number(const PARSER_CHAR* string,
+                               PARSER_SIZE        length,
+                               PARSER_INT64*      int_value_ptr,
+                               PARSER_DOUBLE*     float_value_ptr);
+
 PARSER_ATTRIBUTE_TYPE parser_get_attribute_type(const PARSER_ATTRIBUTE* attribute);
 
+// Integer getter returns ERANGE if the value does not fit 32 bits.
+// Double getter converts integer values too.
+
 PARSER_ERROR parser_get_attribute_int_value(const PARSER_ATTRIBUTE* attribute,
                                             PARSER_INT*             int_value_ptr);
 
+PARSER_ERROR parser_get_attribute_int64_value(const PARSER_ATTRIBUTE* attribute,
+                                              PARSER_INT64*           int_value_ptr);
+
+PARSER_ERROR parser_get_attribute_double_value(const PARSER_ATTRIBUTE* attribute,
+                                               PARSER_DOUBLE*          float_value_ptr);
+
 PARSER_ERROR parser_get_attribute_string_value(const PARSER_ATTRIBUTE* attribute,
                                                const PARSER_CHAR**     string_value_ptr);
 
+PARSER_ERROR parser_get_attribute_string_slice(const PARSER_ATTRIBUTE* attribute,
+                                               const PARSER_CHAR**     string_ptr,
+                                               PARSER_SIZE*            length_ptr);
+
+PARSER_ERROR parser_get_content_string_slice(const PARSER_STRING* string,
+                                             const PARSER_CHAR**  string_ptr,
+                                             PARSER_SIZE*         length_ptr);
+
 const PARSER_ATTRIBUTE* parser_get_first_element_attribute(const PARSER_ELEMENT* element);
 
 const PARSER_ATTRIBUTE* parser_get_next_element_attribute(const PARSER_ATTRIBUTE* attribute);
@@ -42,3 +42,226 @@ void parser_free(void* ptr)
 {
     free(ptr);
 }
+
+// parser_realloc
+
+void* parser_realloc(void* ptr, size_t size)
+{
+    return(realloc(ptr, size));
+}
+
+// parser_default_alloc
+
+static void* parser_default_alloc(void*       context,
+                                  PARSER_SIZE size)
+{
+    (void)context;
+
+    return(parser_malloc(size));
+}
+
+// parser_default_free
+
+static void parser_default_free(void* context,
+                                void* ptr)
+{
+    (void)context;
+
+    parser_free(ptr);
+}
+
+// parser_default_realloc
+
+static void* parser_default_realloc(void*       context,
+                                    void*       ptr,
+                                    PARSER_SIZE size)
+{
+    (void)context;
+
+    return(parser_realloc(ptr, size));
+}
+
+// parser_default_allocator
+
+const PARSER_ALLOCATOR parser_default_allocator=
+{
+    parser_default_alloc,
+    parser_default_free,
+    parser_default_realloc,
+    0
+};
+
+// parser_arena_align
+
+static inline PARSER_SIZE parser_arena_align(PARSER_SIZE size)
+{
+    return((size + (PARSER_ARENA_ALIGNMENT - 1)) & ~((PARSER_SIZE)PARSER_ARENA_ALIGNMENT - 1));
+}
+
+// parser_arena_init
+// Initializes arena. Optional caller-supplied region is used
+// before any blocks are allocated. Region is never freed by the arena.
+
+void parser_arena_init(PARSER_ARENA*           arena,
+                       const PARSER_ALLOCATOR* allocator,
+                       void*                   region,
+                       PARSER_SIZE             region_size)
+{
+    PARSER_SIZE offset;
+
+    arena->allocator   = allocator ? *allocator : parser_default_allocator;
+    arena->first_block = 0;
+    arena->free_block  = 0;
+    arena->position    = 0;
+    arena->end         = 0;
+    arena->region      = 0;
+    arena->region_end  = 0;
+
+    if ( !region || !region_size )
+        return;
+
+    // Align start of the region.
+
+    offset = parser_arena_align((PARSER_SIZE)(uintptr_t)region) - (PARSER_SIZE)(uintptr_t)region;
+    if ( offset >= region_size )
+        return;
+
+    arena->position   = (PARSER_CHAR*)region + offset;
+    arena->end        = (PARSER_CHAR*)region + region_size;
+    arena->region     = arena->position;
+    arena->region_end = arena->end;
+}
+
+// parser_arena_alloc
+// Returns aligned memory from the arena. New block is chained
+// to the arena if current block has not enough free space.
+
+void* parser_arena_alloc(PARSER_ARENA* arena,
+                         PARSER_SIZE   size)
+{
+    PARSER_ARENA_BLOCK* block;
+    PARSER_SIZE         block_size;
+    void*               ptr;
+
+    if ( !arena )
+        return(0);
+
+    size = parser_arena_align(size ? size : 1);
+
+    if ( arena->position && (PARSER_SIZE)(arena->end - arena->position) >= size )
+    {
+        ptr              = arena->position;
+        arena->position += size;
+
+        return(ptr);
+    }
+
+    // Reuse released block or allocate new block.
+
+    block = arena->free_block;
+
+    if ( block && block->size >= size )
+    {
+        arena->free_block = block->next_block;
+        block_size        = block->size;
+    }
+
+    else
+    {
+        block_size = size > PARSER_ARENA_BLOCK_SIZE ? size : PARSER_ARENA_BLOCK_SIZE;
+
+        block = arena->allocator.alloc(arena->allocator.context, parser_arena_align(sizeof(PARSER_ARENA_BLOCK)) + block_size);
+        if ( !block )
+            return(0);
+
+        block->size = block_size;
+    }
+
+    block->next_block  = arena->first_block;
+    arena->first_block = block;
+
+    ptr             = (PARSER_CHAR*)block + parser_arena_align(sizeof(PARSER_ARENA_BLOCK));
+    arena->position = (PARSER_CHAR*)ptr + size;
+    arena->end      = (PARSER_CHAR*)ptr + block_size;
+
+    return(ptr);
+}
+
+// parser_arena_release
+// Frees all blocks allocated by the arena.
+
+void parser_arena_release(PARSER_ARENA* arena)
+{
+    PARSER_ALLOCATOR    allocator;
+    PARSER_ARENA_BLOCK* block;
+    PARSER_ARENA_BLOCK* next_block;
+
+    if ( !arena )
+        return;
+
+    // Arena struct itself may be located in one of the blocks.
+
+    allocator = arena->allocator;
+    block     = arena->free_block;
+
+    arena->free_block = 0;
+
+    while ( block )
+    {
+        next_block = block->next_block;
+        allocator.free(allocator.context, block);
+        block      = next_block;
+    }
+
+    block = arena->first_block;
+
+    arena->first_block = 0;
+    arena->position    = 0;
+    arena->end         = 0;
+
+    while ( block )
+    {
+        next_block = block->next_block;
+        allocator.free(allocator.context, block);
+        block      = next_block;
+    }
+}
+
+// parser_arena_rewind
+// Releases memory allocated after the position in the block, which is
+// one of the blocks of the arena or null for the region. Newer blocks
+// are kept for reuse until parser_arena_release().
+
+void parser_arena_rewind(PARSER_ARENA*       arena,
+                         PARSER_ARENA_BLOCK* block,
+                         PARSER_CHAR*        position)
+{
+    PARSER_ARENA_BLOCK* next_block;
+
+    if ( !arena )
+        return;
+
+    while ( arena->first_block && arena->first_block != block )
+    {
+        next_block                     = arena->first_block->next_block;
+        arena->first_block->next_block = arena->free_block;
+        arena->free_block              = arena->first_block;
+        arena->first_block             = next_block;
+    }
+
+    arena->position = position;
+    arena->end      = block ? (PARSER_CHAR*)block + parser_arena_align(sizeof(PARSER_ARENA_BLOCK)) + block->size : arena->region_end;
+}
+
+// parser_arena_reset
+// Makes all memory of the arena free for reuse. Blocks are kept
+// and the caller-supplied region is used first again. Arena struct
+// must not be located in the arena.
+
+void parser_arena_reset(PARSER_ARENA* arena)
+{
+    if ( !arena )
+        return;
+
+    parser_arena_rewind(arena, 0, arena->region);
+}
@@ -0,0 +1,526 @@
+/*
+MIT License
+
+Copyright (c) 2018 Velli20
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+
+// Batch parse of many small documents with the same name lists.
+// Names are resolved with one shared index, and documents are
+// allocated from arenas of the parsing threads, so a document costs
+// no allocator calls and no index build. Threads of the batch are
+// started once and wait for the next parser_batch_parse().
+
+// Includes
+
+#include <string.h>
+#include "xml_parser.h"
+#include "xml_parser_internal.h"
+
+// Defines
+
+// Documents are taken from the shared counter in groups.
+
+#define PARSER_BATCH_GROUP_SIZE             8
+#define PARSER_BATCH_MAX_THREADS            256
+
+// Types
+
+// parser_batch_thread
+// Arena of one parsing thread. Calling thread is the first.
+
+typedef struct parser_batch_thread
+{
+    struct parser_batch* batch;
+    PARSER_ARENA         arena;
+    PARSER_ALLOCATOR     allocator;
+
+#if defined(PARSER_WITH_PTHREADS)
+
+    pthread_t            thread;
+
+#endif
+}
+PARSER_BATCH_THREAD;
+
+// parser_batch
+
+struct parser_batch
+{
+    PARSER_ALLOCATOR     allocator;
+    PARSER_CONFIG        config;
+
+    // Xml that owns the shared name indexes.
+
+    PARSER_XML*          names;
+
+    PARSER_BATCH_THREAD* threads;
+    PARSER_INT           thread_count;
+    PARSER_INT           started;
+
+    // Documents and results of the current parse.
+
+    const PARSER_CHAR* const* strings;
+    const PARSER_SIZE*        lengths;
+    PARSER_XML**              results;
+    PARSER_ERROR*             errors;
+    PARSER_SIZE               count;
+    PARSER_SIZE               capacity;
+    PARSER_SIZE               next;
+
+#if defined(PARSER_WITH_PTHREADS)
+
+    // Threads run each generation once and the last one
+    // to finish signals done.
+
+    pthread_mutex_t      mutex;
+    pthread_cond_t       work;
+    pthread_cond_t       done;
+    PARSER_SIZE          generation;
+    PARSER_INT           active;
+    PARSER_INT           stop;
+
+#endif
+};
+
+// parser_batch_arena_alloc
+// Allocator of documents. Memory is released when the arena is reset.
+
+static void* parser_batch_arena_alloc(void*       context,
+                                      PARSER_SIZE size)
+{
+    return(parser_arena_alloc(context, size));
+}
+
+// parser_batch_arena_free
+
+static void parser_batch_arena_free(void* context,
+                                    void* ptr)
+{
+    (void)context;
+    (void)ptr;
+}
+
+// parser_batch_parse_document
+
+static void parser_batch_parse_document(PARSER_BATCH*        batch,
+                                        PARSER_BATCH_THREAD* thread,
+                                        PARSER_SIZE          index)
+{
+    PARSER_CONFIG config;
+    PARSER_XML*   xml;
+    PARSER_ERROR  error;
+
+    config           = batch->config;
+    config.allocator = &thread->allocator;
+
+    xml = parser_begin_config(&config);
+    if ( !xml )
+    {
+        batch->results[index] = 0;
+        batch->errors[index]  = ENOMEM;
+        return;
+    }
+
+    if ( batch->lengths[index] > 0x7FFFFFFF )
+        error = EINVAL;
+    else
+        error = parser_append(xml, batch->strings[index], (PARSER_INT)batch->lengths[index]);
+
+    batch->results[index] = xml;
+    batch->errors[index]  = error;
+}
+
+// parser_batch_claim
+// Returns first document of the next group or the count.
+
+static PARSER_SIZE parser_batch_claim(PARSER_BATCH* batch)
+{
+    PARSER_SIZE first;
+
+#if defined(PARSER_WITH_PTHREADS)
+
+    pthread_mutex_lock(&batch->mutex);
+
+#endif
+
+    first        = batch->next;
+    batch->next += first < batch->count ? PARSER_BATCH_GROUP_SIZE : 0;
+
+#if defined(PARSER_WITH_PTHREADS)
+
+    pthread_mutex_unlock(&batch->mutex);
+
+#endif
+
+    return(first < batch->count ? first : batch->count);
+}
+
+// parser_batch_run
+// Parses groups of documents until all are taken.
+
+static void parser_batch_run(PARSER_BATCH*        batch,
+                             PARSER_BATCH_THREAD* thread)
+{
+    PARSER_SIZE first;
+    PARSER_SIZE i;
+
+    while ( (first = parser_batch_claim(batch)) < batch->count )
+    {
+        for ( i = first; i < first + PARSER_BATCH_GROUP_SIZE && i < batch->count; i++ )
+            parser_batch_parse_document(batch, thread, i);
+    }
+}
+
+#if defined(PARSER_WITH_PTHREADS)
+
+// parser_batch_thread_main
+
+static void* parser_batch_thread_main(void* context)
+{
+    PARSER_BATCH_THREAD* thread;
+    PARSER_BATCH*        batch;
+    PARSER_SIZE          generation;
+
+    thread     = context;
+    batch      = thread->batch;
+    generation = 0;
+
+    for ( ;; )
+    {
+        pthread_mutex_lock(&batch->mutex);
+
+        while ( !batch->stop && batch->generation == generation )
+            pthread_cond_wait(&batch->work, &batch->mutex);
+
+        if ( batch->stop )
+        {
+            pthread_mutex_unlock(&batch->mutex);
+            return(0);
+        }
+
+        generation = batch->generation;
+
+        pthread_mutex_unlock(&batch->mutex);
+
+        parser_batch_run(batch, thread);
+
+        pthread_mutex_lock(&batch->mutex);
+
+        if ( --batch->active == 0 )
+            pthread_cond_signal(&batch->done);
+
+        pthread_mutex_unlock(&batch->mutex);
+    }
+}
+
+#endif /* PARSER_WITH_PTHREADS */
+
+// parser_batch_reserve
+// Grows result arrays for count documents.
+
+static PARSER_ERROR parser_batch_reserve(PARSER_BATCH* batch,
+                                         PARSER_SIZE   count)
+{
+    PARSER_XML**  results;
+    PARSER_ERROR* errors;
+
+    if ( count <= batch->capacity )
+        return(0);
+
+    results = batch->allocator.alloc(batch->allocator.context, count * sizeof(PARSER_XML*));
+    errors  = batch->allocator.alloc(batch->allocator.context, count * sizeof(PARSER_ERROR));
+
+    if ( !results || !errors )
+    {
+        if ( results )
+            batch->allocator.free(batch->allocator.context, results);
+
+        if ( errors )
+            batch->allocator.free(batch->allocator.context, errors);
+
+        return(ENOMEM);
+    }
+
+    if ( batch->results )
+        batch->allocator.free(batch->allocator.context, batch->results);
+
+    if ( batch->errors )
+        batch->allocator.free(batch->allocator.context, batch->errors);
+
+    batch->results  = results;
+    batch->errors   = errors;
+    batch->capacity = count;
+
+    return(0);
+}
+
+// parser_begin_batch
+// Returns batch that parses documents with the config on thread_count
+// threads including the calling thread. Event handler and pull
+// parsing are not supported. Free with parser_free_batch().
+
+PARSER_BATCH* parser_begin_batch(const PARSER_CONFIG* config,
+                                 PARSER_INT           thread_count)
+{
+    PARSER_BATCH_THREAD* thread;
+    PARSER_BATCH*        batch;
+    PARSER_CONFIG        names_config;
+    PARSER_XML*          names;
+    PARSER_INT           i;
+
+    if ( !config || config->sax_handler || (config->flags & (PARSER_XML_FLAG_SAX | PARSER_XML_FLAG_PULL)) )
+        return(0);
+
+#if defined(PARSER_WITH_PTHREADS)
+
+    if ( thread_count > PARSER_BATCH_MAX_THREADS )
+        thread_count = PARSER_BATCH_MAX_THREADS;
+
+#else
+
+    thread_count = 1;
+
+#endif
+
+    if ( thread_count < 1 )
+        thread_count = 1;
+
+    // Name indexes are built once.
+
+    names_config              = *config;
+    names_config.flags       &= PARSER_XML_FLAG_LINEAR_NAME_LOOKUP;
+    names_config.arena_region = 0;
+
+    names = parser_begin_config(&names_config);
+    if ( !names )
+        return(0);
+
+    batch = names->allocator.alloc(names->allocator.context, sizeof(PARSER_BATCH));
+    if ( !batch )
+    {
+        parser_free_xml(names);
+        return(0);
+    }
+
+    memset(batch, 0, sizeof(PARSER_BATCH));
+
+    batch->allocator = names->allocator;
+    batch->names     = names;
+
+    // Documents use the shared indexes and the arena of their thread.
+    // Arena of the thread replaces the arena of the document.
+
+    batch->config              = *config;
+    batch->config.flags       &= ~PARSER_XML_FLAG_ARENA;
+    batch->config.arena_region = 0;
+
+    parser_share_name_lookups(batch->names, &batch->config);
+
+    batch->threads = batch->allocator.alloc(batch->allocator.context, (PARSER_SIZE)thread_count * sizeof(PARSER_BATCH_THREAD));
+    if ( !batch->threads )
+    {
+        parser_free_batch(batch);
+        return(0);
+    }
+
+    for ( i = 0; i < thread_count; i++ )
+    {
+        thread = &batch->threads[i];
+
+        thread->batch = batch;
+
+        parser_arena_init(&thread->arena, &batch->allocator, 0, 0);
+
+        thread->allocator.alloc   = parser_batch_arena_alloc;
+        thread->allocator.free    = parser_batch_arena_free;
+        thread->allocator.realloc = 0;
+        thread->allocator.context = &thread->arena;
+    }
+
+    batch->thread_count = thread_count;
+
+#if defined(PARSER_WITH_PTHREADS)
+
+    if ( thread_count > 1 )
+    {
+        if ( pthread_mutex_init(&batch->mutex, 0) )
+        {
+            batch->thread_count = 1;
+            parser_free_batch(batch);
+            return(0);
+        }
+
+        pthread_cond_init(&batch->work, 0);
+        pthread_cond_init(&batch->done, 0);
+
+        // Threads other than the caller.
+
+        for ( batch->started = 1; batch->started < thread_count; batch->started++ )
+        {
+            if ( pthread_create(&batch->threads[batch->started].thread, 0, parser_batch_thread_main, &batch->threads[batch->started]) )
+                break;
+        }
+    }
+
+#endif
+
+    return(batch);
+}
+
+// parser_batch_parse
+// Parses count documents. Results are in the order of the strings and
+// stay valid until the next parse or parser_free_batch(). Returns
+// zero if the documents were parsed; errors of the documents are
+// returned by parser_batch_get_error().
+
+PARSER_ERROR parser_batch_parse(PARSER_BATCH*             batch,
+                                const PARSER_CHAR* const* strings,
+                                const PARSER_SIZE*        lengths,
+                                PARSER_SIZE               count)
+{
+    PARSER_ERROR error;
+    PARSER_INT   i;
+
+    if ( !batch || (count && (!strings || !lengths)) )
+        return(EINVAL);
+
+    error = parser_batch_reserve(batch, count);
+    if ( error )
+        return(error);
+
+    // Memory of the previous documents is reused.
+
+    for ( i = 0; i < batch->thread_count; i++ )
+        parser_arena_reset(&batch->threads[i].arena);
+
+    batch->strings = strings;
+    batch->lengths = lengths;
+    batch->count   = count;
+    batch->next    = 0;
+
+#if defined(PARSER_WITH_PTHREADS)
+
+    if ( batch->started > 1 )
+    {
+        pthread_mutex_lock(&batch->mutex);
+
+        batch->generation += 1;
+        batch->active      = batch->started - 1;
+
+        pthread_cond_broadcast(&batch->work);
+        pthread_mutex_unlock(&batch->mutex);
+
+        parser_batch_run(batch, &batch->threads[0]);
+
+        pthread_mutex_lock(&batch->mutex);
+
+        while ( batch->active > 0 )
+            pthread_cond_wait(&batch->done, &batch->mutex);
+
+        pthread_mutex_unlock(&batch->mutex);
+
+        return(0);
+    }
+
+#endif
+
+    parser_batch_run(batch, &batch->threads[0]);
+
+    return(0);
+}
+
+// parser_batch_get_xml
+// Returns parsed document of the index. Document is owned by
+// the batch and is not freed with parser_free_xml().
+
+PARSER_XML* parser_batch_get_xml(const PARSER_BATCH* batch,
+                                 PARSER_SIZE         index)
+{
+    if ( !batch || index >= batch->count )
+        return(0);
+
+    return(batch->results[index]);
+}
+
+// parser_batch_get_error
+
+PARSER_ERROR parser_batch_get_error(const PARSER_BATCH* batch,
+                                    PARSER_SIZE         index)
+{
+    if ( !batch || index >= batch->count )
+        return(EINVAL);
+
+    return(batch->errors[index]);
+}
+
+// parser_free_batch
+// Stops the threads and frees the batch with all documents.
+
+void parser_free_batch(PARSER_BATCH* batch)
+{
+    PARSER_ALLOCATOR allocator;
+    PARSER_INT       i;
+
+    if ( !batch )
+        return;
+
+#if defined(PARSER_WITH_PTHREADS)
+
+    if ( batch->thread_count > 1 )
+    {
+        pthread_mutex_lock(&batch->mutex);
+
+        batch->stop = 1;
+
+        pthread_cond_broadcast(&batch->work);
+        pthread_mutex_unlock(&batch->mutex);
+
+        for ( i = 1; i < batch->started; i++ )
+            pthread_join(batch->threads[i].thread, 0);
+
+        pthread_cond_destroy(&batch->done);
+        pthread_cond_destroy(&batch->work);
+        pthread_mutex_destroy(&batch->mutex);
+    }
+
+#endif
+
+    allocator = batch->allocator;
+
+    if ( batch->threads )
+    {
+        for ( i = 0; i < batch->thread_count; i++ )
+            parser_arena_release(&batch->threads[i].arena);
+
+        allocator.free(allocator.context, batch->threads);
+    }
+
+    if ( batch->results )
+        allocator.free(allocator.context, batch->results);
+
+    if ( batch->errors )
+        allocator.free(allocator.context, batch->errors);
+
+    parser_free_xml(batch->names);
+
+    allocator.free(allocator.context, batch);
+}
@@ -38,6 +38,11 @@ Parser::Parser(const PARSER_XML_NAME* element_name_list,
                         attribute_name_list_length);
 }
 
+Parser::Parser(const PARSER_CONFIG& config)
+{
+    xml_ = parser_begin_config(&config);
+}
+
 Parser::~Parser()
 {
     if ( !xml_ )
@@ -52,6 +57,56 @@ void Parser::Append(const PARSER_CHAR* xml_string,
     parser_append(xml_, xml_string, xml_string_length);
 }
 
+PARSER_ERROR Parser::AppendParallel(const PARSER_CHAR* xml_string,
+                                    PARSER_SIZE        xml_string_length,
+                                    PARSER_INT         thread_count) const
+{
+    return(parser_append_parallel(xml_, xml_string, xml_string_length, thread_count));
+}
+
+PARSER_ERROR Parser::Reset() const
+{
+    return(parser_reset(xml_));
+}
+
+PARSER_ERROR Parser::ParseFile(const PARSER_CHAR* path,
+                               PARSER_INT         flags) const
+{
+    return(parser_parse_file(xml_, path, flags));
+}
+
+PARSER_ERROR Parser::Write(PARSER_WRITE_FUNCTION write,
+                           void*                 context,
+                           PARSER_INT            flags) const
+{
+    return(parser_write_xml(xml_, write, context, flags));
+}
+
+PARSER_ERROR Parser::WriteToBuffer(PARSER_CHAR* buffer,
+                                   PARSER_SIZE  buffer_size,
+                                   PARSER_SIZE* bytes_written,
+                                   PARSER_INT   flags) const
+{
+    return(parser_write_xml_to_buffer(xml_, buffer, buffer_size, bytes_written, flags));
+}
+
+PARSER_INT Parser::ElementIndex(const PARSER_CHAR* element_name) const
+{
+    return(parser_get_element_name_index(xml_, element_name));
+}
+
+PARSER_INT Parser::AttributeIndex(const PARSER_CHAR* attribute_name) const
+{
+    return(parser_get_attribute_name_index(xml_, attribute_name));
+}
+
+Element* Parser::FindElement(Element*   offset,
+                             PARSER_INT max_depth,
+                             PARSER_INT element_index) const
+{
+    return(parser_find_element_by_index(xml_, offset, max_depth, element_index));
+}
+
 Element* Parser::FindElement(Element*           offset,
                              PARSER_INT         max_depth,
                              const PARSER_CHAR* element_name) const
@@ -59,6 +114,42 @@ Element* Parser::FindElement(Element*           offset,
     return(parser_find_element(xml_, offset, max_depth, element_name));
 }
 
+PARSER_QUERY* Parser::CompileQuery(const PARSER_CHAR* path) const
+{
+    return(parser_compile_query(xml_, path));
+}
+
+Element* Parser::FindElement(PARSER_QUERY* query) const
+{
+    return(parser_find_query_element(xml_, query));
+}
+
+PARSER_ERROR Parser::EvaluateQueries(PARSER_QUERY* const*  queries,
+                                     PARSER_INT            query_count,
+                                     PARSER_QUERY_FUNCTION match,
+                                     void*                 context) const
+{
+    return(parser_evaluate_queries(xml_, queries, query_count, match, context));
+}
+
+PARSER_ERROR Parser::SetFilters(PARSER_QUERY* const*  queries,
+                                PARSER_INT            query_count,
+                                PARSER_QUERY_FUNCTION match,
+                                void*                 context) const
+{
+    return(parser_set_filters(xml_, queries, query_count, match, context));
+}
+
+ElementRange Parser::FindAllElements(const PARSER_CHAR* element_name) const
+{
+    return(ElementRange(parser_find_all_elements(xml_, element_name)));
+}
+
+ElementRange Parser::FindAllElements(PARSER_INT element_index) const
+{
+    return(ElementRange(parser_find_all_elements_by_index(xml_, element_index)));
+}
+
 Element* Parser::GetChildElement(Element* parent)
 {
     if ( !parent )
@@ -82,6 +173,13 @@ Attribute* Parser::FindElementAttribute(Element*           element,
     return(parser_find_attribute(xml_, element, offset, attribute_name));
 }
 
+Attribute* Parser::FindElementAttribute(Element*   element,
+                                        Attribute* offset,
+                                        PARSER_INT attribute_index) const
+{
+    return(parser_find_attribute_by_index(xml_, element, offset, attribute_index));
+}
+
 AttributeType Parser::GetAttributeType(Attribute* attribute)
 {
     if ( !attribute )
@@ -103,12 +201,111 @@ AttributeType Parser::GetAttributeType(Attribute* attribute)
 
 std::optional<std::uint32_t> Parser::GetAttributeValue(Attribute* attribute)
 {
-    if ( !attribute || parser_get_attribute_type(attribute) != ATTRIBUTE_TYPE_INTEGER )
+    PARSER_INT64 value;
+
+    if ( parser_get_attribute_int64_value(attribute, &value) )
+        return{};
+
+    return(static_cast<std::uint32_t>(value));
+}
+
+std::optional<std::int64_t> Parser::GetAttributeInt64(Attribute* attribute)
+{
+    PARSER_INT64 value;
+
+    if ( parser_get_attribute_int64_value(attribute, &value) )
         return{};
 
-    std::uint32_t value = static_cast<std::uint32_t>(attribute->attr_val.int_value);
+    return(value);
+}
+
+std::optional<double> Parser::GetAttributeDouble(Attribute* attribute)
+{
+    PARSER_DOUBLE value;
+
+    if ( parser_get_attribute_double_value(attribute, &value) )
+        return{};
 
     return(value);
 }
 
+Reader::Reader(const PARSER_CONFIG& config)
+{
+    xml_ = parser_begin_pull(&config);
+}
+
+Reader::~Reader()
+{
+    if ( !xml_ )
+        return;
+
+    parser_free_xml(xml_);
+}
+
+PARSER_ERROR Reader::Append(const PARSER_CHAR* xml_string,
+                            PARSER_INT         xml_string_length) const
+{
+    return(parser_append(xml_, xml_string, xml_string_length));
+}
+
+PARSER_ERROR Reader::Next(PARSER_TOKEN& token) const
+{
+    return(parser_next_token(xml_, &token));
+}
+
+PARSER_ERROR Reader::SkipSubtree() const
+{
+    return(parser_skip_subtree(xml_));
+}
+
+Writer::Writer(const PARSER_CONFIG&  config,
+               PARSER_CHAR*          buffer,
+               PARSER_SIZE           buffer_size,
+               PARSER_WRITE_FUNCTION write,
+               void*                 context,
+               PARSER_INT            flags)
+{
+    error_ = parser_writer_init(&writer_, &config, buffer, buffer_size, write, context, flags);
+}
+
+PARSER_ERROR Writer::StartElement(PARSER_INT name_index)
+{
+    return(error_ ? error_ : parser_writer_start_element(&writer_, name_index));
+}
+
+PARSER_ERROR Writer::AttributeInt(PARSER_INT   name_index,
+                                  std::int64_t value)
+{
+    return(error_ ? error_ : parser_writer_attribute_int(&writer_, name_index, value));
+}
+
+PARSER_ERROR Writer::AttributeFloat(PARSER_INT    name_index,
+                                    PARSER_DOUBLE value)
+{
+    return(error_ ? error_ : parser_writer_attribute_float(&writer_, name_index, value));
+}
+
+PARSER_ERROR Writer::AttributeString(PARSER_INT         name_index,
+                                     const PARSER_CHAR* value,
+                                     PARSER_SIZE        length)
+{
+    return(error_ ? error_ : parser_writer_attribute_string(&writer_, name_index, value, length));
+}
+
+PARSER_ERROR Writer::Text(const PARSER_CHAR* text,
+                          PARSER_SIZE        length)
+{
+    return(error_ ? error_ : parser_writer_text(&writer_, text, length));
+}
+
+PARSER_ERROR Writer::EndElement()
+{
+    return(error_ ? error_ : parser_writer_end_element(&writer_));
+}
+
+PARSER_ERROR Writer::Flush()
+{
+    return(error_ ? error_ : parser_writer_flush(&writer_));
+}
+
 } // xml_parser
@@ -27,10 +27,13 @@ SOFTWARE.
 
 #ifdef __cplusplus
 
+#include <cstdint>
 #include <optional>
+#include <type_traits>
 extern "C" {
 #include "xml_parser.h"
 }
+#include "xml_parser_names.h"
 
 namespace xml_parser
 {
@@ -46,6 +49,46 @@ enum class AttributeType
 using Element = const PARSER_ELEMENT;
 using Attribute = const PARSER_ATTRIBUTE;
 
+// ElementRange
+// Elements with the same name in document order. Requires
+// PARSER_XML_FLAG_ELEMENT_INDEX.
+
+class ElementRange
+{
+    public:
+
+    class Iterator
+    {
+        public:
+
+        explicit Iterator(Element* element) : element_(element) {}
+
+        Element* operator*() const { return(element_); }
+
+        Iterator& operator++()
+        {
+            element_ = parser_get_next_element_by_name(element_);
+            return(*this);
+        }
+
+        bool operator!=(const Iterator& other) const { return(element_ != other.element_); }
+
+        private:
+
+        Element* element_;
+    };
+
+    explicit ElementRange(Element* first) : first_(first) {}
+
+    Iterator begin() const { return(Iterator(first_)); }
+
+    Iterator end() const { return(Iterator(nullptr)); }
+
+    private:
+
+    Element* first_;
+};
+
 class Parser
 {
     public:
@@ -55,15 +98,94 @@ class Parser
            const PARSER_XML_NAME* attribute_name_list,
            PARSER_INT             attribute_name_list_length);
 
+    explicit Parser(const PARSER_CONFIG& config);
+
+    // Parser that resolves names with compile-time tables. Tables
+    // must outlive the parser.
+
+    template <typename ElementId, std::size_t ElementCount, typename AttributeId, std::size_t AttributeCount>
+    Parser(const NameTable<ElementId, ElementCount>&     element_names,
+           const NameTable<AttributeId, AttributeCount>& attribute_names);
+
     ~Parser();
 
     void Append(const PARSER_CHAR* xml_string,
                 PARSER_INT         xml_string_length) const;
 
+    // Parses a large buffer with threads. See parser_append_parallel().
+
+    PARSER_ERROR AppendParallel(const PARSER_CHAR* xml_string,
+                                PARSER_SIZE        xml_string_length,
+                                PARSER_INT         thread_count) const;
+
+    // Releases the parsed tree for parsing the next document. See
+    // parser_reset().
+
+    PARSER_ERROR Reset() const;
+
+    // Parses a memory-mapped file. See parser_parse_file().
+
+    PARSER_ERROR ParseFile(const PARSER_CHAR* path,
+                           PARSER_INT         flags = 0) const;
+
+    // Writes the tree back to XML. See parser_write_xml().
+
+    PARSER_ERROR Write(PARSER_WRITE_FUNCTION write,
+                       void*                 context,
+                       PARSER_INT            flags = 0) const;
+
+    PARSER_ERROR WriteToBuffer(PARSER_CHAR* buffer,
+                               PARSER_SIZE  buffer_size,
+                               PARSER_SIZE* bytes_written,
+                               PARSER_INT   flags = 0) const;
+
+    // Resolves names to name list indexes once for queries that
+    // compare only integers. Returns PARSER_UNKNOWN_INDEX if not found.
+
+    PARSER_INT ElementIndex(const PARSER_CHAR* element_name) const;
+
+    PARSER_INT AttributeIndex(const PARSER_CHAR* attribute_name) const;
+
     Element* FindElement(Element*           offset,
                          PARSER_INT         max_depth,
                          const PARSER_CHAR* element_name) const;
 
+    Element* FindElement(Element*   offset,
+                         PARSER_INT max_depth,
+                         PARSER_INT element_index) const;
+
+    template <typename Id, typename = std::enable_if_t<std::is_enum_v<Id>>>
+    Element* FindElement(Element*   offset,
+                         PARSER_INT max_depth,
+                         Id         element_id) const;
+
+    // Compiles a path for FindElement() and EvaluateQueries(). Free
+    // the query with parser_free_query(). See parser_compile_query().
+
+    PARSER_QUERY* CompileQuery(const PARSER_CHAR* path) const;
+
+    Element* FindElement(PARSER_QUERY* query) const;
+
+    PARSER_ERROR EvaluateQueries(PARSER_QUERY* const*  queries,
+                                 PARSER_INT            query_count,
+                                 PARSER_QUERY_FUNCTION match,
+                                 void*                 context) const;
+
+    // Keeps only elements that match the queries while parsing. See
+    // parser_set_filters().
+
+    PARSER_ERROR SetFilters(PARSER_QUERY* const*  queries,
+                            PARSER_INT            query_count,
+                            PARSER_QUERY_FUNCTION match = nullptr,
+                            void*                 context = nullptr) const;
+
+    ElementRange FindAllElements(const PARSER_CHAR* element_name) const;
+
+    ElementRange FindAllElements(PARSER_INT element_index) const;
+
+    template <typename Id, typename = std::enable_if_t<std::is_enum_v<Id>>>
+    ElementRange FindAllElements(Id element_id) const;
+
     static Element* GetChildElement(Element* parent);
 
     static Element* GetNextElement(Element* element);
@@ -72,15 +194,145 @@ class Parser
                                     Attribute*         offset,
                                     const PARSER_CHAR* attribute_name);
 
+    Attribute* FindElementAttribute(Element*   element,
+                                    Attribute* offset,
+                                    PARSER_INT attribute_index) const;
+
+    template <typename Id, typename = std::enable_if_t<std::is_enum_v<Id>>>
+    Attribute* FindElementAttribute(Element*   element,
+                                    Attribute* offset,
+                                    Id         attribute_id) const;
+
     static AttributeType GetAttributeType(Attribute* attribute);
 
     static std::optional<std::uint32_t> GetAttributeValue(Attribute* attribute);
 
+    static std::optional<std::int64_t> GetAttributeInt64(Attribute* attribute);
+
+    // Integer values are converted too.
+
+    static std::optional<double> GetAttributeDouble(Attribute* attribute);
+
     private:
 
     PARSER_XML* xml_;
 };
 
+// Reader
+// Pull parser over buffers given to Append(). See parser_next_token().
+
+class Reader
+{
+    public:
+
+    explicit Reader(const PARSER_CONFIG& config);
+
+    ~Reader();
+
+    Reader(const Reader&) = delete;
+    Reader& operator=(const Reader&) = delete;
+
+    PARSER_ERROR Append(const PARSER_CHAR* xml_string,
+                        PARSER_INT         xml_string_length) const;
+
+    // Returns 0 and the next token, EAGAIN when more input is
+    // needed or other error.
+
+    PARSER_ERROR Next(PARSER_TOKEN& token) const;
+
+    // Skips the rest of the innermost open element.
+
+    PARSER_ERROR SkipSubtree() const;
+
+    private:
+
+    PARSER_XML* xml_;
+};
+
+// Writer
+// Streaming writer that writes names by name list index. See
+// parser_writer_init(). Calls return the error of the constructor
+// if it failed.
+
+class Writer
+{
+    public:
+
+    Writer(const PARSER_CONFIG&  config,
+           PARSER_CHAR*          buffer,
+           PARSER_SIZE           buffer_size,
+           PARSER_WRITE_FUNCTION write,
+           void*                 context,
+           PARSER_INT            flags = 0);
+
+    Writer(const Writer&) = delete;
+    Writer& operator=(const Writer&) = delete;
+
+    PARSER_ERROR StartElement(PARSER_INT name_index);
+
+    PARSER_ERROR AttributeInt(PARSER_INT   name_index,
+                              std::int64_t value);
+
+    PARSER_ERROR AttributeFloat(PARSER_INT    name_index,
+                                PARSER_DOUBLE value);
+
+    PARSER_ERROR AttributeString(PARSER_INT         name_index,
+                                 const PARSER_CHAR* value,
+                                 PARSER_SIZE        length);
+
+    PARSER_ERROR Text(const PARSER_CHAR* text,
+                      PARSER_SIZE        length);
+
+    PARSER_ERROR EndElement();
+
+    PARSER_ERROR Flush();
+
+    private:
+
+    PARSER_WRITER writer_;
+    PARSER_ERROR  error_;
+};
+
+template <typename ElementId, std::size_t ElementCount, typename AttributeId, std::size_t AttributeCount>
+Parser::Parser(const NameTable<ElementId, ElementCount>&     element_names,
+               const NameTable<AttributeId, AttributeCount>& attribute_names)
+{
+    PARSER_CONFIG config;
+
+    parser_init_config(&config,
+                       element_names.List(),
+                       element_names.Count(),
+                       attribute_names.List(),
+                       attribute_names.Count());
+
+    config.element_name_lookup   = element_names.Lookup();
+    config.attribute_name_lookup = attribute_names.Lookup();
+
+    xml_ = parser_begin_config(&config);
+}
+
+template <typename Id, typename>
+Element* Parser::FindElement(Element*   offset,
+                             PARSER_INT max_depth,
+                             Id         element_id) const
+{
+    return(FindElement(offset, max_depth, static_cast<PARSER_INT>(element_id)));
+}
+
+template <typename Id, typename>
+ElementRange Parser::FindAllElements(Id element_id) const
+{
+    return(FindAllElements(static_cast<PARSER_INT>(element_id)));
+}
+
+template <typename Id, typename>
+Attribute* Parser::FindElementAttribute(Element*   element,
+                                        Attribute* offset,
+                                        Id         attribute_id) const
+{
+    return(FindElementAttribute(element, offset, static_cast<PARSER_INT>(attribute_id)));
+}
+
 } // xml_parser
 
 #endif /* __cplusplus */
@@ -0,0 +1,648 @@
+/*
+MIT License
+
+Copyright (c) 2018 Velli20
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+// Compact document. Parser events are written to per-field arrays
+// of elements and attributes instead of linked PARSER_ELEMENT nodes.
+
+// Includes
+
+#include <string.h>
+#include "xml_parser.h"
+
+// Defines
+
+#define PARSER_DOCUMENT_INITIAL_ELEMENTS    64
+#define PARSER_DOCUMENT_INITIAL_ATTRIBUTES  64
+#define PARSER_DOCUMENT_INITIAL_TEXT        1024
+#define PARSER_DOCUMENT_INITIAL_SEGMENTS    16
+
+// parser_document_grow
+// Grows array of count items to new capacity.
+
+static PARSER_ERROR parser_document_grow(PARSER_XML* xml,
+                                         void*       array,
+                                         PARSER_SIZE count,
+                                         PARSER_SIZE capacity,
+                                         PARSER_SIZE item_size)
+{
+    void** items;
+    void*  new_items;
+
+    items = array;
+
+    if ( xml->allocator.realloc && *items )
+    {
+        new_items = xml->allocator.realloc(xml->allocator.context, *items, capacity * item_size);
+    }
+
+    else
+    {
+        new_items = xml->allocator.alloc(xml->allocator.context, capacity * item_size);
+
+        if ( new_items && *items )
+        {
+            memcpy(new_items, *items, count * item_size);
+            xml->allocator.free(xml->allocator.context, *items);
+        }
+    }
+
+    if ( !new_items )
+        return(ENOMEM);
+
+    *items = new_items;
+
+    return(0);
+}
+
+// parser_document_reserve_element
+
+static PARSER_ERROR parser_document_reserve_element(PARSER_XML*      xml,
+                                                    PARSER_DOCUMENT* document)
+{
+    PARSER_SIZE count;
+    PARSER_SIZE capacity;
+
+    if ( document->element_count < document->element_capacity )
+        return(0);
+
+    if ( document->element_capacity >= PARSER_DOCUMENT_NONE / 2 )
+        return(ENOMEM);
+
+    count    = document->element_count;
+    capacity = document->element_capacity ? (PARSER_SIZE)document->element_capacity * 2 : PARSER_DOCUMENT_INITIAL_ELEMENTS;
+
+    if ( parser_document_grow(xml, &document->element_name,            count, capacity, sizeof(PARSER_INT))    ||
+         parser_document_grow(xml, &document->element_depth,           count, capacity, sizeof(PARSER_UINT32)) ||
+         parser_document_grow(xml, &document->element_parent,          count, capacity, sizeof(PARSER_UINT32)) ||
+         parser_document_grow(xml, &document->element_first_child,     count, capacity, sizeof(PARSER_UINT32)) ||
+         parser_document_grow(xml, &document->element_next_sibling,    count, capacity, sizeof(PARSER_UINT32)) ||
+         parser_document_grow(xml, &document->element_subtree_end,     count, capacity, sizeof(PARSER_UINT32)) ||
+         parser_document_grow(xml, &document->element_first_attribute, count, capacity, sizeof(PARSER_UINT32)) ||
+         parser_document_grow(xml, &document->element_text_offset,     count, capacity, sizeof(PARSER_UINT32)) ||
+         parser_document_grow(xml, &document->element_text_length,     count, capacity, sizeof(PARSER_UINT32)) )
+    {
+        return(ENOMEM);
+    }
+
+    document->element_capacity = (PARSER_UINT32)capacity;
+
+    return(0);
+}
+
+// parser_document_reserve_attribute
+
+static PARSER_ERROR parser_document_reserve_attribute(PARSER_XML*      xml,
+                                                      PARSER_DOCUMENT* document)
+{
+    PARSER_SIZE count;
+    PARSER_SIZE capacity;
+
+    if ( document->attribute_count < document->attribute_capacity )
+        return(0);
+
+    if ( document->attribute_capacity >= PARSER_DOCUMENT_NONE / 2 )
+        return(ENOMEM);
+
+    count    = document->attribute_count;
+    capacity = document->attribute_capacity ? (PARSER_SIZE)document->attribute_capacity * 2 : PARSER_DOCUMENT_INITIAL_ATTRIBUTES;
+
+    if ( parser_document_grow(xml, &document->attribute_name,         count, capacity, sizeof(PARSER_INT))    ||
+         parser_document_grow(xml, &document->attribute_value_offset, count, capacity, sizeof(PARSER_UINT32)) ||
+         parser_document_grow(xml, &document->attribute_value_length, count, capacity, sizeof(PARSER_UINT32)) )
+    {
+        return(ENOMEM);
+    }
+
+    document->attribute_capacity = (PARSER_UINT32)capacity;
+
+    return(0);
+}
+
+// parser_document_reserve_segment
+
+static PARSER_ERROR parser_document_reserve_segment(PARSER_XML*      xml,
+                                                    PARSER_DOCUMENT* document)
+{
+    PARSER_SIZE count;
+    PARSER_SIZE capacity;
+
+    if ( document->segment_count < document->segment_capacity )
+        return(0);
+
+    if ( document->segment_capacity >= PARSER_DOCUMENT_NONE / 2 )
+        return(ENOMEM);
+
+    count    = document->segment_count;
+    capacity = document->segment_capacity ? (PARSER_SIZE)document->segment_capacity * 2 : PARSER_DOCUMENT_INITIAL_SEGMENTS;
+
+    if ( parser_document_grow(xml, &document->segment_element, count, capacity, sizeof(PARSER_UINT32)) ||
+         parser_document_grow(xml, &document->segment_offset,  count, capacity, sizeof(PARSER_UINT32)) ||
+         parser_document_grow(xml, &document->segment_length,  count, capacity, sizeof(PARSER_UINT32)) )
+    {
+        return(ENOMEM);
+    }
+
+    document->segment_capacity = (PARSER_UINT32)capacity;
+
+    return(0);
+}
+
+// parser_document_reserve_text
+// Grows the text storage for length more characters. Offsets are 32-bit.
+
+static PARSER_ERROR parser_document_reserve_text(PARSER_XML*      xml,
+                                                 PARSER_DOCUMENT* document,
+                                                 PARSER_SIZE      length)
+{
+    PARSER_SIZE  capacity;
+    PARSER_ERROR error;
+
+    if ( length > PARSER_DOCUMENT_NONE - document->text_length )
+        return(ENOMEM);
+
+    if ( document->text_length + length <= document->text_capacity )
+        return(0);
+
+    for ( capacity = document->text_capacity ? document->text_capacity : PARSER_DOCUMENT_INITIAL_TEXT;
+          capacity < document->text_length + length;
+          capacity *= 2 );
+
+    error = parser_document_grow(xml, &document->text, document->text_length, capacity, sizeof(PARSER_CHAR));
+    if ( error )
+        return(error);
+
+    document->text_capacity = capacity;
+
+    return(0);
+}
+
+// parser_document_start_element
+// Element is linked as the first child of the open element or
+// as the next sibling of the latest closed element.
+
+static PARSER_ERROR parser_document_start_element(void*              context,
+                                                  PARSER_INT         name_index,
+                                                  const PARSER_CHAR* name,
+                                                  PARSER_SIZE        name_length)
+{
+    PARSER_DOCUMENT* document;
+    PARSER_XML*      xml;
+    PARSER_UINT32    element;
+    PARSER_ERROR     error;
+
+    (void)name;
+    (void)name_length;
+
+    xml      = context;
+    document = xml->document;
+
+    error = parser_document_reserve_element(xml, document);
+    if ( error )
+        return(error);
+
+    element = document->element_count++;
+
+    document->element_name[element]            = name_index;
+    document->element_depth[element]           = (PARSER_UINT32)xml->state->depth;
+    document->element_parent[element]          = document->current;
+    document->element_first_child[element]     = PARSER_DOCUMENT_NONE;
+    document->element_next_sibling[element]    = PARSER_DOCUMENT_NONE;
+    document->element_subtree_end[element]     = PARSER_DOCUMENT_NONE;
+    document->element_first_attribute[element] = document->attribute_count;
+    document->element_text_offset[element]     = 0;
+    document->element_text_length[element]     = 0;
+
+    if ( document->current != PARSER_DOCUMENT_NONE && document->element_first_child[document->current] == PARSER_DOCUMENT_NONE )
+        document->element_first_child[document->current] = element;
+
+    if ( document->last_closed != PARSER_DOCUMENT_NONE && document->element_parent[document->last_closed] == document->current )
+        document->element_next_sibling[document->last_closed] = element;
+
+    document->current = element;
+
+    return(0);
+}
+
+// parser_document_attribute
+
+static PARSER_ERROR parser_document_attribute(void*              context,
+                                              PARSER_INT         name_index,
+                                              const PARSER_CHAR* name,
+                                              PARSER_SIZE        name_length,
+                                              const PARSER_CHAR* value,
+                                              PARSER_SIZE        value_length)
+{
+    PARSER_DOCUMENT* document;
+    PARSER_XML*      xml;
+    PARSER_UINT32    attribute;
+    PARSER_SIZE      offset;
+    PARSER_ERROR     error;
+
+    (void)name;
+    (void)name_length;
+
+    xml      = context;
+    document = xml->document;
+    offset   = document->text_length;
+
+    error = parser_document_reserve_attribute(xml, document);
+    if ( error )
+        return(error);
+
+    error = parser_document_reserve_text(xml, document, value_length);
+    if ( error )
+        return(error);
+
+    memcpy(document->text + offset, value, value_length);
+    document->text_length += value_length;
+
+    attribute = document->attribute_count++;
+
+    document->attribute_name[attribute]         = name_index;
+    document->attribute_value_offset[attribute] = (PARSER_UINT32)offset;
+    document->attribute_value_length[attribute] = (PARSER_UINT32)value_length;
+
+    return(0);
+}
+
+// parser_document_text
+// Text is appended to the storage. Text that continues the latest
+// text of the element extends it, and text after a child element
+// starts a new segment.
+
+static PARSER_ERROR parser_document_text(void*              context,
+                                         const PARSER_CHAR* text,
+                                         PARSER_SIZE        length)
+{
+    PARSER_DOCUMENT* document;
+    PARSER_XML*      xml;
+    PARSER_UINT32    element;
+    PARSER_UINT32    segment;
+    PARSER_SIZE      offset;
+    PARSER_ERROR     error;
+
+    xml      = context;
+    document = xml->document;
+    element  = document->current;
+    offset   = document->text_length;
+
+    error = parser_document_reserve_text(xml, document, length);
+    if ( error )
+        return(error);
+
+    memcpy(document->text + offset, text, length);
+    document->text_length += length;
+
+    // First text of the element or text that continues it.
+
+    if ( !document->element_text_length[element] )
+    {
+        document->element_text_offset[element] = (PARSER_UINT32)offset;
+        document->element_text_length[element] = (PARSER_UINT32)length;
+        return(0);
+    }
+
+    segment = document->segment_count;
+
+    if ( segment && document->segment_element[segment - 1] == element )
+    {
+        if ( document->segment_offset[segment - 1] + document->segment_length[segment - 1] == offset )
+        {
+            document->segment_length[segment - 1] += (PARSER_UINT32)length;
+            return(0);
+        }
+    }
+
+    else if ( document->element_text_offset[element] + document->element_text_length[element] == offset )
+    {
+        document->element_text_length[element] += (PARSER_UINT32)length;
+        return(0);
+    }
+
+    error = parser_document_reserve_segment(xml, document);
+    if ( error )
+        return(error);
+
+    document->segment_element[segment] = element;
+    document->segment_offset[segment]  = (PARSER_UINT32)offset;
+    document->segment_length[segment]  = (PARSER_UINT32)length;
+    document->segment_count++;
+
+    return(0);
+}
+
+// parser_document_join_text
+// Copies text of the element and its segments from first up to the
+// last segment to the end of the storage. Each text is copied once
+// when its element ends.
+
+static PARSER_ERROR parser_document_join_text(PARSER_XML*      xml,
+                                              PARSER_DOCUMENT* document,
+                                              PARSER_UINT32    element,
+                                              PARSER_UINT32    first)
+{
+    PARSER_SIZE   offset;
+    PARSER_SIZE   length;
+    PARSER_UINT32 segment;
+    PARSER_ERROR  error;
+
+    length = document->element_text_length[element];
+
+    for ( segment = first; segment < document->segment_count; segment++ )
+        length += document->segment_length[segment];
+
+    error = parser_document_reserve_text(xml, document, length);
+    if ( error )
+        return(error);
+
+    offset = document->text_length;
+
+    memcpy(document->text + offset, document->text + document->element_text_offset[element], document->element_text_length[element]);
+    document->text_length += document->element_text_length[element];
+
+    for ( segment = first; segment < document->segment_count; segment++ )
+    {
+        memcpy(document->text + document->text_length, document->text + document->segment_offset[segment], document->segment_length[segment]);
+        document->text_length += document->segment_length[segment];
+    }
+
+    document->element_text_offset[element] = (PARSER_UINT32)offset;
+    document->element_text_length[element] = (PARSER_UINT32)length;
+    document->segment_count                = first;
+
+    return(0);
+}
+
+// parser_document_end_element
+// Segments of the element are the last ones because segments of
+// its children are joined already.
+
+static PARSER_ERROR parser_document_end_element(void*      context,
+                                                PARSER_INT name_index)
+{
+    PARSER_DOCUMENT* document;
+    PARSER_XML*      xml;
+    PARSER_UINT32    element;
+    PARSER_UINT32    first;
+    PARSER_ERROR     error;
+
+    (void)name_index;
+
+    xml      = context;
+    document = xml->document;
+    element  = document->current;
+
+    for ( first = document->segment_count; first && document->segment_element[first - 1] == element; first-- );
+
+    if ( first < document->segment_count )
+    {
+        error = parser_document_join_text(xml, document, element, first);
+        if ( error )
+            return(error);
+    }
+
+    document->element_subtree_end[element] = document->element_count;
+    document->last_closed                  = element;
+    document->current                      = document->element_parent[element];
+
+    return(0);
+}
+
+// parser_begin_document
+// Same as parser_begin_config() but the xml is stored as a compact
+// document instead of a tree. Document is read with parser_get_document()
+// and released with parser_free_xml().
+
+PARSER_XML* parser_begin_document(const PARSER_CONFIG* config)
+{
+    PARSER_SAX_HANDLER handler;
+    PARSER_XML*        xml;
+
+    handler.start_element = parser_document_start_element;
+    handler.attribute     = parser_document_attribute;
+    handler.text          = parser_document_text;
+    handler.end_element   = parser_document_end_element;
+    handler.context       = 0;
+
+    xml = parser_begin_sax(config, &handler);
+    if ( !xml )
+        return(0);
+
+    xml->document = xml->allocator.alloc(xml->allocator.context, sizeof(PARSER_DOCUMENT));
+    if ( !xml->document )
+    {
+        parser_free_xml(xml);
+        return(0);
+    }
+
+    memset(xml->document, 0, sizeof(PARSER_DOCUMENT));
+
+    xml->document->current     = PARSER_DOCUMENT_NONE;
+    xml->document->last_closed = PARSER_DOCUMENT_NONE;
+
+    xml->sax_handler.context = xml;
+
+    return(xml);
+}
+
+// parser_reset_document
+// Empties compact document and keeps its arrays. Called by
+// parser_reset().
+
+void parser_reset_document(PARSER_XML* xml)
+{
+    if ( !xml || !xml->document )
+        return;
+
+    xml->document->element_count   = 0;
+    xml->document->attribute_count = 0;
+    xml->document->text_length     = 0;
+    xml->document->segment_count   = 0;
+    xml->document->current         = PARSER_DOCUMENT_NONE;
+    xml->document->last_closed     = PARSER_DOCUMENT_NONE;
+}
+
+// parser_free_document
+// Releases compact document. Called by parser_free_xml().
+
+void parser_free_document(PARSER_XML* xml)
+{
+    PARSER_DOCUMENT* document;
+    void*            arrays[17];
+    PARSER_SIZE      i;
+
+    if ( !xml || !xml->document )
+        return;
+
+    document = xml->document;
+
+    arrays[0]  = document->element_name;
+    arrays[1]  = document->element_depth;
+    arrays[2]  = document->element_parent;
+    arrays[3]  = document->element_first_child;
+    arrays[4]  = document->element_next_sibling;
+    arrays[5]  = document->element_subtree_end;
+    arrays[6]  = document->element_first_attribute;
+    arrays[7]  = document->element_text_offset;
+    arrays[8]  = document->element_text_length;
+    arrays[9]  = document->attribute_name;
+    arrays[10] = document->attribute_value_offset;
+    arrays[11] = document->attribute_value_length;
+    arrays[12] = document->text;
+    arrays[13] = document->segment_element;
+    arrays[14] = document->segment_offset;
+    arrays[15] = document->segment_length;
+    arrays[16] = document;
+
+    for ( i = 0; i < sizeof(arrays) / sizeof(arrays[0]); i++ )
+    {
+        if ( arrays[i] )
+            xml->allocator.free(xml->allocator.context, arrays[i]);
+    }
+
+    xml->document = 0;
+}
+
+// parser_get_document
+
+const PARSER_DOCUMENT* parser_get_document(const PARSER_XML* xml)
+{
+    if ( !xml )
+        return(0);
+
+    return(xml->document);
+}
+
+// parser_document_find_element
+// Returns first element from first up to before last with matching
+// name index and depth at most max_depth, or PARSER_DOCUMENT_NONE.
+// Subtrees below max_depth are jumped over with subtree_end. Use
+// PARSER_DOCUMENT_NONE as last and max_depth for no limits.
+
+PARSER_UINT32 parser_document_find_element(const PARSER_DOCUMENT* document,
+                                           PARSER_UINT32          first,
+                                           PARSER_UINT32          last,
+                                           PARSER_UINT32          max_depth,
+                                           PARSER_INT             name_index)
+{
+    const PARSER_INT* names;
+    PARSER_UINT32     i;
+
+    if ( !document )
+        return(PARSER_DOCUMENT_NONE);
+
+    if ( last > document->element_count )
+        last = document->element_count;
+
+    names = document->element_name;
+
+    // Plain scan of the name array.
+
+    if ( max_depth == PARSER_DOCUMENT_NONE )
+    {
+        for ( i = first; i < last; i++ )
+        {
+            if ( names[i] == name_index )
+                return(i);
+        }
+
+        return(PARSER_DOCUMENT_NONE);
+    }
+
+    for ( i = first; i < last; )
+    {
+        if ( document->element_depth[i] > max_depth )
+        {
+            i = document->element_subtree_end[i];
+            continue;
+        }
+
+        if ( names[i] == name_index )
+            return(i);
+
+        i = document->element_depth[i] < max_depth ? i + 1 : document->element_subtree_end[i];
+    }
+
+    return(PARSER_DOCUMENT_NONE);
+}
+
+// parser_document_find_attribute
+// Returns attribute of the element with matching name index
+// or PARSER_DOCUMENT_NONE.
+
+PARSER_UINT32 parser_document_find_attribute(const PARSER_DOCUMENT* document,
+                                             PARSER_UINT32          element,
+                                             PARSER_INT             name_index)
+{
+    PARSER_UINT32 attribute;
+    PARSER_UINT32 last;
+
+    if ( !document || element >= document->element_count )
+        return(PARSER_DOCUMENT_NONE);
+
+    last = element + 1 < document->element_count ? document->element_first_attribute[element + 1] : document->attribute_count;
+
+    for ( attribute = document->element_first_attribute[element]; attribute < last; attribute++ )
+    {
+        if ( document->attribute_name[attribute] == name_index )
+            return(attribute);
+    }
+
+    return(PARSER_DOCUMENT_NONE);
+}
+
+// parser_document_get_text
+// Returns joined content strings of the element. Text is
+// not null terminated.
+
+PARSER_ERROR parser_document_get_text(const PARSER_DOCUMENT* document,
+                                      PARSER_UINT32          element,
+                                      const PARSER_CHAR**    text,
+                                      PARSER_SIZE*           length)
+{
+    if ( !document || element >= document->element_count || !text || !length )
+        return(EINVAL);
+
+    *text   = document->text + document->element_text_offset[element];
+    *length = document->element_text_length[element];
+
+    return(0);
+}
+
+// parser_document_get_attribute_value
+// Returns attribute value that is not null terminated.
+
+PARSER_ERROR parser_document_get_attribute_value(const PARSER_DOCUMENT* document,
+                                                 PARSER_UINT32          attribute,
+                                                 const PARSER_CHAR**    value,
+                                                 PARSER_SIZE*           length)
+{
+    if ( !document || attribute >= document->attribute_count || !value || !length )
+        return(EINVAL);
+
+    *value  = document->text + document->attribute_value_offset[attribute];
+    *length = document->attribute_value_length[attribute];
+
+    return(0);
+}
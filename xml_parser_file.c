@@ -0,0 +1,242 @@
+/*
+MIT License
+
+Copyright (c) 2018 Velli20
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+// File input. Files are memory-mapped on POSIX systems and read
+// into a buffer from the xml allocator elsewhere.
+
+// Includes
+
+#include <errno.h>
+#include <stddef.h>
+#include <inttypes.h>
+#include "xml_parser.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+#define PARSER_FILE_WITH_MMAP
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#else
+#include <stdio.h>
+#endif
+
+// Defines
+
+// Largest buffer passed to a single parser_append() call.
+
+#define PARSER_FILE_APPEND_SIZE ((PARSER_SIZE)1 << 30)
+
+#if defined(PARSER_FILE_WITH_MMAP)
+
+// parser_map_file
+
+static PARSER_ERROR parser_map_file(PARSER_XML*        xml,
+                                    const PARSER_CHAR* path,
+                                    void**             data,
+                                    PARSER_SIZE*       size)
+{
+    struct stat file_stat;
+    void*       mapping;
+    int         fd;
+
+    (void)xml;
+
+    fd = open(path, O_RDONLY);
+    if ( fd < 0 )
+        return(errno);
+
+    if ( fstat(fd, &file_stat) )
+    {
+        close(fd);
+        return(errno);
+    }
+
+    if ( file_stat.st_size < 1 )
+    {
+        close(fd);
+        return(EINVAL);
+    }
+
+    mapping = mmap(0, (size_t)file_stat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+    // Mapping stays valid after the descriptor is closed.
+
+    close(fd);
+
+    if ( mapping == MAP_FAILED )
+        return(errno);
+
+    // Pages are read once from start to end while parsing.
+
+    madvise(mapping, (size_t)file_stat.st_size, MADV_SEQUENTIAL);
+
+    *data = mapping;
+    *size = (PARSER_SIZE)file_stat.st_size;
+
+    return(0);
+}
+
+// parser_unmap_file
+
+static void parser_unmap_file(PARSER_XML* xml,
+                              void*       data,
+                              PARSER_SIZE size)
+{
+    (void)xml;
+
+    munmap(data, size);
+}
+
+#else
+
+// parser_map_file
+// Reads the whole file into a buffer allocated with the xml allocator.
+
+static PARSER_ERROR parser_map_file(PARSER_XML*        xml,
+                                    const PARSER_CHAR* path,
+                                    void**             data,
+                                    PARSER_SIZE*       size)
+{
+    FILE* file;
+    void* buffer;
+    long  length;
+
+    file = fopen(path, "rb");
+    if ( !file )
+        return(errno ? errno : ENOENT);
+
+    if ( fseek(file, 0, SEEK_END) || (length = ftell(file)) < 1 || fseek(file, 0, SEEK_SET) )
+    {
+        fclose(file);
+        return(EINVAL);
+    }
+
+    buffer = xml->allocator.alloc(xml->allocator.context, (PARSER_SIZE)length);
+    if ( !buffer )
+    {
+        fclose(file);
+        return(ENOMEM);
+    }
+
+    if ( fread(buffer, 1, (size_t)length, file) != (size_t)length )
+    {
+        xml->allocator.free(xml->allocator.context, buffer);
+        fclose(file);
+        return(EIO);
+    }
+
+    fclose(file);
+
+    *data = buffer;
+    *size = (PARSER_SIZE)length;
+
+    return(0);
+}
+
+// parser_unmap_file
+
+static void parser_unmap_file(PARSER_XML* xml,
+                              void*       data,
+                              PARSER_SIZE size)
+{
+    (void)size;
+
+    xml->allocator.free(xml->allocator.context, data);
+}
+
+#endif /* PARSER_FILE_WITH_MMAP */
+
+// parser_parse_file
+// Parses the whole file directly from a read-only memory mapping.
+// Mapping is released after parsing unless PARSER_FILE_FLAG_KEEP_MAPPING
+// is given or the xml is in in-situ mode, in which case values refer
+// to the mapping and it is released by parser_free_xml().
+
+PARSER_ERROR parser_parse_file(PARSER_XML*        xml,
+                               const PARSER_CHAR* path,
+                               PARSER_INT         flags)
+{
+    const PARSER_CHAR* data;
+    void*              mapping;
+    PARSER_SIZE        size;
+    PARSER_SIZE        offset;
+    PARSER_SIZE        length;
+    PARSER_INT         keep_mapping;
+    PARSER_ERROR       error;
+
+    if ( !xml || !path || !*path )
+        return(EINVAL);
+
+    keep_mapping = (flags & PARSER_FILE_FLAG_KEEP_MAPPING) || (xml->flags & PARSER_XML_FLAG_IN_SITU);
+
+    // Only one mapping is kept per xml.
+
+    if ( keep_mapping && xml->file_data )
+        return(EBUSY);
+
+    mapping = 0;
+    size    = 0;
+
+    error = parser_map_file(xml, path, &mapping, &size);
+    if ( error )
+        return(error);
+
+    data = mapping;
+
+    for ( offset = 0, error = 0; offset < size && !error; offset += length )
+    {
+        length = size - offset < PARSER_FILE_APPEND_SIZE ? size - offset : PARSER_FILE_APPEND_SIZE;
+        error  = parser_append(xml, data + offset, (PARSER_INT)length);
+    }
+
+    // Partially parsed in-situ tree refers to the mapping also on error.
+
+    if ( keep_mapping )
+    {
+        xml->file_data = mapping;
+        xml->file_size = size;
+    }
+
+    else
+    {
+        parser_unmap_file(xml, mapping, size);
+    }
+
+    return(error);
+}
+
+// parser_release_file
+// Releases the file mapping kept by parser_parse_file().
+
+void parser_release_file(PARSER_XML* xml)
+{
+    if ( !xml || !xml->file_data )
+        return;
+
+    parser_unmap_file(xml, xml->file_data, xml->file_size);
+
+    xml->file_data = 0;
+    xml->file_size = 0;
+}
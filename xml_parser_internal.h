@@ -0,0 +1,172 @@
+/*
+MIT License
+
+Copyright (c) 2018 Velli20
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+
+// Internal interface between the tokenizer and parsers that
+// produce events outside of parser_append(), and the query filters
+// that the tokenizer consults. Not part of the public interface.
+
+#ifndef xml_parser_internal_h
+#define xml_parser_internal_h
+
+// Includes
+
+#include "xml_parser.h"
+
+// Parsers on other threads use POSIX threads. Define
+// PARSER_WITHOUT_THREADS to parse only on the calling thread.
+
+#if !defined(PARSER_WITHOUT_THREADS) && (defined(__unix__) || defined(__APPLE__))
+#define PARSER_WITH_PTHREADS
+#include <pthread.h>
+#endif
+
+// parser_push_element_start
+// Pushed events are handled as if parser_append() had found
+// them: they build the tree or go to the event handler. Names
+// are already resolved to name list indexes. Non-zero result
+// puts the xml to error state.
+
+PARSER_ERROR parser_push_element_start(PARSER_XML*        xml,
+                                       PARSER_INT         name_index,
+                                       const PARSER_CHAR* name,
+                                       PARSER_SIZE        length);
+
+// parser_push_attribute
+
+PARSER_ERROR parser_push_attribute(PARSER_XML*        xml,
+                                   PARSER_INT         name_index,
+                                   const PARSER_CHAR* name,
+                                   PARSER_SIZE        name_length,
+                                   const PARSER_CHAR* value,
+                                   PARSER_SIZE        length);
+
+// parser_push_text
+
+PARSER_ERROR parser_push_text(PARSER_XML*        xml,
+                              const PARSER_CHAR* text,
+                              PARSER_SIZE        length);
+
+// parser_push_element_end
+
+PARSER_ERROR parser_push_element_end(PARSER_XML* xml,
+                                     PARSER_INT  name_index);
+
+// parser_tokenizer_at_tag_open
+// Returns non-zero if the latest character was '<' in content.
+
+PARSER_INT parser_tokenizer_at_tag_open(const PARSER_XML* xml);
+
+// parser_tokenizer_at_text
+// Returns non-zero if the tokenizer is between tokens in content.
+
+PARSER_INT parser_tokenizer_at_text(const PARSER_XML* xml);
+
+// parser_share_name_lookups
+// Sets lookups of the config to use the name indexes of the xml.
+
+void parser_share_name_lookups(const PARSER_XML* xml,
+                               PARSER_CONFIG*    config);
+
+// parser_get_declared_type
+// Returns declared type of the attribute name index or
+// PARSER_DECLARED_TYPE_NONE.
+
+PARSER_INT parser_get_declared_type(const PARSER_XML* xml,
+                                    PARSER_INT        index);
+
+// parser_decode_declared_value
+// Decodes value of a declared type other than string. Returns
+// PARSER_ATTRIBUTE_VALUE_TYPE_INTEGER or _FLOAT, or zero if the
+// value does not match the declaration.
+
+PARSER_INT parser_decode_declared_value(const PARSER_ATTRIBUTE_DECLARATION* declaration,
+                                        const PARSER_CHAR*                  value,
+                                        PARSER_SIZE                         length,
+                                        PARSER_INT64*                       int_value_ptr,
+                                        PARSER_DOUBLE*                      float_value_ptr);
+
+// parser_type_attribute_value
+// Types a value that was stored as a string with
+// PARSER_XML_FLAG_LAZY_VALUES. Does nothing if already typed.
+
+void parser_type_attribute_value(const PARSER_ATTRIBUTE* attribute);
+
+// Filter decisions for an element outside of matched subtrees.
+
+#define PARSER_FILTER_SKIP  0
+#define PARSER_FILTER_PASS  1
+#define PARSER_FILTER_KEEP  2
+#define PARSER_FILTER_TEST  3
+
+// parser_filter
+// Queries of parser_set_filters() and their step masks at each depth
+// of the open elements. Pending masks hold steps whose name matched
+// the innermost element but whose predicates wait for its attributes.
+// Mark is the arena position before the latest kept or tested element.
+
+typedef struct parser_filter
+{
+    PARSER_QUERY**          queries;
+    uint64_t*               masks;
+    uint64_t*               pending;
+    PARSER_SIZE             level_count;
+    const PARSER_ALLOCATOR* allocator;
+
+    PARSER_QUERY_FUNCTION   match;
+    void*                   context;
+
+    PARSER_ARENA_BLOCK*     mark_block;
+    PARSER_CHAR*            mark;
+
+    PARSER_INT              query_count;
+
+    // First query that matched the kept element.
+
+    PARSER_INT              matched_query;
+}
+PARSER_FILTER;
+
+// parser_filter_start
+// Matches element names of the query steps for an element that
+// starts at depth. Decision is PARSER_FILTER_TEST when predicates
+// must be tested with parser_filter_test().
+
+PARSER_ERROR parser_filter_start(PARSER_FILTER* filter,
+                                 PARSER_INT     depth,
+                                 PARSER_INT     name_index,
+                                 PARSER_INT*    decision);
+
+// parser_filter_test
+// Tests pending predicates when attributes of the element are complete.
+
+PARSER_INT parser_filter_test(PARSER_FILTER*        filter,
+                              PARSER_INT            depth,
+                              const PARSER_ELEMENT* element);
+
+// parser_free_filter
+
+void parser_free_filter(PARSER_XML* xml);
+
+#endif /* xml_parser_internal_h */
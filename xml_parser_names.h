@@ -0,0 +1,281 @@
+/*
+MIT License
+
+Copyright (c) 2018 Velli20
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef xml_parser_names_h
+#define xml_parser_names_h
+
+#ifdef __cplusplus
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+extern "C" {
+#include "xml_parser.h"
+}
+
+namespace xml_parser
+{
+
+namespace detail
+{
+
+// FNV-1a hash of the name, computed once per lookup.
+
+constexpr std::uint32_t NameHash(const char* name, std::size_t length)
+{
+    std::uint32_t hash = 2166136261u;
+
+    for ( std::size_t i = 0; i < length; i++ )
+    {
+        hash ^= static_cast<std::uint8_t>(name[i]);
+        hash *= 16777619u;
+    }
+
+    return(hash);
+}
+
+// Mixes name hash with a bucket displacement to get the final slot.
+
+constexpr std::uint32_t MixHash(std::uint32_t hash, std::uint32_t displacement)
+{
+    hash ^= displacement * 0x9e3779b9u;
+    hash ^= hash >> 16;
+    hash *= 0x85ebca6bu;
+    hash ^= hash >> 13;
+    hash *= 0xc2b2ae35u;
+    hash ^= hash >> 16;
+
+    return(hash);
+}
+
+constexpr std::size_t NameLength(const char* name)
+{
+    std::size_t length = 0;
+
+    while ( name[length] )
+        length++;
+
+    return(length);
+}
+
+constexpr std::size_t SlotCount(std::size_t name_count)
+{
+    std::size_t count = 8;
+
+    while ( count < name_count * 2 )
+        count *= 2;
+
+    return(count);
+}
+
+} // detail
+
+// NameTable
+// Compile-time name list with a perfect hash (hash and displace).
+// Names are hashed into buckets, and each bucket gets a displacement
+// that maps all of its names to free slots. Lookup hashes the name
+// once, reads one displacement and one slot and verifies the only
+// candidate. Id is an enum whose values are the name list indexes.
+
+template <typename Id, std::size_t N>
+class NameTable
+{
+    static_assert(std::is_enum_v<Id>, "Name id must be an enum");
+    static_assert(N > 0, "Name table must not be empty");
+
+    public:
+
+    static constexpr std::size_t   kSlotCount       = detail::SlotCount(N);
+    static constexpr std::uint32_t kMaxDisplacement = 1u << 16;
+
+    constexpr explicit NameTable(const std::array<const char*, N>& names)
+        : names_{}, lengths_{}, displacements_{}, slots_{}
+    {
+        std::array<std::uint32_t, N> hashes{};
+        std::array<std::size_t,   N> bucket_sizes{};
+        std::array<std::size_t,   N> members{};
+        std::size_t                  max_bucket_size = 0;
+
+        for ( std::size_t i = 0; i < kSlotCount; i++ )
+            slots_[i] = PARSER_UNKNOWN_INDEX;
+
+        for ( std::size_t i = 0; i < N; i++ )
+        {
+            names_[i]   = PARSER_XML_NAME{ names[i] };
+            lengths_[i] = detail::NameLength(names[i]);
+            hashes[i]   = detail::NameHash(names[i], lengths_[i]);
+
+            std::size_t bucket = hashes[i] % N;
+
+            bucket_sizes[bucket]++;
+
+            if ( bucket_sizes[bucket] > max_bucket_size )
+                max_bucket_size = bucket_sizes[bucket];
+        }
+
+        // Place largest buckets first while there is most free slots.
+
+        for ( std::size_t size = max_bucket_size; size > 0; size-- )
+        {
+            for ( std::size_t bucket = 0; bucket < N; bucket++ )
+            {
+                if ( bucket_sizes[bucket] != size )
+                    continue;
+
+                std::size_t member_count = 0;
+
+                for ( std::size_t i = 0; i < N; i++ )
+                {
+                    if ( hashes[i] % N == bucket )
+                        members[member_count++] = i;
+                }
+
+                displacements_[bucket] = PlaceBucket(hashes, members, member_count);
+            }
+        }
+    }
+
+    // Returns index of the name or PARSER_UNKNOWN_INDEX.
+
+    constexpr PARSER_INT Find(const char* name, std::size_t length) const
+    {
+        std::uint32_t hash  = detail::NameHash(name, length);
+        PARSER_INT    index = slots_[detail::MixHash(hash, displacements_[hash % N]) & (kSlotCount - 1)];
+
+        if ( index == PARSER_UNKNOWN_INDEX || lengths_[static_cast<std::size_t>(index)] != length )
+            return(PARSER_UNKNOWN_INDEX);
+
+        for ( std::size_t i = 0; i < length; i++ )
+        {
+            if ( names_[static_cast<std::size_t>(index)].name[i] != name[i] )
+                return(PARSER_UNKNOWN_INDEX);
+        }
+
+        return(index);
+    }
+
+    constexpr PARSER_INT Find(const char* name) const
+    {
+        return(Find(name, detail::NameLength(name)));
+    }
+
+    static constexpr PARSER_INT Index(Id id)
+    {
+        return(static_cast<PARSER_INT>(id));
+    }
+
+    constexpr const char* Name(Id id) const
+    {
+        return(names_[static_cast<std::size_t>(id)].name);
+    }
+
+    // Name list that is passed to the parser.
+
+    constexpr const PARSER_XML_NAME* List() const
+    {
+        return(names_.data());
+    }
+
+    static constexpr PARSER_INT Count()
+    {
+        return(static_cast<PARSER_INT>(N));
+    }
+
+    // Lookup that replaces runtime hash index of the parser. Table
+    // must outlive the parser.
+
+    PARSER_NAME_LOOKUP Lookup() const
+    {
+        return(PARSER_NAME_LOOKUP{ &NameTable::LookupFunction, this });
+    }
+
+    private:
+
+    static PARSER_INT LookupFunction(const void*        context,
+                                     const PARSER_CHAR* name,
+                                     PARSER_SIZE        length)
+    {
+        return(static_cast<const NameTable*>(context)->Find(name, length));
+    }
+
+    // Returns displacement that maps all bucket members to free slots.
+
+    constexpr std::uint32_t PlaceBucket(const std::array<std::uint32_t, N>& hashes,
+                                        const std::array<std::size_t, N>&   members,
+                                        std::size_t                         member_count)
+    {
+        std::array<std::size_t, N> member_slots{};
+
+        for ( std::uint32_t displacement = 0; displacement < kMaxDisplacement; displacement++ )
+        {
+            bool fits = true;
+
+            for ( std::size_t i = 0; i < member_count && fits; i++ )
+            {
+                member_slots[i] = detail::MixHash(hashes[members[i]], displacement) & (kSlotCount - 1);
+
+                if ( slots_[member_slots[i]] != PARSER_UNKNOWN_INDEX )
+                    fits = false;
+
+                for ( std::size_t j = 0; j < i && fits; j++ )
+                {
+                    if ( member_slots[j] == member_slots[i] )
+                        fits = false;
+                }
+            }
+
+            if ( !fits )
+                continue;
+
+            for ( std::size_t i = 0; i < member_count; i++ )
+                slots_[member_slots[i]] = static_cast<PARSER_INT>(members[i]);
+
+            return(displacement);
+        }
+
+        // Not a constant expression: duplicate names or full hash collision.
+
+        throw "xml_parser::NameTable: no perfect hash found";
+    }
+
+    std::array<PARSER_XML_NAME, N>       names_;
+    std::array<std::size_t, N>           lengths_;
+    std::array<std::uint32_t, N>         displacements_;
+    std::array<PARSER_INT, kSlotCount>   slots_;
+};
+
+// MakeNameTable
+// constexpr auto kElements = MakeNameTable<ElementId>("root", "item");
+
+template <typename Id, typename... Names>
+constexpr NameTable<Id, sizeof...(Names)> MakeNameTable(Names... names)
+{
+    return(NameTable<Id, sizeof...(Names)>(std::array<const char*, sizeof...(Names)>{ names... }));
+}
+
+} // xml_parser
+
+#endif /* __cplusplus */
+#endif /* xml_parser_names_h */
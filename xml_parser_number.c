@@ -0,0 +1,441 @@
+/*
+MIT License
+
+Copyright (c) 2018 Velli20
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+// Decoding of numeric attribute values. Digits are read eight at
+// a time, and floats that have at most 19 significant digits and a
+// small exponent are computed exactly with one multiplication or
+// division. Other floats are passed to strtod() as digits and an
+// exponent without a decimal point, so the result does not depend
+// on the locale.
+
+// Includes
+
+#include <float.h>
+#include <stdlib.h>
+#include <string.h>
+#include "xml_parser.h"
+
+// Defines
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#define PARSER_NUMBER_SWAR
+#endif
+
+// Exact float result needs double rounding of each operation,
+// which is not the case with x87 extended precision.
+
+#if defined(FLT_EVAL_METHOD) && FLT_EVAL_METHOD == 0
+#define PARSER_NUMBER_FAST_FLOAT
+#endif
+
+// Unsigned 64-bit mantissa holds any 19 digits.
+
+#define PARSER_NUMBER_MAX_DIGITS        19
+
+// Largest integer that double holds exactly is 2^53.
+
+#define PARSER_NUMBER_MAX_EXACT         ((uint64_t)1 << 53)
+
+// Exponent digits after this do not change the result.
+
+#define PARSER_NUMBER_MAX_EXPONENT      100000
+
+// Significant digits that are passed to strtod(). Correct rounding
+// of a double needs at most 767 digits, and the digits after them
+// only matter by being zero or not.
+
+#define PARSER_NUMBER_MAX_STRTOD_DIGITS 768
+
+// Sign, digits, one sticky digit, 'e' and a 64-bit exponent.
+
+#define PARSER_NUMBER_BUFFER_SIZE       (PARSER_NUMBER_MAX_STRTOD_DIGITS + 32)
+
+#define PARSER_NUMBER_SWAR_ASCII_ZEROS  ((uint64_t)0x3030303030303030ull)
+
+// Variables
+
+// Powers of ten that are exact doubles.
+
+static const double parser_number_powers_of_ten[]=
+{
+    1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+static const uint64_t parser_number_integer_powers_of_ten[]=
+{
+    1ull,
+    10ull,
+    100ull,
+    1000ull,
+    10000ull,
+    100000ull,
+    1000000ull,
+    10000000ull,
+    100000000ull,
+    1000000000ull,
+    10000000000ull,
+    100000000000ull,
+    1000000000000ull,
+    10000000000000ull,
+    100000000000000ull,
+    1000000000000000ull,
+    10000000000000000ull
+};
+
+#if defined(PARSER_NUMBER_SWAR)
+
+// parser_number_is_eight_digits
+// Every byte is from '0' to '9' when both the high nibble is 3 and
+// adding 6 does not carry into the high nibble.
+
+static inline PARSER_INT parser_number_is_eight_digits(uint64_t word)
+{
+    return((((word & 0xF0F0F0F0F0F0F0F0ull) | (((word + 0x0606060606060606ull) & 0xF0F0F0F0F0F0F0F0ull) >> 4)) == 0x3333333333333333ull));
+}
+
+// parser_number_eight_digits
+// Value of eight digits with the first digit in the lowest byte.
+// Pairs, quads and the final two halves are combined with three
+// multiplications.
+
+static inline uint64_t parser_number_eight_digits(uint64_t word)
+{
+    word -= PARSER_NUMBER_SWAR_ASCII_ZEROS;
+    word  = (word * 10) + (word >> 8);
+    word  = (((word & 0x000000FF000000FFull) * (100 + (1000000ull << 32))) +
+             (((word >> 16) & 0x000000FF000000FFull) * (1 + (10000ull << 32)))) >> 32;
+
+    return(word);
+}
+
+#endif /* PARSER_NUMBER_SWAR */
+
+// parser_number_count_digits
+// Returns length of the run of digits at the beginning of string.
+
+static PARSER_SIZE parser_number_count_digits(const PARSER_CHAR* string,
+                                              PARSER_SIZE        length)
+{
+    PARSER_SIZE n;
+
+    n = 0;
+
+#if defined(PARSER_NUMBER_SWAR)
+
+    {
+        uint64_t word;
+
+        for ( ; n + 8 <= length; n += 8 )
+        {
+            memcpy(&word, string + n, sizeof(word));
+
+            if ( !parser_number_is_eight_digits(word) )
+                break;
+        }
+    }
+
+#endif
+
+    while ( n < length && string[n] >= '0' && string[n] <= '9' )
+        n++;
+
+    return(n);
+}
+
+// parser_number_accumulate
+// Appends count digits to value. Caller makes sure that the
+// result fits.
+
+static uint64_t parser_number_accumulate(uint64_t           value,
+                                         const PARSER_CHAR* digits,
+                                         PARSER_SIZE        count)
+{
+    PARSER_SIZE n;
+
+    n = 0;
+
+#if defined(PARSER_NUMBER_SWAR)
+
+    {
+        uint64_t word;
+
+        for ( ; n + 8 <= count; n += 8 )
+        {
+            memcpy(&word, digits + n, sizeof(word));
+
+            value = value * 100000000ull + parser_number_eight_digits(word);
+        }
+    }
+
+#endif
+
+    for ( ; n < count; n++ )
+        value = value * 10 + (uint64_t)(digits[n] - '0');
+
+    return(value);
+}
+
+// parser_number_strtod
+// Slow path for floats that are not exact with the fast path. Value
+// is the digits of integer and fraction times 10^exponent. Digits
+// after PARSER_NUMBER_MAX_STRTOD_DIGITS are replaced by one nonzero
+// digit if any of them is not zero.
+
+static PARSER_DOUBLE parser_number_strtod(const PARSER_CHAR* integer,
+                                          PARSER_SIZE        integer_length,
+                                          const PARSER_CHAR* fraction,
+                                          PARSER_SIZE        fraction_length,
+                                          int64_t            exponent,
+                                          PARSER_INT         negative)
+{
+    PARSER_CHAR  buffer[PARSER_NUMBER_BUFFER_SIZE];
+    PARSER_CHAR  exponent_digits[24];
+    PARSER_CHAR* position;
+    PARSER_SIZE  count;
+    PARSER_SIZE  n;
+    uint64_t     magnitude;
+
+    position = buffer;
+
+    if ( negative )
+        *position++ = '-';
+
+    // Integer digits and then fraction digits up to the limit.
+
+    count = integer_length < PARSER_NUMBER_MAX_STRTOD_DIGITS ? integer_length : PARSER_NUMBER_MAX_STRTOD_DIGITS;
+
+    memcpy(position, integer, count);
+    position += count;
+    exponent += (int64_t)(integer_length - count);
+
+    n = fraction_length < PARSER_NUMBER_MAX_STRTOD_DIGITS - count ? fraction_length : PARSER_NUMBER_MAX_STRTOD_DIGITS - count;
+
+    memcpy(position, fraction, n);
+    position += n;
+    exponent -= (int64_t)n;
+
+    // Dropped integer digits start from index count and dropped
+    // fraction digits from index n.
+
+    while ( count < integer_length && integer[count] == '0' )
+        count++;
+
+    while ( n < fraction_length && fraction[n] == '0' )
+        n++;
+
+    if ( count < integer_length || n < fraction_length )
+    {
+        *position++ = '1';
+        exponent--;
+    }
+
+    if ( position == buffer + negative )
+        *position++ = '0';
+
+    // Exponent digits are written from the end.
+
+    *position++ = 'e';
+
+    if ( exponent < 0 )
+        *position++ = '-';
+
+    magnitude = exponent < 0 ? (uint64_t)0 - (uint64_t)exponent : (uint64_t)exponent;
+    n         = sizeof(exponent_digits);
+
+    do
+    {
+        exponent_digits[--n] = (PARSER_CHAR)('0' + magnitude % 10);
+        magnitude           /= 10;
+    }
+    while ( magnitude );
+
+    memcpy(position, exponent_digits + n, sizeof(exponent_digits) - n);
+    position += sizeof(exponent_digits) - n;
+
+    *position = '\0';
+
+    return(strtod(buffer, 0));
+}
+
+// parser_parse_number
+
+PARSER_INT parser_parse_number(const PARSER_CHAR* string,
+                               PARSER_SIZE        length,
+                               PARSER_INT64*      int_value_ptr,
+                               PARSER_DOUBLE*     float_value_ptr)
+{
+    const PARSER_CHAR* integer;
+    const PARSER_CHAR* fraction;
+    PARSER_SIZE        integer_length;
+    PARSER_SIZE        fraction_length;
+    PARSER_SIZE        n;
+    PARSER_SIZE        count;
+    uint64_t           mantissa;
+    int64_t            exponent;
+    PARSER_INT         exponent_negative;
+    PARSER_INT         negative;
+    PARSER_INT         is_float;
+
+    if ( !string || !int_value_ptr || !float_value_ptr )
+        return(PARSER_ATTRIBUTE_VALUE_TYPE_STRING);
+
+    negative = length && string[0] == '-';
+    n        = (PARSER_SIZE)negative;
+    is_float = 0;
+
+    // Integer part.
+
+    integer        = string + n;
+    integer_length = parser_number_count_digits(integer, length - n);
+    n             += integer_length;
+
+    // Fraction part.
+
+    fraction        = string + n;
+    fraction_length = 0;
+
+    if ( n < length && string[n] == '.' )
+    {
+        is_float        = 1;
+        fraction        = string + n + 1;
+        fraction_length = parser_number_count_digits(fraction, length - n - 1);
+        n              += fraction_length + 1;
+    }
+
+    if ( !integer_length && !fraction_length )
+        return(PARSER_ATTRIBUTE_VALUE_TYPE_STRING);
+
+    // Exponent.
+
+    exponent = 0;
+
+    if ( n < length && (string[n] == 'e' || string[n] == 'E') )
+    {
+        is_float          = 1;
+        n++;
+        exponent_negative = n < length && string[n] == '-';
+
+        if ( n < length && (string[n] == '-' || string[n] == '+') )
+            n++;
+
+        count = parser_number_count_digits(string + n, length - n);
+        if ( !count )
+            return(PARSER_ATTRIBUTE_VALUE_TYPE_STRING);
+
+        for ( ; count; count--, n++ )
+        {
+            if ( exponent < PARSER_NUMBER_MAX_EXPONENT )
+                exponent = exponent * 10 + (string[n] - '0');
+        }
+
+        if ( exponent_negative )
+            exponent = -exponent;
+    }
+
+    if ( n != length )
+        return(PARSER_ATTRIBUTE_VALUE_TYPE_STRING);
+
+    // Leading zeros are not significant.
+
+    while ( integer_length && *integer == '0' )
+    {
+        integer++;
+        integer_length--;
+    }
+
+    if ( !integer_length )
+    {
+        while ( fraction_length && *fraction == '0' )
+        {
+            fraction++;
+            fraction_length--;
+            exponent--;
+        }
+    }
+
+    // Integers that do not fit 64 bits are floats.
+
+    if ( !is_float && integer_length <= PARSER_NUMBER_MAX_DIGITS )
+    {
+        mantissa = parser_number_accumulate(0, integer, integer_length);
+
+        if ( mantissa <= (uint64_t)INT64_MAX )
+        {
+            *int_value_ptr = negative ? -(int64_t)mantissa : (int64_t)mantissa;
+            return(PARSER_ATTRIBUTE_VALUE_TYPE_INTEGER);
+        }
+
+        if ( negative && mantissa == (uint64_t)INT64_MAX + 1 )
+        {
+            *int_value_ptr = INT64_MIN;
+            return(PARSER_ATTRIBUTE_VALUE_TYPE_INTEGER);
+        }
+    }
+
+#if defined(PARSER_NUMBER_FAST_FLOAT)
+
+    // Value is mantissa * 10^exponent. When both are exact doubles
+    // the correctly rounded result is one operation away.
+
+    if ( integer_length + fraction_length <= PARSER_NUMBER_MAX_DIGITS )
+    {
+        double  value;
+        int64_t scale;
+
+        mantissa = parser_number_accumulate(0, integer, integer_length);
+        mantissa = parser_number_accumulate(mantissa, fraction, fraction_length);
+        scale    = exponent - (int64_t)fraction_length;
+
+        // Zeros after the exponent are moved to the mantissa
+        // while it stays exact.
+
+        if ( scale > 22 && scale <= 22 + 16 && mantissa <= PARSER_NUMBER_MAX_EXACT / parser_number_integer_powers_of_ten[scale - 22] )
+        {
+            mantissa *= parser_number_integer_powers_of_ten[scale - 22];
+            scale     = 22;
+        }
+
+        if ( mantissa <= PARSER_NUMBER_MAX_EXACT && (!mantissa || (scale >= -22 && scale <= 22)) )
+        {
+            value = (double)mantissa;
+
+            if ( mantissa && scale < 0 )
+                value /= parser_number_powers_of_ten[-scale];
+
+            else if ( mantissa )
+                value *= parser_number_powers_of_ten[scale];
+
+            *float_value_ptr = negative ? -value : value;
+
+            return(PARSER_ATTRIBUTE_VALUE_TYPE_FLOAT);
+        }
+    }
+
+#endif
+
+    *float_value_ptr = parser_number_strtod(integer, integer_length, fraction, fraction_length, exponent, negative);
+
+    return(PARSER_ATTRIBUTE_VALUE_TYPE_FLOAT);
+}
@@ -0,0 +1,747 @@
+/*
+MIT License
+
+Copyright (c) 2018 Velli20
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+
+// Parallel parse of one large buffer. Input is split to chunks at
+// '<' characters that probably start a tag, and each chunk is
+// tokenized on a worker thread assuming that the tokenizer is in
+// content when the chunk begins. Workers record the events of their
+// chunk and the calling thread replays them in order to the xml, so
+// the result is the same tree, document or event sequence as with
+// parser_append(). A worker ending somewhere else than at the next
+// chunk's '<' shows that the next chunk was guessed wrong, for
+// example when the '<' was in a comment or attribute value. Such
+// chunks are parsed again serially until the parser is back in
+// content at a chunk boundary.
+
+// Includes
+
+#include <string.h>
+#include "xml_parser.h"
+#include "xml_parser_internal.h"
+
+// Defines
+
+// Inputs are split to about four chunks per thread so that replay
+// can start while later chunks are still parsed.
+
+#define PARSER_PARALLEL_CHUNKS_PER_THREAD   4
+#define PARSER_PARALLEL_MIN_CHUNK_LENGTH    (16 * 1024)
+#define PARSER_PARALLEL_MAX_CHUNK_LENGTH    ((PARSER_SIZE)1 << 30)
+#define PARSER_PARALLEL_MAX_THREADS         256
+
+// Depth of the worker before its chunk. Chunks may close elements
+// that were opened in earlier chunks.
+
+#define PARSER_PARALLEL_BASE_DEPTH          (1 << 30)
+
+#define PARSER_PARALLEL_INITIAL_EVENTS      1024
+#define PARSER_PARALLEL_INITIAL_NAMES       1024
+
+#define PARSER_PARALLEL_EVENT_START_ELEMENT 1
+#define PARSER_PARALLEL_EVENT_ATTRIBUTE     2
+#define PARSER_PARALLEL_EVENT_TEXT          3
+#define PARSER_PARALLEL_EVENT_END_ELEMENT   4
+
+// Macros
+
+#define IS_PARALLEL_WHITESPACE(C)   ((C) == ' ' || (C) == '\t' || (C) == '\r' || (C) == '\n')
+#define IS_PARALLEL_NAME_START(C)   (((C) >= 'a' && (C) <= 'z') || ((C) >= 'A' && (C) <= 'Z') || \
+                                     (C) == '_' || (C) == ':' || (unsigned char)(C) >= 0x80)
+
+// parser_parallel_append_serial
+// Appends input in pieces that fit to parser_append().
+
+static PARSER_ERROR parser_parallel_append_serial(PARSER_XML*        xml,
+                                                  const PARSER_CHAR* string,
+                                                  PARSER_SIZE        length)
+{
+    PARSER_SIZE  piece;
+    PARSER_ERROR error;
+
+    while ( length > 0 )
+    {
+        piece = length < PARSER_PARALLEL_MAX_CHUNK_LENGTH ? length : PARSER_PARALLEL_MAX_CHUNK_LENGTH;
+
+        error = parser_append(xml, string, (PARSER_INT)piece);
+        if ( error )
+            return(error);
+
+        string += piece;
+        length -= piece;
+    }
+
+    return(0);
+}
+
+#if defined(PARSER_WITH_PTHREADS)
+
+// Types
+
+// parser_parallel_event
+// Recorded event. Attribute names are copied to the names of
+// the chunk and referenced with name_offset, other strings are
+// slices of the input.
+
+typedef struct parser_parallel_event
+{
+    const PARSER_CHAR* name;
+    const PARSER_CHAR* value;
+    PARSER_SIZE        name_offset;
+    PARSER_SIZE        name_length;
+    PARSER_SIZE        value_length;
+    PARSER_INT         type;
+    PARSER_INT         name_index;
+}
+PARSER_PARALLEL_EVENT;
+
+// parser_parallel_chunk
+
+typedef struct parser_parallel_chunk
+{
+    const PARSER_CHAR*     string;
+    PARSER_SIZE            length;
+
+    PARSER_PARALLEL_EVENT* events;
+    PARSER_SIZE            event_count;
+    PARSER_SIZE            event_capacity;
+
+    PARSER_CHAR*           names;
+    PARSER_SIZE            names_length;
+    PARSER_SIZE            names_capacity;
+
+    // Error of the worker and whether the chunk ended where the
+    // next chunk was assumed to begin.
+
+    PARSER_ERROR           error;
+    PARSER_INT             boundary_ok;
+    PARSER_INT             done;
+    PARSER_INT             pad;
+}
+PARSER_PARALLEL_CHUNK;
+
+// parser_parallel_job
+
+typedef struct parser_parallel_job
+{
+    PARSER_XML*            xml;
+    PARSER_PARALLEL_CHUNK* chunks;
+    PARSER_SIZE            chunk_count;
+    PARSER_SIZE            next_chunk;
+
+    // Input ends after the last chunk.
+
+    const PARSER_CHAR*     end;
+    PARSER_INT             stop;
+    PARSER_INT             pad;
+
+    pthread_mutex_t        mutex;
+    pthread_cond_t         chunk_done;
+}
+PARSER_PARALLEL_JOB;
+
+// parser_parallel_grow
+// Grows array of count items to new capacity.
+
+static PARSER_ERROR parser_parallel_grow(PARSER_XML* xml,
+                                         void*       array,
+                                         PARSER_SIZE count,
+                                         PARSER_SIZE capacity,
+                                         PARSER_SIZE item_size)
+{
+    void** items;
+    void*  new_items;
+
+    items = array;
+
+    if ( xml->allocator.realloc && *items )
+    {
+        new_items = xml->allocator.realloc(xml->allocator.context, *items, capacity * item_size);
+    }
+
+    else
+    {
+        new_items = xml->allocator.alloc(xml->allocator.context, capacity * item_size);
+
+        if ( new_items && *items )
+        {
+            memcpy(new_items, *items, count * item_size);
+            xml->allocator.free(xml->allocator.context, *items);
+        }
+    }
+
+    if ( !new_items )
+        return(ENOMEM);
+
+    *items = new_items;
+
+    return(0);
+}
+
+// parser_parallel_free_chunk
+
+static void parser_parallel_free_chunk(PARSER_XML*            xml,
+                                       PARSER_PARALLEL_CHUNK* chunk)
+{
+    if ( chunk->events )
+        xml->allocator.free(xml->allocator.context, chunk->events);
+
+    if ( chunk->names )
+        xml->allocator.free(xml->allocator.context, chunk->names);
+
+    chunk->events         = 0;
+    chunk->event_count    = 0;
+    chunk->event_capacity = 0;
+    chunk->names          = 0;
+    chunk->names_length   = 0;
+    chunk->names_capacity = 0;
+}
+
+// parser_parallel_recorder
+// Context of the event handler of a worker.
+
+typedef struct parser_parallel_recorder
+{
+    PARSER_XML*            xml;
+    PARSER_PARALLEL_CHUNK* chunk;
+}
+PARSER_PARALLEL_RECORDER;
+
+// parser_parallel_record
+
+static PARSER_ERROR parser_parallel_record(PARSER_PARALLEL_RECORDER* recorder,
+                                           PARSER_INT                type,
+                                           PARSER_INT                name_index,
+                                           const PARSER_CHAR*        name,
+                                           PARSER_SIZE               name_length,
+                                           const PARSER_CHAR*        value,
+                                           PARSER_SIZE               value_length)
+{
+    PARSER_PARALLEL_CHUNK* chunk;
+    PARSER_PARALLEL_EVENT* event;
+    PARSER_SIZE            capacity;
+    PARSER_ERROR           error;
+
+    chunk = recorder->chunk;
+
+    if ( chunk->event_count == chunk->event_capacity )
+    {
+        capacity = chunk->event_capacity ? chunk->event_capacity * 2 : PARSER_PARALLEL_INITIAL_EVENTS;
+
+        error = parser_parallel_grow(recorder->xml, &chunk->events, chunk->event_count, capacity, sizeof(PARSER_PARALLEL_EVENT));
+        if ( error )
+            return(error);
+
+        chunk->event_capacity = capacity;
+    }
+
+    event = &chunk->events[chunk->event_count++];
+
+    event->type         = type;
+    event->name_index   = name_index;
+    event->name         = name;
+    event->name_offset  = 0;
+    event->name_length  = name_length;
+    event->value        = value;
+    event->value_length = value_length;
+
+    return(0);
+}
+
+// parser_parallel_on_start_element
+
+static PARSER_ERROR parser_parallel_on_start_element(void*              context,
+                                                     PARSER_INT         name_index,
+                                                     const PARSER_CHAR* name,
+                                                     PARSER_SIZE        name_length)
+{
+    return(parser_parallel_record(context, PARSER_PARALLEL_EVENT_START_ELEMENT, name_index, name, name_length, 0, 0));
+}
+
+// parser_parallel_on_attribute
+// Attribute name is in the scratch buffer of the worker.
+
+static PARSER_ERROR parser_parallel_on_attribute(void*              context,
+                                                 PARSER_INT         name_index,
+                                                 const PARSER_CHAR* name,
+                                                 PARSER_SIZE        name_length,
+                                                 const PARSER_CHAR* value,
+                                                 PARSER_SIZE        value_length)
+{
+    PARSER_PARALLEL_RECORDER* recorder;
+    PARSER_PARALLEL_CHUNK*    chunk;
+    PARSER_SIZE               capacity;
+    PARSER_ERROR              error;
+
+    recorder = context;
+    chunk    = recorder->chunk;
+
+    if ( chunk->names_length + name_length > chunk->names_capacity )
+    {
+        capacity = chunk->names_capacity ? chunk->names_capacity : PARSER_PARALLEL_INITIAL_NAMES;
+
+        while ( capacity < chunk->names_length + name_length )
+            capacity *= 2;
+
+        error = parser_parallel_grow(recorder->xml, &chunk->names, chunk->names_length, capacity, sizeof(PARSER_CHAR));
+        if ( error )
+            return(error);
+
+        chunk->names_capacity = capacity;
+    }
+
+    memcpy(chunk->names + chunk->names_length, name, name_length);
+
+    error = parser_parallel_record(recorder, PARSER_PARALLEL_EVENT_ATTRIBUTE, name_index, 0, name_length, value, value_length);
+    if ( error )
+        return(error);
+
+    chunk->events[chunk->event_count - 1].name_offset  = chunk->names_length;
+    chunk->names_length                               += name_length;
+
+    return(0);
+}
+
+// parser_parallel_on_text
+
+static PARSER_ERROR parser_parallel_on_text(void*              context,
+                                            const PARSER_CHAR* text,
+                                            PARSER_SIZE        length)
+{
+    return(parser_parallel_record(context, PARSER_PARALLEL_EVENT_TEXT, PARSER_UNKNOWN_INDEX, 0, 0, text, length));
+}
+
+// parser_parallel_on_end_element
+
+static PARSER_ERROR parser_parallel_on_end_element(void*      context,
+                                                   PARSER_INT name_index)
+{
+    return(parser_parallel_record(context, PARSER_PARALLEL_EVENT_END_ELEMENT, name_index, 0, 0, 0, 0));
+}
+
+// parser_parallel_parse_chunk
+// Tokenizes the chunk and the '<' that begins the next chunk
+// with a worker parser that has the name lists of the xml.
+
+static void parser_parallel_parse_chunk(PARSER_PARALLEL_JOB*   job,
+                                        PARSER_PARALLEL_CHUNK* chunk)
+{
+    PARSER_PARALLEL_RECORDER recorder;
+    PARSER_SAX_HANDLER       handler;
+    PARSER_CONFIG            config;
+    PARSER_XML*              worker;
+    PARSER_XML*              xml;
+    PARSER_SIZE              length;
+    PARSER_INT               last;
+
+    xml    = job->xml;
+    last   = (chunk->string + chunk->length == job->end);
+    length = chunk->length + (last ? 0 : 1);
+
+    if ( length > PARSER_PARALLEL_MAX_CHUNK_LENGTH )
+    {
+        chunk->error = EINVAL;
+        return;
+    }
+
+    parser_init_config(&config, xml->element_name_list, xml->element_name_list_length,
+                       xml->attribute_name_list, xml->attribute_name_list_length);
+
+    config.allocator = &xml->allocator;
+
+    parser_share_name_lookups(xml, &config);
+
+    recorder.xml   = xml;
+    recorder.chunk = chunk;
+
+    handler.start_element = parser_parallel_on_start_element;
+    handler.attribute     = parser_parallel_on_attribute;
+    handler.text          = parser_parallel_on_text;
+    handler.end_element   = parser_parallel_on_end_element;
+    handler.context       = &recorder;
+
+    worker = parser_begin_sax(&config, &handler);
+    if ( !worker )
+    {
+        chunk->error = ENOMEM;
+        return;
+    }
+
+    worker->state->depth = PARSER_PARALLEL_BASE_DEPTH;
+
+    chunk->error = parser_append(worker, chunk->string, (PARSER_INT)length);
+    if ( !chunk->error )
+        chunk->boundary_ok = last ? parser_tokenizer_at_text(worker) : parser_tokenizer_at_tag_open(worker);
+
+    parser_free_xml(worker);
+}
+
+// parser_parallel_find_boundary
+// Returns start of the first tag at or after the position and
+// before the end that follows '>' and whitespace, or the end.
+// Parser is in content at such '<' unless the '>' was inside a
+// comment, attribute value or text.
+
+static const PARSER_CHAR* parser_parallel_find_boundary(const PARSER_CHAR* begin,
+                                                        const PARSER_CHAR* position,
+                                                        const PARSER_CHAR* end)
+{
+    const PARSER_CHAR* previous;
+    const PARSER_CHAR* limit;
+
+    while ( position < end )
+    {
+        position = memchr(position, '<', (PARSER_SIZE)(end - position));
+        if ( !position || position + 1 >= end )
+            return(end);
+
+        if ( IS_PARALLEL_NAME_START(position[1]) || position[1] == '/' )
+        {
+            limit = position - begin > 64 ? position - 64 : begin;
+
+            for ( previous = position - 1; previous > limit && IS_PARALLEL_WHITESPACE(*previous); previous-- )
+                ;
+
+            if ( previous >= begin && *previous == '>' )
+                return(position);
+        }
+
+        position++;
+    }
+
+    return(end);
+}
+
+// parser_parallel_replay
+// Delivers count first recorded events of the chunk to the xml.
+
+static PARSER_ERROR parser_parallel_replay(PARSER_XML*                  xml,
+                                           const PARSER_PARALLEL_CHUNK* chunk,
+                                           PARSER_SIZE                  count)
+{
+    const PARSER_PARALLEL_EVENT* event;
+    PARSER_SIZE                  i;
+    PARSER_ERROR                 error;
+
+    for ( i = 0; i < count; i++ )
+    {
+        event = &chunk->events[i];
+
+        switch ( event->type )
+        {
+            case PARSER_PARALLEL_EVENT_START_ELEMENT:
+                error = parser_push_element_start(xml, event->name_index, event->name, event->name_length);
+                break;
+
+            case PARSER_PARALLEL_EVENT_ATTRIBUTE:
+                error = parser_push_attribute(xml, event->name_index, chunk->names + event->name_offset, event->name_length,
+                                              event->value, event->value_length);
+                break;
+
+            case PARSER_PARALLEL_EVENT_TEXT:
+                error = parser_push_text(xml, event->value, event->value_length);
+                break;
+
+            default:
+                error = parser_push_element_end(xml, event->name_index);
+                break;
+        }
+
+        if ( error )
+            return(error);
+    }
+
+    return(0);
+}
+
+// parser_parallel_resume_event
+// Returns index of the last start element of the chunk or zero.
+// Parser was in content before the '<' of the element, so events
+// before it are valid also when the chunk did not end in content.
+
+static PARSER_SIZE parser_parallel_resume_event(const PARSER_PARALLEL_CHUNK* chunk)
+{
+    PARSER_SIZE i;
+
+    for ( i = chunk->event_count; i > 0; i-- )
+    {
+        if ( chunk->events[i - 1].type == PARSER_PARALLEL_EVENT_START_ELEMENT )
+            return(i - 1);
+    }
+
+    return(0);
+}
+
+// parser_parallel_worker
+// Thread function. Chunks are taken in order from the job.
+
+static void* parser_parallel_worker(void* context)
+{
+    PARSER_PARALLEL_JOB*   job;
+    PARSER_PARALLEL_CHUNK* chunk;
+
+    job = context;
+
+    for ( ;; )
+    {
+        pthread_mutex_lock(&job->mutex);
+
+        if ( job->stop || job->next_chunk >= job->chunk_count )
+        {
+            pthread_mutex_unlock(&job->mutex);
+            return(0);
+        }
+
+        chunk = &job->chunks[job->next_chunk++];
+
+        pthread_mutex_unlock(&job->mutex);
+
+        parser_parallel_parse_chunk(job, chunk);
+
+        pthread_mutex_lock(&job->mutex);
+
+        chunk->done = 1;
+        pthread_cond_broadcast(&job->chunk_done);
+
+        pthread_mutex_unlock(&job->mutex);
+    }
+}
+
+// parser_parallel_wait_chunk
+
+static void parser_parallel_wait_chunk(PARSER_PARALLEL_JOB*   job,
+                                       PARSER_PARALLEL_CHUNK* chunk)
+{
+    pthread_mutex_lock(&job->mutex);
+
+    while ( !chunk->done )
+        pthread_cond_wait(&job->chunk_done, &job->mutex);
+
+    pthread_mutex_unlock(&job->mutex);
+}
+
+// parser_parallel_run
+// Parses chunks on threads and replays them in order. Chunks
+// after a wrongly guessed boundary are parsed serially until the
+// parser is again in content at a chunk boundary.
+
+static PARSER_ERROR parser_parallel_run(PARSER_PARALLEL_JOB* job,
+                                        PARSER_INT           thread_count)
+{
+    pthread_t              threads[PARSER_PARALLEL_MAX_THREADS];
+    PARSER_PARALLEL_CHUNK* chunk;
+    const PARSER_CHAR*     resume;
+    PARSER_INT             started;
+    PARSER_INT             speculate;
+    PARSER_SIZE            count;
+    PARSER_SIZE            i;
+    PARSER_ERROR           error;
+
+    if ( pthread_mutex_init(&job->mutex, 0) )
+        return(ENOMEM);
+
+    if ( pthread_cond_init(&job->chunk_done, 0) )
+    {
+        pthread_mutex_destroy(&job->mutex);
+        return(ENOMEM);
+    }
+
+    for ( started = 0; started < thread_count; started++ )
+    {
+        if ( pthread_create(&threads[started], 0, parser_parallel_worker, job) )
+            break;
+    }
+
+    error     = 0;
+    speculate = 1;
+
+    for ( i = 0; i < job->chunk_count && !error; i++ )
+    {
+        chunk  = &job->chunks[i];
+        resume = chunk->string;
+
+        // Without threads the chunks are only parsed serially.
+
+        if ( started < 1 )
+            speculate = 0;
+
+        if ( speculate )
+        {
+            parser_parallel_wait_chunk(job, chunk);
+
+            if ( !chunk->error && chunk->boundary_ok )
+            {
+                error = parser_parallel_replay(job->xml, chunk, chunk->event_count);
+                parser_parallel_free_chunk(job->xml, chunk);
+                continue;
+            }
+
+            // Chunk began in content but the next one did not. Only
+            // the end of the chunk is parsed again.
+
+            count = parser_parallel_resume_event(chunk);
+
+            if ( count < chunk->event_count && chunk->events[count].type == PARSER_PARALLEL_EVENT_START_ELEMENT )
+            {
+                resume = chunk->events[count].name - 1;
+                error  = parser_parallel_replay(job->xml, chunk, count);
+            }
+
+            parser_parallel_free_chunk(job->xml, chunk);
+
+            if ( error )
+                break;
+        }
+
+        error = parser_parallel_append_serial(job->xml, resume, (PARSER_SIZE)(chunk->string + chunk->length - resume));
+
+        // Guess of the next chunk holds if it starts in content.
+
+        speculate = parser_tokenizer_at_text(job->xml);
+    }
+
+    pthread_mutex_lock(&job->mutex);
+    job->stop = 1;
+    pthread_mutex_unlock(&job->mutex);
+
+    while ( started > 0 )
+        pthread_join(threads[--started], 0);
+
+    pthread_cond_destroy(&job->chunk_done);
+    pthread_mutex_destroy(&job->mutex);
+
+    return(error);
+}
+
+// parser_parallel_parse
+// Splits the input to chunks and parses them with threads.
+
+static PARSER_ERROR parser_parallel_parse(PARSER_XML*        xml,
+                                          const PARSER_CHAR* xml_string,
+                                          PARSER_SIZE        xml_string_length,
+                                          PARSER_INT         thread_count)
+{
+    PARSER_PARALLEL_JOB job;
+    const PARSER_CHAR*  position;
+    const PARSER_CHAR*  start;
+    const PARSER_CHAR*  next;
+    PARSER_SIZE         chunk_count;
+    PARSER_SIZE         chunk_length;
+    PARSER_SIZE         i;
+    PARSER_ERROR        error;
+
+    chunk_count = (PARSER_SIZE)thread_count * PARSER_PARALLEL_CHUNKS_PER_THREAD;
+
+    if ( chunk_count > xml_string_length / PARSER_PARALLEL_MIN_CHUNK_LENGTH )
+        chunk_count = xml_string_length / PARSER_PARALLEL_MIN_CHUNK_LENGTH;
+
+    if ( chunk_count < xml_string_length / PARSER_PARALLEL_MAX_CHUNK_LENGTH + 1 )
+        chunk_count = xml_string_length / PARSER_PARALLEL_MAX_CHUNK_LENGTH + 1;
+
+    if ( chunk_count < 2 )
+        return(parser_parallel_append_serial(xml, xml_string, xml_string_length));
+
+    job.chunks = xml->allocator.alloc(xml->allocator.context, chunk_count * sizeof(PARSER_PARALLEL_CHUNK));
+    if ( !job.chunks )
+        return(ENOMEM);
+
+    job.xml        = xml;
+    job.next_chunk = 0;
+    job.end        = xml_string + xml_string_length;
+    job.stop       = 0;
+
+    chunk_length = xml_string_length / chunk_count;
+    position     = xml_string;
+
+    for ( i = 0; i < chunk_count && position < job.end; i++ )
+    {
+        next = job.end;
+
+        if ( i + 1 < chunk_count )
+        {
+            start = xml_string + (i + 1) * chunk_length;
+            if ( start <= position )
+                start = position + 1;
+
+            next = parser_parallel_find_boundary(xml_string, start, job.end);
+        }
+
+        memset(&job.chunks[i], 0, sizeof(PARSER_PARALLEL_CHUNK));
+
+        job.chunks[i].string = position;
+        job.chunks[i].length = (PARSER_SIZE)(next - position);
+
+        position = next;
+    }
+
+    job.chunk_count = i;
+
+    error = parser_parallel_run(&job, thread_count);
+
+    for ( i = 0; i < job.chunk_count; i++ )
+        parser_parallel_free_chunk(xml, &job.chunks[i]);
+
+    xml->allocator.free(xml->allocator.context, job.chunks);
+
+    return(error);
+}
+
+#endif /* PARSER_WITH_PTHREADS */
+
+// parser_append_parallel
+
+PARSER_ERROR parser_append_parallel(PARSER_XML*        xml,
+                                    const PARSER_CHAR* xml_string,
+                                    PARSER_SIZE        xml_string_length,
+                                    PARSER_INT         thread_count)
+{
+    if ( !xml || !xml->state || !xml_string || xml_string_length < 1 )
+        return(EINVAL);
+
+    // Pull parser reads its input with parser_next_token().
+
+    if ( xml->flags & PARSER_XML_FLAG_PULL )
+        return(EINVAL);
+
+#if defined(PARSER_WITH_PTHREADS)
+
+    // Chunks are guessed to begin in content. Filters decide on
+    // each element in document order.
+
+    if ( thread_count > 1 && parser_tokenizer_at_text(xml) && !xml->filter )
+    {
+        if ( thread_count > PARSER_PARALLEL_MAX_THREADS )
+            thread_count = PARSER_PARALLEL_MAX_THREADS;
+
+        return(parser_parallel_parse(xml, xml_string, xml_string_length, thread_count));
+    }
+
+#else
+
+    (void)thread_count;
+
+#endif /* PARSER_WITH_PTHREADS */
+
+    return(parser_parallel_append_serial(xml, xml_string, xml_string_length));
+}
@@ -0,0 +1,942 @@
+/*
+MIT License
+
+Copyright (c) 2018 Velli20
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+// Queries over the parsed tree with a subset of XPath. A path is
+// compiled once to a list of steps that compare name list indexes,
+// and any number of compiled queries are evaluated together in a
+// single pass over the tree.
+
+// Includes
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include "xml_parser.h"
+#include "xml_parser_internal.h"
+
+// Defines
+
+// Steps of a query are bits of a 64-bit mask, and bit 0 is taken
+// by the context above the root elements.
+
+#define PARSER_QUERY_MAX_STEPS          63
+
+// Element name of a step that matches any element and of a name
+// that is not in the name list and matches nothing.
+
+#define PARSER_QUERY_NAME_ANY           -2
+#define PARSER_QUERY_NAME_NONE          -3
+
+#define PARSER_QUERY_OPERATION_EXISTS   0x00
+#define PARSER_QUERY_OPERATION_EQ       0x01
+#define PARSER_QUERY_OPERATION_NE       0x02
+#define PARSER_QUERY_OPERATION_LT       0x03
+#define PARSER_QUERY_OPERATION_LE       0x04
+#define PARSER_QUERY_OPERATION_GT       0x05
+#define PARSER_QUERY_OPERATION_GE       0x06
+
+#define PARSER_QUERY_VALUE_NUMBER       0x01
+#define PARSER_QUERY_VALUE_STRING       0x02
+
+// Number that is also stored exactly in integer.
+
+#define PARSER_QUERY_VALUE_INTEGER      0x04
+
+// Result of comparing NaN.
+
+#define PARSER_QUERY_UNORDERED          2
+
+// Masks of this many levels are kept on the stack.
+
+#define PARSER_QUERY_LOCAL_MASKS        256
+
+// Stops parser_evaluate_queries() at the first match.
+
+#define PARSER_QUERY_STOP               -1
+
+// Characters that end a name.
+
+#define PARSER_QUERY_NAME_DELIMITERS    "/[]=!<>@*'\" \t\r\n"
+
+// Types
+
+typedef struct parser_query_predicate
+{
+    double             number;
+    PARSER_INT64       integer;
+    const PARSER_CHAR* string;
+
+    PARSER_INT         attribute_index;
+    PARSER_INT         operation;
+    PARSER_INT         value_type;
+    PARSER_INT         value_length;
+}
+PARSER_QUERY_PREDICATE;
+
+typedef struct parser_query_step
+{
+    PARSER_INT name_index;
+    PARSER_INT first_predicate;
+    PARSER_INT predicate_count;
+}
+PARSER_QUERY_STEP;
+
+// parser_query
+// Bit k of the child mask is set if step k selects children of
+// the element that matched the previous step, and bit k of the
+// descendant mask if it selects any of its descendants.
+
+struct parser_query
+{
+    uint64_t                child_mask;
+    uint64_t                descendant_mask;
+
+    // Allocator of the xml the query was compiled with.
+
+    PARSER_ALLOCATOR        allocator;
+
+    PARSER_QUERY_PREDICATE* predicates;
+    PARSER_QUERY_STEP*      steps;
+
+    PARSER_INT              step_count;
+    PARSER_INT              predicate_count;
+};
+
+// parser_query_skip_space
+
+static PARSER_CHAR* parser_query_skip_space(PARSER_CHAR* cursor)
+{
+    while ( *cursor == ' ' || *cursor == '\t' || *cursor == '\r' || *cursor == '\n' )
+        cursor++;
+
+    return(cursor);
+}
+
+// parser_query_resolve_name
+// Resolves name in the copy of the path. Name is terminated
+// for the lookup and the path is restored afterwards.
+
+static PARSER_INT parser_query_resolve_name(const PARSER_XML* xml,
+                                            PARSER_CHAR*      name,
+                                            PARSER_SIZE       length,
+                                            PARSER_INT        is_element)
+{
+    PARSER_CHAR end;
+    PARSER_INT  index;
+
+    end          = name[length];
+    name[length] = 0;
+
+    if ( is_element )
+        index = parser_get_element_name_index(xml, name);
+    else
+        index = parser_get_attribute_name_index(xml, name);
+
+    name[length] = end;
+
+    return(index == PARSER_UNKNOWN_INDEX ? PARSER_QUERY_NAME_NONE : index);
+}
+
+// parser_query_parse_value
+// Number or a string in single or double quotes.
+
+static PARSER_ERROR parser_query_parse_value(PARSER_CHAR**           cursor,
+                                             PARSER_QUERY_PREDICATE* predicate)
+{
+    PARSER_CHAR* value;
+    PARSER_CHAR* end;
+    PARSER_INT   type;
+
+    value = *cursor;
+
+    if ( *value == '\'' || *value == '"' )
+    {
+        end = strchr(value + 1, *value);
+        if ( !end )
+            return(EINVAL);
+
+        predicate->value_type   = PARSER_QUERY_VALUE_STRING;
+        predicate->string       = value + 1;
+        predicate->value_length = (PARSER_INT)(end - value - 1);
+
+        *cursor = end + 1;
+        return(0);
+    }
+
+    // Number is decoded like attribute values, so the result does
+    // not depend on the locale.
+
+    if ( *value == '+' )
+        value++;
+
+    end = value + (*value == '-');
+
+    while ( (*end >= '0' && *end <= '9') || *end == '.' )
+        end++;
+
+    if ( *end == 'e' || *end == 'E' )
+    {
+        end++;
+        end += *end == '-' || *end == '+';
+
+        while ( *end >= '0' && *end <= '9' )
+            end++;
+    }
+
+    type = parser_parse_number(value, (PARSER_SIZE)(end - value), &predicate->integer, &predicate->number);
+
+    if ( type == PARSER_ATTRIBUTE_VALUE_TYPE_INTEGER )
+    {
+        predicate->number     = (double)predicate->integer;
+        predicate->value_type = PARSER_QUERY_VALUE_NUMBER | PARSER_QUERY_VALUE_INTEGER;
+    }
+
+    else if ( type == PARSER_ATTRIBUTE_VALUE_TYPE_FLOAT )
+    {
+        predicate->value_type = PARSER_QUERY_VALUE_NUMBER;
+    }
+
+    else
+    {
+        return(EINVAL);
+    }
+
+    *cursor = end;
+    return(0);
+}
+
+// parser_query_parse_predicate
+// [@name] or [@name operation value].
+
+static PARSER_ERROR parser_query_parse_predicate(const PARSER_XML* xml,
+                                                 PARSER_QUERY*     query,
+                                                 PARSER_CHAR**     cursor)
+{
+    PARSER_QUERY_PREDICATE* predicate;
+    PARSER_CHAR*            position;
+    PARSER_SIZE             length;
+    PARSER_INT64            int_value;
+    PARSER_DOUBLE           float_value;
+    PARSER_INT              declared_type;
+    PARSER_ERROR            error;
+
+    position = parser_query_skip_space(*cursor + 1);
+    if ( *position != '@' )
+        return(EINVAL);
+
+    position++;
+
+    length = strcspn(position, PARSER_QUERY_NAME_DELIMITERS);
+    if ( !length )
+        return(EINVAL);
+
+    predicate = &query->predicates[query->predicate_count++];
+
+    predicate->attribute_index = parser_query_resolve_name(xml, position, length, 0);
+    predicate->operation       = PARSER_QUERY_OPERATION_EXISTS;
+
+    position = parser_query_skip_space(position + length);
+
+    switch ( *position )
+    {
+        case '=':
+            predicate->operation = PARSER_QUERY_OPERATION_EQ;
+            position++;
+            break;
+
+        case '!':
+            if ( position[1] != '=' )
+                return(EINVAL);
+
+            predicate->operation = PARSER_QUERY_OPERATION_NE;
+            position += 2;
+            break;
+
+        case '<':
+        case '>':
+            if ( position[1] == '=' )
+                predicate->operation = *position == '<' ? PARSER_QUERY_OPERATION_LE : PARSER_QUERY_OPERATION_GE;
+            else
+                predicate->operation = *position == '<' ? PARSER_QUERY_OPERATION_LT : PARSER_QUERY_OPERATION_GT;
+
+            position += position[1] == '=' ? 2 : 1;
+            break;
+
+        default:
+            break;
+    }
+
+    if ( predicate->operation != PARSER_QUERY_OPERATION_EXISTS )
+    {
+        position = parser_query_skip_space(position);
+
+        error = parser_query_parse_value(&position, predicate);
+        if ( error )
+            return(error);
+
+        // Bool and enum values are compared by their stored integers.
+
+        declared_type = parser_get_declared_type(xml, predicate->attribute_index);
+
+        if ( predicate->value_type == PARSER_QUERY_VALUE_STRING &&
+             (declared_type == PARSER_DECLARED_TYPE_BOOL || declared_type == PARSER_DECLARED_TYPE_ENUM) &&
+             parser_decode_declared_value(&xml->attribute_declarations[predicate->attribute_index], predicate->string, (PARSER_SIZE)predicate->value_length, &int_value, &float_value) )
+        {
+            predicate->value_type = PARSER_QUERY_VALUE_NUMBER | PARSER_QUERY_VALUE_INTEGER;
+            predicate->integer    = int_value;
+            predicate->number     = (double)int_value;
+        }
+
+        position = parser_query_skip_space(position);
+    }
+
+    if ( *position != ']' )
+        return(EINVAL);
+
+    *cursor = position + 1;
+    return(0);
+}
+
+// parser_query_parse_path
+// Steps are / for children and // for descendants followed by
+// element name or * and predicates.
+
+static PARSER_ERROR parser_query_parse_path(const PARSER_XML* xml,
+                                            PARSER_QUERY*     query,
+                                            PARSER_CHAR*      cursor)
+{
+    PARSER_QUERY_STEP* step;
+    PARSER_SIZE        length;
+    PARSER_ERROR       error;
+    uint64_t           step_bit;
+    PARSER_INT         is_descendant;
+
+    if ( *cursor != '/' )
+        return(EINVAL);
+
+    while ( *cursor == '/' )
+    {
+        is_descendant = cursor[1] == '/';
+        cursor       += is_descendant ? 2 : 1;
+
+        if ( query->step_count >= PARSER_QUERY_MAX_STEPS )
+            return(EINVAL);
+
+        step = &query->steps[query->step_count];
+
+        if ( *cursor == '*' )
+        {
+            step->name_index = PARSER_QUERY_NAME_ANY;
+            cursor++;
+        }
+        else
+        {
+            length = strcspn(cursor, PARSER_QUERY_NAME_DELIMITERS);
+            if ( !length )
+                return(EINVAL);
+
+            step->name_index = parser_query_resolve_name(xml, cursor, length, 1);
+            cursor          += length;
+        }
+
+        step->first_predicate = query->predicate_count;
+
+        while ( *cursor == '[' )
+        {
+            error = parser_query_parse_predicate(xml, query, &cursor);
+            if ( error )
+                return(error);
+        }
+
+        step->predicate_count = query->predicate_count - step->first_predicate;
+
+        step_bit = (uint64_t)1 << query->step_count;
+
+        if ( is_descendant )
+            query->descendant_mask |= step_bit;
+        else
+            query->child_mask |= step_bit;
+
+        query->step_count++;
+    }
+
+    return(*cursor ? EINVAL : 0);
+}
+
+// parser_compile_query
+
+PARSER_QUERY* parser_compile_query(const PARSER_XML*  xml,
+                                   const PARSER_CHAR* path)
+{
+    PARSER_QUERY* query;
+    PARSER_CHAR*  path_copy;
+    PARSER_SIZE   length;
+    PARSER_SIZE   i;
+    PARSER_INT    step_count;
+    PARSER_INT    predicate_count;
+
+    if ( !xml || !path )
+        return(0);
+
+    // Upper bounds of steps and predicates. Query, predicates, steps
+    // and the copy of the path that string values point to are
+    // allocated together.
+
+    length = strlen(path);
+
+    for ( i = 0, step_count = 0, predicate_count = 0; i < length; i++ )
+    {
+        step_count      += path[i] == '/';
+        predicate_count += path[i] == '[';
+    }
+
+    query = (PARSER_QUERY*)xml->allocator.alloc(xml->allocator.context, sizeof(PARSER_QUERY) +
+                                                (PARSER_SIZE)predicate_count * sizeof(PARSER_QUERY_PREDICATE) +
+                                                (PARSER_SIZE)step_count * sizeof(PARSER_QUERY_STEP) +
+                                                length + 1);
+    if ( !query )
+        return(0);
+
+    memset(query, 0, sizeof(PARSER_QUERY));
+
+    query->allocator = xml->allocator;
+
+    query->predicates = (PARSER_QUERY_PREDICATE*)(void*)(query + 1);
+    query->steps      = (PARSER_QUERY_STEP*)(void*)(query->predicates + predicate_count);
+    path_copy         = (PARSER_CHAR*)(query->steps + step_count);
+
+    memcpy(path_copy, path, length + 1);
+
+    if ( parser_query_parse_path(xml, query, path_copy) )
+    {
+        parser_free_query(query);
+        return(0);
+    }
+
+    return(query);
+}
+
+// parser_free_query
+
+void parser_free_query(PARSER_QUERY* query)
+{
+    if ( query )
+        query->allocator.free(query->allocator.context, query);
+}
+
+// parser_query_compare_numbers
+
+static PARSER_INT parser_query_compare_numbers(double a,
+                                               double b)
+{
+    if ( a < b )
+        return(-1);
+
+    if ( a > b )
+        return(1);
+
+    return(a == b ? 0 : PARSER_QUERY_UNORDERED);
+}
+
+// parser_query_compare_integers
+
+static PARSER_INT parser_query_compare_integers(PARSER_INT64 a,
+                                                PARSER_INT64 b)
+{
+    return(a < b ? -1 : a > b);
+}
+
+// parser_query_match_predicate
+
+static PARSER_INT parser_query_match_predicate(const PARSER_QUERY_PREDICATE* predicate,
+                                               const PARSER_ELEMENT*         element)
+{
+    const PARSER_ATTRIBUTE* attribute;
+    const PARSER_CHAR*      string;
+    PARSER_SIZE             length;
+    PARSER_INT              compare;
+
+    for ( attribute = element->first_attribute; attribute; attribute = attribute->next_attribute )
+    {
+        if ( (attribute->attribute_type & PARSER_ATTRIBUTE_NAME_TYPE_INDEX) && attribute->attr_name.attribute_index == predicate->attribute_index )
+            break;
+    }
+
+    if ( !attribute )
+        return(0);
+
+    if ( predicate->operation == PARSER_QUERY_OPERATION_EXISTS )
+        return(1);
+
+    // Numbers are compared with numeric values and strings with string
+    // values. Two integers are compared exactly, and as doubles if
+    // either one is a float.
+
+    parser_type_attribute_value(attribute);
+
+    if ( predicate->value_type & PARSER_QUERY_VALUE_NUMBER )
+    {
+        if ( (attribute->attribute_type & PARSER_ATTRIBUTE_VALUE_TYPE_INTEGER) && (predicate->value_type & PARSER_QUERY_VALUE_INTEGER) )
+            compare = parser_query_compare_integers(attribute->attr_val.int_value, predicate->integer);
+
+        else if ( attribute->attribute_type & PARSER_ATTRIBUTE_VALUE_TYPE_INTEGER )
+            compare = parser_query_compare_numbers((double)attribute->attr_val.int_value, predicate->number);
+
+        else if ( attribute->attribute_type & PARSER_ATTRIBUTE_VALUE_TYPE_FLOAT )
+            compare = parser_query_compare_numbers(attribute->attr_val.float_value, predicate->number);
+
+        else
+            return(0);
+    }
+    else
+    {
+        if ( !(attribute->attribute_type & PARSER_ATTRIBUTE_VALUE_TYPE_STRING) )
+            return(0);
+
+        string  = attribute->attribute_type & PARSER_ATTRIBUTE_VALUE_BORROWED ? attribute->attr_val.string_slice : attribute->attr_val.string_ptr;
+        length  = (PARSER_SIZE)(attribute->value_length < predicate->value_length ? attribute->value_length : predicate->value_length);
+        compare = memcmp(string, predicate->string, length);
+
+        if ( !compare )
+            compare = attribute->value_length - predicate->value_length;
+
+        compare = compare < 0 ? -1 : compare > 0;
+    }
+
+    switch ( predicate->operation )
+    {
+        case PARSER_QUERY_OPERATION_EQ: return(compare == 0);
+        case PARSER_QUERY_OPERATION_NE: return(compare != 0);
+        case PARSER_QUERY_OPERATION_LT: return(compare == -1);
+        case PARSER_QUERY_OPERATION_LE: return(compare == -1 || compare == 0);
+        case PARSER_QUERY_OPERATION_GT: return(compare == 1);
+        case PARSER_QUERY_OPERATION_GE: return(compare == 1 || compare == 0);
+        default:                        return(0);
+    }
+}
+
+// parser_query_match_name
+
+static inline PARSER_INT parser_query_match_name(const PARSER_QUERY_STEP* step,
+                                                 PARSER_INT               name_index)
+{
+    return(step->name_index == PARSER_QUERY_NAME_ANY || step->name_index == name_index);
+}
+
+// parser_query_match_predicates
+
+static PARSER_INT parser_query_match_predicates(const PARSER_QUERY*      query,
+                                                const PARSER_QUERY_STEP* step,
+                                                const PARSER_ELEMENT*    element)
+{
+    PARSER_INT i;
+
+    for ( i = 0; i < step->predicate_count; i++ )
+    {
+        if ( !parser_query_match_predicate(&query->predicates[step->first_predicate + i], element) )
+            return(0);
+    }
+
+    return(1);
+}
+
+// parser_query_match_step
+
+static PARSER_INT parser_query_match_step(const PARSER_QUERY*   query,
+                                          const PARSER_ELEMENT* element,
+                                          PARSER_INT            step_index)
+{
+    const PARSER_QUERY_STEP* step;
+
+    step = &query->steps[step_index];
+
+    if ( !parser_query_match_name(step, element->content_type & PARSER_ELEMENT_NAME_TYPE_INDEX ? element->elem_name.name_index : PARSER_UNKNOWN_INDEX) )
+        return(0);
+
+    return(parser_query_match_predicates(query, step, element));
+}
+
+// parser_evaluate_queries
+// Walks the tree once in document order. Each level keeps two masks
+// per query: steps that the element at that level matched and steps
+// that it or any of its ancestors matched. Bit k + 1 is set for
+// step k, and the element matches the query when the bit of the
+// last step is set. Subtrees where no query can match are skipped.
+
+PARSER_ERROR parser_evaluate_queries(const PARSER_XML*     xml,
+                                     PARSER_QUERY* const*  queries,
+                                     PARSER_INT            query_count,
+                                     PARSER_QUERY_FUNCTION match,
+                                     void*                 context)
+{
+    uint64_t              local_masks[PARSER_QUERY_LOCAL_MASKS];
+    uint64_t*             masks;
+    uint64_t*             new_masks;
+    uint64_t*             parent;
+    uint64_t*             current;
+    const PARSER_QUERY*   query;
+    const PARSER_ELEMENT* element;
+    const PARSER_ELEMENT* next;
+    PARSER_SIZE           level_size;
+    PARSER_SIZE           level_count;
+    PARSER_SIZE           new_level_count;
+    uint64_t              candidates;
+    uint64_t              matched;
+    uint64_t              active;
+    PARSER_ERROR          error;
+    PARSER_INT            step;
+    PARSER_INT            i;
+
+    if ( !xml || !queries || query_count <= 0 || !match )
+        return(EINVAL);
+
+    for ( i = 0; i < query_count; i++ )
+    {
+        if ( !queries[i] )
+            return(EINVAL);
+    }
+
+    level_size  = (PARSER_SIZE)query_count * 2;
+    level_count = PARSER_QUERY_LOCAL_MASKS / level_size;
+    masks       = local_masks;
+
+    if ( level_count < 2 )
+    {
+        level_count = 16;
+
+        masks = (uint64_t*)xml->allocator.alloc(xml->allocator.context, level_count * level_size * sizeof(uint64_t));
+        if ( !masks )
+            return(ENOMEM);
+    }
+
+    // Level 0 is the context above the root elements.
+
+    for ( i = 0; i < query_count; i++ )
+    {
+        masks[i * 2]     = 1;
+        masks[i * 2 + 1] = 1;
+    }
+
+    error = 0;
+
+    for ( element = xml->first_element; element && !error; element = next )
+    {
+        if ( (PARSER_SIZE)element->depth >= level_count )
+        {
+            new_level_count = level_count * 2 > (PARSER_SIZE)element->depth ? level_count * 2 : (PARSER_SIZE)element->depth + 1;
+
+            new_masks = (uint64_t*)xml->allocator.alloc(xml->allocator.context, new_level_count * level_size * sizeof(uint64_t));
+            if ( !new_masks )
+            {
+                error = ENOMEM;
+                break;
+            }
+
+            memcpy(new_masks, masks, level_count * level_size * sizeof(uint64_t));
+
+            if ( masks != local_masks )
+                xml->allocator.free(xml->allocator.context, masks);
+
+            masks       = new_masks;
+            level_count = new_level_count;
+        }
+
+        parent  = masks + (PARSER_SIZE)(element->depth - 1) * level_size;
+        current = parent + level_size;
+        active  = 0;
+
+        for ( i = 0; i < query_count && !error; i++ )
+        {
+            query      = queries[i];
+            candidates = (parent[i * 2] & query->child_mask) | (parent[i * 2 + 1] & query->descendant_mask);
+            matched    = 0;
+
+            for ( step = 0; candidates; step++, candidates >>= 1 )
+            {
+                if ( (candidates & 1) && parser_query_match_step(query, element, step) )
+                    matched |= (uint64_t)2 << step;
+            }
+
+            current[i * 2]     = matched;
+            current[i * 2 + 1] = parent[i * 2 + 1] | matched;
+
+            active |= (matched & query->child_mask) | (current[i * 2 + 1] & query->descendant_mask);
+
+            if ( (matched >> query->step_count) & 1 )
+                error = match(context, i, element);
+        }
+
+        next = active && element->child_element.first_element ? element->child_element.first_element : element->subtree_next;
+    }
+
+    if ( masks != local_masks )
+        xml->allocator.free(xml->allocator.context, masks);
+
+    return(error);
+}
+
+// parser_query_first_match
+
+static PARSER_ERROR parser_query_first_match(void*                 context,
+                                             PARSER_INT            query_index,
+                                             const PARSER_ELEMENT* element)
+{
+    (void)query_index;
+
+    *(const PARSER_ELEMENT**)context = element;
+
+    return(PARSER_QUERY_STOP);
+}
+
+// parser_find_query_element
+
+const PARSER_ELEMENT* parser_find_query_element(const PARSER_XML* xml,
+                                                PARSER_QUERY*     query)
+{
+    const PARSER_ELEMENT* element;
+
+    element = 0;
+
+    if ( parser_evaluate_queries(xml, &query, 1, parser_query_first_match, &element) != PARSER_QUERY_STOP )
+        return(0);
+
+    return(element);
+}
+
+// parser_query_filter_decision
+// Element is kept if it matches a query. Otherwise its subtree is
+// passed if a query can still match in it.
+
+static PARSER_INT parser_query_filter_decision(PARSER_FILTER*  filter,
+                                               const uint64_t* level)
+{
+    const PARSER_QUERY* query;
+    uint64_t            active;
+    PARSER_INT          i;
+
+    for ( i = 0, active = 0; i < filter->query_count; i++ )
+    {
+        query = filter->queries[i];
+
+        if ( (level[i * 2] >> query->step_count) & 1 )
+        {
+            filter->matched_query = i;
+            return(PARSER_FILTER_KEEP);
+        }
+
+        active |= (level[i * 2] & query->child_mask) | (level[i * 2 + 1] & query->descendant_mask);
+    }
+
+    return(active ? PARSER_FILTER_PASS : PARSER_FILTER_SKIP);
+}
+
+// parser_filter_start
+// Same step masks as in parser_evaluate_queries() from the name
+// of the element only.
+
+PARSER_ERROR parser_filter_start(PARSER_FILTER* filter,
+                                 PARSER_INT     depth,
+                                 PARSER_INT     name_index,
+                                 PARSER_INT*    decision)
+{
+    const PARSER_QUERY* query;
+    uint64_t*           masks;
+    uint64_t*           parent;
+    uint64_t*           current;
+    PARSER_SIZE         level_size;
+    PARSER_SIZE         level_count;
+    uint64_t            candidates;
+    uint64_t            matched;
+    uint64_t            pending;
+    uint64_t            any_pending;
+    PARSER_INT          step;
+    PARSER_INT          i;
+
+    level_size = (PARSER_SIZE)filter->query_count * 2;
+
+    if ( (PARSER_SIZE)depth >= filter->level_count )
+    {
+        level_count = filter->level_count * 2 > (PARSER_SIZE)depth ? filter->level_count * 2 : (PARSER_SIZE)depth + 1;
+
+        masks = (uint64_t*)filter->allocator->alloc(filter->allocator->context, level_count * level_size * sizeof(uint64_t));
+        if ( !masks )
+            return(ENOMEM);
+
+        memcpy(masks, filter->masks, filter->level_count * level_size * sizeof(uint64_t));
+        filter->allocator->free(filter->allocator->context, filter->masks);
+
+        filter->masks       = masks;
+        filter->level_count = level_count;
+    }
+
+    parent      = filter->masks + (PARSER_SIZE)(depth - 1) * level_size;
+    current     = parent + level_size;
+    any_pending = 0;
+
+    for ( i = 0; i < filter->query_count; i++ )
+    {
+        query      = filter->queries[i];
+        candidates = (parent[i * 2] & query->child_mask) | (parent[i * 2 + 1] & query->descendant_mask);
+        matched    = 0;
+        pending    = 0;
+
+        for ( step = 0; candidates; step++, candidates >>= 1 )
+        {
+            if ( !(candidates & 1) || !parser_query_match_name(&query->steps[step], name_index) )
+                continue;
+
+            if ( query->steps[step].predicate_count )
+                pending |= (uint64_t)2 << step;
+            else
+                matched |= (uint64_t)2 << step;
+        }
+
+        current[i * 2]     = matched;
+        current[i * 2 + 1] = parent[i * 2 + 1] | matched;
+        filter->pending[i] = pending;
+
+        any_pending |= pending;
+    }
+
+    *decision = any_pending ? PARSER_FILTER_TEST : parser_query_filter_decision(filter, current);
+
+    return(0);
+}
+
+// parser_filter_test
+
+PARSER_INT parser_filter_test(PARSER_FILTER*        filter,
+                              PARSER_INT            depth,
+                              const PARSER_ELEMENT* element)
+{
+    const PARSER_QUERY* query;
+    uint64_t*           current;
+    uint64_t            pending;
+    uint64_t            matched;
+    PARSER_INT          step;
+    PARSER_INT          i;
+
+    current = filter->masks + (PARSER_SIZE)depth * (PARSER_SIZE)filter->query_count * 2;
+
+    for ( i = 0; i < filter->query_count; i++ )
+    {
+        query   = filter->queries[i];
+        matched = 0;
+
+        for ( step = 0, pending = filter->pending[i] >> 1; pending; step++, pending >>= 1 )
+        {
+            if ( (pending & 1) && parser_query_match_predicates(query, &query->steps[step], element) )
+                matched |= (uint64_t)2 << step;
+        }
+
+        current[i * 2]     |= matched;
+        current[i * 2 + 1] |= matched;
+    }
+
+    return(parser_query_filter_decision(filter, current));
+}
+
+// parser_free_filter
+
+void parser_free_filter(PARSER_XML* xml)
+{
+    if ( !xml->filter )
+        return;
+
+    xml->allocator.free(xml->allocator.context, xml->filter->masks);
+    xml->allocator.free(xml->allocator.context, xml->filter);
+
+    xml->filter = 0;
+}
+
+// parser_set_filters
+
+PARSER_ERROR parser_set_filters(PARSER_XML*           xml,
+                                PARSER_QUERY* const*  queries,
+                                PARSER_INT            query_count,
+                                PARSER_QUERY_FUNCTION match,
+                                void*                 context)
+{
+    PARSER_FILTER* filter;
+    PARSER_INT     i;
+
+    if ( !xml || !xml->state || query_count < 0 || (query_count && !queries) )
+        return(EINVAL);
+
+    if ( (xml->flags & (PARSER_XML_FLAG_SAX | PARSER_XML_FLAG_PULL)) || xml->document )
+        return(EINVAL);
+
+    for ( i = 0; i < query_count; i++ )
+    {
+        if ( !queries[i] )
+            return(EINVAL);
+    }
+
+    // Filters can be removed after a complete document.
+
+    if ( xml->state->depth || !parser_tokenizer_at_text(xml) || (query_count && xml->first_element) )
+        return(EBUSY);
+
+    parser_free_filter(xml);
+
+    if ( !query_count )
+        return(0);
+
+    // Pending masks and query list follow the filter.
+
+    filter = (PARSER_FILTER*)xml->allocator.alloc(xml->allocator.context, sizeof(PARSER_FILTER) +
+                                                  (PARSER_SIZE)query_count * (sizeof(uint64_t) + sizeof(PARSER_QUERY*)));
+    if ( !filter )
+        return(ENOMEM);
+
+    memset(filter, 0, sizeof(PARSER_FILTER));
+
+    filter->pending     = (uint64_t*)(void*)(filter + 1);
+    filter->queries     = (PARSER_QUERY**)(void*)(filter->pending + query_count);
+    filter->level_count = 16;
+    filter->allocator   = &xml->allocator;
+    filter->match       = match;
+    filter->context     = context;
+    filter->query_count = query_count;
+
+    filter->masks = (uint64_t*)xml->allocator.alloc(xml->allocator.context, filter->level_count * (PARSER_SIZE)query_count * 2 * sizeof(uint64_t));
+    if ( !filter->masks )
+    {
+        xml->allocator.free(xml->allocator.context, filter);
+        return(ENOMEM);
+    }
+
+    // Level 0 is the context above the root elements.
+
+    for ( i = 0; i < query_count; i++ )
+    {
+        filter->queries[i]       = queries[i];
+        filter->masks[i * 2]     = 1;
+        filter->masks[i * 2 + 1] = 1;
+    }
+
+    xml->filter = filter;
+
+    return(0);
+}
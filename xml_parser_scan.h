@@ -0,0 +1,321 @@
+/*
+MIT License
+
+Copyright (c) 2018 Velli20
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+// Internal helpers for finding the next structural character
+// from a run of bytes. Not part of the public interface.
+
+#ifndef xml_parser_scan_h
+#define xml_parser_scan_h
+
+// Includes
+
+#include <string.h>
+#include "xml_parser.h"
+
+// Select vector implementation. Define PARSER_WITHOUT_SIMD to
+// use only the portable implementation.
+
+#if !defined(PARSER_WITHOUT_SIMD) && defined(__SSE2__)
+#define PARSER_SCAN_SSE2
+#include <emmintrin.h>
+#endif
+
+#if defined(PARSER_SCAN_SSE2) && defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define PARSER_SCAN_AVX2
+#include <immintrin.h>
+#endif
+
+// Defines
+
+#define PARSER_SCAN_SWAR_ONES   ((uint64_t)0x0101010101010101ull)
+#define PARSER_SCAN_SWAR_HIGHS  ((uint64_t)0x8080808080808080ull)
+
+// Macros
+
+// Non-zero byte lanes of the result mark bytes of WORD that are zero.
+
+#define PARSER_SCAN_SWAR_ZERO_BYTES(WORD) (((WORD) - PARSER_SCAN_SWAR_ONES) & ~(WORD) & PARSER_SCAN_SWAR_HIGHS)
+
+// parser_scan_any_scalar
+// Portable implementation that tests eight bytes at a time.
+
+static inline PARSER_SIZE parser_scan_any_scalar(const PARSER_CHAR* string,
+                                                 PARSER_SIZE        length,
+                                                 PARSER_CHAR        c1,
+                                                 PARSER_CHAR        c2)
+{
+    uint64_t    pattern_1;
+    uint64_t    pattern_2;
+    uint64_t    word;
+    PARSER_SIZE n;
+
+    pattern_1 = PARSER_SCAN_SWAR_ONES * (unsigned char)c1;
+    pattern_2 = PARSER_SCAN_SWAR_ONES * (unsigned char)c2;
+
+    for ( n = 0; n + 8 <= length; n += 8 )
+    {
+        memcpy(&word, string + n, sizeof(word));
+
+        if ( PARSER_SCAN_SWAR_ZERO_BYTES(word ^ pattern_1) | PARSER_SCAN_SWAR_ZERO_BYTES(word ^ pattern_2) )
+            break;
+    }
+
+    for ( ; n < length; n++ )
+    {
+        if ( string[n] == c1 || string[n] == c2 )
+            break;
+    }
+
+    return(n);
+}
+
+#if defined(PARSER_SCAN_AVX2)
+
+// parser_scan_any_avx2
+
+__attribute__((target("avx2")))
+static PARSER_SIZE parser_scan_any_avx2(const PARSER_CHAR* string,
+                                        PARSER_SIZE        length,
+                                        PARSER_CHAR        c1,
+                                        PARSER_CHAR        c2)
+{
+    __m256i     pattern_1;
+    __m256i     pattern_2;
+    __m256i     chunk;
+    unsigned    mask;
+    PARSER_SIZE n;
+
+    pattern_1 = _mm256_set1_epi8(c1);
+    pattern_2 = _mm256_set1_epi8(c2);
+
+    for ( n = 0; n + 32 <= length; n += 32 )
+    {
+        chunk = _mm256_loadu_si256((const __m256i*)(const void*)(string + n));
+        mask  = (unsigned)_mm256_movemask_epi8(_mm256_or_si256(_mm256_cmpeq_epi8(chunk, pattern_1),
+                                                               _mm256_cmpeq_epi8(chunk, pattern_2)));
+        if ( mask )
+            return(n + (PARSER_SIZE)__builtin_ctz(mask));
+    }
+
+    return(n + parser_scan_any_scalar(string + n, length - n, c1, c2));
+}
+
+#endif /* PARSER_SCAN_AVX2 */
+
+#if defined(PARSER_SCAN_SSE2)
+
+// parser_scan_any_sse2
+
+static inline PARSER_SIZE parser_scan_any_sse2(const PARSER_CHAR* string,
+                                               PARSER_SIZE        length,
+                                               PARSER_CHAR        c1,
+                                               PARSER_CHAR        c2)
+{
+    __m128i     pattern_1;
+    __m128i     pattern_2;
+    __m128i     chunk;
+    unsigned    mask;
+    PARSER_SIZE n;
+
+    pattern_1 = _mm_set1_epi8(c1);
+    pattern_2 = _mm_set1_epi8(c2);
+
+    for ( n = 0; n + 16 <= length; n += 16 )
+    {
+        chunk = _mm_loadu_si128((const __m128i*)(const void*)(string + n));
+        mask  = (unsigned)_mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(chunk, pattern_1),
+                                                         _mm_cmpeq_epi8(chunk, pattern_2)));
+        if ( mask )
+            return(n + (PARSER_SIZE)__builtin_ctz(mask));
+    }
+
+    return(n + parser_scan_any_scalar(string + n, length - n, c1, c2));
+}
+
+#endif /* PARSER_SCAN_SSE2 */
+
+// parser_scan_any
+// Returns offset of the first byte that equals c1 or c2,
+// or length if there is no such byte. AVX2 is selected at
+// runtime when the CPU supports it.
+
+static inline PARSER_SIZE parser_scan_any(const PARSER_CHAR* string,
+                                          PARSER_SIZE        length,
+                                          PARSER_CHAR        c1,
+                                          PARSER_CHAR        c2)
+{
+#if defined(PARSER_SCAN_AVX2)
+
+    if ( length >= 64 && __builtin_cpu_supports("avx2") )
+        return(parser_scan_any_avx2(string, length, c1, c2));
+
+#endif
+
+#if defined(PARSER_SCAN_SSE2)
+
+    if ( length >= 16 )
+        return(parser_scan_any_sse2(string, length, c1, c2));
+
+#endif
+
+    return(parser_scan_any_scalar(string, length, c1, c2));
+}
+
+// parser_scan_any3_scalar
+
+static inline PARSER_SIZE parser_scan_any3_scalar(const PARSER_CHAR* string,
+                                                  PARSER_SIZE        length,
+                                                  PARSER_CHAR        c1,
+                                                  PARSER_CHAR        c2,
+                                                  PARSER_CHAR        c3)
+{
+    uint64_t    pattern_1;
+    uint64_t    pattern_2;
+    uint64_t    pattern_3;
+    uint64_t    word;
+    PARSER_SIZE n;
+
+    pattern_1 = PARSER_SCAN_SWAR_ONES * (unsigned char)c1;
+    pattern_2 = PARSER_SCAN_SWAR_ONES * (unsigned char)c2;
+    pattern_3 = PARSER_SCAN_SWAR_ONES * (unsigned char)c3;
+
+    for ( n = 0; n + 8 <= length; n += 8 )
+    {
+        memcpy(&word, string + n, sizeof(word));
+
+        if ( PARSER_SCAN_SWAR_ZERO_BYTES(word ^ pattern_1) |
+             PARSER_SCAN_SWAR_ZERO_BYTES(word ^ pattern_2) |
+             PARSER_SCAN_SWAR_ZERO_BYTES(word ^ pattern_3) )
+            break;
+    }
+
+    for ( ; n < length; n++ )
+    {
+        if ( string[n] == c1 || string[n] == c2 || string[n] == c3 )
+            break;
+    }
+
+    return(n);
+}
+
+#if defined(PARSER_SCAN_AVX2)
+
+// parser_scan_any3_avx2
+
+__attribute__((target("avx2")))
+static PARSER_SIZE parser_scan_any3_avx2(const PARSER_CHAR* string,
+                                         PARSER_SIZE        length,
+                                         PARSER_CHAR        c1,
+                                         PARSER_CHAR        c2,
+                                         PARSER_CHAR        c3)
+{
+    __m256i     pattern_1;
+    __m256i     pattern_2;
+    __m256i     pattern_3;
+    __m256i     chunk;
+    unsigned    mask;
+    PARSER_SIZE n;
+
+    pattern_1 = _mm256_set1_epi8(c1);
+    pattern_2 = _mm256_set1_epi8(c2);
+    pattern_3 = _mm256_set1_epi8(c3);
+
+    for ( n = 0; n + 32 <= length; n += 32 )
+    {
+        chunk = _mm256_loadu_si256((const __m256i*)(const void*)(string + n));
+        mask  = (unsigned)_mm256_movemask_epi8(_mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(chunk, pattern_1),
+                                                                               _mm256_cmpeq_epi8(chunk, pattern_2)),
+                                                               _mm256_cmpeq_epi8(chunk, pattern_3)));
+        if ( mask )
+            return(n + (PARSER_SIZE)__builtin_ctz(mask));
+    }
+
+    return(n + parser_scan_any3_scalar(string + n, length - n, c1, c2, c3));
+}
+
+#endif /* PARSER_SCAN_AVX2 */
+
+#if defined(PARSER_SCAN_SSE2)
+
+// parser_scan_any3_sse2
+
+static inline PARSER_SIZE parser_scan_any3_sse2(const PARSER_CHAR* string,
+                                                PARSER_SIZE        length,
+                                                PARSER_CHAR        c1,
+                                                PARSER_CHAR        c2,
+                                                PARSER_CHAR        c3)
+{
+    __m128i     pattern_1;
+    __m128i     pattern_2;
+    __m128i     pattern_3;
+    __m128i     chunk;
+    unsigned    mask;
+    PARSER_SIZE n;
+
+    pattern_1 = _mm_set1_epi8(c1);
+    pattern_2 = _mm_set1_epi8(c2);
+    pattern_3 = _mm_set1_epi8(c3);
+
+    for ( n = 0; n + 16 <= length; n += 16 )
+    {
+        chunk = _mm_loadu_si128((const __m128i*)(const void*)(string + n));
+        mask  = (unsigned)_mm_movemask_epi8(_mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(chunk, pattern_1),
+                                                                      _mm_cmpeq_epi8(chunk, pattern_2)),
+                                                         _mm_cmpeq_epi8(chunk, pattern_3)));
+        if ( mask )
+            return(n + (PARSER_SIZE)__builtin_ctz(mask));
+    }
+
+    return(n + parser_scan_any3_scalar(string + n, length - n, c1, c2, c3));
+}
+
+#endif /* PARSER_SCAN_SSE2 */
+
+// parser_scan_any3
+// Same as parser_scan_any() for three bytes.
+
+static inline PARSER_SIZE parser_scan_any3(const PARSER_CHAR* string,
+                                           PARSER_SIZE        length,
+                                           PARSER_CHAR        c1,
+                                           PARSER_CHAR        c2,
+                                           PARSER_CHAR        c3)
+{
+#if defined(PARSER_SCAN_AVX2)
+
+    if ( length >= 64 && __builtin_cpu_supports("avx2") )
+        return(parser_scan_any3_avx2(string, length, c1, c2, c3));
+
+#endif
+
+#if defined(PARSER_SCAN_SSE2)
+
+    if ( length >= 16 )
+        return(parser_scan_any3_sse2(string, length, c1, c2, c3));
+
+#endif
+
+    return(parser_scan_any3_scalar(string, length, c1, c2, c3));
+}
+
+#endif /* xml_parser_scan_h */
@@ -0,0 +1,1273 @@
+/*
+MIT License
+
+Copyright (c) 2018 Velli20
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+// Writers that produce XML: serializer of the parsed tree and
+// streaming writer of events. Output is collected to a buffer and
+// passed on in large pieces, so the write callback is not called
+// per element.
+
+// Includes
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "xml_parser.h"
+#include "xml_parser_internal.h"
+#include "xml_parser_scan.h"
+
+// Defines
+
+// Size of the buffer that is passed to the write callback.
+
+#define PARSER_WRITE_CHUNK_SIZE     4096
+
+// Room for any formatted number.
+
+#define PARSER_WRITE_NUMBER_SIZE    32
+
+#define PARSER_WRITE_INDENT_WIDTH   2
+
+// Two digit decimal strings of 0 - 99.
+
+static const PARSER_CHAR parser_digit_pairs[]=
+{
+"00010203040506070809"
+"10111213141516171819"
+"20212223242526272829"
+"30313233343536373839"
+"40414243444546474849"
+"50515253545556575859"
+"60616263646566676869"
+"70717273747576777879"
+"80818283848586878889"
+"90919293949596979899"
+};
+
+static const double parser_powers_of_ten[]=
+{
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9
+};
+
+// parser_output_flush_fixed
+// Caller buffer does not grow.
+
+static PARSER_ERROR parser_output_flush_fixed(PARSER_WRITE_OUTPUT* output,
+                                              PARSER_SIZE          needed)
+{
+    (void)output;
+    (void)needed;
+
+    return(ENOBUFS);
+}
+
+// parser_output_flush_grow
+// Grows the buffer with the allocator in the output context.
+
+static PARSER_ERROR parser_output_flush_grow(PARSER_WRITE_OUTPUT* output,
+                                             PARSER_SIZE          needed)
+{
+    PARSER_ALLOCATOR* allocator;
+    PARSER_CHAR*      data;
+    PARSER_SIZE       size;
+
+    allocator = output->context;
+
+    size = output->size * 2;
+    if ( size < output->position + needed )
+        size = output->position + needed;
+
+    if ( allocator->realloc )
+    {
+        data = allocator->realloc(allocator->context, output->data, size);
+    }
+
+    else
+    {
+        data = allocator->alloc(allocator->context, size);
+
+        if ( data )
+        {
+            memcpy(data, output->data, output->position);
+            allocator->free(allocator->context, output->data);
+        }
+    }
+
+    if ( !data )
+        return(ENOMEM);
+
+    output->data = data;
+    output->size = size;
+
+    return(0);
+}
+
+// parser_output_flush_callback
+
+static PARSER_ERROR parser_output_flush_callback(PARSER_WRITE_OUTPUT* output,
+                                                 PARSER_SIZE          needed)
+{
+    PARSER_ERROR error;
+
+    (void)needed;
+
+    if ( !output->position )
+        return(0);
+
+    error = output->write(output->context, output->data, output->position);
+
+    output->position = 0;
+
+    return(error);
+}
+
+// parser_output_reserve
+// Makes room for a short piece of output. Longer output is written
+// with parser_output_write().
+
+static inline PARSER_ERROR parser_output_reserve(PARSER_WRITE_OUTPUT* output,
+                                                 PARSER_SIZE          length)
+{
+    if ( output->size - output->position >= length )
+        return(0);
+
+    return(output->flush(output, length));
+}
+
+// parser_output_write_pieces
+// Writes output that does not fit the free space of the buffer.
+
+static PARSER_ERROR parser_output_write_pieces(PARSER_WRITE_OUTPUT* output,
+                                               const PARSER_CHAR*   data,
+                                               PARSER_SIZE          length)
+{
+    PARSER_SIZE  count;
+    PARSER_ERROR error;
+
+    while ( length )
+    {
+        if ( output->position == output->size )
+        {
+            error = output->flush(output, length);
+            if ( error )
+                return(error);
+        }
+
+        count = output->size - output->position;
+        if ( count > length )
+            count = length;
+
+        memcpy(output->data + output->position, data, count);
+
+        output->position += count;
+        data             += count;
+        length           -= count;
+    }
+
+    return(0);
+}
+
+// parser_output_write
+
+static inline PARSER_ERROR parser_output_write(PARSER_WRITE_OUTPUT* output,
+                                               const PARSER_CHAR*   data,
+                                               PARSER_SIZE          length)
+{
+    if ( output->size - output->position < length )
+        return(parser_output_write_pieces(output, data, length));
+
+    memcpy(output->data + output->position, data, length);
+    output->position += length;
+
+    return(0);
+}
+
+// parser_output_char
+
+static inline PARSER_ERROR parser_output_char(PARSER_WRITE_OUTPUT* output,
+                                              PARSER_CHAR          c)
+{
+    PARSER_ERROR error;
+
+    error = parser_output_reserve(output, 1);
+    if ( error )
+        return(error);
+
+    output->data[output->position++] = c;
+
+    return(0);
+}
+
+// parser_output_escaped
+// Writes value and replaces c1, c2 and c3 with the entity. Runs
+// without them are copied at once.
+
+static PARSER_ERROR parser_output_escaped(PARSER_WRITE_OUTPUT* output,
+                                          const PARSER_CHAR*   value,
+                                          PARSER_SIZE          length,
+                                          PARSER_CHAR          c1,
+                                          PARSER_CHAR          c2,
+                                          PARSER_CHAR          c3)
+{
+    PARSER_SIZE  run;
+    PARSER_ERROR error;
+
+    while ( length )
+    {
+        run = parser_scan_any3(value, length, c1, c2, c3);
+
+        error = parser_output_write(output, value, run);
+        if ( error || run == length )
+            return(error);
+
+        switch ( value[run] )
+        {
+            case '<':  error = parser_output_write(output, "&lt;",   4); break;
+            case '>':  error = parser_output_write(output, "&gt;",   4); break;
+            case '"':  error = parser_output_write(output, "&quot;", 6); break;
+            case '&':  error = parser_output_write(output, "&amp;",  5); break;
+            default:   error = parser_output_char(output, value[run]);   break;
+        }
+
+        if ( error )
+            return(error);
+
+        value  += run + 1;
+        length -= run + 1;
+    }
+
+    return(0);
+}
+
+// parser_format_int
+// Writes decimal integer to out that has room for
+// PARSER_WRITE_NUMBER_SIZE bytes. Returns length.
+
+static PARSER_SIZE parser_format_int(PARSER_CHAR* out,
+                                     int64_t      value)
+{
+    PARSER_CHAR digits[PARSER_WRITE_NUMBER_SIZE];
+    uint64_t    magnitude;
+    PARSER_SIZE position;
+    PARSER_SIZE length;
+
+    magnitude = value < 0 ? (uint64_t)0 - (uint64_t)value : (uint64_t)value;
+    position  = sizeof(digits);
+
+    // Two digits per division.
+
+    while ( magnitude >= 100 )
+    {
+        position -= 2;
+        memcpy(digits + position, parser_digit_pairs + (magnitude % 100) * 2, 2);
+        magnitude /= 100;
+    }
+
+    if ( magnitude >= 10 )
+    {
+        position -= 2;
+        memcpy(digits + position, parser_digit_pairs + magnitude * 2, 2);
+    }
+
+    else
+    {
+        digits[--position] = (PARSER_CHAR)('0' + magnitude);
+    }
+
+    if ( value < 0 )
+        digits[--position] = '-';
+
+    length = sizeof(digits) - position;
+    memcpy(out, digits + position, length);
+
+    return(length);
+}
+
+// parser_format_decimal
+// Writes the shortest decimal with at most nine fraction digits
+// that reads back as the same value. Value always has a decimal
+// point or an exponent, so it is parsed back as a float. Very large
+// and small values are written with the fewest snprintf() digits
+// that read back, with '.' as the decimal point in any locale.
+
+static PARSER_SIZE parser_format_decimal(PARSER_CHAR* out,
+                                         double       value)
+{
+    double        magnitude;
+    double        scaled;
+    double        decimal;
+    uint64_t      digits;
+    PARSER_SIZE   length;
+    PARSER_SIZE   integer_length;
+    PARSER_SIZE   fraction;
+    PARSER_SIZE   n;
+    PARSER_INT64  integer;
+    PARSER_DOUBLE parsed;
+    PARSER_INT    type;
+    int           precision;
+    int           written;
+
+    magnitude = value < 0 ? -value : value;
+    length    = 0;
+
+    if ( magnitude == magnitude && magnitude < 1e9 && (magnitude == 0 || magnitude >= 1e-3) )
+    {
+        for ( fraction = 0; fraction < sizeof(parser_powers_of_ten) / sizeof(parser_powers_of_ten[0]); fraction++ )
+        {
+            scaled  = magnitude * parser_powers_of_ten[fraction];
+            digits  = (uint64_t)(scaled + 0.5);
+            decimal = (double)digits / parser_powers_of_ten[fraction];
+
+            if ( decimal != magnitude )
+                continue;
+
+            if ( value < 0 || (value == 0 && 1 / value < 0) )
+                out[length++] = '-';
+
+            // Digits are written to the end of the room for the integer
+            // part and moved after the decimal point is known.
+
+            n = parser_format_int(out + length, (int64_t)digits);
+
+            if ( n <= fraction )
+            {
+                memmove(out + length + fraction - n + 1, out + length, n);
+                memset(out + length, '0', fraction - n + 1);
+                n = fraction + 1;
+            }
+
+            integer_length = n - fraction;
+
+            if ( !fraction )
+            {
+                memcpy(out + length + n, ".0", 2);
+                return(length + n + 2);
+            }
+
+            memmove(out + length + integer_length + 1, out + length + integer_length, fraction);
+            out[length + integer_length] = '.';
+
+            return(length + n + 1);
+        }
+    }
+
+    // Infinity and NaN are written as inf and nan.
+
+    if ( value != value || magnitude - magnitude != 0 )
+    {
+        written = snprintf(out, PARSER_WRITE_NUMBER_SIZE, "%g", value);
+        return(written > 0 ? (PARSER_SIZE)written : 0);
+    }
+
+    for ( precision = 15; ; precision++ )
+    {
+        written = snprintf(out, PARSER_WRITE_NUMBER_SIZE - 2, "%.*g", precision, value);
+        if ( written <= 0 || written >= PARSER_WRITE_NUMBER_SIZE - 2 )
+            return(0);
+
+        // Decimal point of the locale such as ',' or a multibyte
+        // separator is replaced with '.'.
+
+        length = 0;
+
+        for ( n = 0; n < (PARSER_SIZE)written; n++ )
+        {
+            if ( (out[n] >= '0' && out[n] <= '9') || out[n] == '-' || out[n] == '+' || out[n] == 'e' )
+                out[length++] = out[n];
+
+            else if ( out[length - 1] != '.' )
+                out[length++] = '.';
+        }
+
+        out[length] = 0;
+
+        // Round trip is checked with the parser that reads the
+        // value back, as strtod() depends on the locale too.
+
+        type = parser_parse_number(out, length, &integer, &parsed);
+        if ( type == PARSER_ATTRIBUTE_VALUE_TYPE_INTEGER )
+            parsed = (double)integer;
+
+        if ( precision == 17 || (type != PARSER_ATTRIBUTE_VALUE_TYPE_STRING && parsed == value) )
+            break;
+    }
+
+    // Integral values such as 1e+20 written as 100000000000000000000
+    // would be read back as integers.
+
+    if ( strcspn(out, ".e") == length )
+    {
+        memcpy(out + length, ".0", 2);
+        length += 2;
+    }
+
+    return(length);
+}
+
+// parser_output_indent
+
+static PARSER_ERROR parser_output_indent(PARSER_WRITE_OUTPUT* output,
+                                         PARSER_INT           depth,
+                                         PARSER_INT           flags)
+{
+    PARSER_SIZE  length;
+    PARSER_SIZE  count;
+    PARSER_ERROR error;
+
+    if ( !(flags & PARSER_WRITE_FLAG_PRETTY) )
+        return(0);
+
+    length = (PARSER_SIZE)depth * PARSER_WRITE_INDENT_WIDTH;
+
+    while ( length )
+    {
+        error = parser_output_reserve(output, 1);
+        if ( error )
+            return(error);
+
+        count = output->size - output->position;
+        if ( count > length )
+            count = length;
+
+        memset(output->data + output->position, ' ', count);
+
+        output->position += count;
+        length           -= count;
+    }
+
+    return(0);
+}
+
+// parser_output_newline
+
+static inline PARSER_ERROR parser_output_newline(PARSER_WRITE_OUTPUT* output,
+                                                 PARSER_INT           flags)
+{
+    if ( !(flags & PARSER_WRITE_FLAG_PRETTY) )
+        return(0);
+
+    return(parser_output_char(output, '\n'));
+}
+
+// parser_output_start_tag
+// Writes '<' and the name. Fixed parts of the tags are written
+// straight to the buffer when there is room.
+
+static PARSER_ERROR parser_output_start_tag(PARSER_WRITE_OUTPUT* output,
+                                            const PARSER_CHAR*   name)
+{
+    PARSER_SIZE  length;
+    PARSER_ERROR error;
+
+    length = strlen(name);
+
+    if ( output->size - output->position < length + 1 )
+    {
+        error = parser_output_char(output, '<');
+        if ( !error )
+            error = parser_output_write(output, name, length);
+
+        return(error);
+    }
+
+    output->data[output->position++] = '<';
+    memcpy(output->data + output->position, name, length);
+    output->position += length;
+
+    return(0);
+}
+
+// parser_output_end_tag
+
+static PARSER_ERROR parser_output_end_tag(PARSER_WRITE_OUTPUT* output,
+                                          const PARSER_CHAR*   name)
+{
+    PARSER_SIZE  length;
+    PARSER_ERROR error;
+
+    length = strlen(name);
+
+    if ( output->size - output->position < length + 3 )
+    {
+        error = parser_output_write(output, "</", 2);
+        if ( !error )
+            error = parser_output_write(output, name, length);
+        if ( !error )
+            error = parser_output_char(output, '>');
+
+        return(error);
+    }
+
+    output->data[output->position++] = '<';
+    output->data[output->position++] = '/';
+    memcpy(output->data + output->position, name, length);
+    output->position += length;
+    output->data[output->position++] = '>';
+
+    return(0);
+}
+
+// parser_output_attribute_name
+// Writes space, name and the opening quote.
+
+static PARSER_ERROR parser_output_attribute_name(PARSER_WRITE_OUTPUT* output,
+                                                 const PARSER_CHAR*   name)
+{
+    PARSER_SIZE  length;
+    PARSER_ERROR error;
+
+    length = strlen(name);
+
+    if ( output->size - output->position < length + 3 )
+    {
+        error = parser_output_char(output, ' ');
+        if ( !error )
+            error = parser_output_write(output, name, length);
+        if ( !error )
+            error = parser_output_write(output, "=\"", 2);
+
+        return(error);
+    }
+
+    output->data[output->position++] = ' ';
+    memcpy(output->data + output->position, name, length);
+    output->position += length;
+    output->data[output->position++] = '=';
+    output->data[output->position++] = '"';
+
+    return(0);
+}
+
+// parser_get_element_name
+// Returns name of the element or null if the name was not found
+// in the name list while parsing.
+
+static const PARSER_CHAR* parser_get_element_name(const PARSER_XML*     xml,
+                                                  const PARSER_ELEMENT* element)
+{
+#if defined(PARSER_WITH_DYNAMIC_NAMES)
+
+    if ( element->content_type & PARSER_ELEMENT_NAME_TYPE_STRING )
+        return(element->elem_name.name_string);
+
+#endif
+
+    if ( !(element->content_type & PARSER_ELEMENT_NAME_TYPE_INDEX) ||
+         element->elem_name.name_index < 0 || element->elem_name.name_index >= xml->element_name_list_length )
+        return(0);
+
+    return(xml->element_name_list[element->elem_name.name_index].name);
+}
+
+// parser_get_attribute_name
+
+static const PARSER_CHAR* parser_get_attribute_name(const PARSER_XML*       xml,
+                                                    const PARSER_ATTRIBUTE* attribute)
+{
+    if ( attribute->attribute_type & PARSER_ATTRIBUTE_NAME_TYPE_STRING )
+        return(attribute->attr_name.name_string);
+
+    if ( !(attribute->attribute_type & PARSER_ATTRIBUTE_NAME_TYPE_INDEX) ||
+         attribute->attr_name.attribute_index < 0 || attribute->attr_name.attribute_index >= xml->attribute_name_list_length )
+        return(0);
+
+    return(xml->attribute_name_list[attribute->attr_name.attribute_index].name);
+}
+
+// parser_get_declared_value_name
+// Returns name of a declared bool or enum value, or null for
+// other values.
+
+static const PARSER_CHAR* parser_get_declared_value_name(const PARSER_XML*       xml,
+                                                         const PARSER_ATTRIBUTE* attribute)
+{
+    const PARSER_ATTRIBUTE_DECLARATION* declaration;
+    PARSER_INT                          declared_type;
+
+    if ( !(attribute->attribute_type & PARSER_ATTRIBUTE_NAME_TYPE_INDEX) || !(attribute->attribute_type & PARSER_ATTRIBUTE_VALUE_TYPE_INTEGER) )
+        return(0);
+
+    declared_type = parser_get_declared_type(xml, attribute->attr_name.attribute_index);
+
+    if ( declared_type == PARSER_DECLARED_TYPE_BOOL )
+        return(attribute->attr_val.int_value ? "true" : "false");
+
+    if ( declared_type != PARSER_DECLARED_TYPE_ENUM )
+        return(0);
+
+    declaration = &xml->attribute_declarations[attribute->attr_name.attribute_index];
+
+    if ( attribute->attr_val.int_value < 0 || attribute->attr_val.int_value >= declaration->enum_value_count )
+        return(0);
+
+    return(declaration->enum_values[attribute->attr_val.int_value]);
+}
+
+// parser_write_attribute
+// Writes space, name and quoted value.
+
+static PARSER_ERROR parser_write_attribute(const PARSER_XML*       xml,
+                                           PARSER_WRITE_OUTPUT*    output,
+                                           const PARSER_ATTRIBUTE* attribute)
+{
+    PARSER_CHAR        number[PARSER_WRITE_NUMBER_SIZE];
+    const PARSER_CHAR* name;
+    const PARSER_CHAR* value;
+    PARSER_ERROR       error;
+
+    name = parser_get_attribute_name(xml, attribute);
+    if ( !name )
+        return(EINVAL);
+
+    error = parser_output_attribute_name(output, name);
+    if ( error )
+        return(error);
+
+    value = parser_get_declared_value_name(xml, attribute);
+
+    if ( value )
+    {
+        error = parser_output_escaped(output, value, strlen(value), '"', '<', '<');
+    }
+
+    else if ( attribute->attribute_type & PARSER_ATTRIBUTE_VALUE_TYPE_INTEGER )
+    {
+        error = parser_output_write(output, number, parser_format_int(number, attribute->attr_val.int_value));
+    }
+
+    else if ( attribute->attribute_type & PARSER_ATTRIBUTE_VALUE_TYPE_FLOAT )
+    {
+        error = parser_output_write(output, number, parser_format_decimal(number, attribute->attr_val.float_value));
+    }
+
+    else
+    {
+        value = attribute->attribute_type & PARSER_ATTRIBUTE_VALUE_BORROWED ? attribute->attr_val.string_slice : attribute->attr_val.string_ptr;
+        error = parser_output_escaped(output, value, (PARSER_SIZE)attribute->value_length, '"', '<', '<');
+    }
+
+    if ( error )
+        return(error);
+
+    return(parser_output_char(output, '"'));
+}
+
+// parser_is_space
+
+static inline PARSER_INT parser_is_space(PARSER_CHAR c)
+{
+    return(c == ' ' || c == '\t' || c == '\r' || c == '\n');
+}
+
+// parser_trim_text
+// Pretty output leaves out whitespace around the text of the element.
+
+static void parser_trim_text(const PARSER_STRING*  string,
+                             const PARSER_ELEMENT* element,
+                             PARSER_INT            flags,
+                             PARSER_SIZE*          start,
+                             PARSER_SIZE*          end)
+{
+    *start = 0;
+    *end   = string->length;
+
+    if ( !(flags & PARSER_WRITE_FLAG_PRETTY) )
+        return;
+
+    if ( string == element->child_string.first_string )
+    {
+        while ( *start < *end && parser_is_space(string->buffer[*start]) )
+            (*start)++;
+    }
+
+    if ( string == element->child_string.last_string )
+    {
+        while ( *end > *start && parser_is_space(string->buffer[*end - 1]) )
+            (*end)--;
+    }
+}
+
+// parser_has_text
+// Returns non-zero if the element has text to write.
+
+static PARSER_INT parser_has_text(const PARSER_ELEMENT* element,
+                                  PARSER_INT            flags)
+{
+    const PARSER_STRING* string;
+    PARSER_SIZE          start;
+    PARSER_SIZE          end;
+
+    for ( string = element->child_string.first_string; string; string = string->next_string )
+    {
+        parser_trim_text(string, element, flags, &start, &end);
+
+        if ( start < end )
+            return(1);
+    }
+
+    return(0);
+}
+
+// parser_write_text
+// Writes all content strings of the element.
+
+static PARSER_ERROR parser_write_text(PARSER_WRITE_OUTPUT*  output,
+                                      const PARSER_ELEMENT* element,
+                                      PARSER_INT            flags)
+{
+    const PARSER_STRING* string;
+    PARSER_SIZE          start;
+    PARSER_SIZE          end;
+    PARSER_ERROR         error;
+
+    for ( string = element->child_string.first_string; string; string = string->next_string )
+    {
+        parser_trim_text(string, element, flags, &start, &end);
+
+        error = parser_output_escaped(output, string->buffer + start, end - start, '<', '<', '<');
+        if ( error )
+            return(error);
+    }
+
+    return(0);
+}
+
+// parser_write_start_tag
+// Writes start tag and the text of the element. Element without
+// content is closed in the same tag.
+
+static PARSER_ERROR parser_write_start_tag(const PARSER_XML*     xml,
+                                           PARSER_WRITE_OUTPUT*  output,
+                                           const PARSER_ELEMENT* element,
+                                           PARSER_INT            depth,
+                                           PARSER_INT            flags)
+{
+    const PARSER_ATTRIBUTE* attribute;
+    const PARSER_CHAR*      name;
+    PARSER_INT              has_text;
+    PARSER_ERROR            error;
+
+    name = parser_get_element_name(xml, element);
+    if ( !name )
+        return(EINVAL);
+
+    error = parser_output_indent(output, depth, flags);
+    if ( !error )
+        error = parser_output_start_tag(output, name);
+    if ( error )
+        return(error);
+
+    for ( attribute = element->first_attribute; attribute; attribute = attribute->next_attribute )
+    {
+        error = parser_write_attribute(xml, output, attribute);
+        if ( error )
+            return(error);
+    }
+
+    has_text = parser_has_text(element, flags);
+
+    if ( !has_text && !element->child_element.first_element )
+    {
+        error = parser_output_write(output, "/>", 2);
+        if ( !error )
+            error = parser_output_newline(output, flags);
+
+        return(error);
+    }
+
+    error = parser_output_char(output, '>');
+    if ( error )
+        return(error);
+
+    // Text only element is written on one line.
+
+    if ( !element->child_element.first_element )
+        return(parser_write_text(output, element, flags));
+
+    if ( !has_text )
+        return(parser_output_newline(output, flags));
+
+    error = parser_output_newline(output, flags);
+    if ( !error )
+        error = parser_output_indent(output, depth + 1, flags);
+    if ( !error )
+        error = parser_write_text(output, element, flags);
+    if ( !error )
+        error = parser_output_newline(output, flags);
+
+    return(error);
+}
+
+// parser_write_end_tag
+
+static PARSER_ERROR parser_write_end_tag(const PARSER_XML*     xml,
+                                         PARSER_WRITE_OUTPUT*  output,
+                                         const PARSER_ELEMENT* element,
+                                         PARSER_INT            depth,
+                                         PARSER_INT            flags)
+{
+    PARSER_ERROR error;
+
+    // Closed already in the start tag.
+
+    if ( !element->child_element.first_element && !parser_has_text(element, flags) )
+        return(0);
+
+    if ( element->child_element.first_element )
+    {
+        error = parser_output_indent(output, depth, flags);
+        if ( error )
+            return(error);
+    }
+
+    error = parser_output_end_tag(output, parser_get_element_name(xml, element));
+    if ( error )
+        return(error);
+
+    return(parser_output_newline(output, flags));
+}
+
+// parser_write_tree
+// Walks the tree in document order without recursion.
+
+static PARSER_ERROR parser_write_tree(const PARSER_XML*    xml,
+                                      PARSER_WRITE_OUTPUT* output,
+                                      PARSER_INT           flags)
+{
+    const PARSER_ELEMENT* element;
+    PARSER_INT            depth;
+    PARSER_ERROR          error;
+
+    element = xml->first_element;
+    depth   = 0;
+
+    while ( element )
+    {
+        error = parser_write_start_tag(xml, output, element, depth, flags);
+        if ( error )
+            return(error);
+
+        if ( element->child_element.first_element )
+        {
+            element = element->child_element.first_element;
+            depth++;
+            continue;
+        }
+
+        error = parser_write_end_tag(xml, output, element, depth, flags);
+        if ( error )
+            return(error);
+
+        // Close parents of the last child.
+
+        while ( !element->next_element && element->parent_element )
+        {
+            element = element->parent_element;
+            depth--;
+
+            error = parser_write_end_tag(xml, output, element, depth, flags);
+            if ( error )
+                return(error);
+        }
+
+        element = element->next_element;
+    }
+
+    return(0);
+}
+
+// parser_write_xml
+
+PARSER_ERROR parser_write_xml(const PARSER_XML*     xml,
+                              PARSER_WRITE_FUNCTION write,
+                              void*                 context,
+                              PARSER_INT            flags)
+{
+    PARSER_CHAR         chunk[PARSER_WRITE_CHUNK_SIZE];
+    PARSER_WRITE_OUTPUT output;
+    PARSER_ERROR        error;
+
+    if ( !xml || !write )
+        return(EINVAL);
+
+    output.data     = chunk;
+    output.size     = sizeof(chunk);
+    output.position = 0;
+    output.flush    = parser_output_flush_callback;
+    output.write    = write;
+    output.context  = context;
+
+    error = parser_write_tree(xml, &output, flags);
+    if ( error )
+        return(error);
+
+    return(parser_output_flush_callback(&output, 0));
+}
+
+// parser_write_xml_to_buffer
+
+PARSER_ERROR parser_write_xml_to_buffer(const PARSER_XML* xml,
+                                        PARSER_CHAR*      buffer,
+                                        PARSER_SIZE       buffer_size,
+                                        PARSER_SIZE*      bytes_written,
+                                        PARSER_INT        flags)
+{
+    PARSER_WRITE_OUTPUT output;
+    PARSER_ERROR        error;
+
+    if ( !xml || !buffer || !buffer_size )
+        return(EINVAL);
+
+    // Last byte is kept for the null terminator.
+
+    output.data     = buffer;
+    output.size     = buffer_size - 1;
+    output.position = 0;
+    output.flush    = parser_output_flush_fixed;
+    output.write    = 0;
+    output.context  = 0;
+
+    error = parser_write_tree(xml, &output, flags);
+
+    buffer[output.position] = '\0';
+
+    if ( bytes_written )
+        *bytes_written = output.position;
+
+    return(error);
+}
+
+// parser_write_xml_to_string
+
+PARSER_ERROR parser_write_xml_to_string(const PARSER_XML* xml,
+                                        PARSER_CHAR**     string,
+                                        PARSER_SIZE*      length,
+                                        PARSER_INT        flags)
+{
+    PARSER_WRITE_OUTPUT output;
+    PARSER_ALLOCATOR    allocator;
+    PARSER_ERROR        error;
+
+    if ( !xml || !string )
+        return(EINVAL);
+
+    allocator = xml->allocator;
+
+    output.data = allocator.alloc(allocator.context, PARSER_WRITE_CHUNK_SIZE);
+    if ( !output.data )
+        return(ENOMEM);
+
+    output.size     = PARSER_WRITE_CHUNK_SIZE;
+    output.position = 0;
+    output.flush    = parser_output_flush_grow;
+    output.write    = 0;
+    output.context  = &allocator;
+
+    error = parser_write_tree(xml, &output, flags);
+    if ( !error )
+        error = parser_output_char(&output, '\0');
+
+    if ( error )
+    {
+        allocator.free(allocator.context, output.data);
+        return(error);
+    }
+
+    *string = output.data;
+
+    if ( length )
+        *length = output.position - 1;
+
+    return(0);
+}
+
+// parser_writer_name
+// Returns name of the index in the list or null.
+
+static const PARSER_CHAR* parser_writer_name(const PARSER_XML_NAME* list,
+                                             PARSER_INT             list_length,
+                                             PARSER_INT             index)
+{
+    if ( index < 0 || index >= list_length )
+        return(0);
+
+    return(list[index].name);
+}
+
+// parser_writer_close_tag
+// Ends start tag of the innermost element before its content.
+
+static PARSER_ERROR parser_writer_close_tag(PARSER_WRITER* writer)
+{
+    if ( !writer->tag_open )
+        return(0);
+
+    writer->tag_open = 0;
+
+    return(parser_output_char(&writer->output, '>'));
+}
+
+// parser_writer_attribute_name
+// Checks that attributes can be written and writes the name.
+
+static PARSER_ERROR parser_writer_attribute_name(PARSER_WRITER* writer,
+                                                 PARSER_INT     name_index)
+{
+    const PARSER_CHAR* name;
+
+    if ( !writer || !writer->tag_open )
+        return(EINVAL);
+
+    name = parser_writer_name(writer->attribute_name_list, writer->attribute_name_list_length, name_index);
+    if ( !name )
+        return(EINVAL);
+
+    return(parser_output_attribute_name(&writer->output, name));
+}
+
+// parser_writer_init
+
+PARSER_ERROR parser_writer_init(PARSER_WRITER*        writer,
+                                const PARSER_CONFIG*  config,
+                                PARSER_CHAR*          buffer,
+                                PARSER_SIZE           buffer_size,
+                                PARSER_WRITE_FUNCTION write,
+                                void*                 context,
+                                PARSER_INT            flags)
+{
+    if ( !writer || !config || !buffer || buffer_size < 2 )
+        return(EINVAL);
+
+    // Without callback last byte is kept for the null terminator.
+
+    writer->output.data     = buffer;
+    writer->output.size     = write ? buffer_size : buffer_size - 1;
+    writer->output.position = 0;
+    writer->output.flush    = write ? parser_output_flush_callback : parser_output_flush_fixed;
+    writer->output.write    = write;
+    writer->output.context  = context;
+
+    writer->element_name_list          = config->element_name_list;
+    writer->element_name_list_length   = config->element_name_list_length;
+    writer->attribute_name_list        = config->attribute_name_list;
+    writer->attribute_name_list_length = config->attribute_name_list_length;
+
+    writer->flags        = flags;
+    writer->depth        = 0;
+    writer->tag_open     = 0;
+    writer->has_children = 0;
+
+    return(0);
+}
+
+// parser_writer_start_element
+
+PARSER_ERROR parser_writer_start_element(PARSER_WRITER* writer,
+                                         PARSER_INT     name_index)
+{
+    const PARSER_CHAR* name;
+    PARSER_ERROR       error;
+
+    if ( !writer )
+        return(EINVAL);
+
+    name = parser_writer_name(writer->element_name_list, writer->element_name_list_length, name_index);
+    if ( !name )
+        return(EINVAL);
+
+    if ( writer->depth >= PARSER_WRITER_MAX_DEPTH )
+        return(EOVERFLOW);
+
+    error = parser_writer_close_tag(writer);
+    if ( error )
+        return(error);
+
+    // Root elements start after the newline of the previous root.
+
+    if ( writer->depth )
+    {
+        error = parser_output_newline(&writer->output, writer->flags);
+        if ( !error )
+            error = parser_output_indent(&writer->output, writer->depth, writer->flags);
+        if ( error )
+            return(error);
+    }
+
+    error = parser_output_start_tag(&writer->output, name);
+    if ( error )
+        return(error);
+
+    writer->open_elements[writer->depth++] = name_index;
+    writer->tag_open                       = 1;
+    writer->has_children                   = 0;
+
+    return(0);
+}
+
+// parser_writer_attribute_int
+
+PARSER_ERROR parser_writer_attribute_int(PARSER_WRITER* writer,
+                                         PARSER_INT     name_index,
+                                         int64_t        value)
+{
+    PARSER_CHAR  number[PARSER_WRITE_NUMBER_SIZE];
+    PARSER_ERROR error;
+
+    error = parser_writer_attribute_name(writer, name_index);
+    if ( !error )
+        error = parser_output_write(&writer->output, number, parser_format_int(number, value));
+    if ( !error )
+        error = parser_output_char(&writer->output, '"');
+
+    return(error);
+}
+
+// parser_writer_attribute_float
+
+PARSER_ERROR parser_writer_attribute_float(PARSER_WRITER* writer,
+                                           PARSER_INT     name_index,
+                                           PARSER_DOUBLE  value)
+{
+    PARSER_CHAR  number[PARSER_WRITE_NUMBER_SIZE];
+    PARSER_ERROR error;
+
+    error = parser_writer_attribute_name(writer, name_index);
+    if ( !error )
+        error = parser_output_write(&writer->output, number, parser_format_decimal(number, value));
+    if ( !error )
+        error = parser_output_char(&writer->output, '"');
+
+    return(error);
+}
+
+// parser_writer_attribute_string
+
+PARSER_ERROR parser_writer_attribute_string(PARSER_WRITER*     writer,
+                                            PARSER_INT         name_index,
+                                            const PARSER_CHAR* value,
+                                            PARSER_SIZE        length)
+{
+    PARSER_ERROR error;
+
+    if ( !value && length )
+        return(EINVAL);
+
+    error = parser_writer_attribute_name(writer, name_index);
+    if ( !error )
+        error = parser_output_escaped(&writer->output, value, length, '&', '<', '"');
+    if ( !error )
+        error = parser_output_char(&writer->output, '"');
+
+    return(error);
+}
+
+// parser_writer_text
+
+PARSER_ERROR parser_writer_text(PARSER_WRITER*     writer,
+                                const PARSER_CHAR* text,
+                                PARSER_SIZE        length)
+{
+    PARSER_ERROR error;
+
+    if ( !writer || !writer->depth || (!text && length) )
+        return(EINVAL);
+
+    error = parser_writer_close_tag(writer);
+    if ( error )
+        return(error);
+
+    // Text after child elements goes on its own line.
+
+    if ( writer->has_children )
+    {
+        error = parser_output_newline(&writer->output, writer->flags);
+        if ( !error )
+            error = parser_output_indent(&writer->output, writer->depth, writer->flags);
+        if ( error )
+            return(error);
+    }
+
+    return(parser_output_escaped(&writer->output, text, length, '&', '<', '>'));
+}
+
+// parser_writer_end_element
+
+PARSER_ERROR parser_writer_end_element(PARSER_WRITER* writer)
+{
+    PARSER_ERROR error;
+
+    if ( !writer || !writer->depth )
+        return(EINVAL);
+
+    writer->depth--;
+
+    // Element without content is closed in the start tag.
+
+    if ( writer->tag_open )
+    {
+        writer->tag_open = 0;
+
+        error = parser_output_write(&writer->output, "/>", 2);
+    }
+
+    else
+    {
+        error = 0;
+
+        if ( writer->has_children )
+        {
+            error = parser_output_newline(&writer->output, writer->flags);
+            if ( !error )
+                error = parser_output_indent(&writer->output, writer->depth, writer->flags);
+        }
+
+        if ( !error )
+            error = parser_output_end_tag(&writer->output, writer->element_name_list[writer->open_elements[writer->depth]].name);
+    }
+
+    if ( error )
+        return(error);
+
+    writer->has_children = 1;
+
+    if ( !writer->depth )
+        return(parser_output_newline(&writer->output, writer->flags));
+
+    return(0);
+}
+
+// parser_writer_flush
+
+PARSER_ERROR parser_writer_flush(PARSER_WRITER* writer)
+{
+    if ( !writer )
+        return(EINVAL);
+
+    if ( writer->output.write )
+        return(parser_output_flush_callback(&writer->output, 0));
+
+    writer->output.data[writer->output.position] = '\0';
+
+    return(0);
+}